@@ -414,12 +414,28 @@ public:
 
         _total = _keys.size();
 
+        jobs::get_pool("oe.bakefeaturetiles")->set_concurrency(_numThreads);
+
+        auto group = jobs::jobgroup::create();
+
         for (auto &key : _keys)
         {
-            this->handleTile(key);
+            jobs::context job;
+            job.name = "handleTile";
+            job.pool = jobs::get_pool("oe.bakefeaturetiles");
+            job.group = group;
+
+            jobs::dispatch([this, key]()
+                {
+                    if (!_progress.valid() || !_progress->isCanceled())
+                    {
+                        this->handleTile(key);
+                    }
+                },
+                job);
         }
 
-        _group->join();
+        group->join();
     }    
 
     std::vector< TileKey > _keys;
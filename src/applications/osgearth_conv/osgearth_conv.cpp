@@ -32,6 +32,9 @@
 #include <osgEarth/OGRFeatureSource>
 #include <osgEarth/ImageUtils>
 #include <osgEarth/TileEstimator>
+#include <osgEarth/Cache>
+#include <osgEarth/CacheSeed>
+#include <osgEarth/StringUtils>
 
 #include <osg/ArgumentParser>
 #include <osg/Timer>
@@ -60,6 +63,13 @@ int usage(char** argv)
         << "\n    --extents [minLat] [minLong] [maxLat] [maxLong] : Lat/Long extends to copy"
         << "\n    --no-overwrite                      : skip tiles that already exist in the destination"
         << "\n    --threads [int]                     : go faster by using [n] working threads"
+        << "\n    --write-threads [int]               : number of threads writing to the output (default = 1)"
+        << "\n    --checkpoint [file]                 : periodically record progress in [file]"
+        << "\n    --resume                            : with --checkpoint, skip the tiles already completed"
+        << "\n    --shard [i/N]                       : handle only slice i (0-based) of N disjoint slices of the tiles"
+        << "\n    --seed                              : with --in-earth, seed the layer's cache instead of using --out"
+        << "\n    --merge                             : with --in-earth, copy the layer's tiles from other caches into its cache"
+        << "\n    --from [path]                       : with --merge, location of a cache to copy from (repeat for each shard)"
         << std::endl;
 
     return 0;
@@ -76,8 +86,6 @@ struct ImageLayerTileCopy : public TileHandler
 
     bool handleTile(const TileKey& key, const TileVisitor& tv) override
     {
-        bool ok = false;
-
         // if overwriting is disabled, check to see whether the destination
         // already has data for the key
         if (_overwrite == false)
@@ -88,22 +96,54 @@ struct ImageLayerTileCopy : public TileHandler
             }
         }
 
-        GeoImage image = _source->createImage(key);
-        if (image.valid())
+        osg::ref_ptr<const osg::Image> image = readTile(key);
+        return image.valid() && writeTile(key, image.get());
+    }
+
+    // Pipelined: fetch and compress on the read threads...
+    std::vector<TileData> readTiles(const std::vector<TileKey>& keys, const TileVisitor& tv) override
+    {
+        std::vector<TileData> data(keys.size());
+        for (unsigned i = 0; i < keys.size(); ++i)
         {
-            osg::ref_ptr<const osg::Image> imageToWrite = image.getImage();
-            if (_compress)
-                imageToWrite = ImageUtils::compressImage(image.getImage(), "cpu");
+            if (_overwrite == false && _dest->createImage(keys[i]).valid())
+                continue;
 
-            Status status = _dest->writeImage(key, imageToWrite.get(), 0L);
-            ok = status.isOK();
-            if (!ok)
-            {
-                OE_WARN << key.str() << ": " << status.message() << std::endl;
-            }
+            data[i] = const_cast<osg::Image*>(readTile(keys[i]).get());
         }
+        return data;
+    }
 
-        return ok;
+    // ...and write on the write threads.
+    void writeTiles(const std::vector<TileKey>& keys, const std::vector<TileData>& data, const TileVisitor& tv) override
+    {
+        for (unsigned i = 0; i < keys.size(); ++i)
+        {
+            if (data[i].valid())
+                writeTile(keys[i], static_cast<const osg::Image*>(data[i].get()));
+        }
+    }
+
+    osg::ref_ptr<const osg::Image> readTile(const TileKey& key) const
+    {
+        GeoImage image = _source->createImage(key);
+        if (!image.valid())
+            return nullptr;
+
+        osg::ref_ptr<const osg::Image> result = image.getImage();
+        if (_compress)
+            result = ImageUtils::compressImage(image.getImage(), "cpu");
+        return result;
+    }
+
+    bool writeTile(const TileKey& key, const osg::Image* image) const
+    {
+        Status status = _dest->writeImage(key, image, 0L);
+        if (status.isError())
+        {
+            OE_WARN << key.str() << ": " << status.message() << std::endl;
+        }
+        return status.isOK();
     }
 
     bool hasData(const TileKey& key) const override
@@ -145,8 +185,6 @@ struct ElevationLayerTileCopy : public TileHandler
 
     bool handleTile(const TileKey& key, const TileVisitor& tv) override
     {
-        bool ok = false;
-
         // if overwriting is disabled, check to see whether the destination
         // already has data for the key
         if (_overwrite == false)
@@ -158,20 +196,43 @@ struct ElevationLayerTileCopy : public TileHandler
         }
 
         GeoHeightField hf = _source->createHeightField(key, 0L);
-        if ( hf.valid() )
+        return hf.valid() && writeTile(key, hf.getHeightField());
+    }
+
+    // Pipelined: fetch on the read threads...
+    std::vector<TileData> readTiles(const std::vector<TileKey>& keys, const TileVisitor& tv) override
+    {
+        std::vector<TileData> data(keys.size());
+        for (unsigned i = 0; i < keys.size(); ++i)
         {
-            Status s = _dest->writeHeightField(key, hf.getHeightField(), 0L);
-            ok = s.isOK();
-            if (!ok)
-            {
-                OE_WARN << key.str() << ": " << s.message() << std::endl;
-            }
+            if (_overwrite == false && _dest->createHeightField(keys[i]).valid())
+                continue;
+
+            GeoHeightField hf = _source->createHeightField(keys[i], 0L);
+            if (hf.valid())
+                data[i] = const_cast<osg::HeightField*>(hf.getHeightField());
         }
-        else
+        return data;
+    }
+
+    // ...and write on the write threads.
+    void writeTiles(const std::vector<TileKey>& keys, const std::vector<TileData>& data, const TileVisitor& tv) override
+    {
+        for (unsigned i = 0; i < keys.size(); ++i)
         {
-            //OE_WARN << key.str() << " : " << hf.getStatus().message() << std::endl;
+            if (data[i].valid())
+                writeTile(keys[i], static_cast<const osg::HeightField*>(data[i].get()));
         }
-        return ok;
+    }
+
+    bool writeTile(const TileKey& key, const osg::HeightField* hf) const
+    {
+        Status s = _dest->writeHeightField(key, hf, 0L);
+        if (s.isError())
+        {
+            OE_WARN << key.str() << ": " << s.message() << std::endl;
+        }
+        return s.isOK();
     }
 
     bool hasData(const TileKey& key) const override
@@ -319,6 +380,23 @@ struct ProgressReporter : public osgEarth::ProgressCallback
  *      --extents [minLat] [minLong] [maxLat] [maxLong] : Lat/Long extends to copy (*)
  *      --no-overwrite        : don't overwrite data that already exists
  *      --threads [int]       : number of threads to launch
+ *      --write-threads [int] : number of threads writing to the output
+ *      --checkpoint [file]   : periodically record progress in a file
+ *      --resume              : with --checkpoint, continue an interrupted run
+ *      --shard [i/N]         : handle only slice i of N disjoint slices of the tiles
+ *      --seed                : seed the --in-earth layer's cache (no --out)
+ *      --merge               : copy the --in-earth layer's tiles into its cache
+ *      --from [path]         : with --merge, a cache to copy from (repeatable)
+ *
+ * Example #3: seed a cache with 4 processes, then merge the shards into the
+ * earth file's cache. Each shard writes to its own cache location:
+ *
+ *   OSGEARTH_CACHE_PATH=shard0 osgearth_conv --in-earth myfile.earth
+ *      --in-layer my_image_layer_name --seed --shard 0/4
+ *   ... and likewise for shards 1, 2 and 3, then:
+ *
+ *   osgearth_conv --in-earth myfile.earth --in-layer my_image_layer_name
+ *      --merge --from shard0 --from shard1 --from shard2 --from shard3
  *
  * OSG arguments:
  *
@@ -425,6 +503,44 @@ main(int argc, char** argv)
         return -1;
     }
 
+    // Instead of converting, seed the input layer's cache, or merge other
+    // caches into it. Both work on the cache of the --in-earth map.
+    bool seedCache = args.read("--seed");
+    bool mergeCache = args.read("--merge");
+    bool cacheMode = seedCache || mergeCache;
+
+    std::vector<osg::ref_ptr<Cache>> mergeSources;
+    if (cacheMode)
+    {
+        if (!map.valid() || !map->getCache())
+        {
+            OE_WARN << LC << "--seed and --merge require an --in-earth file with a cache" << std::endl;
+            return -1;
+        }
+
+        // The caches to merge use the same driver and settings as the
+        // map's cache, in a different location.
+        std::string path;
+        while (args.read("--from", path))
+        {
+            Config conf = map->getCache()->getCacheOptions().getConfig();
+            conf.set("path", path);
+            osg::ref_ptr<Cache> cache = Util::CacheFactory::create(CacheOptions(ConfigOptions(conf)));
+            if (!cache.valid() || cache->getStatus().isError())
+            {
+                OE_WARN << LC << "Failed to open cache at " << path << std::endl;
+                return -1;
+            }
+            mergeSources.push_back(cache);
+        }
+
+        if (mergeCache && mergeSources.empty())
+        {
+            OE_WARN << LC << "--merge requires at least one --from" << std::endl;
+            return -1;
+        }
+    }
+
     // collect output configuration:
     bool compress = false;
     Config outConf;
@@ -458,25 +574,35 @@ main(int argc, char** argv)
         isSameProfile = outputProfile->isHorizEquivalentTo(input->getProfile());
     }
 
+    // the cache is keyed in the map's profile
+    if (cacheMode)
+    {
+        outputProfile = map->getProfile();
+    }
+
     // set the output profile.
     ProfileOptions profileOptions = outputProfile->toProfileOptions();
     outConf.add("profile", profileOptions.getConfig());
 
     // open the output tile source:
-    auto layer = Layer::create(ConfigOptions(outConf));
-    osg::ref_ptr<TileLayer> output = dynamic_cast<TileLayer*>(layer.get());
-    if (!output)
+    osg::ref_ptr<TileLayer> output;
+    if (!cacheMode)
     {
-        OE_WARN << LC << "Failed to create output layer" << std::endl;
-        return -1;
-    }
+        auto layer = Layer::create(ConfigOptions(outConf));
+        output = dynamic_cast<TileLayer*>(layer.get());
+        if (!output)
+        {
+            OE_WARN << LC << "Failed to create output layer" << std::endl;
+            return -1;
+        }
 
-    output->setReadOptions(dbo.get());
-    Status outputStatus = output->openForWriting();
-    if (outputStatus.isError())
-    {
-        OE_WARN << LC << "Error initializing output: " << outputStatus.message() << std::endl;
-        return -1;
+        output->setReadOptions(dbo.get());
+        Status outputStatus = output->openForWriting();
+        if (outputStatus.isError())
+        {
+            OE_WARN << LC << "Error initializing output: " << outputStatus.message() << std::endl;
+            return -1;
+        }
     }
 
     // Dump out some stuff...
@@ -485,7 +611,7 @@ main(int argc, char** argv)
         << std::endl;
 
     OE_NOTICE << LC << "TO:\n"
-        << outConf.toJSON(true)
+        << (cacheMode ? map->getCache()->getCacheOptions().getConfig() : outConf).toJSON(true)
         << std::endl;
 
     // create the visitor.
@@ -495,13 +621,58 @@ main(int argc, char** argv)
     args.read("--threads", numThreads);
     MultithreadedTileVisitor* mtv = new MultithreadedTileVisitor();
     mtv->setNumThreads(numThreads < 1 ? 1 : numThreads);
+
+    unsigned numWriteThreads = 1;
+    if (args.read("--write-threads", numWriteThreads))
+        mtv->setNumWriteThreads(numWriteThreads < 1 ? 1 : numWriteThreads);
+
+    std::string checkpointFile;
+    if (args.read("--checkpoint", checkpointFile))
+        mtv->setCheckpointFile(checkpointFile);
+
+    if (args.read("--resume"))
+    {
+        if (checkpointFile.empty())
+        {
+            OE_WARN << LC << "--resume requires --checkpoint" << std::endl;
+            return -1;
+        }
+        mtv->setResume(true);
+    }
+
+    std::string shard;
+    if (args.read("--shard", shard))
+    {
+        StringVector parts;
+        StringTokenizer(shard, parts, "/");
+        unsigned shardIndex = parts.size() == 2 ? as<unsigned>(parts[0], ~0u) : ~0u;
+        unsigned shardCount = parts.size() == 2 ? as<unsigned>(parts[1], 0u) : 0u;
+        if (shardCount == 0 || shardIndex >= shardCount)
+        {
+            OE_WARN << LC << "--shard must be i/N with 0 <= i < N" << std::endl;
+            return -1;
+        }
+        mtv->setShard(shardIndex, shardCount);
+    }
+
     visitor = mtv;
 
     bool overwrite = true;
     if (args.read("--no-overwrite"))
         overwrite = false;
 
-    if (dynamic_cast<ImageLayer*>(input.get()) && dynamic_cast<ImageLayer*>(output.get()))
+    osg::ref_ptr<Contrib::CacheMergeTileHandler> merger;
+
+    if (seedCache)
+    {
+        visitor->setTileHandler(new Contrib::CacheTileHandler(input.get(), map.get()));
+    }
+    else if (mergeCache)
+    {
+        merger = new Contrib::CacheMergeTileHandler(input.get(), map.get(), mergeSources);
+        visitor->setTileHandler(merger.get());
+    }
+    else if (dynamic_cast<ImageLayer*>(input.get()) && dynamic_cast<ImageLayer*>(output.get()))
     {
         visitor->setTileHandler(new ImageLayerTileCopy(
             dynamic_cast<ImageLayer*>(input.get()),
@@ -630,7 +801,7 @@ main(int argc, char** argv)
     }
 
 
-    if (!outputExtents.empty())
+    if (output.valid() && !outputExtents.empty())
     {
         output->setDataExtents(outputExtents);
     }
@@ -644,6 +815,20 @@ main(int argc, char** argv)
 
     visitor->run( outputProfile.get() );
 
+    // commit any buffered writes before stopping the clock
+    Status flushed;
+    if (output.valid())
+    {
+        flushed = output->flushWrites();
+        output->close();
+    }
+
+    if (flushed.isError())
+    {
+        OE_WARN << LC << "Error writing output: " << flushed.message() << std::endl;
+        return -1;
+    }
+
     osg::Timer_t t1 = osg::Timer::instance()->tick();
 
     std::cout
@@ -654,5 +839,10 @@ main(int argc, char** argv)
         << osg::Timer::instance()->delta_s(t0, t1)
         << " seconds." << std::endl;
 
+    if (merger.valid())
+    {
+        std::cout << "Merged " << merger->getNumTilesMerged() << " tiles." << std::endl;
+    }
+
     return 0;
 }
@@ -144,6 +144,9 @@ main(int argc, char** argv)
     osg::ArgumentParser arguments(&argc,argv);
     osgViewer::Viewer viewer(arguments);
 
+    // compute LOS from the elevation data instead of the scene graph
+    bool useHeightfield = arguments.read("--heightfield");
+
     // load the .earth file from the command line.
     osg::ref_ptr<osg::Node> earthNode = osgDB::readNodeFiles( arguments );
     if (!earthNode.valid())
@@ -185,6 +188,7 @@ main(int argc, char** argv)
         GeoPoint(geoSRS, -121.665, 46.0878, 1258.00, ALTMODE_ABSOLUTE),
         GeoPoint(geoSRS, -121.488, 46.2054, 3620.11, ALTMODE_ABSOLUTE) );
 
+    los->setUseHeightfield( useHeightfield );
     losGroup->addChild( los );
 
     //Create an editor for the point to point line of sight that allows you to drag the beginning and end points around.
@@ -198,6 +202,7 @@ main(int argc, char** argv)
         GeoPoint(geoSRS, -121.2, 46.1, 10, ALTMODE_RELATIVE),
         GeoPoint(geoSRS, -121.488, 46.2054, 10, ALTMODE_RELATIVE) );
 
+    relativeLOS->setUseHeightfield( useHeightfield );
     losGroup->addChild( relativeLOS );
 
     LinearLineOfSightEditor* relEditor = new LinearLineOfSightEditor( relativeLOS );
@@ -208,6 +213,7 @@ main(int argc, char** argv)
     radial->setCenter( GeoPoint(geoSRS, -121.515, 46.054, 847.604, ALTMODE_ABSOLUTE) );
     radial->setRadius( 2000 );
     radial->setNumSpokes( 100 );
+    radial->setUseHeightfield( useHeightfield );
     losGroup->addChild( radial );
     RadialLineOfSightEditor* radialEditor = new RadialLineOfSightEditor( radial );
     losGroup->addChild( radialEditor );
@@ -217,6 +223,7 @@ main(int argc, char** argv)
     radialRelative->setCenter( GeoPoint(geoSRS, -121.2, 46.054, 10, ALTMODE_RELATIVE) );
     radialRelative->setRadius( 3000 );
     radialRelative->setNumSpokes(60);
+    radialRelative->setUseHeightfield( useHeightfield );
     losGroup->addChild( radialRelative );
     RadialLineOfSightEditor* radialRelEditor = new RadialLineOfSightEditor( radialRelative );
     losGroup->addChild( radialRelEditor );
@@ -233,6 +240,7 @@ main(int argc, char** argv)
     //Create a LineOfSightNode that will use a LineOfSightTether callback to monitor
     //the two plane's positions and recompute the LOS when they move
     LinearLineOfSightNode* tetheredLOS = new LinearLineOfSightNode( mapNode);
+    tetheredLOS->setUseHeightfield( useHeightfield );
     losGroup->addChild( tetheredLOS );
     tetheredLOS->setUpdateCallback( new LineOfSightTether( plane1, plane2 ) );
 
@@ -247,6 +255,7 @@ main(int argc, char** argv)
     tetheredRadial->setGoodColor( osg::Vec4(0,1,0,0.3) );
     tetheredRadial->setBadColor( osg::Vec4(1,0,0,0.3) );
     tetheredRadial->setNumSpokes( 100 );
+    tetheredRadial->setUseHeightfield( useHeightfield );
     losGroup->addChild( tetheredRadial );
     tetheredRadial->setUpdateCallback( new RadialLineOfSightTether( plane3 ) );
 
@@ -25,6 +25,7 @@
 #include <osgDB/ReadFile>
 
 #include <osg/io_utils>
+#include <osg/Timer>
 
 #include <osgEarth/Common>
 #include <osgEarth/Cache>
@@ -51,6 +52,7 @@ using namespace osgEarth;
 int list( osg::ArgumentParser& args );
 int seed( osg::ArgumentParser& args );
 int purge( osg::ArgumentParser& args );
+int compact( osg::ArgumentParser& args );
 int usage( const std::string& msg );
 int message( const std::string& msg );
 
@@ -65,6 +67,8 @@ int main(int argc, char** argv)
         return list( args );
     else if ( args.read( "--purge" ) )
         return purge( args );        
+    else if ( args.read( "--compact" ) )
+        return compact( args );
     else
     return usage("");
 }
@@ -94,6 +98,9 @@ int usage( const std::string& msg )
         << "        [--verbose]                     ; Displays progress of the seed operation" << std::endl
         << std::endl
         << "    --purge file.earth                  ; Purges a layer cache in a .earth file (interactive)" << std::endl
+        << std::endl
+        << "    --compact file.earth                ; Compacts the cache in a .earth file, migrating any" << std::endl
+        << "                                        ; per-file records into bundles (filesystem cache with layout=bundles)" << std::endl
         << std::endl;
 
     return -1;
@@ -561,4 +568,33 @@ purge( osg::ArgumentParser& args )
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+
+int
+compact( osg::ArgumentParser& args )
+{
+    osg::ref_ptr<osg::Node> node = osgDB::readNodeFiles( args );
+    if ( !node.valid() )
+        return usage( "Failed to read .earth file." );
+
+    MapNode* mapNode = MapNode::findMapNode( node.get() );
+    if ( !mapNode )
+        return usage( "Input file was not a .earth file" );
+
+    Map* map = mapNode->getMap();
+
+    if ( !map->getCache() )
+        return message( "Earth file does not contain a cache." );
+
+    std::cout << "Compacting.." << std::flush;
+
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    bool ok = map->getCache()->compact();
+    double seconds = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+
+    std::cout << (ok ? " done" : " FAILED (the cache may not support compaction)")
+        << " (" << seconds << "s)" << std::endl;
+
+    return ok ? 0 : -1;
+}
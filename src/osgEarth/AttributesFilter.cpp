@@ -96,3 +96,33 @@ AttributesFilter::push(FeatureList& input, FilterContext& context)
 
     return context;
 }
+
+FilterContext
+AttributesFilter::push(FeatureBatch& input, FilterContext& context)
+{
+    // Look each attribute up once, then test rows by index
+    std::vector<const FeatureBatch::Column*> columns;
+    for (auto& a : _attributes)
+    {
+        auto column = input.getColumn(a);
+        if (column)
+            columns.push_back(column);
+    }
+
+    std::vector<unsigned> rows;
+    rows.reserve(input.size());
+    for (unsigned row = 0; row < input.size(); ++row)
+    {
+        for (auto column : columns)
+        {
+            if (column->has(row))
+            {
+                rows.push_back(row);
+                break;
+            }
+        }
+    }
+    input.retain(rows);
+
+    return context;
+}
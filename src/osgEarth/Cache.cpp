@@ -170,6 +170,39 @@ namespace
     }
 }
 
+void
+Cache::readMany(std::vector<BinRead>& reads, const osgDB::Options* dbo)
+{
+    // group the requests by bin and record type, preserving their order
+    std::vector<bool> done(reads.size(), false);
+
+    for (unsigned i = 0; i < reads.size(); ++i)
+    {
+        if (done[i] || reads[i].bin == nullptr)
+            continue;
+
+        std::vector<unsigned> indices;
+        std::vector<std::string> keys;
+
+        for (unsigned j = i; j < reads.size(); ++j)
+        {
+            if (!done[j] && reads[j].bin == reads[i].bin && reads[j].image == reads[i].image)
+            {
+                indices.push_back(j);
+                keys.push_back(reads[j].key);
+                done[j] = true;
+            }
+        }
+
+        std::vector<ReadResult> results = reads[i].bin->readMany(keys, reads[i].image, dbo);
+
+        for (unsigned k = 0; k < indices.size() && k < results.size(); ++k)
+        {
+            reads[indices[k]].result = results[k];
+        }
+    }
+}
+
 std::string
 Cache::makeCacheKey(const std::string& key, const std::string& prefix)
 {
@@ -274,6 +274,40 @@ CacheBin::writeNode(const std::string&    key,
     return true;
 }
 
+std::vector<ReadResult>
+CacheBin::readMany(const std::vector<std::string>& keys,
+                   bool                            images,
+                   const osgDB::Options*           readOptions)
+{
+    std::vector<ReadResult> results;
+    results.reserve(keys.size());
+
+    for (auto& key : keys)
+    {
+        if (images)
+            results.push_back(readImage(key, readOptions));
+        else
+            results.push_back(readObject(key, readOptions));
+    }
+
+    return results;
+}
+
+bool
+CacheBin::writeMany(const std::vector<WriteRecord>& records,
+                    const osgDB::Options*           writeOptions)
+{
+    bool ok = true;
+
+    for (auto& record : records)
+    {
+        if (!write(record.key, record.object.get(), record.metadata, writeOptions))
+            ok = false;
+    }
+
+    return ok;
+}
+
 
 #undef  LC
 #define LC "[ReadImageFromCachePseudoLoader] "
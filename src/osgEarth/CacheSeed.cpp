@@ -68,6 +68,28 @@ bool CacheTileHandler::handleTile(const TileKey& key, const TileVisitor& tv)
     return false;        
 }   
 
+std::vector<bool> CacheTileHandler::handleTiles(const std::vector<TileKey>& keys, const TileVisitor& tv)
+{
+    ImageLayer* imageLayer = dynamic_cast< ImageLayer* >( _layer.get() );
+
+    // Elevation layers cache one key at a time.
+    if (!imageLayer)
+    {
+        return TileHandler::handleTiles(keys, tv);
+    }
+
+    // Create the images together so the cache reads and writes go out in batches.
+    std::vector<GeoImage> images = imageLayer->createImages(keys, nullptr);
+
+    std::vector<bool> results(keys.size(), false);
+    for (unsigned i = 0; i < keys.size(); ++i)
+    {
+        // As in handleTile, keep traversing out-of-range keys b/c a min level was set.
+        results[i] = images[i].valid() || !_layer->isKeyInLegalRange(keys[i]);
+    }
+    return results;
+}
+
 bool CacheTileHandler::hasData( const TileKey& key ) const
 {
     return _layer->mayHaveData(key);
@@ -97,6 +119,91 @@ std::string CacheTileHandler::getProcessString() const
 
 
 
+/***************************************************************************************/
+
+CacheMergeTileHandler::CacheMergeTileHandler(TileLayer* layer, const Map* map, const std::vector<osg::ref_ptr<Cache> >& sources) :
+    _layer(layer),
+    _map(map),
+    _merged(0u)
+{
+    for (auto& cache : sources)
+    {
+        CacheBin* bin = cache.valid() ? cache->addBin(layer->getCacheID()) : nullptr;
+        if (bin)
+            _sources.push_back(bin);
+    }
+}
+
+osg::ref_ptr<osg::Object> CacheMergeTileHandler::read(const TileKey& key, unsigned& source) const
+{
+    bool isImage = dynamic_cast<ImageLayer*>(_layer.get()) != nullptr;
+    std::string cacheKey = _layer->getCacheKey(key);
+
+    // Start with the source that had the last tile; neighbors usually
+    // come from the same one.
+    for (unsigned i = 0; i < _sources.size(); ++i)
+    {
+        unsigned s = (source + i) % _sources.size();
+        ReadResult rr = isImage ?
+            _sources[s]->readImage(cacheKey, nullptr) :
+            _sources[s]->readObject(cacheKey, nullptr);
+
+        if (rr.succeeded())
+        {
+            source = s;
+            return rr.getObject();
+        }
+    }
+    return nullptr;
+}
+
+bool CacheMergeTileHandler::write(const TileKey& key, const osg::Object* object)
+{
+    CacheBin* bin = _layer->getCacheBin(key.getProfile());
+    if (bin && bin->write(_layer->getCacheKey(key), object, Config(), nullptr))
+    {
+        ++_merged;
+        return true;
+    }
+    return false;
+}
+
+bool CacheMergeTileHandler::handleTile(const TileKey& key, const TileVisitor& tv)
+{
+    unsigned source = 0;
+    osg::ref_ptr<osg::Object> object = read(key, source);
+    if (object.valid())
+        write(key, object.get());
+
+    // Always traverse the children; a source may have them even if not the parent.
+    return true;
+}
+
+std::vector<TileHandler::TileData> CacheMergeTileHandler::readTiles(const std::vector<TileKey>& keys, const TileVisitor& tv)
+{
+    std::vector<TileData> data(keys.size());
+    unsigned source = 0;
+    for (unsigned i = 0; i < keys.size(); ++i)
+    {
+        data[i] = read(keys[i], source).get();
+    }
+    return data;
+}
+
+void CacheMergeTileHandler::writeTiles(const std::vector<TileKey>& keys, const std::vector<TileData>& data, const TileVisitor& tv)
+{
+    for (unsigned i = 0; i < keys.size(); ++i)
+    {
+        if (data[i].valid())
+            write(keys[i], static_cast<const osg::Object*>(data[i].get()));
+    }
+}
+
+bool CacheMergeTileHandler::hasData(const TileKey& key) const
+{
+    return _layer->mayHaveData(key);
+}
+
 /***************************************************************************************/
 
 CacheSeed::CacheSeed():
@@ -118,4 +225,12 @@ void CacheSeed::run( TileLayer* layer, const Map* map )
 {
     _visitor->setTileHandler( new CacheTileHandler( layer, map ) );
     _visitor->run( map->getProfile() );
+}
+
+unsigned CacheSeed::merge( TileLayer* layer, const Map* map, const std::vector<osg::ref_ptr<Cache> >& sources )
+{
+    osg::ref_ptr<CacheMergeTileHandler> handler = new CacheMergeTileHandler( layer, map, sources );
+    _visitor->setTileHandler( handler.get() );
+    _visitor->run( map->getProfile() );
+    return handler->getNumTilesMerged();
 }
\ No newline at end of file
@@ -227,6 +227,96 @@ ElevationTexture::generateNormalMap(
 #define LC "[NormalMapGenerator] "
 
 #if 1
+
+namespace
+{
+    // Widest stencil (in texels) the padded-grid path will handle. Tiles
+    // whose data is upsampled more than this from a lower LOD fall back
+    // on per-texel sampling, since the border would get too expensive.
+    constexpr int MAX_STENCIL_STRIDE = 16;
+
+    osg::Texture2D* makeNormalMapTexture(osg::Image* image)
+    {
+        osg::Texture2D* normalTex = new osg::Texture2D(image);
+
+        normalTex->setInternalFormat(GL_RG8);
+        normalTex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        normalTex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR_MIPMAP_LINEAR);
+        normalTex->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        normalTex->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        normalTex->setResizeNonPowerOfTwoHint(false);
+        normalTex->setMaxAnisotropy(1.0f);
+        normalTex->setUnRefImageDataAfterApply(Registry::instance()->unRefImageDataAfterApply().get());
+        ImageUtils::mipmapImageInPlace(image);
+
+        return normalTex;
+    }
+}
+
+void
+NormalMapGenerator::computeNormals(
+    const float* heights,
+    int pitch,
+    int count,
+    int stride,
+    float dx,
+    float dy,
+    GLubyte* out,
+    GLubyte* ruggedness)
+{
+    const float* west = heights - stride;
+    const float* east = heights + stride;
+    const float* south = heights - stride * pitch;
+    const float* north = heights + stride * pitch;
+
+    // The normal is (a1-a0)^(a3-a2) for the four stencil vectors
+    // a0=(-dx,0,W), a1=(dx,0,E), a2=(0,-dy,S), a3=(0,dy,N). Z is always
+    // positive, so octohedral packing never has to fold, and the packing
+    // divides out the length so there is no need to normalize first.
+    // Keep this loop free of branches so the compiler can vectorize it.
+    const float nz = 4.0f * dx * dy;
+
+    for (int i = 0; i < count; ++i)
+    {
+        float W = west[i], E = east[i], S = south[i], N = north[i];
+
+        bool valid =
+            (W != NO_DATA_VALUE) & (E != NO_DATA_VALUE) &
+            (S != NO_DATA_VALUE) & (N != NO_DATA_VALUE);
+
+        float nx = -2.0f * dy * (E - W);
+        float ny = -2.0f * dx * (N - S);
+
+        // zeroing the numerator gives invalid texels the packed (0,0,1) normal.
+        // (keep both arms constant; a conditional divide won't vectorize.)
+        float d = (valid ? 1.0f : 0.0f) / (fabsf(nx) + fabsf(ny) + nz);
+
+        out[2 * i + 0] = (GLubyte)(0.5f * (nx * d + 1.0f) * 255.0f);
+        out[2 * i + 1] = (GLubyte)(0.5f * (ny * d + 1.0f) * 255.0f);
+    }
+
+    if (ruggedness)
+    {
+        // rudimentary normalized ruggedness index
+        const float invdy = 1.0f / dy;
+
+        for (int i = 0; i < count; ++i)
+        {
+            float W = west[i], E = east[i], S = south[i], N = north[i];
+
+            bool valid =
+                (W != NO_DATA_VALUE) & (E != NO_DATA_VALUE) &
+                (S != NO_DATA_VALUE) & (N != NO_DATA_VALUE);
+
+            float ri = 0.25f * (fabsf(W - N) + fabsf(E - W) + fabsf(S - E) + fabsf(N - S));
+            ri = clamp(ri * invdy, 0.0f, 1.0f);
+            ri = harden(harden(ri)) * (valid ? 1.0f : 0.0f);
+
+            ruggedness[i] = (GLubyte)(ri * 255.0f);
+        }
+    }
+}
+
 osg::Texture2D*
 NormalMapGenerator::createNormalMap(
     const TileKey& key,
@@ -242,6 +332,215 @@ NormalMapGenerator::createNormalMap(
 
     ElevationPool::WorkingSet* workingSet = static_cast<ElevationPool::WorkingSet*>(ws);
 
+    ElevationPool* pool = map->getElevationPool();
+
+    // fetch the base tile once; it supplies the interior heights
+    // (when it's a native tile) and the per-texel resolutions.
+    osg::ref_ptr<ElevationTexture> heights;
+    pool->getTile(key, true, heights, workingSet, progress);
+
+    if (!heights.valid())
+        return NULL;
+
+    const int size = ELEVATION_TILE_SIZE;
+
+    if (heights->getResolutions().size() != (std::size_t)(size * size))
+    {
+        return createNormalMapFromSamples(key, map, ws, ruggedness, progress);
+    }
+
+    const GeoExtent& ex = key.getExtent();
+    const double hx = ex.width() / (double)(size - 1);
+    const double hy = ex.height() / (double)(size - 1);
+
+    // Stencil half-width of each texel, in texels. It follows the resolution
+    // of the data under the texel, so it widens where the data came from a
+    // lower LOD. Zero marks a texel with no data.
+    std::vector<int> strides(size * size);
+    int border = 1;
+    for (int i = 0; i < size * size; ++i)
+    {
+        float r = heights->getResolutions()[i];
+        if (r == FLT_MAX)
+        {
+            strides[i] = 0;
+        }
+        else
+        {
+            strides[i] = std::max(1, (int)(r / hy + 0.5));
+            border = std::max(border, strides[i]);
+        }
+    }
+
+    if (border > MAX_STENCIL_STRIDE)
+    {
+        return createNormalMapFromSamples(key, map, ws, ruggedness, progress);
+    }
+
+    // Padded height grid: the tile plus "border" texels on every side,
+    // so the stencil can run straight across the tile edges.
+    const int pitch = size + 2 * border;
+    std::vector<float> grid(pitch * pitch, NO_DATA_VALUE);
+    float* origin = &grid[border * pitch + border];
+
+    // Copy the interior straight out of the heightfield if we have it
+    // at this LOD. Otherwise it was upsampled from a parent, and we sample it.
+    const osg::HeightField* hf = heights->getHeightField();
+    bool haveInterior =
+        heights->getTileKey() == key &&
+        hf != nullptr &&
+        hf->getNumColumns() == (unsigned)size &&
+        hf->getNumRows() == (unsigned)size;
+
+    if (haveInterior)
+    {
+        const float* src = hf->getHeightList().data();
+        for (int t = 0; t < size; ++t)
+        {
+            memcpy(origin + t * pitch, src + t * size, sizeof(float) * size);
+        }
+    }
+
+    // Collect the samples we still need: always the border ring,
+    // and the interior if we couldn't copy it.
+    std::vector<osg::Vec4d> points;
+    std::vector<int> offsets;
+    points.reserve(haveInterior ? 4 * border * (pitch - border) : pitch * pitch);
+    offsets.reserve(points.capacity());
+
+    for (int j = -border; j < size + border; ++j)
+    {
+        bool insideRow = j >= 0 && j < size;
+        double y = ex.yMin() + (double)j * hy;
+
+        for (int i = -border; i < size + border; ++i)
+        {
+            if (haveInterior && insideRow && i == 0)
+            {
+                i = size - 1;
+                continue;
+            }
+
+            // sample at the resolution of the nearest texel in the tile
+            float r = heights->getResolution(
+                osg::clampBetween(i, 0, size - 1),
+                osg::clampBetween(j, 0, size - 1));
+
+            points.emplace_back(
+                ex.xMin() + (double)i * hx,
+                y,
+                0.0,
+                r != FLT_MAX ? r : hy);
+
+            offsets.push_back((j + border) * pitch + (i + border));
+        }
+    }
+
+    int sampleOK = pool->sampleMapCoords(
+        points.begin(), points.end(),
+        workingSet,
+        progress);
+
+    if (progress && progress->isCanceled())
+    {
+        // canceled. Bail.
+        return NULL;
+    }
+
+    if (sampleOK < 0)
+    {
+        OE_WARN << LC << "Internal error - contact support" << std::endl;
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < points.size(); ++i)
+    {
+        grid[offsets[i]] = (float)points[i].z();
+    }
+
+    osg::ref_ptr<osg::Image> image = new osg::Image();
+    image->allocateImage(size, size, 1, GL_RG, GL_UNSIGNED_BYTE);
+    image->setInternalTextureFormat(GL_RG8);
+
+    // we write the ruggedness bytes directly, so only use it if
+    // it's in the format ElevationTexture allocates.
+    GLubyte* ruggedData = nullptr;
+    if (ruggedness &&
+        ruggedness->getPixelFormat() == GL_RED &&
+        ruggedness->getDataType() == GL_UNSIGNED_BYTE &&
+        ruggedness->s() == size && ruggedness->t() == size)
+    {
+        ruggedData = ruggedness->data();
+    }
+
+    // value to write where there is no data at all
+    osg::Vec4 up;
+    NormalMapGenerator::pack(osg::Vec3(0, 0, 1), up);
+    const GLubyte upx = (GLubyte)(up.x() * 255.0f), upy = (GLubyte)(up.y() * 255.0f);
+
+    const osgEarth::Units& units = key.getProfile()->getSRS()->getUnits();
+
+    for (int t = 0; t < size; ++t)
+    {
+        double y_or_lat = ex.yMin() + (double)t * hy;
+        GLubyte* out = image->data(0, t);
+        const int* k = &strides[t * size];
+
+        // run the stencil over each span of texels that share a stencil width;
+        // there is usually just one per row.
+        for (int s = 0; s < size; )
+        {
+            int e = s + 1;
+            while (e < size && k[e] == k[s])
+                ++e;
+
+            if (k[s] == 0)
+            {
+                for (int i = s; i < e; ++i)
+                {
+                    out[2 * i + 0] = upx;
+                    out[2 * i + 1] = upy;
+                    if (ruggedData)
+                        ruggedData[t * size + i] = 0;
+                }
+            }
+            else
+            {
+                float dx = (float)Distance(k[s] * hx, units).asDistance(Units::METERS, y_or_lat);
+                float dy = (float)Distance(k[s] * hy, units).asDistance(Units::METERS, 0.0);
+
+                computeNormals(
+                    origin + t * pitch + s,
+                    pitch,
+                    e - s,
+                    k[s],
+                    dx, dy,
+                    out + 2 * s,
+                    ruggedData ? ruggedData + t * size + s : nullptr);
+            }
+
+            s = e;
+        }
+    }
+
+    return makeNormalMapTexture(image.get());
+}
+
+osg::Texture2D*
+NormalMapGenerator::createNormalMapFromSamples(
+    const TileKey& key,
+    const Map* map,
+    void* ws,
+    osg::Image* ruggedness,
+    ProgressCallback* progress)
+{
+    if (!map)
+        return NULL;
+
+    OE_PROFILING_ZONE;
+
+    ElevationPool::WorkingSet* workingSet = static_cast<ElevationPool::WorkingSet*>(ws);
+
     osg::ref_ptr<osg::Image> image = new osg::Image();
     image->allocateImage(ELEVATION_TILE_SIZE, ELEVATION_TILE_SIZE, 1, GL_RG, GL_UNSIGNED_BYTE);
     image->setInternalTextureFormat(GL_RG8);
@@ -388,19 +687,7 @@ NormalMapGenerator::createNormalMap(
         }
     }
 
-    osg::Texture2D* normalTex = new osg::Texture2D(image.get());
-
-    normalTex->setInternalFormat(GL_RG8);
-    normalTex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
-    normalTex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR_MIPMAP_LINEAR);
-    normalTex->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
-    normalTex->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
-    normalTex->setResizeNonPowerOfTwoHint(false);
-    normalTex->setMaxAnisotropy(1.0f);
-    normalTex->setUnRefImageDataAfterApply(Registry::instance()->unRefImageDataAfterApply().get());
-    ImageUtils::mipmapImageInPlace(image.get());
-
-    return normalTex;
+    return makeNormalMapTexture(image.get());
 }
 #else
 
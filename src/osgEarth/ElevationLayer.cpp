@@ -402,7 +402,7 @@ ElevationLayer::createHeightFieldInKeyProfile(const TileKey& key, ProgressCallba
 
     // cache key combines the key with the full signature (incl vdatum)
     // the cache key combines the Key and the horizontal profile.
-    auto cacheKey = Cache::makeCacheKey(key.str() + "-" + key.getProfile()->getHorizSignature(), "elevation");
+    auto cacheKey = getCacheKey(key);
     std::string memCacheKey;
 
     // see if there's a persistent cache.
@@ -587,6 +587,13 @@ ElevationLayer::createHeightFieldInKeyProfile(const TileKey& key, ProgressCallba
     return result;
 }
 
+std::string
+ElevationLayer::getCacheKey(const TileKey& key) const
+{
+    // the cache key combines the Key and the horizontal profile.
+    return Cache::makeCacheKey(key.str() + "-" + key.getProfile()->getHorizSignature(), "elevation");
+}
+
 Status
 ElevationLayer::writeHeightField(const TileKey& key, const osg::HeightField* hf, ProgressCallback* progress) const
 {
@@ -680,13 +687,189 @@ namespace
     {
         LayerDataVector contenders;
         LayerDataVector offsets;
+    };
+
+    // Samples one layer's heightfield at the posts of the output tile, a
+    // whole row at a time. GeoHeightField::getElevation repeats the SRS
+    // check, extent test, and pixel mapping for every sample; here they are
+    // worked out once per column and once per row. Results match
+    // getElevation() sample for sample.
+    class RowSampler
+    {
+    public:
+        RowSampler(
+            const GeoHeightField& source,
+            const SpatialReference* srs,
+            RasterInterpolation interpolation,
+            double xmin, double dx, unsigned numColumns,
+            double ymin, double dy) :
+
+            _source(source),
+            _hf(source.getHeightField()),
+            _srs(srs),
+            _interp(interpolation),
+            _xmin(xmin), _dx(dx), _numColumns(numColumns),
+            _ymin(ymin), _dy(dy),
+            _identityColumns(false)
+        {
+            const SpatialReference* sourceSRS = source.getExtent().getSRS();
 
-        GeoHeightFieldVector heightFields;
-        std::vector<TileKey> heightFieldActualKeys;
-        GeoHeightFieldVector offsetFields;
-        std::vector<bool>  heightFallback;
-        std::vector<bool>  heightFailed;
-        std::vector<bool>  offsetFailed;
+            // We can only map pixels directly if no reprojection or vertical
+            // datum shift is involved; otherwise sample one point at a time.
+            _direct =
+                _hf->getNumColumns() > 1 && _hf->getNumRows() > 1 &&
+                (sourceSRS == srs || (sourceSRS && sourceSRS->isEquivalentTo(srs)));
+
+            if (!_direct)
+                return;
+
+            const GeoExtent& ex = source.getExtent();
+            const int cols = _hf->getNumColumns();
+            const double xInterval = ex.width() / (double)(cols - 1);
+            const double ycenter = 0.5 * (ex.yMin() + ex.yMax());
+
+            _px.resize(numColumns);
+            _inside.resize(numColumns);
+            _c0.resize(numColumns);
+            _c1.resize(numColumns);
+            _wx0.resize(numColumns);
+            _wx1.resize(numColumns);
+
+            _identityColumns = (numColumns == (unsigned)cols);
+
+            for (unsigned c = 0; c < numColumns; ++c)
+            {
+                double x = _xmin + (_dx * (double)c);
+
+                // GeoExtent::contains tests X and Y separately,
+                // so we can split the test into a column and a row part.
+                _inside[c] = ex.contains(x, ycenter) ? 1 : 0;
+
+                double px = osg::clampBetween((x - ex.xMin()) / xInterval, 0.0, (double)(cols - 1));
+                _px[c] = px;
+
+                // Bilinear weights. Where a sample falls right on a post, point both
+                // corners at that post so we validate and blend exactly the same
+                // samples as HeightFieldUtils::getHeightAtPixel.
+                int c0 = std::min(std::max((int)floor(px), 0), cols - 2);
+                int c1 = c0 + 1;
+                _wx0[c] = (double)c1 - px;
+                _wx1[c] = px - (double)c0;
+                if (_wx1[c] == 0.0) c1 = c0;
+                if (_wx0[c] == 0.0) c0 = c1;
+                _c0[c] = c0;
+                _c1[c] = c1;
+
+                if (c0 != (int)c || c1 != (int)c)
+                    _identityColumns = false;
+            }
+        }
+
+        //! Samples output row "r" into "out", writing NO_DATA_VALUE
+        //! wherever the source has nothing to offer.
+        void sampleRow(unsigned r, float* out) const
+        {
+            double y = _ymin + (_dy * (double)r);
+
+            if (!_direct)
+            {
+                for (unsigned c = 0; c < _numColumns; ++c)
+                {
+                    double x = _xmin + (_dx * (double)c);
+                    float elevation;
+                    if (!_source.getElevation(_srs, x, y, _interp, _srs, elevation))
+                        elevation = NO_DATA_VALUE;
+                    out[c] = elevation;
+                }
+                return;
+            }
+
+            const GeoExtent& ex = _source.getExtent();
+            const int rows = _hf->getNumRows();
+
+            if (!ex.contains(0.5 * (ex.xMin() + ex.xMax()), y))
+            {
+                std::fill(out, out + _numColumns, NO_DATA_VALUE);
+                return;
+            }
+
+            const double yInterval = ex.height() / (double)(rows - 1);
+            const double py = osg::clampBetween((y - ex.yMin()) / yInterval, 0.0, (double)(rows - 1));
+
+            if (_interp != INTERP_BILINEAR)
+            {
+                for (unsigned c = 0; c < _numColumns; ++c)
+                {
+                    out[c] = _inside[c] ?
+                        HeightFieldUtils::getHeightAtPixel(_hf, _px[c], py, _interp) :
+                        NO_DATA_VALUE;
+                }
+                return;
+            }
+
+            int r0 = std::min(std::max((int)floor(py), 0), rows - 2);
+            int r1 = r0 + 1;
+            const double wy0 = (double)r1 - py;
+            const double wy1 = py - (double)r0;
+            if (wy1 == 0.0) r1 = r0;
+            if (wy0 == 0.0) r0 = r1;
+
+            const float* heights = _hf->getFloatArray()->asVector().data();
+            const float* lo = heights + r0 * _hf->getNumColumns();
+            const float* hi = heights + r1 * _hf->getNumColumns();
+
+            // posts line up exactly with the source grid: straight copy
+            if (_identityColumns && r0 == r1)
+            {
+                for (unsigned c = 0; c < _numColumns; ++c)
+                {
+                    out[c] = _inside[c] ? lo[c] : NO_DATA_VALUE;
+                }
+                return;
+            }
+
+            // Bilinear blend, kept free of branches. As in
+            // HeightFieldUtils::validateSamples, missing corners take the
+            // value of the first valid one; if there are none, no data.
+            for (unsigned c = 0; c < _numColumns; ++c)
+            {
+                float ll = lo[_c0[c]], lr = lo[_c1[c]];
+                float ul = hi[_c0[c]], ur = hi[_c1[c]];
+
+                bool vur = ur != NO_DATA_VALUE, vll = ll != NO_DATA_VALUE;
+                bool vul = ul != NO_DATA_VALUE, vlr = lr != NO_DATA_VALUE;
+
+                float first = vur ? ur : vll ? ll : vul ? ul : lr;
+                ur = vur ? ur : first;
+                ll = vll ? ll : first;
+                ul = vul ? ul : first;
+                lr = vlr ? lr : first;
+
+                double r1 = _wx0[c] * (double)ll + _wx1[c] * (double)lr;
+                double r2 = _wx0[c] * (double)ul + _wx1[c] * (double)ur;
+                float result = (float)(wy0 * r1 + wy1 * r2);
+
+                bool valid = _inside[c] && (vur | vll | vul | vlr);
+                out[c] = valid ? result : NO_DATA_VALUE;
+            }
+        }
+
+    private:
+        const GeoHeightField& _source;
+        const osg::HeightField* _hf;
+        const SpatialReference* _srs;
+        RasterInterpolation _interp;
+        double _xmin, _dx;
+        unsigned _numColumns;
+        double _ymin, _dy;
+        bool _direct;
+        bool _identityColumns;
+
+        // per-column pixel mapping
+        std::vector<double> _px;
+        std::vector<char> _inside;
+        std::vector<int> _c0, _c1;
+        std::vector<double> _wx0, _wx1;
     };
     //thread_local Workspace s_per_thread_workspace;
 }
@@ -843,10 +1026,6 @@ ElevationLayerVector::populateHeightField(
 
     unsigned int total = numColumns * numRows;
 
-    int nodataCount = 0;
-
-    TileKey actualKey; // Storage if a new key needs to be constructed
-
     bool requiresResample = true;
 
     // If we only have a single contender layer, and the tile is the same size as the requested
@@ -880,198 +1059,180 @@ ElevationLayerVector::populateHeightField(
         }
     }
 
-    // If we need to mosaic multiple layers or resample it to a new output tilesize go through a resampling loop.
+    // If we need to mosaic multiple layers or resample it to a new output tilesize,
+    // composite the layers one at a time over the whole tile. Each contender only
+    // fills in the posts that the higher-priority layers left empty, so once every
+    // post is resolved we never touch (or even load) the layers underneath.
     if (requiresResample)
     {
-        // We will load the actual heightfields on demand. We might not need them all.
-        w.heightFields.assign(w.contenders.size(), {});
-        w.heightFieldActualKeys.assign(w.contenders.size(), {});
-        w.offsetFields.assign(w.offsets.size(), {});
-        w.heightFallback.assign(w.contenders.size(), false);
-        w.heightFailed.assign(w.contenders.size(), false);
-        w.offsetFailed.assign(w.offsets.size(), false);
-
-        // Initialize the actual keys to match the contender keys.
-        // We'll adjust these as necessary if we need to fall back
-        for(unsigned i=0; i< w.contenders.size(); ++i)
-        {
-            w.heightFieldActualKeys[i] = w.contenders[i].key;
-        }
+        float* heights = hf->getFloatArray()->asVector().data();
+
+        // index of the layer that supplied each post, or -1
+        std::vector<int> resolvedIndex(total, -1);
+        unsigned numUnresolved = total;
 
-        // The maximum number of heightfields to keep in this local cache
-        const unsigned maxHeightFields = 50;
-        unsigned numHeightFieldsInCache = 0;
+        std::vector<float> sampleResolutions(total, FLT_MAX);
+        std::vector<float> row(numColumns);
 
-        for (unsigned c = 0; c < numColumns; ++c)
+        for (unsigned i = 0; i < w.contenders.size() && numUnresolved > 0; ++i)
         {
-            double x = xmin + (dx * (double)c);
+            ElevationLayer* layer = w.contenders[i].layer.get();
+            const TileKey& contenderKey = w.contenders[i].key;
+            int index = w.contenders[i].index;
+
+            // Fall back on parent keys to make sure that we have data
+            // at the location even if it's fallback.
+            TileKey actualKey = contenderKey;
+            GeoHeightField layerHF;
+            while (!layerHF.valid() && actualKey.valid() && layer->isKeyInLegalRange(actualKey))
+            {
+                layerHF = layer->createHeightField(actualKey, progress);
+                if (!layerHF.valid())
+                {
+                    actualKey.makeParent();
+                }
+            }
 
-            // periodically check for cancelation
             if (progress && progress->isCanceled())
             {
                 return false;
             }
 
-            for (unsigned r = 0; r < numRows; ++r)
+            if (!layerHF.valid())
             {
-                double y = ymin + (dy * (double)r);
-
-                // Collect elevations from each layer as necessary.
-                int resolvedIndex = -1;
-
-                float resolution = FLT_MAX;
-
-                osg::Vec3 normal_sum(0, 0, 0);
+#ifdef ANALYZE
+                layerAnalysis[layer].failed = true;
+                layerAnalysis[layer].actualKeyValid = actualKey.valid();
+                if (progress) layerAnalysis[layer].message = progress->message();
+#endif
+                continue;
+            }
 
-                for (int i = 0; i < w.contenders.size() && resolvedIndex < 0; ++i)
-                {
-                    ElevationLayer* layer = w.contenders[i].layer.get();
-                    TileKey& contenderKey = w.contenders[i].key;
-                    int index = w.contenders[i].index;
+            //TODO: check this. Should it be actualKey != keyToUse...?
+            bool isFallback =
+                w.contenders[i].isFallback ||
+                (actualKey != contenderKey);
 
-                    if (w.heightFailed[i])
-                        continue;
+#ifdef ANALYZE
+            layerAnalysis[layer].fallback = isFallback;
+#endif
 
-                    GeoHeightField& layerHF = w.heightFields[i];
-                    TileKey& actualKey = w.heightFieldActualKeys[i];
+            // We only have real data if this is not a fallback heightfield.
+            if (!isFallback)
+            {
+                realData = true;
+            }
 
-                    if (!layerHF.valid())
-                    {
-                        // We couldn't get the heightfield from the cache, so try to create it.
-                        // We also fallback on parent layers to make sure that we have data at the location even if it's fallback.
-                        while (!layerHF.valid() && actualKey.valid() && layer->isKeyInLegalRange(actualKey))
-                        {
-                            layerHF = layer->createHeightField(actualKey, progress);
-                            if (!layerHF.valid())
-                            {
-                                actualKey.makeParent();
-                            }
-                        }
+            float layerResolution = actualKey.getResolution(numColumns).second;
 
-                        // Mark this layer as fallback if necessary.
-                        if (layerHF.valid())
-                        {
-                            //TODO: check this. Should it be actualKey != keyToUse...?
-                            w.heightFallback[i] =
-                                w.contenders[i].isFallback ||
-                                (actualKey != contenderKey);
+            RowSampler sampler(layerHF, keySRS, interpolation, xmin, dx, numColumns, ymin, dy);
 
-                            numHeightFieldsInCache++;
-                        }
-                        else
-                        {
-                            w.heightFailed[i] = true;
-#ifdef ANALYZE
-                            layerAnalysis[layer].failed = true;
-                            layerAnalysis[layer].actualKeyValid = actualKey->valid();
-                            if (progress) layerAnalysis[layer].message = progress->message();
-#endif
-                            continue;
-                        }
-                    }
+            for (unsigned r = 0; r < numRows && numUnresolved > 0; ++r)
+            {
+                // periodically check for cancelation
+                if (progress && progress->isCanceled())
+                {
+                    return false;
+                }
 
-                    if (layerHF.valid())
-                    {
-                        bool isFallback = w.heightFallback[i];
-#ifdef ANALYZE
-                        layerAnalysis[layer].fallback = isFallback;
-#endif
+                unsigned base = r * numColumns;
+                int* rowResolved = &resolvedIndex[base];
 
-                        // We only have real data if this is not a fallback heightfield.
-                        if (!isFallback)
-                        {
-                            realData = true;
-                        }
+                // skip rows that are already full
+                unsigned c = 0;
+                while (c < numColumns && rowResolved[c] >= 0)
+                    ++c;
+                if (c == numColumns)
+                    continue;
 
-                        float elevation;
-                        if (layerHF.getElevation(keySRS, x, y, interpolation, keySRS, elevation))
-                        {
-                            if (elevation != NO_DATA_VALUE)
-                            {
-                                // remember the index so we can only apply offset layers that
-                                // sit on TOP of this layer.
-                                resolvedIndex = index;
+                sampler.sampleRow(r, row.data());
 
-                                hf->setHeight(c, r, elevation);
+                float* rowHeights = heights + base;
+                float* rowRes = &sampleResolutions[base];
 
-                                resolution = actualKey.getResolution(hf->getNumColumns()).second;
+                for (; c < numColumns; ++c)
+                {
+                    if (rowResolved[c] < 0 && row[c] != NO_DATA_VALUE)
+                    {
+                        // remember the index so we can only apply offset layers that
+                        // sit on TOP of this layer.
+                        rowResolved[c] = index;
+                        rowHeights[c] = row[c];
+                        rowRes[c] = layerResolution;
+                        --numUnresolved;
 #ifdef ANALYZE
-                                layerAnalysis[layer].samples++;
+                        layerAnalysis[layer].samples++;
 #endif
-                            }
-                            else
-                            {
-                                ++nodataCount;
-                            }
-                        }
                     }
+                }
+            }
+        }
 
+        for (int i = w.offsets.size() - 1; i >= 0; --i)
+        {
+            if (progress && progress->isCanceled())
+                return false;
 
-                    // Clear the heightfield cache if we have too many heightfields in the cache.
-                    if (numHeightFieldsInCache >= maxHeightFields)
-                    {
-                        //OE_NOTICE << "Clearing cache" << std::endl;
-                        for (unsigned int k = 0; k < w.heightFields.size(); k++)
-                        {
-                            w.heightFields[k] = GeoHeightField::INVALID;
-                            w.heightFallback[k] = false;
-                        }
-                        numHeightFieldsInCache = 0;
-                    }
-                }
+            // Only apply an offset layer where it sits on top of the resolved layer
+            // (or where there was no resolved layer).
+            int offsetIndex = w.offsets[i].index;
+            bool applies = false;
+            for (unsigned k = 0; k < total && !applies; ++k)
+            {
+                applies = resolvedIndex[k] < 0 || offsetIndex >= resolvedIndex[k];
+            }
+            if (!applies)
+                continue;
 
-                for (int i = w.offsets.size() - 1; i >= 0; --i)
-                {
-                    if (progress && progress->isCanceled())
-                        return false;
+            const TileKey& contenderKey = w.offsets[i].key;
+            ElevationLayer* offset = w.offsets[i].layer.get();
 
-                    // Only apply an offset layer if it sits on top of the resolved layer
-                    // (or if there was no resolved layer).
-                    if (resolvedIndex >= 0 && w.offsets[i].index < resolvedIndex)
-                        continue;
+            GeoHeightField layerHF = offset->createHeightField(contenderKey, progress);
+            if (!layerHF.valid())
+                continue;
 
-                    TileKey& contenderKey = w.offsets[i].key;
+            // If we actually got a layer then we have real data
+            realData = true;
 
-                    if (w.offsetFailed[i] == true)
-                        continue;
+            float offsetResolution = contenderKey.getResolution(numColumns).second;
 
-                    GeoHeightField& layerHF = w.offsetFields[i];
-                    if (!layerHF.valid())
-                    {
-                        ElevationLayer* offset = w.offsets[i].layer.get();
+            RowSampler sampler(layerHF, keySRS, interpolation, xmin, dx, numColumns, ymin, dy);
 
-                        layerHF = offset->createHeightField(contenderKey, progress);
-                        if (!layerHF.valid())
-                        {
-                            w.offsetFailed[i] = true;
-                            continue;
-                        }
-                    }
+            for (unsigned r = 0; r < numRows; ++r)
+            {
+                if (progress && progress->isCanceled())
+                    return false;
 
-                    // If we actually got a layer then we have real data
-                    realData = true;
+                sampler.sampleRow(r, row.data());
 
-                    float elevation = 0.0f;
-                    if (layerHF.getElevation(keySRS, x, y, interpolation, keySRS, elevation) &&
-                        elevation != NO_DATA_VALUE &&
-                        !osg::equivalent(elevation, 0.0f) )
+                unsigned base = r * numColumns;
+                const int* rowResolved = &resolvedIndex[base];
+                float* rowHeights = heights + base;
+                float* rowRes = &sampleResolutions[base];
+
+                for (unsigned c = 0; c < numColumns; ++c)
+                {
+                    if ((rowResolved[c] < 0 || offsetIndex >= rowResolved[c]) &&
+                        row[c] != NO_DATA_VALUE &&
+                        !osg::equivalent(row[c], 0.0f))
                     {
-                        hf->getHeight(c, r) += elevation;
+                        rowHeights[c] += row[c];
 
                         // Technically this is correct, but the resultin normal maps
                         // look awful and faceted.
-                        resolution = std::min(
-                            resolution,
-                            (float)contenderKey.getResolution(hf->getNumColumns()).second);
+                        rowRes[c] = std::min(rowRes[c], offsetResolution);
                     }
                 }
-
-                if (resolutions)
-                {
-                    (*resolutions)[r*numColumns+c] = resolution;
-                }
             }
         }
+
+        if (resolutions)
+        {
+            std::copy(
+                sampleResolutions.begin(),
+                sampleResolutions.begin() + std::min(sampleResolutions.size(), resolutions->size()),
+                resolutions->begin());
+        }
     }
 
 #ifdef ANALYZE
@@ -211,7 +211,6 @@ ElevationPool::refresh(const Map* map)
 
     _L2.clear();
 
-    ScopedWriteLock lock(_globalLUTMutex);
     _globalLUT.clear();
 }
 
@@ -261,141 +260,84 @@ ElevationPool::WorkingSet::clear()
     // No need to clear the elevation layers; only invalidate the cache.
 }
 
-bool
-ElevationPool::findExistingRaster(
+osg::ref_ptr<ElevationTexture>
+ElevationPool::getOrCreateRaster(
     const Internal::RevElevationKey& key,
+    const Map* map,
+    bool acceptLowerRes,
     WorkingSet* ws,
-    osg::ref_ptr<ElevationTexture>& output,
-    bool* fromWS,
-    bool* fromL2,
-    bool* fromLUT)
+    ProgressCallback* progress)
 {
     OE_PROFILING_ZONE;
 
-    *fromWS = false;
-    *fromL2 = false;
-    *fromLUT = false;
-
-    // Next check the system LUT -- see if someone somewhere else
-    // already has it (the terrain or another WorkingSet)
-    optional<Internal::RevElevationKey> orphanedKey;
-    {
-        ScopedReadLock lock(_globalLUTMutex);
-
-        auto i = _globalLUT.find(key);
-        if (i != _globalLUT.end())
+    // Check the system LUT -- see if someone somewhere else already has it
+    // (the terrain or another WorkingSet) -- and build it if not. Threads
+    // that ask for the same key at the same time share a single build.
+    osg::ref_ptr<ElevationTexture> result = _globalLUT.getOrCreate(key, [&]()
         {
-            i->second.lock(output);
-            if (output.valid())
-            {
-                *fromLUT = true;
-            }
-            else
-            {
-                // observer was orphaned..remove it
-                orphanedKey = key;
-            }
-        }
-    }
+            osg::ref_ptr<ElevationTexture> raster;
 
-    if (orphanedKey.isSet())
-    {
-        ScopedWriteLock lock(_globalLUTMutex);
-        _globalLUT.erase(orphanedKey.get());
-    }
+            // need to build NEW data for this key
+            osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(
+                key._tilekey.getExtent(),
+                _tileSize, _tileSize,
+                false,      // no border
+                true);      // initialize to HAE (0.0) heights
 
-    // found it, so stick it in the L2 cache
-    if (output.valid())
-    {
-        //OE_DEBUG << LC << key._tilekey.str() << " - Cache hit (global LUT)" << std::endl;
-    }
+            std::vector<float> resolutions;
+            resolutions.assign(_tileSize * _tileSize, FLT_MAX);
 
-    return output.valid();
-}
+            TileKey keyToUse;
+            bool populated = false;
 
-osg::ref_ptr<ElevationTexture>
-ElevationPool::getOrCreateRaster(
-    const Internal::RevElevationKey& key,
-    const Map* map,
-    bool acceptLowerRes,
-    WorkingSet* ws,
-    ProgressCallback* progress)
-{
-    OE_PROFILING_ZONE;
+            const ElevationLayerVector& layersToSample =
+                ws && !ws->_elevationLayers.empty() ? ws->_elevationLayers :
+                _elevationLayers;
 
-    // first check for pre-existing data for this key:
-    osg::ref_ptr<ElevationTexture> result;
-    bool fromWS, fromL2, fromLUT;
+            for (keyToUse = key._tilekey;
+                keyToUse.valid();
+                keyToUse.makeParent())
+            {
+                populated = layersToSample.populateHeightField(
+                    hf.get(),
+                    &resolutions,
+                    keyToUse,
+                    map->getProfileNoVDatum(),
+                    map->getElevationInterpolation(),
+                    progress);
 
-    findExistingRaster(key, ws, result, &fromWS, &fromL2, &fromLUT);
+                if ((populated == true) ||
+                    (acceptLowerRes == false) ||
+                    (progress && progress->isCanceled()))
+                {
+                    break;
+                }
+            }
 
-    if (!result.valid())
-    {
-        // need to build NEW data for this key
-        osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(
-            key._tilekey.getExtent(),
-            _tileSize, _tileSize,
-            false,      // no border
-            true);      // initialize to HAE (0.0) heights
-
-        std::vector<float> resolutions;
-        resolutions.assign(_tileSize * _tileSize, FLT_MAX);
-
-        TileKey keyToUse;
-        bool populated = false;
-
-        const ElevationLayerVector& layersToSample =
-            ws && !ws->_elevationLayers.empty() ? ws->_elevationLayers :
-            _elevationLayers;
-
-        for (keyToUse = key._tilekey;
-            keyToUse.valid();
-            keyToUse.makeParent())
-        {
-            populated = layersToSample.populateHeightField(
-                hf.get(),
-                &resolutions,
-                keyToUse,
-                map->getProfileNoVDatum(),
-                map->getElevationInterpolation(),
-                progress);
-
-            if ((populated == true) ||
-                (acceptLowerRes == false) ||
-                (progress && progress->isCanceled()))
+            // check for cancelation/deferral
+            if (populated && !(progress && progress->isCanceled()))
             {
-                break;
+                raster = new ElevationTexture(
+                    keyToUse,
+                    GeoHeightField(hf.get(), keyToUse.getExtent()),
+                    resolutions);
             }
-        }
 
-        // check for cancelation/deferral
-        if (progress && progress->isCanceled())
-        {
-            return NULL;
-        }
+            return raster;
+        },
+        nullptr,
+        progress); // stop waiting on another thread's build if canceled
 
-        if (populated)
-        {
-            result = new ElevationTexture(
-                keyToUse,
-                GeoHeightField(hf.get(), keyToUse.getExtent()),
-                resolutions);
-        }
-        else
-        {
-            return NULL;
-        }
+    if (!result.valid())
+    {
+        return NULL;
     }
 
-    else
+    // if it's a lower res tile and we aren't accepting those, discard it.
+    if (acceptLowerRes == false &&
+        result->getTileKey() != key._tilekey)
     {
-        // found it ... but if it's a lower res tile and we aren't accepting
-        // those, discard it.
-        if (acceptLowerRes == false &&
-            result->getTileKey() != key._tilekey)
-        {
-            return NULL;
-        }
+        return NULL;
     }
 
     // update WorkingSet:
@@ -405,13 +347,6 @@ ElevationPool::getOrCreateRaster(
     // update the L2 cache:
     _L2.push(result);
 
-    // update system weak-LUT:
-    if (!fromLUT)
-    {
-        ScopedWriteLock lock(_globalLUTMutex);
-        _globalLUT[key] = result.get();
-    }
-
     return result;
 }
 
@@ -466,6 +401,188 @@ namespace
         a.BOT = a.LL * minusSmix + a.LR * smix;
         out = a.TOP * minusTmis + a.BOT * tmix;
     }
+
+    // Groups sample points by the elevation tile they fall in, so that
+    // each tile is fetched once and its points are sampled together.
+    struct TileBins
+    {
+        std::vector<int> binOfPoint; // -1 means the point isn't sampled
+        std::vector<Internal::RevElevationKey> keys;
+        std::unordered_map<Internal::RevElevationKey, int> lookup;
+        int last = -1;
+
+        void add(const Internal::RevElevationKey& key)
+        {
+            // consecutive points usually land in the same tile
+            if (last < 0 || keys[last] != key)
+            {
+                auto i = lookup.find(key);
+                if (i != lookup.end())
+                {
+                    last = i->second;
+                }
+                else
+                {
+                    last = (int)keys.size();
+                    keys.push_back(key);
+                    lookup.emplace(key, last);
+                }
+            }
+            binOfPoint.push_back(last);
+        }
+
+        void skip()
+        {
+            binOfPoint.push_back(-1);
+        }
+
+        // point indices sorted by bin; bin b owns order[offsets[b]..offsets[b+1])
+        void sortByBin(std::vector<unsigned>& order, std::vector<unsigned>& offsets) const
+        {
+            offsets.assign(keys.size() + 1, 0u);
+            for (int b : binOfPoint)
+                if (b >= 0)
+                    ++offsets[b + 1];
+            for (unsigned b = 0; b < keys.size(); ++b)
+                offsets[b + 1] += offsets[b];
+
+            order.resize(offsets.back());
+            std::vector<unsigned> next(offsets.begin(), offsets.end() - 1);
+            for (unsigned i = 0; i < binOfPoint.size(); ++i)
+                if (binOfPoint[i] >= 0)
+                    order[next[binOfPoint[i]]++] = i;
+        }
+    };
+
+    // Bilinear sampler over a single-channel float raster. Does the same
+    // arithmetic as quickSample() but reads the heights directly instead
+    // of going through the PixelReader for each of the four corners.
+    struct HeightSampler
+    {
+        const float* data = nullptr;
+        unsigned rowFloats = 0u;
+        double sizeS, sizeT;
+        double xmin, ymin, width, height;
+
+        HeightSampler(const ElevationTexture* raster)
+        {
+            const ImageUtils::PixelReader& reader = raster->reader();
+            if (reader._image &&
+                reader._image->getDataType() == GL_FLOAT &&
+                reader._colBytes == sizeof(float) &&
+                reader._rowBytes % sizeof(float) == 0)
+            {
+                data = reinterpret_cast<const float*>(reader.data());
+                rowFloats = reader._rowBytes / sizeof(float);
+            }
+            sizeS = (double)(reader.s() - 1);
+            sizeT = (double)(reader.t() - 1);
+            xmin = raster->getExtent().xMin();
+            ymin = raster->getExtent().yMin();
+            width = raster->getExtent().width();
+            height = raster->getExtent().height();
+        }
+
+        bool valid() const { return data != nullptr; }
+
+        inline float operator()(double x, double y) const
+        {
+            double u = (x - xmin) / width;
+            double v = (y - ymin) / height;
+            u = osg::clampBetween(u, 0.0, 1.0);
+            v = osg::clampBetween(v, 0.0, 1.0);
+
+            const double s = u * sizeS;
+            const double t = v * sizeT;
+
+            const double s0 = std::max(floor(s), 0.0);
+            const int intS0 = s0;
+            const double s1 = std::min(s0 + 1.0, sizeS);
+            const int intS1 = s1;
+            const double smix = s0 < s1 ? (s - s0) / (s1 - s0) : 0.0;
+
+            const double t0 = std::max(floor(t), 0.0);
+            const int intT0 = t0;
+            const double t1 = std::min(t0 + 1.0, sizeT);
+            const int intT1 = t1;
+            const double tmix = t0 < t1 ? (t - t0) / (t1 - t0) : 0.0;
+
+            const float* row0 = data + intT0 * rowFloats;
+            const float* row1 = data + intT1 * rowFloats;
+
+            // float weights, as in the osg::Vec4f math of quickSample
+            const float minusSmix = (float)(1.0 - smix), fsmix = (float)smix;
+            const float minusTmix = (float)(1.0 - tmix), ftmix = (float)tmix;
+
+            const float top = row0[intS0] * minusSmix + row0[intS1] * fsmix;
+            const float bot = row1[intS0] * minusSmix + row1[intS1] * fsmix;
+            return top * minusTmix + bot * ftmix;
+        }
+    };
+
+    // Samples every binned point from its bin's raster, one bin at a time.
+    // Returns the number of points that did not receive the fail value.
+    template<typename ITER>
+    int sampleBins(
+        ITER begin,
+        const TileBins& bins,
+        const std::vector<osg::ref_ptr<ElevationTexture>>& rasters,
+        float failValue,
+        ElevationPool::Envelope::QuickSampleVars& vars)
+    {
+        std::vector<unsigned> order, offsets;
+        bins.sortByBin(order, offsets);
+
+        int count = 0;
+        osg::Vec4f elev;
+
+        for (unsigned b = 0; b < bins.keys.size(); ++b)
+        {
+            const ElevationTexture* raster = rasters[b].get();
+            const unsigned* first = order.data() + offsets[b];
+            const unsigned* last = order.data() + offsets[b + 1];
+
+            if (raster == nullptr)
+            {
+                for (auto i = first; i != last; ++i)
+                {
+                    auto& p = *(begin + *i);
+                    p.z() = failValue;
+                }
+                continue;
+            }
+
+            HeightSampler sampler(raster);
+
+            if (sampler.valid())
+            {
+                for (auto i = first; i != last; ++i)
+                {
+                    auto& p = *(begin + *i);
+                    p.z() = sampler(p.x(), p.y());
+                    if (p.z() != failValue)
+                        ++count;
+                }
+            }
+            else
+            {
+                for (auto i = first; i != last; ++i)
+                {
+                    auto& p = *(begin + *i);
+                    double u = (p.x() - raster->getExtent().xMin()) / raster->getExtent().width();
+                    double v = (p.y() - raster->getExtent().yMin()) / raster->getExtent().height();
+                    u = osg::clampBetween(u, 0.0, 1.0);
+                    v = osg::clampBetween(v, 0.0, 1.0);
+                    quickSample(raster->reader(), u, v, elev, vars);
+                    p.z() = elev.r();
+                    if (p.z() != failValue)
+                        ++count;
+                }
+            }
+        }
+
+        return count;
+    }
 }
 
 bool
@@ -488,7 +605,6 @@ ElevationPool::prepareEnvelope(
 
     env._key._revision = getElevationHash(ws);
 
-    env._raster = nullptr;
     env._cache.clear();
 
     env._pw = env._profile->getExtent().width();
@@ -523,6 +639,96 @@ ElevationPool::prepareEnvelope(
     return true;
 }
 
+bool
+ElevationPool::getOrCreateRasters(
+    const std::vector<Internal::RevElevationKey>& keys,
+    std::vector<osg::ref_ptr<ElevationTexture>>& rasters,
+    Envelope::QuickCache& quickCache,
+    const Map* map,
+    WorkingSet* ws,
+    ProgressCallback* progress)
+{
+    OE_PROFILING_ZONE;
+
+    rasters.assign(keys.size(), nullptr);
+
+    std::vector<unsigned> missing;
+    for (unsigned i = 0; i < keys.size(); ++i)
+    {
+        auto iter = quickCache.find(keys[i]);
+        if (iter != quickCache.end())
+            rasters[i] = iter->second;
+        else
+            missing.push_back(i);
+    }
+
+    auto fetch = [&](unsigned i, ProgressCallback* fetchProgress)
+    {
+        rasters[i] = getOrCreateRaster(
+            keys[i],   // key to query
+            map,       // map to query
+            true,      // fall back on lower resolution data if necessary
+            ws,        // user's workingset
+            fetchProgress);
+    };
+
+    const unsigned numMissing = missing.size();
+
+    if (numMissing == 1)
+    {
+        fetch(missing[0], progress);
+    }
+    else if (numMissing > 1)
+    {
+        // Build the missing tiles in parallel. Only the calling thread
+        // passes the caller's callback down, since progress reports assume a
+        // single thread; the pool threads get a relay that only answers
+        // cancelation. Every thread checks for cancelation before each fetch.
+        auto canceled = std::make_shared<std::atomic_bool>(false);
+        const std::thread::id caller = std::this_thread::get_id();
+
+        jobs::parallel_for(jobs::get_pool("oe.elevationpool"), numMissing, 1u,
+            [&](std::size_t begin, std::size_t end)
+            {
+                const bool onCaller = (std::this_thread::get_id() == caller);
+
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    if (*canceled || (progress && progress->isCanceled()))
+                    {
+                        *canceled = true;
+                        return;
+                    }
+
+                    if (onCaller)
+                    {
+                        fetch(missing[i], progress);
+                    }
+                    else
+                    {
+                        osg::ref_ptr<ProgressCallback> relay = new ProgressCallback(
+                            progress, [canceled]() { return canceled->load(); });
+
+                        fetch(missing[i], relay.get());
+                    }
+                }
+            });
+    }
+
+    // bail on cancelation before using the quickcache
+    if (progress && progress->isCanceled())
+    {
+        return false;
+    }
+
+    for (auto i : missing)
+    {
+        quickCache[keys[i]] = rasters[i].get();
+    }
+
+    return true;
+}
+
 int
 ElevationPool::Envelope::sampleMapCoords(
     std::vector<osg::Vec3d>::iterator begin,
@@ -537,92 +743,49 @@ ElevationPool::Envelope::sampleMapCoords(
 
     ScopedReadLock lk(_pool->_mutex);
 
-    double u, v;
     double rx, ry;
     int tx, ty;
     int tx_prev = INT_MAX, ty_prev = INT_MAX;
-    float lastRes = -1.0f;
     int lod = _lod;
     int lod_prev = INT_MAX;
-    osg::Vec4f elev;
     int count = 0;
 
+    TileBins bins;
+    bins.binOfPoint.reserve(end - begin);
+
     for (auto iter = begin; iter != end; ++iter)
     {
         auto& p = *iter;
 
-        {
-            //OE_PROFILING_ZONE_NAMED("createTileKey");
-
-            rx = (p.x() - _pxmin) / _pw, ry = (p.y() - _pymin) / _ph;
-            tx = osg::clampBelow((unsigned)(rx * (double)_tw), _tw - 1u); // TODO: wrap around for geo
-            ty = osg::clampBelow((unsigned)((1.0 - ry) * (double)_th), _th - 1u);
+        rx = (p.x() - _pxmin) / _pw, ry = (p.y() - _pymin) / _ph;
+        tx = osg::clampBelow((unsigned)(rx * (double)_tw), _tw - 1u); // TODO: wrap around for geo
+        ty = osg::clampBelow((unsigned)((1.0 - ry) * (double)_th), _th - 1u);
 
-            if (lod != lod_prev || tx != tx_prev || ty != ty_prev)
-            {
-                _key._tilekey = TileKey(lod, tx, ty, _profile.get());
-                lod_prev = lod;
-                tx_prev = tx;
-                ty_prev = ty;
-            }
+        if (lod != lod_prev || tx != tx_prev || ty != ty_prev)
+        {
+            _key._tilekey = TileKey(lod, tx, ty, _profile.get());
+            lod_prev = lod;
+            tx_prev = tx;
+            ty_prev = ty;
         }
 
         if (_key._tilekey.valid())
         {
-            auto iter = _cache.find(_key);
-
-            if (iter == _cache.end())
-            {
-                _raster = _pool->getOrCreateRaster(
-                    _key,   // key to query
-                    _map.get(), // map to query
-                    true,  // fall back on lower resolution data if necessary
-                    _ws,    // user's workingset
-                    progress);
-
-                // bail on cancelation before using the quickcache
-                if (progress && progress->isCanceled())
-                {
-                    return -1;
-                }
-
-                _cache[_key] = _raster.get();
-            }
-            else
-            {
-                _raster = iter->second;
-            }
-
-            {
-                //OE_PROFILING_ZONE_NAMED("sample");
-                if (_raster.valid())
-                {
-                    u = (p.x() - _raster->getExtent().xMin()) / _raster->getExtent().width();
-                    v = (p.y() - _raster->getExtent().yMin()) / _raster->getExtent().height();
-
-                    // Note: This can happen on the map edges..
-                    // TODO: consider looping around for geo and clamping for projected
-                    u = osg::clampBetween(u, 0.0, 1.0);
-                    v = osg::clampBetween(v, 0.0, 1.0);
-
-                    quickSample(_raster->reader(), u, v, elev, _vars);
-                    p.z() = elev.r();
-                }
-                else
-                {
-                    p.z() = failValue;
-                }
-            }
+            bins.add(_key);
         }
         else
         {
+            bins.skip();
             p.z() = failValue;
         }
-
-        if (p.z() != failValue)
-            ++count;
     }
 
+    std::vector<osg::ref_ptr<ElevationTexture>> rasters;
+    if (!_pool->getOrCreateRasters(bins.keys, rasters, _cache, _map.get(), _ws, progress))
+        return -1;
+
+    count += sampleBins(begin, bins, rasters, failValue, _vars);
+
     return count;
 }
 
@@ -650,10 +813,6 @@ ElevationPool::sampleMapCoords(
     Internal::RevElevationKey key;
     key._revision = getElevationHash(ws);
 
-    osg::ref_ptr<ElevationTexture> raster;
-    osg::Vec4 elev;
-    double u, v;
-
     const Profile* profile = map->getProfile();
     double pw = profile->getExtent().width();
     double ph = profile->getExtent().height();
@@ -675,95 +834,58 @@ ElevationPool::sampleMapCoords(
     auto& units = map->getSRS()->getUnits();
     Distance pointRes(0.0, units);
 
+    TileBins bins;
+    bins.binOfPoint.reserve(end - begin);
+
     for (auto iter = begin; iter != end; ++iter)
     {
         auto& p = *iter;
 
         if (p.w() == FLT_MAX)
-            continue;
-
         {
-            //OE_PROFILING_ZONE_NAMED("createTileKey");            
+            bins.skip();
+            continue;
+        }
 
-            pointRes.set(p.w(), units);
+        pointRes.set(p.w(), units);
 
-            double resolutionInMapUnits = pointRes.asDistance(units, p.y());
+        double resolutionInMapUnits = pointRes.asDistance(units, p.y());
 
-            lod = profile->getLevelOfDetailForHorizResolution(
-                resolutionInMapUnits,
-                ELEVATION_TILE_SIZE);
+        lod = profile->getLevelOfDetailForHorizResolution(
+            resolutionInMapUnits,
+            ELEVATION_TILE_SIZE);
 
-            profile->getNumTiles(lod, tw, th);
+        profile->getNumTiles(lod, tw, th);
 
-            rx = (p.x() - pxmin) / pw, ry = (p.y() - pymin) / ph;
-            tx = osg::clampBelow((unsigned)(rx * (double)tw), tw - 1u); // TODO: wrap around for geo
-            ty = osg::clampBelow((unsigned)((1.0 - ry) * (double)th), th - 1u);
+        rx = (p.x() - pxmin) / pw, ry = (p.y() - pymin) / ph;
+        tx = osg::clampBelow((unsigned)(rx * (double)tw), tw - 1u); // TODO: wrap around for geo
+        ty = osg::clampBelow((unsigned)((1.0 - ry) * (double)th), th - 1u);
 
-            if (lod != lod_prev || tx != tx_prev || ty != ty_prev)
-            {
-                key._tilekey = TileKey(lod, tx, ty, profile);
-                lod_prev = lod;
-                tx_prev = tx;
-                ty_prev = ty;
-            }
+        if (lod != lod_prev || tx != tx_prev || ty != ty_prev)
+        {
+            key._tilekey = TileKey(lod, tx, ty, profile);
+            lod_prev = lod;
+            tx_prev = tx;
+            ty_prev = ty;
         }
 
         if (key._tilekey.valid())
         {
-            auto iter = quickCache.find(key);
-
-            if (iter == quickCache.end())
-            {
-                raster = getOrCreateRaster(
-                    key,   // key to query
-                    map.get(), // map to query
-                    true,  // fall back on lower resolution data if necessary
-                    ws,    // user's workingset
-                    progress);
-
-                // bail on cancelation before using the quickcache
-                if (progress && progress->isCanceled())
-                {
-                    return -1;
-                }
-
-                quickCache[key] = raster.get();
-            }
-            else
-            {
-                raster = iter->second;
-            }
-
-            {
-                //OE_PROFILING_ZONE_NAMED("sample");
-                if (raster.valid())
-                {
-                    u = (p.x() - raster->getExtent().xMin()) / raster->getExtent().width();
-                    v = (p.y() - raster->getExtent().yMin()) / raster->getExtent().height();
-
-                    // Note: This can happen on the map edges..
-                    // TODO: consider looping around for geo and clamping for projected
-                    u = osg::clampBetween(u, 0.0, 1.0);
-                    v = osg::clampBetween(v, 0.0, 1.0);
-
-                    quickSample(raster->reader(), u, v, elev, qvars);
-                    p.z() = elev.r();
-                }
-                else
-                {
-                    p.z() = failValue;
-                }
-            }
+            bins.add(key);
         }
         else
         {
+            bins.skip();
             p.z() = failValue;
         }
-
-        if (p.z() != failValue)
-            ++count;
     }
 
+    std::vector<osg::ref_ptr<ElevationTexture>> rasters;
+    if (!getOrCreateRasters(bins.keys, rasters, quickCache, map.get(), ws, progress))
+        return -1;
+
+    count += sampleBins(begin, bins, rasters, failValue, qvars);
+
     return count;
 }
 
@@ -791,10 +913,6 @@ ElevationPool::sampleMapCoords(
     Internal::RevElevationKey key;
     key._revision = getElevationHash(ws);
 
-    osg::ref_ptr<ElevationTexture> raster;
-    osg::Vec4 elev;
-    double u, v;
-
     const Profile* profile = map->getProfile();
     double pw = profile->getExtent().width();
     double ph = profile->getExtent().height();
@@ -815,95 +933,58 @@ ElevationPool::sampleMapCoords(
     int lod_prev = INT_MAX;
     auto& units = map->getSRS()->getUnits();
 
+    TileBins bins;
+    bins.binOfPoint.reserve(end - begin);
+
     for (auto iter = begin; iter != end; ++iter)
     {
         auto& p = *iter;
-        {
-            //OE_PROFILING_ZONE_NAMED("createTileKey");
-            double resolutionInMapUnits = resolution.asDistance(units, p.y());
-            int computedLOD = profile->getLevelOfDetailForHorizResolution(
-                resolutionInMapUnits,
-                ELEVATION_TILE_SIZE);
 
-            lod = osg::minimum(getLOD(p.x(), p.y()), (int)computedLOD);
+        double resolutionInMapUnits = resolution.asDistance(units, p.y());
+        int computedLOD = profile->getLevelOfDetailForHorizResolution(
+            resolutionInMapUnits,
+            ELEVATION_TILE_SIZE);
 
-            if (lod < 0)
-            {
-                p.z() = failValue;
-                continue;
-            }
+        lod = osg::minimum(getLOD(p.x(), p.y()), (int)computedLOD);
+
+        if (lod < 0)
+        {
+            bins.skip();
+            p.z() = failValue;
+            continue;
+        }
 
-            profile->getNumTiles(lod, tw, th);
+        profile->getNumTiles(lod, tw, th);
 
-            rx = (p.x() - pxmin) / pw, ry = (p.y() - pymin) / ph;
-            tx = osg::clampBelow((unsigned)(rx * (double)tw), tw - 1u); // TODO: wrap around for geo
-            ty = osg::clampBelow((unsigned)((1.0 - ry) * (double)th), th - 1u);
+        rx = (p.x() - pxmin) / pw, ry = (p.y() - pymin) / ph;
+        tx = osg::clampBelow((unsigned)(rx * (double)tw), tw - 1u); // TODO: wrap around for geo
+        ty = osg::clampBelow((unsigned)((1.0 - ry) * (double)th), th - 1u);
 
-            if (lod != lod_prev || tx != tx_prev || ty != ty_prev)
-            {
-                key._tilekey = TileKey(lod, tx, ty, profile);
-                lod_prev = lod;
-                tx_prev = tx;
-                ty_prev = ty;
-            }
+        if (lod != lod_prev || tx != tx_prev || ty != ty_prev)
+        {
+            key._tilekey = TileKey(lod, tx, ty, profile);
+            lod_prev = lod;
+            tx_prev = tx;
+            ty_prev = ty;
         }
 
         if (key._tilekey.valid())
         {
-            auto iter = quickCache.find(key);
-
-            if (iter == quickCache.end())
-            {
-                raster = getOrCreateRaster(
-                    key,   // key to query
-                    map.get(), // map to query
-                    true,  // fall back on lower resolution data if necessary
-                    ws,    // user's workingset
-                    progress);
-
-                // bail on cancelation before using the quickcache
-                if (progress && progress->isCanceled())
-                {
-                    return -1;
-                }
-
-                quickCache[key] = raster.get();
-            }
-            else
-            {
-                raster = iter->second;
-            }
-
-            {
-                //OE_PROFILING_ZONE_NAMED("sample");
-                if (raster.valid())
-                {
-                    u = (p.x() - raster->getExtent().xMin()) / raster->getExtent().width();
-                    v = (p.y() - raster->getExtent().yMin()) / raster->getExtent().height();
-
-                    // Note: This can happen on the map edges..
-                    // TODO: consider looping around for geo and clamping for projected
-                    u = osg::clampBetween(u, 0.0, 1.0);
-                    v = osg::clampBetween(v, 0.0, 1.0);
-
-                    quickSample(raster->reader(), u, v, elev, qvars);
-                    p.z() = elev.r();
-                }
-                else
-                {
-                    p.z() = failValue;
-                }
-            }
+            bins.add(key);
         }
         else
         {
+            bins.skip();
             p.z() = failValue;
         }
-
-        if (p.z() != failValue)
-            ++count;
     }
 
+    std::vector<osg::ref_ptr<ElevationTexture>> rasters;
+    if (!getOrCreateRasters(bins.keys, rasters, quickCache, map.get(), ws, progress))
+        return -1;
+
+    count += sampleBins(begin, bins, rasters, failValue, qvars);
+
     return count;
 }
 
@@ -0,0 +1,793 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+ * Copyright 2020 Pelican Mapping
+ * http://osgearth.org
+ *
+ * osgEarth is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include <osgEarth/FeatureBatch>
+#include <osgEarth/StringUtils>
+#include <mutex>
+
+using namespace osgEarth;
+
+#define LC "[FeatureBatch] "
+
+namespace
+{
+    // Process-wide table of interned attribute names, keyed in lower case
+    // to match the case-insensitive AttributeTable.
+    struct AttributeNames
+    {
+        std::mutex _mutex;
+        std::unordered_map<std::string, AttributeKey> _keys;
+    };
+
+    AttributeNames& attributeNames()
+    {
+        static AttributeNames names;
+        return names;
+    }
+
+    const std::vector<double> EMPTY_DOUBLE_ARRAY;
+}
+
+//----------------------------------------------------------------------------
+
+void
+FeatureBatch::Column::grow(unsigned row)
+{
+    if (row >= _state.size())
+        _state.resize(row + 1, ABSENT);
+    fit();
+}
+
+void
+FeatureBatch::Column::fit()
+{
+    std::size_t n = _state.size();
+    if (_mixed)
+        _values.resize(n);
+    else if (_typed)
+    {
+        switch (_type)
+        {
+        case ATTRTYPE_STRING: _strings.resize(n); break;
+        case ATTRTYPE_DOUBLE: _doubles.resize(n); break;
+        case ATTRTYPE_INT:
+        case ATTRTYPE_BOOL: _ints.resize(n); break;
+        case ATTRTYPE_DOUBLEARRAY: _arrays.resize(n); break;
+        default: break;
+        }
+    }
+}
+
+bool
+FeatureBatch::Column::accept(AttributeType type)
+{
+    if (_mixed)
+        return false;
+
+    if (!_typed && type != ATTRTYPE_UNSPECIFIED)
+    {
+        // so far only nulls (if anything), which simply take on the new type
+        _type = type;
+        _typed = true;
+        fit();
+        return true;
+    }
+
+    if (_typed && type == _type)
+        return true;
+
+    // a second type: fall back on whole values.
+    std::vector<AttributeValue> values(_state.size());
+    for (unsigned row = 0; row < _state.size(); ++row)
+    {
+        if (_state[row] != ABSENT)
+            values[row] = getValue(row);
+    }
+    _values.swap(values);
+    _doubles = std::vector<double>();
+    _ints = std::vector<long long>();
+    _strings = std::vector<std::string>();
+    _arrays = std::vector<std::vector<double>>();
+    _mixed = true;
+    return false;
+}
+
+AttributeValue
+FeatureBatch::Column::getValue(unsigned row) const
+{
+    if (!has(row))
+        return AttributeValue();
+
+    if (_mixed)
+        return _values[row];
+
+    AttributeValue a = AttributeValue();
+    a.type = _type;
+    a.value.set = (_state[row] == SET);
+    if (a.value.set)
+    {
+        switch (_type)
+        {
+        case ATTRTYPE_STRING: a.value.stringValue = _strings[row]; break;
+        case ATTRTYPE_DOUBLE: a.value.doubleValue = _doubles[row]; break;
+        case ATTRTYPE_INT: a.value.intValue = _ints[row]; break;
+        case ATTRTYPE_BOOL: a.value.boolValue = _ints[row] != 0; break;
+        case ATTRTYPE_DOUBLEARRAY: a.value.doubleArrayValue = _arrays[row]; break;
+        default: break;
+        }
+    }
+    return a;
+}
+
+std::string
+FeatureBatch::Column::getString(unsigned row) const
+{
+    if (!isSet(row))
+        return "";
+    if (!_mixed && _type == ATTRTYPE_STRING)
+        return _strings[row];
+    return getValue(row).getString();
+}
+
+double
+FeatureBatch::Column::getDouble(unsigned row, double defaultValue) const
+{
+    if (!isSet(row))
+        return defaultValue;
+    if (!_mixed)
+    {
+        if (_type == ATTRTYPE_DOUBLE) return _doubles[row];
+        if (_type == ATTRTYPE_INT || _type == ATTRTYPE_BOOL) return (double)_ints[row];
+    }
+    return getValue(row).getDouble(defaultValue);
+}
+
+long long
+FeatureBatch::Column::getInt(unsigned row, long long defaultValue) const
+{
+    if (!isSet(row))
+        return defaultValue;
+    if (!_mixed)
+    {
+        if (_type == ATTRTYPE_INT || _type == ATTRTYPE_BOOL) return _ints[row];
+        if (_type == ATTRTYPE_DOUBLE) return (long long)_doubles[row];
+    }
+    return getValue(row).getInt(defaultValue);
+}
+
+bool
+FeatureBatch::Column::getBool(unsigned row, bool defaultValue) const
+{
+    if (!isSet(row))
+        return defaultValue;
+    if (!_mixed)
+    {
+        if (_type == ATTRTYPE_INT || _type == ATTRTYPE_BOOL) return _ints[row] != 0;
+        if (_type == ATTRTYPE_DOUBLE) return _doubles[row] != 0.0;
+    }
+    return getValue(row).getBool(defaultValue);
+}
+
+const std::vector<double>*
+FeatureBatch::Column::getDoubleArray(unsigned row) const
+{
+    if (!has(row))
+        return nullptr;
+    if (_mixed)
+        return &_values[row].value.doubleArrayValue;
+    if (_type == ATTRTYPE_DOUBLEARRAY)
+        return &_arrays[row];
+    return &EMPTY_DOUBLE_ARRAY;
+}
+
+void
+FeatureBatch::Column::set(unsigned row, const AttributeValue& value)
+{
+    if (!value.value.set)
+    {
+        if (!_typed && !_mixed)
+            _type = value.type;
+        grow(row);
+        if (_mixed)
+            _values[row] = value;
+        _state[row] = NUL;
+        return;
+    }
+
+    accept(value.type);
+    grow(row);
+
+    if (_mixed)
+    {
+        _values[row] = value;
+    }
+    else switch (_type)
+    {
+    case ATTRTYPE_STRING: _strings[row] = value.value.stringValue; break;
+    case ATTRTYPE_DOUBLE: _doubles[row] = value.value.doubleValue; break;
+    case ATTRTYPE_INT: _ints[row] = value.value.intValue; break;
+    case ATTRTYPE_BOOL: _ints[row] = value.value.boolValue ? 1 : 0; break;
+    case ATTRTYPE_DOUBLEARRAY: _arrays[row] = value.value.doubleArrayValue; break;
+    default: break;
+    }
+    _state[row] = SET;
+}
+
+void
+FeatureBatch::Column::set(unsigned row, const std::string& value)
+{
+    if (accept(ATTRTYPE_STRING))
+    {
+        grow(row);
+        _strings[row] = value;
+        _state[row] = SET;
+    }
+    else
+    {
+        AttributeValue a = AttributeValue();
+        a.type = ATTRTYPE_STRING;
+        a.value.stringValue = value;
+        a.value.set = true;
+        set(row, a);
+    }
+}
+
+void
+FeatureBatch::Column::set(unsigned row, double value)
+{
+    if (accept(ATTRTYPE_DOUBLE))
+    {
+        grow(row);
+        _doubles[row] = value;
+        _state[row] = SET;
+    }
+    else
+    {
+        AttributeValue a = AttributeValue();
+        a.type = ATTRTYPE_DOUBLE;
+        a.value.doubleValue = value;
+        a.value.set = true;
+        set(row, a);
+    }
+}
+
+void
+FeatureBatch::Column::set(unsigned row, long long value)
+{
+    if (accept(ATTRTYPE_INT))
+    {
+        grow(row);
+        _ints[row] = value;
+        _state[row] = SET;
+    }
+    else
+    {
+        AttributeValue a = AttributeValue();
+        a.type = ATTRTYPE_INT;
+        a.value.intValue = value;
+        a.value.set = true;
+        set(row, a);
+    }
+}
+
+void
+FeatureBatch::Column::set(unsigned row, bool value)
+{
+    if (accept(ATTRTYPE_BOOL))
+    {
+        grow(row);
+        _ints[row] = value ? 1 : 0;
+        _state[row] = SET;
+    }
+    else
+    {
+        AttributeValue a = AttributeValue();
+        a.type = ATTRTYPE_BOOL;
+        a.value.boolValue = value;
+        a.value.set = true;
+        set(row, a);
+    }
+}
+
+void
+FeatureBatch::Column::setNull(unsigned row)
+{
+    grow(row);
+    if (_mixed)
+        _values[row].value.set = false;
+    _state[row] = NUL;
+}
+
+void
+FeatureBatch::Column::remove(unsigned row)
+{
+    if (row < _state.size())
+    {
+        _state[row] = ABSENT;
+        if (_mixed)
+            _values[row] = AttributeValue();
+        else if (_typed && _type == ATTRTYPE_STRING)
+            _strings[row].clear();
+        else if (_typed && _type == ATTRTYPE_DOUBLEARRAY)
+            _arrays[row].clear();
+    }
+}
+
+void
+FeatureBatch::Column::retain(const std::vector<unsigned>& rows)
+{
+    // rows past the end of the column are absent, so stop at the first one
+    unsigned count = 0;
+    for (; count < rows.size() && rows[count] < _state.size(); ++count)
+    {
+        unsigned row = rows[count];
+        if (row == count)
+            continue;
+
+        _state[count] = _state[row];
+        if (_mixed)
+            _values[count] = std::move(_values[row]);
+        else if (_typed) switch (_type)
+        {
+        case ATTRTYPE_STRING: _strings[count] = std::move(_strings[row]); break;
+        case ATTRTYPE_DOUBLE: _doubles[count] = _doubles[row]; break;
+        case ATTRTYPE_INT:
+        case ATTRTYPE_BOOL: _ints[count] = _ints[row]; break;
+        case ATTRTYPE_DOUBLEARRAY: _arrays[count] = std::move(_arrays[row]); break;
+        default: break;
+        }
+    }
+
+    _state.resize(count);
+    fit();
+}
+
+//----------------------------------------------------------------------------
+
+FeatureBatch::FeatureBatch(const SpatialReference* srs) :
+    _srs(srs)
+{
+    clear();
+}
+
+FeatureBatch::FeatureBatch(const FeatureList& features)
+{
+    clear();
+    append(features);
+}
+
+AttributeKey
+FeatureBatch::intern(const std::string& name)
+{
+    std::string lower = toLower(name);
+    AttributeNames& names = attributeNames();
+    std::lock_guard<std::mutex> lock(names._mutex);
+    return names._keys.emplace(lower, (AttributeKey)names._keys.size()).first->second;
+}
+
+bool
+FeatureBatch::findKey(const std::string& name, AttributeKey& key)
+{
+    std::string lower = toLower(name);
+    AttributeNames& names = attributeNames();
+    std::lock_guard<std::mutex> lock(names._mutex);
+    auto i = names._keys.find(lower);
+    if (i == names._keys.end())
+        return false;
+    key = i->second;
+    return true;
+}
+
+void
+FeatureBatch::clear()
+{
+    _fids.clear();
+    _geomTypes.clear();
+    _featureParts.assign(1, 0u);
+    _partTypes.clear();
+    _partRings.assign(1, 0u);
+    _ringCoords.assign(1, 0u);
+    _coords.clear();
+    _meshIndices.clear();
+    _styles.clear();
+    _geoInterps.clear();
+    _columns.clear();
+    _columnIndex.clear();
+    _nameCache.clear();
+}
+
+void
+FeatureBatch::reserve(unsigned features, unsigned coords)
+{
+    _fids.reserve(features);
+    _geomTypes.reserve(features);
+    _featureParts.reserve(features + 1);
+    _partTypes.reserve(features);
+    _partRings.reserve(features + 1);
+    _ringCoords.reserve(features + 1);
+    _coords.reserve(coords);
+}
+
+void
+FeatureBatch::appendRing(const Geometry* geom)
+{
+    _coords.insert(_coords.end(), geom->begin(), geom->end());
+    _ringCoords.push_back((unsigned)_coords.size());
+}
+
+void
+FeatureBatch::appendPart(const Geometry* geom)
+{
+    unsigned part = (unsigned)_partTypes.size();
+    _partTypes.push_back(geom->getType());
+
+    appendRing(geom);
+
+    if (geom->getType() == Geometry::TYPE_POLYGON)
+    {
+        for (auto& hole : static_cast<const Polygon*>(geom)->getHoles())
+            appendRing(hole.get());
+    }
+    else if (geom->getType() == Geometry::TYPE_TRIMESH)
+    {
+        _meshIndices[part] = static_cast<const TriMesh*>(geom)->_indices;
+    }
+
+    _partRings.push_back((unsigned)_ringCoords.size() - 1);
+}
+
+void
+FeatureBatch::appendGeometry(const Geometry* geom)
+{
+    if (geom->getType() == Geometry::TYPE_MULTI)
+    {
+        for (auto& part : static_cast<const MultiGeometry*>(geom)->getComponents())
+        {
+            if (part.valid())
+                appendGeometry(part.get());
+        }
+    }
+    else
+    {
+        appendPart(geom);
+    }
+}
+
+unsigned
+FeatureBatch::append(const Feature* feature)
+{
+    unsigned row = size();
+    std::size_t firstCoord = _coords.size();
+
+    const Geometry* geom = feature->getGeometry();
+    _fids.push_back(feature->getFID());
+    _geomTypes.push_back(geom ? geom->getType() : Geometry::TYPE_UNKNOWN);
+    if (geom)
+        appendGeometry(geom);
+    _featureParts.push_back((unsigned)_partTypes.size());
+
+    const SpatialReference* srs = feature->getSRS();
+    if (!_srs.valid())
+    {
+        _srs = srs;
+    }
+    else if (
+        srs &&
+        srs != _srs.get() &&
+        _coords.size() > firstCoord &&
+        !srs->isEquivalentTo(_srs.get()))
+    {
+        std::vector<osg::Vec3d> temp(_coords.begin() + firstCoord, _coords.end());
+        srs->transform(temp, _srs.get());
+        std::copy(temp.begin(), temp.end(), _coords.begin() + firstCoord);
+    }
+
+    if (feature->style().isSet())
+        _styles[row] = feature->style().get();
+
+    if (feature->geoInterp().isSet())
+        _geoInterps[row] = feature->geoInterp().get();
+
+    for (auto& attr : feature->getAttrs())
+    {
+        addColumn(attr.first).set(row, attr.second);
+    }
+
+    return row;
+}
+
+void
+FeatureBatch::append(const FeatureList& features)
+{
+    for (auto& feature : features)
+    {
+        if (feature.valid())
+            append(feature.get());
+    }
+}
+
+void
+FeatureBatch::assign(const FeatureList& features)
+{
+    clear();
+    for (auto& feature : features)
+    {
+        if (feature.valid())
+        {
+            _srs = feature->getSRS();
+            break;
+        }
+    }
+    append(features);
+}
+
+Geometry*
+FeatureBatch::createPart(unsigned part) const
+{
+    Geometry::Type type = getPartType(part);
+    unsigned ring = ringsBegin(part);
+
+    Geometry* geom = nullptr;
+    switch (type)
+    {
+    case Geometry::TYPE_POINT: geom = new Point(); break;
+    case Geometry::TYPE_POINTSET: geom = new PointSet(); break;
+    case Geometry::TYPE_LINESTRING: geom = new LineString(); break;
+    case Geometry::TYPE_RING: geom = new Ring(); break;
+    case Geometry::TYPE_POLYGON: geom = new Polygon(); break;
+    case Geometry::TYPE_TRIMESH:
+    {
+        TriMesh* mesh = new TriMesh();
+        auto i = _meshIndices.find(part);
+        if (i != _meshIndices.end())
+            mesh->_indices = i->second;
+        geom = mesh;
+        break;
+    }
+    default: geom = new Geometry(); break;
+    }
+
+    geom->assign(_coords.begin() + coordsBegin(ring), _coords.begin() + coordsEnd(ring));
+
+    if (type == Geometry::TYPE_POLYGON)
+    {
+        Polygon* poly = static_cast<Polygon*>(geom);
+        for (++ring; ring < ringsEnd(part); ++ring)
+        {
+            Ring* hole = new Ring();
+            hole->assign(_coords.begin() + coordsBegin(ring), _coords.begin() + coordsEnd(ring));
+            poly->getHoles().push_back(hole);
+        }
+    }
+
+    return geom;
+}
+
+Feature*
+FeatureBatch::createFeature(unsigned row) const
+{
+    Geometry* geom = nullptr;
+
+    if (getGeometryType(row) == Geometry::TYPE_MULTI)
+    {
+        MultiGeometry* multi = new MultiGeometry();
+        for (unsigned part = partsBegin(row); part < partsEnd(row); ++part)
+            multi->add(createPart(part));
+        geom = multi;
+    }
+    else if (partsEnd(row) > partsBegin(row))
+    {
+        geom = createPart(partsBegin(row));
+    }
+
+    Feature* feature = new Feature(geom, _srs.get(), Style(), getFID(row));
+
+    auto style = _styles.find(row);
+    if (style != _styles.end())
+        feature->style() = style->second;
+
+    auto geoInterp = _geoInterps.find(row);
+    if (geoInterp != _geoInterps.end())
+        feature->geoInterp() = geoInterp->second;
+
+    for (auto& column : _columns)
+    {
+        if (column.has(row))
+            feature->set(column.getName(), column.getValue(row));
+    }
+
+    return feature;
+}
+
+void
+FeatureBatch::createFeatures(FeatureList& output) const
+{
+    output.reserve(output.size() + size());
+    for (unsigned row = 0; row < size(); ++row)
+        output.emplace_back(createFeature(row));
+}
+
+void
+FeatureBatch::retain(const std::vector<unsigned>& rows)
+{
+    if (rows.size() == size())
+        return;
+
+    // Compact in place. Every index we write is at or before the index we
+    // read, so nothing is overwritten before it's used.
+    unsigned outPart = 0u, outRing = 0u, outCoord = 0u;
+    std::unordered_map<unsigned, std::vector<unsigned>> meshIndices;
+    std::unordered_map<unsigned, Style> styles;
+    std::unordered_map<unsigned, GeoInterpolation> geoInterps;
+
+    for (unsigned k = 0; k < rows.size(); ++k)
+    {
+        unsigned row = rows[k];
+        unsigned pb = _featureParts[row], pe = _featureParts[row + 1];
+
+        _fids[k] = _fids[row];
+        _geomTypes[k] = _geomTypes[row];
+        _featureParts[k] = outPart;
+
+        for (unsigned p = pb; p < pe; ++p)
+        {
+            unsigned rb = _partRings[p], re = _partRings[p + 1];
+
+            _partTypes[outPart] = _partTypes[p];
+            _partRings[outPart] = outRing;
+
+            if (!_meshIndices.empty())
+            {
+                auto i = _meshIndices.find(p);
+                if (i != _meshIndices.end())
+                    meshIndices[outPart] = std::move(i->second);
+            }
+
+            for (unsigned r = rb; r < re; ++r)
+            {
+                unsigned cb = _ringCoords[r], ce = _ringCoords[r + 1];
+                _ringCoords[outRing++] = outCoord;
+                if (cb != outCoord)
+                    std::copy(_coords.begin() + cb, _coords.begin() + ce, _coords.begin() + outCoord);
+                outCoord += ce - cb;
+            }
+            ++outPart;
+        }
+
+        if (!_styles.empty())
+        {
+            auto i = _styles.find(row);
+            if (i != _styles.end())
+                styles[k] = std::move(i->second);
+        }
+
+        if (!_geoInterps.empty())
+        {
+            auto i = _geoInterps.find(row);
+            if (i != _geoInterps.end())
+                geoInterps[k] = i->second;
+        }
+    }
+
+    unsigned count = (unsigned)rows.size();
+    _fids.resize(count);
+    _geomTypes.resize(count);
+    _featureParts.resize(count + 1);
+    _featureParts[count] = outPart;
+    _partTypes.resize(outPart);
+    _partRings.resize(outPart + 1);
+    _partRings[outPart] = outRing;
+    _ringCoords.resize(outRing + 1);
+    _ringCoords[outRing] = outCoord;
+    _coords.resize(outCoord);
+
+    _meshIndices.swap(meshIndices);
+    _styles.swap(styles);
+    _geoInterps.swap(geoInterps);
+
+    for (auto& column : _columns)
+        column.retain(rows);
+}
+
+const Style*
+FeatureBatch::getStyle(unsigned row) const
+{
+    auto i = _styles.find(row);
+    return i != _styles.end() ? &i->second : nullptr;
+}
+
+void
+FeatureBatch::setStyle(unsigned row, const Style& style)
+{
+    _styles[row] = style;
+}
+
+optional<GeoInterpolation>
+FeatureBatch::getGeoInterp(unsigned row) const
+{
+    optional<GeoInterpolation> result;
+    auto i = _geoInterps.find(row);
+    if (i != _geoInterps.end())
+        result = i->second;
+    return result;
+}
+
+void
+FeatureBatch::setGeoInterp(unsigned row, const GeoInterpolation& value)
+{
+    _geoInterps[row] = value;
+}
+
+FeatureBatch::Column*
+FeatureBatch::getColumn(AttributeKey key)
+{
+    return key < _columnIndex.size() && _columnIndex[key] >= 0 ?
+        &_columns[_columnIndex[key]] : nullptr;
+}
+
+const FeatureBatch::Column*
+FeatureBatch::getColumn(AttributeKey key) const
+{
+    return key < _columnIndex.size() && _columnIndex[key] >= 0 ?
+        &_columns[_columnIndex[key]] : nullptr;
+}
+
+FeatureBatch::Column*
+FeatureBatch::getColumn(const std::string& name)
+{
+    auto i = _nameCache.find(name);
+    if (i != _nameCache.end())
+        return &_columns[i->second];
+
+    AttributeKey key;
+    return findKey(name, key) ? getColumn(key) : nullptr;
+}
+
+const FeatureBatch::Column*
+FeatureBatch::getColumn(const std::string& name) const
+{
+    auto i = _nameCache.find(name);
+    if (i != _nameCache.end())
+        return &_columns[i->second];
+
+    AttributeKey key;
+    return findKey(name, key) ? getColumn(key) : nullptr;
+}
+
+FeatureBatch::Column&
+FeatureBatch::addColumn(const std::string& name)
+{
+    auto i = _nameCache.find(name);
+    if (i != _nameCache.end())
+        return _columns[i->second];
+
+    AttributeKey key = intern(name);
+    if (key >= _columnIndex.size())
+        _columnIndex.resize(key + 1, -1);
+
+    if (_columnIndex[key] < 0)
+    {
+        _columnIndex[key] = (int)_columns.size();
+        _columns.emplace_back();
+        _columns.back()._name = name;
+        _columns.back()._key = key;
+    }
+
+    _nameCache[name] = _columnIndex[key];
+    return _columns[_columnIndex[key]];
+}
@@ -68,6 +68,22 @@ FeatureCursor::fill(FeatureList& list, std::function<bool(const Feature*)> predi
     return count;
 }
 
+unsigned
+FeatureCursor::fill(FeatureBatch& batch)
+{
+    unsigned count = 0;
+    while (hasMore())
+    {
+        osg::ref_ptr<Feature> f = nextFeature();
+        if (f.valid())
+        {
+            batch.append(f.get());
+            ++count;
+        }
+    }
+    return count;
+}
+
 //---------------------------------------------------------------------------
 
 GeometryFeatureCursor::GeometryFeatureCursor(Geometry* geom) :
@@ -22,6 +22,7 @@
 #include <osgEarth/Registry>
 #include <osgEarth/Progress>
 #include <osgEarth/LandCover>
+#include <osgEarth/ImageUtils>
 #include <osgEarth/Metrics>
 
 using namespace osgEarth;
@@ -43,6 +44,7 @@ FeatureImageLayer::Options::getConfig() const
     conf.set("gamma", gamma());
     conf.set("sdf", sdf());
     conf.set("sdf_invert", sdf_invert());
+    conf.set("metatile_size", metatileSize());
 
     if (filters().empty() == false)
     {
@@ -61,12 +63,14 @@ FeatureImageLayer::Options::fromConfig(const Config& conf)
     gamma().setDefault(1.3);
     sdf().setDefault(false);
     sdf_invert().setDefault(false);
+    metatileSize().setDefault(1u);
 
     featureSource().get(conf, "features");
     styleSheet().get(conf, "styles");
     conf.get("gamma", gamma());
     conf.get("sdf", sdf());
     conf.get("sdf_invert", sdf_invert());
+    conf.get("metatile_size", metatileSize());
 
     const Config& filtersConf = conf.child("filters");
     for (ConfigSet::const_iterator i = filtersConf.children().begin(); i != filtersConf.children().end(); ++i)
@@ -112,6 +116,16 @@ FeatureImageLayer::openImplementation()
         options().filters(), 
         getReadOptions());
 
+    if (options().metatileSize().get() > 8u)
+    {
+        OE_WARN << LC << "metatile_size is limited to 8" << std::endl;
+    }
+
+    // hold 256 tiles' worth of metatiles (at least 4, at the largest size)
+    unsigned metatileSize = getMetatileSize();
+    _metatiles.setMaxSize(256u / (metatileSize * metatileSize));
+    _metatiles.clear();
+
     return Status::NoError;
 }
 
@@ -202,9 +216,27 @@ FeatureImageLayer::setStyleSheet(StyleSheet* value)
         {
             _global._session->setStyles(getStyleSheet());
         }
+        _metatiles.clear();
     }
 }
 
+void
+FeatureImageLayer::setMetatileSize(unsigned value)
+{
+    options().metatileSize() = value;
+}
+
+unsigned
+FeatureImageLayer::getMetatileSize() const
+{
+    // round down to a power of two; larger metatiles would blow the
+    // cache's memory budget
+    unsigned size = osg::clampBetween(options().metatileSize().get(), 1u, 8u);
+    while (size & (size - 1))
+        size &= size - 1;
+    return size;
+}
+
 void
 FeatureImageLayer::updateSession()
 {
@@ -237,6 +269,8 @@ FeatureImageLayer::updateSession()
 
         _global._session->setFeatureSource(getFeatureSource());
         _global._session->setStyles(getStyleSheet());
+
+        _metatiles.clear();
     }
 }
 
@@ -278,6 +312,98 @@ FeatureImageLayer::createImageImplementation(const TileKey& key, ProgressCallbac
     }
 
 
+    unsigned levels = getMetatileLevels(key, featureProfile);
+    if (levels > 0u)
+    {
+        return createImageFromMetatile(key, levels, local, featureProfile, progress);
+    }
+
+    return renderImage(key, getTileSize(), local, featureProfile, progress);
+}
+
+unsigned
+FeatureImageLayer::getMetatileLevels(const TileKey& key, const FeatureProfile* featureProfile) const
+{
+    unsigned levels = 0u;
+    for (unsigned size = getMetatileSize(); size > 1u; size >>= 1)
+        ++levels;
+
+    levels = std::min(levels, key.getLOD());
+
+    // A tiled source answers a query with its tiles at the query's LOD, so a
+    // metatile is only equivalent when its LOD is past the source's max level.
+    if (levels > 0u && featureProfile->isTiled() && featureProfile->getMaxLevel() >= 0)
+    {
+        unsigned lod = featureProfile->getTilingProfile()->getEquivalentLOD(key.getProfile(), key.getLOD());
+        unsigned maxLevel = (unsigned)featureProfile->getMaxLevel();
+        levels = lod > maxLevel ? std::min(levels, lod - maxLevel) : 0u;
+    }
+
+    return levels;
+}
+
+GeoImage
+FeatureImageLayer::createImageFromMetatile(
+    const TileKey& key,
+    unsigned levels,
+    const Isolate& local,
+    const FeatureProfile* featureProfile,
+    ProgressCallback* progress) const
+{
+    TileKey metaKey = key.createAncestorKey(key.getLOD() - levels);
+
+    GeoImage canvas;
+    {
+        // Siblings that arrive while the metatile renders wait for it
+        // instead of rendering it again.
+        ScopedGate<TileKey> gate(_metatileGate, metaKey);
+
+        Util::LRUCache<TileKey, Metatile>::Record record;
+        if (_metatiles.get(metaKey, record) && record.value()._revision == getRevision())
+        {
+            canvas = record.value()._image;
+        }
+        else
+        {
+            canvas = renderImage(metaKey, getTileSize() << levels, local, featureProfile, progress);
+
+            if (canvas.valid() && !(progress && progress->isCanceled()))
+            {
+                Metatile metatile;
+                metatile._image = canvas;
+                metatile._revision = getRevision();
+                _metatiles.insert(metaKey, metatile);
+            }
+        }
+    }
+
+    if (!canvas.valid())
+    {
+        return GeoImage::INVALID;
+    }
+
+    // Slice this tile out of the canvas. Rows start at the south edge.
+    osg::Image* image = const_cast<osg::Image*>(canvas.getImage());
+    const GeoExtent& canvasExtent = canvas.getExtent();
+    const GeoExtent& extent = key.getExtent();
+    const unsigned size = getTileSize();
+
+    double s = (extent.xMin() - canvasExtent.xMin()) / canvasExtent.width() * (double)image->s();
+    double t = (extent.yMin() - canvasExtent.yMin()) / canvasExtent.height() * (double)image->t();
+    unsigned x = std::min((unsigned)std::max(std::round(s), 0.0), image->s() - size);
+    unsigned y = std::min((unsigned)std::max(std::round(t), 0.0), image->t() - size);
+
+    return GeoImage(ImageUtils::cropImage(image, x, y, size, size), extent);
+}
+
+GeoImage
+FeatureImageLayer::renderImage(
+    const TileKey& key,
+    unsigned size,
+    const Isolate& local,
+    const FeatureProfile* featureProfile,
+    ProgressCallback* progress) const
+{
     FeatureRasterizer* rasterizer = nullptr;
 
     osg::ref_ptr<osg::Image> image;
@@ -287,9 +413,7 @@ FeatureImageLayer::createImageImplementation(const TileKey& key, ProgressCallbac
         {
             if (style.second.getSymbol<CoverageSymbol>())
             {
-                image = LandCover::createImage(
-                    getTileSize(),
-                    getTileSize());
+                image = LandCover::createImage(size, size);
 
                 rasterizer = new FeatureRasterizer(image.get(), key.getExtent());
                 ImageUtils::PixelWriter writer(image.get());
@@ -301,7 +425,7 @@ FeatureImageLayer::createImageImplementation(const TileKey& key, ProgressCallbac
 
     if (!rasterizer)
     {
-        rasterizer = new FeatureRasterizer(getTileSize(), getTileSize(), key.getExtent());
+        rasterizer = new FeatureRasterizer(size, size, key.getExtent());
     }
 
     FeatureStyleSorter::Function renderer = [&](
@@ -91,7 +91,10 @@ FeatureSource::openImplementation()
     if (l2CacheSize > 0)
     {
         // note: cannot use std::make_unique in C++11
-        _featuresCache = std::unique_ptr<FeaturesLRU>(new FeaturesLRU(l2CacheSize));
+        if (options().l2CacheConcurrent() == true)
+            _featuresConcurrentCache = std::unique_ptr<FeaturesConcurrentLRU>(new FeaturesConcurrentLRU(l2CacheSize, 4u));
+        else
+            _featuresCache = std::unique_ptr<FeaturesLRU>(new FeaturesLRU(l2CacheSize));
     }
 
     Status parent = super::openImplementation();
@@ -259,9 +262,56 @@ FeatureSource::dirty()
         _featuresCache->clear();
     }
 
+    if (_featuresConcurrentCache)
+    {
+        _featuresConcurrentCache->clear();
+    }
+
     super::dirty();
 }
 
+bool
+FeatureSource::getCachedFeatures(const TileKey& key, FeatureList& output) const
+{
+    if (_featuresConcurrentCache)
+    {
+        FeaturesConcurrentLRU::Record cache_entry;
+        if (_featuresConcurrentCache->get(key, cache_entry))
+        {
+            output = cache_entry.value();
+            return true;
+        }
+    }
+    else if (_featuresCache)
+    {
+        FeaturesLRU::Record cache_entry;
+        {
+            std::lock_guard<std::mutex> lk(_featuresCacheMutex);
+            _featuresCache->get(key, cache_entry);
+        }
+        if (cache_entry.valid())
+        {
+            output = cache_entry.value();
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+FeatureSource::cacheFeatures(const TileKey& key, const FeatureList& features) const
+{
+    if (_featuresConcurrentCache)
+    {
+        _featuresConcurrentCache->insert(key, features);
+    }
+    else if (_featuresCache)
+    {
+        std::lock_guard<std::mutex> lk(_featuresCacheMutex);
+        _featuresCache->insert(key, features);
+    }
+}
+
 osg::ref_ptr<FeatureCursor>
 FeatureSource::createFeatureCursor(
     const Query& query,
@@ -286,21 +336,14 @@ FeatureSource::createFeatureCursor(
     if (query.tileKey().isSet())
     {
         // Try reading from the cache first if we have a TileKey.
-        if (_featuresCache)
+        FeatureList cached;
+        if (getCachedFeatures(*query.tileKey(), cached))
         {
-            FeaturesLRU::Record cache_entry;
-            {
-                std::lock_guard<std::mutex> lk(_featuresCacheMutex);
-                _featuresCache->get(*query.tileKey(), cache_entry);
-            }
-            if (result.valid())
-            {
-                FeatureList copy(cache_entry.value().size());
-                std::transform(cache_entry.value().begin(), cache_entry.value().end(), copy.begin(),
-                    [&](auto& feature) { return new Feature(*feature); });
-                result = new FeatureListCursor(std::move(copy));
-                fromCache = true;
-            }
+            FeatureList copy(cached.size());
+            std::transform(cached.begin(), cached.end(), copy.begin(),
+                [&](auto& feature) { return new Feature(*feature); });
+            result = new FeatureListCursor(std::move(copy));
+            fromCache = true;
         }
 
         if (!temp_cx.extent().isSet())
@@ -380,7 +423,7 @@ FeatureSource::createFeatureCursor(
 
             // Write the feature set to the L2 cache.
             // TODO: If we have a persistent cache, write to that as well here
-            if (_featuresCache)
+            if (_featuresCache || _featuresConcurrentCache)
             {
                 FeatureList features;
                 result->fill(features, [](const Feature* f) { return f != nullptr; });
@@ -390,8 +433,7 @@ FeatureSource::createFeatureCursor(
                 std::transform(features.begin(), features.end(), clone.begin(),
                     [&](auto& feature) { return new Feature(*feature); });
 
-                std::lock_guard<std::mutex> lk(_featuresCacheMutex);
-                _featuresCache->insert(*query.tileKey(), clone);
+                cacheFeatures(*query.tileKey(), clone);
 
                 result = new FeatureListCursor(std::move(features));
             }
@@ -26,6 +26,7 @@
 #include <osgDB/ConvertUTF>
 #include <osg/Object>
 #include <stack>
+#include <cstdio>
 
 #include <errno.h>
 
@@ -536,6 +537,16 @@ osgEarth::Util::makeDirectoryForFile( const std::string &path )
     return makeDirectory( osgDB::getFilePath( path ));
 }
 
+bool
+osgEarth::Util::replaceFile( const std::string& from, const std::string& to )
+{
+#ifdef WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return ::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
 
 bool
 osgEarth::Util::touchFile(const std::string& path)
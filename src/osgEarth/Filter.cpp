@@ -44,6 +44,16 @@ void FeatureFilter::addedToMap(const class Map*)
 {
 }
 
+FilterContext
+FeatureFilter::push(FeatureBatch& input, FilterContext& context)
+{
+    FeatureList features;
+    input.createFeatures(features);
+    FilterContext output = push(features, context);
+    input.assign(features);
+    return output;
+}
+
 /********************************************************************************/
 
 #undef LC
@@ -75,6 +85,44 @@ FeatureFilterChain::create(const std::vector<ConfigOptions>& filters, const osgD
     return std::move(chain);
 }
 
+FilterContext
+FeatureFilterChain::push(FeatureBatch& input, FilterContext& context) const
+{
+    FilterContext temp = context;
+    FeatureList features;
+    bool converted = false;
+
+    for (auto& filter : *this)
+    {
+        if (filter->supportsBatch())
+        {
+            if (converted)
+            {
+                input.assign(features);
+                features.clear();
+                converted = false;
+            }
+            temp = filter->push(input, temp);
+        }
+        else
+        {
+            if (!converted)
+            {
+                input.createFeatures(features);
+                converted = true;
+            }
+            temp = filter->push(features, temp);
+        }
+    }
+
+    if (converted)
+    {
+        input.assign(features);
+    }
+
+    return temp;
+}
+
 /********************************************************************************/
         
 #undef  LC
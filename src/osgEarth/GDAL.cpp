@@ -417,6 +417,14 @@ namespace osgEarth
 
 GDAL::Driver::~Driver()
 {
+    // the thread-safe wrapper holds a reference to the source dataset,
+    // so release it first
+    if (_threadSafeDS)
+    {
+        GDALClose(_threadSafeDS);
+        _warpedDS = _srcDS;
+    }
+
     if (_warpedDS)
         GDALClose(_warpedDS);
     else if (_srcDS)
@@ -429,6 +437,31 @@ GDAL::Driver::setExternalDataset(GDAL::ExternalDataset* value)
     _externalDataset = value;
 }
 
+void
+GDAL::Driver::setShared(std::size_t blockCacheBytes)
+{
+    _shared = true;
+    _blockCacheBytes = blockCacheBytes;
+}
+
+ConcurrentCacheShardStats
+GDAL::Driver::getBlockCacheStats() const
+{
+    ConcurrentCacheShardStats total;
+    if (_blockCache)
+    {
+        for (auto& shard : _blockCache->getShardStats())
+        {
+            total._entries += shard._entries;
+            total._bytes += shard._bytes;
+            total._hits += shard._hits;
+            total._misses += shard._misses;
+            total._evictions += shard._evictions;
+        }
+    }
+    return total;
+}
+
 // Open the data source and prepare it for reading
 Status
 GDAL::Driver::open(
@@ -793,6 +826,48 @@ GDAL::Driver::open(
     // Get the linear units of the SRS for scaling elevation values
     _linearUnits = srs->getReportedLinearUnits();
 
+    if (_shared)
+    {
+        // Cache blocks that follow the dataset's natural block layout, within
+        // reason; scanline-organized files would otherwise yield 1-row blocks.
+        int nativeWidth = 0, nativeHeight = 0;
+        if (_warpedDS->GetRasterCount() > 0)
+            _warpedDS->GetRasterBand(1)->GetBlockSize(&nativeWidth, &nativeHeight);
+        _blockWidth = osg::clampBetween(nativeWidth, 64, 512);
+        _blockHeight = osg::clampBetween(nativeHeight, 64, 512);
+
+        // size the entry limit so the byte budget is what actually governs
+        std::size_t blockBytes = (std::size_t)_blockWidth * (std::size_t)_blockHeight * sizeof(float);
+        unsigned maxBlocks = (unsigned)osg::clampBetween(
+            _blockCacheBytes / blockBytes + 1u, (std::size_t)16u, (std::size_t)0x7fffffff);
+
+        _blockCache.reset(new BlockCache(maxBlocks, 16u));
+        _blockCache->setMaxBytes(_blockCacheBytes, [](const BlockPtr& block) {
+            return sizeof(Block) + block->_data.size() * sizeof(float);
+        });
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,10,0)
+        // GDAL 3.10 can wrap a dataset so that concurrent RasterIO calls are
+        // safe, sharing one set of handles and one block cache. That only works
+        // for datasets GDAL can re-open by name, so not for our warped VRTs.
+        if (_warpedDS == _srcDS && !_externalDataset.valid())
+        {
+            GDALDatasetH ts = GDALGetThreadSafeDataset(GDALDataset::ToHandle(_srcDS), GDAL_OF_RASTER, nullptr);
+            if (ts)
+            {
+                _threadSafeDS = GDALDataset::FromHandle(ts);
+                _warpedDS = _threadSafeDS;
+                _threadSafeReads = true;
+            }
+        }
+#endif
+
+        if (verbose)
+            OE_DEBUG << LC << source << ": shared dataset, block cache = "
+                << (_blockCacheBytes / 1048576) << " MB, "
+                << (_threadSafeReads ? "concurrent reads" : "serialized reads") << std::endl;
+    }
+
     if (verbose)
         OE_DEBUG << LC << source << ": set Profile to " << _profile->toString() << std::endl;
 
@@ -885,6 +960,7 @@ GDAL::Driver::getInterpolatedValue(GDALRasterBand* band, double x, double y, boo
     }
 
     float result = 0.0f;
+    BlockPtr hint;
 
     //If the location is outside of the pixel values of the dataset, just return 0
     if (c < 0 || r < 0 || c > _warpedDS->GetRasterXSize() - 1 || r > _warpedDS->GetRasterYSize() - 1)
@@ -892,7 +968,7 @@ GDAL::Driver::getInterpolatedValue(GDALRasterBand* band, double x, double y, boo
 
     if (gdalOptions().interpolation() == INTERP_NEAREST)
     {
-        rasterIO(band, GF_Read, osg::round(c), osg::round(r), 1, 1, &result, 1, 1, GDT_Float32, 0, 0);
+        readValue(band, osg::round(c), osg::round(r), result, hint);
         if (!isValidValue(result, band))
         {
             return NO_DATA_VALUE;
@@ -910,10 +986,10 @@ GDAL::Driver::getInterpolatedValue(GDALRasterBand* band, double x, double y, boo
 
         float urHeight, llHeight, ulHeight, lrHeight;
 
-        rasterIO(band, GF_Read, colMin, rowMin, 1, 1, &llHeight, 1, 1, GDT_Float32, 0, 0);
-        rasterIO(band, GF_Read, colMin, rowMax, 1, 1, &ulHeight, 1, 1, GDT_Float32, 0, 0);
-        rasterIO(band, GF_Read, colMax, rowMin, 1, 1, &lrHeight, 1, 1, GDT_Float32, 0, 0);
-        rasterIO(band, GF_Read, colMax, rowMax, 1, 1, &urHeight, 1, 1, GDT_Float32, 0, 0);
+        readValue(band, colMin, rowMin, llHeight, hint);
+        readValue(band, colMin, rowMax, ulHeight, hint);
+        readValue(band, colMax, rowMin, lrHeight, hint);
+        readValue(band, colMax, rowMax, urHeight, hint);
 
         if ((!isValidValue(urHeight, band)) || (!isValidValue(llHeight, band)) || (!isValidValue(ulHeight, band)) || (!isValidValue(lrHeight, band)))
         {
@@ -968,6 +1044,68 @@ GDAL::Driver::getInterpolatedValue(GDALRasterBand* band, double x, double y, boo
     return result;
 }
 
+void
+GDAL::Driver::readValue(GDALRasterBand* band, int col, int row, float& out, BlockPtr& hint)
+{
+    if (!_blockCache)
+    {
+        rasterIO(band, GF_Read, col, row, 1, 1, &out, 1, 1, GDT_Float32, 0, 0);
+        return;
+    }
+
+    // neighboring samples almost always fall in the same block,
+    // so check the last one before going to the cache
+    if (!hint ||
+        col < hint->_x || col >= hint->_x + hint->_width ||
+        row < hint->_y || row >= hint->_y + hint->_height)
+    {
+        hint = getBlock(band, col, row);
+    }
+
+    if (hint)
+        out = hint->_data[(row - hint->_y) * hint->_width + (col - hint->_x)];
+    else
+        out = NO_DATA_VALUE;
+}
+
+GDAL::Driver::BlockPtr
+GDAL::Driver::getBlock(GDALRasterBand* band, int col, int row)
+{
+    int bx = col / _blockWidth;
+    int by = row / _blockHeight;
+
+    std::uint64_t key =
+        ((std::uint64_t)(band->GetBand() & 0xff) << 56) |
+        ((std::uint64_t)(by & 0xfffffff) << 28) |
+        (std::uint64_t)(bx & 0xfffffff);
+
+    BlockCache::Record record;
+    if (_blockCache->get(key, record))
+        return record.value();
+
+    auto block = std::make_shared<Block>();
+    block->_x = bx * _blockWidth;
+    block->_y = by * _blockHeight;
+    block->_width = osg::minimum(_blockWidth, _warpedDS->GetRasterXSize() - block->_x);
+    block->_height = osg::minimum(_blockHeight, _warpedDS->GetRasterYSize() - block->_y);
+    block->_data.resize(block->_width * block->_height);
+
+    // Two threads may occasionally load the same block; the second insert
+    // just replaces the first, which is cheaper than a per-key lock.
+    bool ok;
+    {
+        Util::scoped_lock_if lock(_datasetMutex, !_threadSafeReads);
+        ok = rasterIO(band, GF_Read, block->_x, block->_y, block->_width, block->_height,
+            &block->_data[0], block->_width, block->_height, GDT_Float32, 0, 0);
+    }
+
+    if (!ok)
+        return nullptr;
+
+    _blockCache->insert(key, block);
+    return block;
+}
+
 bool
 GDAL::Driver::intersects(const TileKey& key)
 {
@@ -992,6 +1130,9 @@ GDAL::Driver::createImage(const TileKey& key,
         return NULL;
     }
 
+    // a shared dataset without thread-safe reads must be accessed serially
+    Util::scoped_lock_if lock(_datasetMutex, _shared && !_threadSafeReads);
+
     osg::ref_ptr<osg::Image> image;
 
     //Get the extents of the tile
@@ -1448,7 +1589,10 @@ GDAL::Driver::createHeightField(const TileKey& key,
             int startOffset = iBufRowMin * tileSize + iBufColMin;
             int lineSpace = tileSize * sizeof(float);
 
-            rasterIO(band, GF_Read, iWinColMin, iWinRowMin, iNumWinCols, iNumWinRows, &buffer[startOffset], iNumBufCols, iNumBufRows, GDT_Float32, 0, lineSpace);
+            {
+                Util::scoped_lock_if lock(_datasetMutex, _shared && !_threadSafeReads);
+                rasterIO(band, GF_Read, iWinColMin, iWinRowMin, iNumWinCols, iNumWinRows, &buffer[startOffset], iNumBufCols, iNumBufRows, GDT_Float32, 0, lineSpace);
+            }
 
             for (unsigned r = 0, ir = tileSize - 1; r < tileSize; ++r, --ir)
             {
@@ -1499,6 +1643,10 @@ GDAL::Driver::createHeightFieldWithVRT(const TileKey& key,
 
     if (intersects(key))
     {
+        // the temporary VRT reads the source dataset directly, which is
+        // never safe to share across threads
+        Util::scoped_lock_if lock(_datasetMutex, _shared);
+
         GDALResampleAlg resampleAlg = GRA_NearestNeighbour;
         switch (*_gdalOptions.interpolation())
         {
@@ -1610,6 +1758,8 @@ GDAL::Options::readFrom(const Config& conf)
     conf.get("interpolation", "cubicspline", _interpolation, osgEarth::INTERP_CUBICSPLINE);
     conf.get("coverage_uses_palette_index", coverageUsesPaletteIndex());
     conf.get("single_threaded", singleThreaded());
+    conf.get("shared_dataset", sharedDataset());
+    conf.get("block_cache_size", blockCacheSize());
     conf.get("use_vrt", useVRT());
     conf.get("fallback_profile", fallbackProfile());
 
@@ -1636,6 +1786,8 @@ GDAL::Options::writeTo(Config& conf) const
     conf.set("interpolation", "cubicspline", _interpolation, osgEarth::INTERP_CUBICSPLINE);
     conf.set("coverage_uses_palette_index", coverageUsesPaletteIndex());
     conf.set("single_threaded", singleThreaded());
+    conf.set("shared_dataset", sharedDataset());
+    conf.set("block_cache_size", blockCacheSize());
     conf.set("fallback_profile", fallbackProfile());
 }
 
@@ -1656,6 +1808,9 @@ namespace
     {
         driver = std::make_shared<GDAL::Driver>();
 
+        if (layer->options().sharedDataset() == true && layer->options().singleThreaded() == false)
+            driver->setShared(layer->options().blockCacheSize().get());
+
         if (layer->options().noDataValue().isSet())
             driver->setNoDataValue(layer->options().noDataValue().get());
         if (layer->options().minValidValue().isSet())
@@ -1684,6 +1839,29 @@ namespace
 
         return Status::NoError;
     }
+
+    // Returns the driver for the calling thread, opening it on first use.
+    // Pass a mutex for drivers that every thread sees (single-threaded and
+    // shared modes) so that only one thread creates them.
+    template<typename T>
+    GDAL::Driver::Ptr getOrOpenDriver(
+        const T* layer,
+        GDAL::Driver::Ptr& driver,
+        std::mutex* mutex)
+    {
+        std::unique_lock<std::mutex> lock;
+        if (mutex)
+            lock = std::unique_lock<std::mutex>(*mutex);
+
+        if (driver == nullptr)
+        {
+            // calling openImpl with NULL params limits the setup
+            // since we already called this during openImplementation
+            osg::ref_ptr<const Profile> profile = layer->getProfile();
+            openOnThisThread(layer, driver, &profile, nullptr, false);
+        }
+        return driver;
+    }
 }
 
 //......................................................................
@@ -1715,6 +1893,9 @@ OE_LAYER_PROPERTY_IMPL(GDALImageLayer, RasterInterpolation, Interpolation, inter
 void GDALImageLayer::setSingleThreaded(bool value) { options().singleThreaded() = value; }
 bool GDALImageLayer::getSingleThreaded() const { return options().singleThreaded().get(); }
 
+void GDALImageLayer::setSharedDataset(bool value) { options().sharedDataset() = value; }
+bool GDALImageLayer::getSharedDataset() const { return options().sharedDataset().get(); }
+
 
 void
 GDALImageLayer::init()
@@ -1748,10 +1929,15 @@ GDALImageLayer::openImplementation()
     // GDAL thread-safety requirement: each thread requires a separate GDALDataSet.
     // So we just encapsulate the entire setup once per thread.
     // https://trac.osgeo.org/gdal/wiki/FAQMiscellaneous#IstheGDALlibrarythread-safe
+    // In shared-dataset mode a single driver serves all threads instead, and
+    // guards its own dataset access.
 
     // Note: no need to mutex the _driverSingleThreaded instance since we are in open
     // and open is single-threaded by definition.
-    GDAL::Driver::Ptr& driver = getSingleThreaded() ? _driverSingleThreaded : _driverPerThread.get();
+    GDAL::Driver::Ptr& driver =
+        getSingleThreaded() ? _driverSingleThreaded :
+        getSharedDataset() ? _driverShared :
+        _driverPerThread.get();
 
     DataExtentList dataExtents;
 
@@ -1783,6 +1969,7 @@ GDALImageLayer::closeImplementation()
     Util::ScopedWriteLock unique_lock(_createCloseMutex);
     _driverPerThread.clear();
     _driverSingleThreaded = nullptr;
+    _driverShared = nullptr;
 
     return ImageLayer::closeImplementation();
 }
@@ -1799,15 +1986,12 @@ GDALImageLayer::createImageImplementation(const TileKey& key, ProgressCallback*
     if (!isOpen())
         return GeoImage::INVALID;
 
-    GDAL::Driver::Ptr& driver = getSingleThreaded() ? _driverSingleThreaded : _driverPerThread.get();
-
-    if (driver == nullptr)
-    {
-        // calling openImpl with NULL params limits the setup
-        // since we already called this during openImplementation
-        osg::ref_ptr<const Profile> profile = getProfile();
-        openOnThisThread(this, driver, &profile, nullptr, false);
-    }
+    GDAL::Driver::Ptr driver = getOrOpenDriver(
+        this,
+        getSingleThreaded() ? _driverSingleThreaded :
+        getSharedDataset() ? _driverShared :
+        _driverPerThread.get(),
+        getSingleThreaded() || getSharedDataset() ? &_driverMutex : nullptr);
 
     if (driver != nullptr)
     {
@@ -1857,6 +2041,9 @@ OE_LAYER_PROPERTY_IMPL(GDALElevationLayer, bool, UseVRT, useVRT);
 void GDALElevationLayer::setSingleThreaded(bool value) { options().singleThreaded() = value; }
 bool GDALElevationLayer::getSingleThreaded() const { return options().singleThreaded().get(); }
 
+void GDALElevationLayer::setSharedDataset(bool value) { options().sharedDataset() = value; }
+bool GDALElevationLayer::getSharedDataset() const { return options().sharedDataset().get(); }
+
 void
 GDALElevationLayer::setExternalDataset(GDAL::ExternalDataset* value)
 {
@@ -1882,9 +2069,14 @@ GDALElevationLayer::openImplementation()
     // GDAL thread-safety requirement: each thread requires a separate GDALDataSet.
     // So we just encapsulate the entire setup once per thread.
     // https://trac.osgeo.org/gdal/wiki/FAQMiscellaneous#IstheGDALlibrarythread-safe
+    // In shared-dataset mode a single driver serves all threads instead, and
+    // guards its own dataset access.
 
     // Open the dataset temporarily to query the profile and extents.
-    GDAL::Driver::Ptr& driver = getSingleThreaded() ? _driverSingleThreaded :  _driverPerThread.get();
+    GDAL::Driver::Ptr& driver =
+        getSingleThreaded() ? _driverSingleThreaded :
+        getSharedDataset() ? _driverShared :
+        _driverPerThread.get();
 
     DataExtentList dataExtents;
 
@@ -1916,6 +2108,7 @@ GDALElevationLayer::closeImplementation()
         Util::ScopedWriteLock unique_lock(_createCloseMutex);
         _driverPerThread.clear();
         _driverSingleThreaded = nullptr;
+        _driverShared = nullptr;
     }
 
     return ElevationLayer::closeImplementation();
@@ -1933,15 +2126,12 @@ GDALElevationLayer::createHeightFieldImplementation(const TileKey& key, Progress
     if (!isOpen())
         return GeoHeightField::INVALID;
 
-    GDAL::Driver::Ptr& driver = getSingleThreaded() ? _driverSingleThreaded : _driverPerThread.get();
-
-    if (driver == nullptr)
-    {
-        // calling openImpl with NULL params limits the setup
-        // since we already called this during openImplementation
-        osg::ref_ptr<const Profile> profile = getProfile();
-        openOnThisThread(this, driver, &profile, nullptr, false);
-    }
+    GDAL::Driver::Ptr driver = getOrOpenDriver(
+        this,
+        getSingleThreaded() ? _driverSingleThreaded :
+        getSharedDataset() ? _driverShared :
+        _driverPerThread.get(),
+        getSingleThreaded() || getSharedDataset() ? &_driverMutex : nullptr);
 
     if (driver != nullptr)
     {
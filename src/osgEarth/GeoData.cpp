@@ -2144,6 +2144,307 @@ namespace
     }
 }
 
+namespace
+{
+    // Storage-type traits for the reprojection kernel. These reproduce the
+    // exact float conversions ImageUtils::PixelReader/PixelWriter perform so
+    // the results match manualReproject bit for bit.
+    template<typename T> struct ReprojectType;
+
+    template<> struct ReprojectType<GLubyte>
+    {
+        static double scale() { return 1.0 / 255.0; } // normalized
+    };
+
+    template<> struct ReprojectType<GLfloat>
+    {
+        static double scale() { return 1.0; }
+    };
+
+    // Row-major, format-specialized replacement for manualReproject's inner
+    // loop. T is the channel type, N the number of channels. The pixel
+    // readers for multi-channel formats scale in float precision, and the
+    // single-channel ones in double precision; FSCALE selects which.
+    template<typename T, unsigned N, bool FSCALE>
+    struct ReprojectKernel
+    {
+        const osg::Image* src;
+        osg::Image* dst;
+        const double* srcX; // source-space sample grid, row-major
+        const double* srcY;
+        double xmin, ymin, xmax, ymax;
+        double xfac, yfac;
+        bool interpolate;
+        const double dscale = ReprojectType<T>::scale();
+        const float fscale = (float)ReprojectType<T>::scale();
+
+        inline float read(T v) const
+        {
+            return FSCALE ? float(v) * fscale : (float)(float(v) * dscale);
+        }
+
+        inline T write(float c) const
+        {
+            return (T)(c / dscale);
+        }
+
+        inline void readPixel(float* out, int s, int t, int r) const
+        {
+            const T* ptr = reinterpret_cast<const T*>(src->data(s, t, r));
+            for (unsigned i = 0; i < N; ++i)
+                out[i] = read(ptr[i]);
+        }
+
+        void operator()(unsigned row) const
+        {
+            const int src_s = src->s(), src_t = src->t();
+            const unsigned width = dst->s();
+
+            float ll[N], lr[N], ul[N], ur[N], color[N];
+
+            for (int depth = 0; depth < src->r(); ++depth)
+            {
+                T* out = reinterpret_cast<T*>(dst->data(0, row, depth));
+                const double* xs = srcX + row * width;
+                const double* ys = srcY + row * width;
+
+                for (unsigned col = 0; col < width; ++col, out += N)
+                {
+                    double src_x = xs[col];
+                    double src_y = ys[col];
+
+                    // outside the source extent: leave it transparent
+                    if (src_x < xmin || src_x > xmax || src_y < ymin || src_y > ymax)
+                        continue;
+
+                    float px = (src_x - xmin) * xfac;
+                    float py = (src_y - ymin) * yfac;
+
+                    int px_i = osg::clampBetween((int)osg::round(px), 0, src_s - 1);
+                    int py_i = osg::clampBetween((int)osg::round(py), 0, src_t - 1);
+
+                    if (!interpolate)
+                    {
+                        readPixel(color, px_i, py_i, depth);
+                    }
+                    else
+                    {
+                        int rowMin = osg::maximum((int)floor(py), 0);
+                        int rowMax = osg::maximum(osg::minimum((int)ceil(py), src_t - 1), 0);
+                        int colMin = osg::maximum((int)floor(px), 0);
+                        int colMax = osg::maximum(osg::minimum((int)ceil(px), src_s - 1), 0);
+
+                        if (rowMin > rowMax) rowMin = rowMax;
+                        if (colMin > colMax) colMin = colMax;
+
+                        if ((colMax == colMin) && (rowMax == rowMin))
+                        {
+                            readPixel(color, px_i, py_i, depth);
+                        }
+                        else if (colMax == colMin)
+                        {
+                            readPixel(ll, colMin, rowMin, depth);
+                            readPixel(ul, colMin, rowMax, depth);
+                            float w0 = (float)rowMax - py, w1 = py - (float)rowMin;
+                            for (unsigned i = 0; i < N; ++i)
+                                color[i] = w0 * ll[i] + w1 * ul[i];
+                        }
+                        else if (rowMax == rowMin)
+                        {
+                            readPixel(ll, colMin, rowMin, depth);
+                            readPixel(lr, colMax, rowMin, depth);
+                            float w0 = (float)colMax - px, w1 = px - (float)colMin;
+                            for (unsigned i = 0; i < N; ++i)
+                                color[i] = w0 * ll[i] + w1 * lr[i];
+                        }
+                        else
+                        {
+                            readPixel(ll, colMin, rowMin, depth);
+                            readPixel(lr, colMax, rowMin, depth);
+                            readPixel(ul, colMin, rowMax, depth);
+                            readPixel(ur, colMax, rowMax, depth);
+                            float col1 = colMax - px, col2 = px - colMin;
+                            float row1 = rowMax - py, row2 = py - rowMin;
+                            for (unsigned i = 0; i < N; ++i)
+                            {
+                                float r1 = col1 * ll[i] + col2 * lr[i];
+                                float r2 = col1 * ul[i] + col2 * ur[i];
+                                color[i] = row1 * r1 + row2 * r2;
+                            }
+                        }
+                    }
+
+                    for (unsigned i = 0; i < N; ++i)
+                        out[i] = write(color[i]);
+                }
+            }
+        }
+    };
+
+    template<typename T, unsigned N, bool FSCALE>
+    void fastReproject(
+        const osg::Image* image, osg::Image* result,
+        const GeoExtent& src_extent, const double* srcX, const double* srcY,
+        bool interpolate)
+    {
+        ReprojectKernel<T, N, FSCALE> kernel;
+        kernel.src = image;
+        kernel.dst = result;
+        kernel.srcX = srcX;
+        kernel.srcY = srcY;
+        kernel.xmin = src_extent.xMin(), kernel.ymin = src_extent.yMin();
+        kernel.xmax = src_extent.xMax(), kernel.ymax = src_extent.yMax();
+        kernel.xfac = (image->s() - 1) / src_extent.width();
+        kernel.yfac = (image->t() - 1) / src_extent.height();
+        kernel.interpolate = interpolate;
+
+        // split large images across a job pool, 16 rows at a time
+        jobs::jobpool* pool = result->s() * result->t() >= 256 * 256 ?
+            jobs::get_pool("oe.reproject") : nullptr;
+
+        jobs::parallel_for(pool, result->t(), 16, [&kernel](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t row = begin; row < end; ++row)
+                    kernel((unsigned)row);
+            });
+    }
+
+    // Same contract and output as manualReproject, but it samples the
+    // destination in row-major order with a kernel specialized for the pixel
+    // format. Returns nullptr for formats it doesn't handle.
+    osg::Image* manualReprojectFast(
+        const osg::Image* image,
+        const GeoExtent&  src_extent,
+        const GeoExtent&  dest_extent,
+        bool              interpolate,
+        unsigned int      width = 0,
+        unsigned int      height = 0)
+    {
+        OE_PROFILING_ZONE;
+
+        GLenum type = image->getDataType();
+        GLenum format = image->getPixelFormat();
+
+        if (type != GL_UNSIGNED_BYTE && type != GL_FLOAT)
+            return nullptr;
+
+        unsigned numChannels = 0u;
+        switch (format)
+        {
+        case GL_RED:
+        case GL_LUMINANCE:
+        case GL_ALPHA:
+            numChannels = 1; break;
+        case GL_RG:
+        case GL_LUMINANCE_ALPHA:
+            numChannels = 2; break;
+        case GL_RGB:
+        case GL_BGR:
+            numChannels = 3; break;
+        case GL_RGBA:
+        case GL_BGRA:
+            numChannels = 4; break;
+        default:
+            return nullptr;
+        }
+
+        if (width == 0 || height == 0)
+        {
+            //If no width and height are specified, just use the minimum dimension for the image
+            width = osg::minimum(image->s(), image->t());
+            height = osg::minimum(image->s(), image->t());
+        }
+
+        osg::Image *result = new osg::Image();
+        result->allocateImage(width, height, image->r(), image->getPixelFormat(), image->getDataType());
+        result->setInternalTextureFormat(image->getInternalTextureFormat());
+        memset(result->data(), 0, result->getImageSizeInBytes());
+
+        const double dx = dest_extent.width() / (double)width;
+        const double dy = dest_extent.height() / (double)height;
+
+        // Build the pixel-center sample grid in row-major order, using the
+        // same arithmetic as SpatialReference::transformGrid.
+        const double in_xmin = dest_extent.xMin() + .5 * dx, in_xmax = dest_extent.xMax() - .5 * dx;
+        const double in_ymin = dest_extent.yMin() + .5 * dy, in_ymax = dest_extent.yMax() - .5 * dy;
+        const double gdx = (in_xmax - in_xmin) / (width - 1);
+        const double gdy = (in_ymax - in_ymin) / (height - 1);
+
+        unsigned numPixels = width * height;
+        std::vector<osg::Vec3d> points(numPixels);
+        for (unsigned r = 0; r < height; ++r)
+        {
+            double dest_y = in_ymin + (double)r * gdy;
+            for (unsigned c = 0; c < width; ++c)
+            {
+                points[r * width + c].set(in_xmin + (double)c * gdx, dest_y, 0.0);
+            }
+        }
+
+        if (!dest_extent.getSRS()->transform(points, src_extent.getSRS()))
+            return result;
+
+        std::vector<double> srcXY(numPixels * 2);
+        double* srcX = srcXY.data();
+        double* srcY = srcX + numPixels;
+        for (unsigned i = 0; i < numPixels; ++i)
+        {
+            srcX[i] = points[i].x();
+            srcY[i] = points[i].y();
+        }
+        points = std::vector<osg::Vec3d>();
+
+        if (type == GL_UNSIGNED_BYTE)
+        {
+            switch (numChannels)
+            {
+            case 1: fastReproject<GLubyte, 1, false>(image, result, src_extent, srcX, srcY, interpolate); break;
+            case 2: fastReproject<GLubyte, 2, true>(image, result, src_extent, srcX, srcY, interpolate); break;
+            case 3: fastReproject<GLubyte, 3, true>(image, result, src_extent, srcX, srcY, interpolate); break;
+            case 4: fastReproject<GLubyte, 4, true>(image, result, src_extent, srcX, srcY, interpolate); break;
+            }
+        }
+        else // GL_FLOAT
+        {
+            switch (numChannels)
+            {
+            case 1: fastReproject<GLfloat, 1, false>(image, result, src_extent, srcX, srcY, interpolate); break;
+            case 2: fastReproject<GLfloat, 2, true>(image, result, src_extent, srcX, srcY, interpolate); break;
+            case 3: fastReproject<GLfloat, 3, true>(image, result, src_extent, srcX, srcY, interpolate); break;
+            case 4: fastReproject<GLfloat, 4, true>(image, result, src_extent, srcX, srcY, interpolate); break;
+            }
+        }
+
+        return result;
+    }
+}
+
+GeoImage
+GeoImage::reprojectManual(
+    const GeoExtent& to_extent,
+    unsigned int width,
+    unsigned int height,
+    bool useBilinearInterpolation,
+    bool useReferenceImplementation) const
+{
+    if (!valid())
+        return GeoImage::INVALID;
+
+    osg::Image* resultImage = nullptr;
+
+    if (!useReferenceImplementation)
+    {
+        resultImage = manualReprojectFast(getImage(), getExtent(), to_extent, useBilinearInterpolation, width, height);
+    }
+
+    if (resultImage == nullptr)
+    {
+        resultImage = manualReproject(getImage(), getExtent(), to_extent, useBilinearInterpolation, width, height);
+    }
+
+    return GeoImage(resultImage, to_extent);
+}
+
 GeoImage
 GeoImage::reproject(const SpatialReference* to_srs, const GeoExtent* to_extent, unsigned int width, unsigned int height, bool useBilinearInterpolation) const
 {  
@@ -2162,7 +2463,10 @@ GeoImage::reproject(const SpatialReference* to_srs, const GeoExtent* to_extent,
     {
         // if either of the SRS is a custom projection or it is a 3D image, we have to do a manual reprojection since
         // GDAL will not recognize the SRS and does not handle 3D images.
-        resultImage = manualReproject(getImage(), getExtent(), destExtent, useBilinearInterpolation, width, height);
+        resultImage = manualReprojectFast(getImage(), getExtent(), destExtent, useBilinearInterpolation, width, height);
+
+        if (resultImage == nullptr)
+            resultImage = manualReproject(getImage(), getExtent(), destExtent, useBilinearInterpolation, width, height);
     }
     else
     {
@@ -29,6 +29,8 @@
 #include <osgDB/ReadFile>
 #include <osgDB/FileNameUtils>
 #include <curl/curl.h>
+#include <atomic>
+#include <thread>
 
 // Whether to use WinInet instead of cURL - CMAKE option
 #ifdef OSGEARTH_USE_WININET_FOR_HTTP
@@ -46,6 +48,7 @@
 
 using namespace osgEarth;
 using namespace osgEarth::Util;
+using namespace osgEarth::Threading;
 
 namespace osgEarth
 {
@@ -443,6 +446,8 @@ namespace
     static long                        s_connectTimeout = 0;
     static float                       s_retryDelay_s = 0.5f;
 
+    static unsigned                    s_maxConnectionsPerHost = 8u;
+
     // HTTP debugging.
     static bool                        s_HTTP_DEBUG = false;
     static std::mutex            s_HTTP_DEBUG_mutex;
@@ -452,60 +457,76 @@ namespace
     static osg::ref_ptr< URLRewriter > s_rewriter;
 
     static osg::ref_ptr< ConfigHandler > s_curlConfigHandler;
+
+    // The global settings, with any environment variable overrides applied
+    std::string getEffectiveUserAgent()
+    {
+        const char* userAgentEnv = getenv("OSGEARTH_USERAGENT");
+        return userAgentEnv ? std::string(userAgentEnv) : s_userAgent;
+    }
+
+    long getEffectiveTimeout()
+    {
+        const char* timeoutEnv = getenv("OSGEARTH_HTTP_TIMEOUT");
+        return timeoutEnv ? osgEarth::as<long>(std::string(timeoutEnv), 0) : s_timeout;
+    }
+
+    long getEffectiveConnectTimeout()
+    {
+        const char* connectTimeoutEnv = getenv("OSGEARTH_HTTP_CONNECTTIMEOUT");
+        return connectTimeoutEnv ? osgEarth::as<long>(std::string(connectTimeoutEnv), 0) : s_connectTimeout;
+    }
+
+    unsigned getEffectiveMaxConnectionsPerHost()
+    {
+        const char* maxEnv = getenv("OSGEARTH_HTTP_MAX_CONNECTIONS_PER_HOST");
+        return maxEnv ? osgEarth::as<unsigned>(std::string(maxEnv), s_maxConnectionsPerHost) : s_maxConnectionsPerHost;
+    }
 }
 
 //.........................................................................
 
 namespace
 {
-    class CURLImplementation : public HTTPClient::Implementation
+    void readProxyOptions(const osgDB::Options* options, std::string& proxy_host, std::string& proxy_port)
     {
-    public:
-        CURLImplementation() : _curl_handle(0), _previousHttpAuthentication(0) { }
-
-        void initialize()
+        // try to set proxy host/port by reading the CURL proxy options
+        if ( options )
         {
-            _previousHttpAuthentication = 0L;
-
-            _curl_handle = curl_easy_init();
-
-            curl_easy_setopt( _curl_handle, CURLOPT_WRITEFUNCTION, StreamObjectReadCallback );
-            curl_easy_setopt( _curl_handle, CURLOPT_HEADERFUNCTION, StreamObjectHeaderCallback );
-            curl_easy_setopt( _curl_handle, CURLOPT_FOLLOWLOCATION, (void*)1 );
-            curl_easy_setopt( _curl_handle, CURLOPT_MAXREDIRS, (void*)5 );
-            curl_easy_setopt( _curl_handle, CURLOPT_PROGRESSFUNCTION, &CurlProgressCallback);
-            curl_easy_setopt( _curl_handle, CURLOPT_NOPROGRESS, (void*)0 ); //0=enable.
-            curl_easy_setopt( _curl_handle, CURLOPT_FILETIME, true );
-
-#ifdef OE_CURL_SHARE
-            curl_easy_setopt( _curl_handle, CURLOPT_SHARE, CURL_SHARE);
-#endif
-
-            // Enable automatic CURL decompression of known types. An empty string will automatically add all supported encoding types that are built into curl.
-            // Note that you must have curl built against zlib to support gzip or deflate encoding.
-            curl_easy_setopt( _curl_handle, CURLOPT_ENCODING, "");
-
-            osg::ref_ptr< ConfigHandler > curlConfigHandler = HTTPClient::getConfigHandler();
-            if (curlConfigHandler.valid()) {
-                curlConfigHandler->onInitialize(_curl_handle);
+            std::istringstream iss( options->getOptionString() );
+            std::string opt;
+            while( iss >> opt )
+            {
+                int index = opt.find('=');
+                if( opt.substr( 0, index ) == "OSG_CURL_PROXY" )
+                {
+                    proxy_host = opt.substr( index+1 );
+                }
+                else if ( opt.substr( 0, index ) == "OSG_CURL_PROXYPORT" )
+                {
+                    proxy_port = opt.substr( index+1 );
+                }
             }
         }
+    }
 
-        ~CURLImplementation()
+    /**
+     * Everything a cURL GET needs to know besides the handle itself:
+     * the final URL, proxy, credentials and request headers. Shared by
+     * the blocking implementation and the multiplexed engine.
+     */
+    struct CurlGetSetup
+    {
+        std::string url;
+        std::string proxy_addr;
+        std::string proxy_auth;
+        std::string password;
+        const osgDB::AuthenticationDetails* details = nullptr;
+        struct curl_slist* headers = nullptr;
+
+        CurlGetSetup(const HTTPRequest& request, const osgDB::Options* options)
         {
-            if (_curl_handle)
-                curl_easy_cleanup( _curl_handle );
-            _curl_handle = 0;
-        }
-
-        HTTPResponse doGet(
-            const HTTPRequest&    request,
-            const osgDB::Options* options,
-            ProgressCallback*     progress ) const
-        {            
-            OE_START_TIMER(http_get);
-
-            std::string url = request.getURL();
+            url = request.getURL();
 
             const osgDB::AuthenticationMap* authenticationMap = (options && options->getAuthenticationMap()) ?
                 options->getAuthenticationMap() :
@@ -513,7 +534,6 @@ namespace
 
             std::string proxy_host;
             std::string proxy_port = "8080";
-            std::string proxy_auth;
 
             //TODO: don't do all this proxy setup on every GET. Just do it once per client, or only when
             // the proxy information changes.
@@ -535,7 +555,7 @@ namespace
             }
 
             //Try to get the proxy settings from the local options that are passed in.
-            readOptions( options, proxy_host, proxy_port );
+            readProxyOptions( options, proxy_host, proxy_port );
 
             optional< ProxySettings > proxySettings;
             ProxySettings::fromOptions( options, proxySettings );
@@ -565,23 +585,67 @@ namespace
                 proxy_auth = std::string(proxyEnvAuth);
             }
 
-            // Set up proxy server:
-            std::string proxy_addr;
             if ( !proxy_host.empty() )
             {
                 std::stringstream buf;
                 buf << proxy_host << ":" << proxy_port;
-                std::string bufStr;
-                bufStr = buf.str();
-                proxy_addr = bufStr;
+                proxy_addr = buf.str();
+            }
+
+            // Rewrite the url if the url rewriter is available
+            osg::ref_ptr< URLRewriter > rewriter = HTTPClient::getURLRewriter();
+            if ( rewriter.valid() )
+            {
+                std::string oldURL = url;
+                url = rewriter->rewrite( oldURL );
+                OE_TEST << LC << "Rewrote URL " << oldURL << " to " << url << std::endl;
+            }
 
+            details = authenticationMap ?
+                authenticationMap->getAuthenticationDetails( url ) :
+                0;
+
+            if (details)
+            {
+                const std::string colon(":");
+                password = details->username + colon + details->password;
+            }
+
+            // Set any headers
+            if (!request.getHeaders().empty())
+            {
+                for (HTTPRequest::Parameters::const_iterator itr = request.getHeaders().begin(); itr != request.getHeaders().end(); ++itr)
+                {
+                    std::stringstream buf;
+                    buf << osgEarth::toLower(itr->first) << ": " << itr->second;
+                    headers = curl_slist_append(headers, buf.str().c_str());
+                }
+            }
+
+            // Disable the default Pragma: no-cache that curl adds by default.
+            headers = curl_slist_append(headers, "pragma: ");
+        }
+
+        ~CurlGetSetup()
+        {
+            if (headers)
+            {
+                curl_slist_free_all(headers);
+            }
+        }
+
+        //! Applies the proxy settings to a handle
+        void applyProxy(CURL* handle) const
+        {
+            if ( !proxy_addr.empty() )
+            {
                 if ( s_HTTP_DEBUG )
                 {
                     OE_NOTICE << LC << "Using proxy: " << proxy_addr << std::endl;
                 }
 
-                //curl_easy_setopt( _curl_handle, CURLOPT_HTTPPROXYTUNNEL, 1 );
-                curl_easy_setopt( _curl_handle, CURLOPT_PROXY, proxy_addr.c_str() );
+                //curl_easy_setopt( handle, CURLOPT_HTTPPROXYTUNNEL, 1 );
+                curl_easy_setopt( handle, CURLOPT_PROXY, proxy_addr.c_str() );
 
                 //Setup the proxy authentication if setup
                 if (!proxy_auth.empty())
@@ -591,42 +655,246 @@ namespace
                         OE_NOTICE << LC << "Using proxy authentication " << proxy_auth << std::endl;
                     }
 
-                    curl_easy_setopt( _curl_handle, CURLOPT_PROXYUSERPWD, proxy_auth.c_str());
+                    curl_easy_setopt( handle, CURLOPT_PROXYUSERPWD, proxy_auth.c_str());
+                }
+                else
+                {
+                    // handles are reused, so clear any earlier request's credentials
+                    curl_easy_setopt( handle, CURLOPT_PROXYUSERPWD, nullptr );
                 }
             }
             else
             {
-                curl_easy_setopt( _curl_handle, CURLOPT_PROXY, 0 );
+                curl_easy_setopt( handle, CURLOPT_PROXY, 0 );
+                curl_easy_setopt( handle, CURLOPT_PROXYUSERPWD, nullptr );
             }
+        }
+    };
 
-            // Rewrite the url if the url rewriter is available
-            osg::ref_ptr< URLRewriter > rewriter = HTTPClient::getURLRewriter();
-            if ( rewriter.valid() )
+    /**
+     * Builds an HTTPResponse from a finished cURL transfer.
+     */
+    HTTPResponse makeCurlResponse(
+        CURL* handle,
+        CURLcode res,
+        const CurlGetSetup& setup,
+        const HTTPRequest& request,
+        HTTPResponse::Part* part,
+        StreamObject& sp,
+        osg::Timer_t startTime)
+    {
+        long response_code = 0L;
+
+        // check for cancel or timeout:
+        if (res == CURLE_ABORTED_BY_CALLBACK || res == CURLE_OPERATION_TIMEDOUT)
+        {
+            // CURLE_ABORTED_BY_CALLBACK means ProgressCallback cancelation.
+            HTTPResponse response;
+            response.setCanceled(true);
+            return response;
+        }
+
+        if (!setup.proxy_addr.empty())
+        {
+            long connect_code = 0L;
+            CURLcode r = curl_easy_getinfo(handle, CURLINFO_HTTP_CONNECTCODE, &connect_code);
+            if ( r != CURLE_OK )
             {
-                std::string oldURL = url;
-                url = rewriter->rewrite( oldURL );
-                OE_TEST << LC << "Rewrote URL " << oldURL << " to " << url << std::endl;
+                OE_WARN << LC << "Proxy connect error: " << curl_easy_strerror(r) << std::endl;
+                return HTTPResponse(0);
             }
+        }
 
-            const osgDB::AuthenticationDetails* details = authenticationMap ?
-                authenticationMap->getAuthenticationDetails( url ) :
-                0;
+        curl_easy_getinfo( handle, CURLINFO_RESPONSE_CODE, &response_code );
 
-            if (details)
+        if (s_simResponseCode > 0)
+        {
+            unsigned hash = std::hash<double>()(osg::Timer::instance()->tick()) % 10;
+            if (hash == 0)
+                response_code = s_simResponseCode;
+        }
+
+        HTTPResponse response( response_code );
+
+
+
+        // read the response content type:
+        char* content_type_cp;
+
+        curl_easy_getinfo( handle, CURLINFO_CONTENT_TYPE, &content_type_cp );
+
+        if ( content_type_cp != NULL )
+        {
+            response.setMimeType(content_type_cp);
+        }
+
+        // read the file time:
+        response.setLastModified(getCurlFileTime( handle ));
+
+        if (res == CURLE_OK)
+        {
+            // check for multipart content
+            if (response.getMimeType().length() > 9 &&
+                ::strstr( response.getMimeType().c_str(), "multipart" ) == response.getMimeType().c_str() )
             {
-                const std::string colon(":");
-                std::string password(details->username + colon + details->password);
-                curl_easy_setopt(_curl_handle, CURLOPT_USERPWD, password.c_str());
-                _previousPassword = password;
+                OE_TEST << LC << "detected multipart data; decoding..." << std::endl;
+
+                //TODO: parse out the "wcs" -- this is WCS-specific
+                if ( !decodeMultipartStream( "wcs", part, response.getParts() ) )
+                {
+                    // error decoding an invalid multipart stream.
+                    // should we do anything, or just leave the response empty?
+                }
+            }
+            else
+            {
+                for (Headers::iterator itr = sp._headers.begin(); itr != sp._headers.end(); ++itr)
+                {
+                    part->_headers[itr->first] = itr->second;
+                }
+
+                // Write the headers to the metadata
+                response.getParts().push_back( part );
+            }
+        }
+
+        else
+        {
+            response.setMessage(curl_easy_strerror(res));
+
+            if (res == CURLE_GOT_NOTHING)
+            {
+                OE_TEST << LC << "CURLE_GOT_NOTHING for " << setup.url << std::endl;
+            }
+        }
+
+        response.setDuration(osg::Timer::instance()->delta_s(startTime, osg::Timer::instance()->tick()));
+
+        if ( s_HTTP_DEBUG )
+        {
+            TimeStamp filetime = getCurlFileTime(handle);
+
+            OE_NOTICE << LC
+                << "GET(" << response_code << ") " << response.getMimeType() << ": \""
+                << setup.url << "\" (" << DateTime(filetime).asRFC1123() << ") t="
+                << std::setprecision(4) << response.getDuration() << "s" << std::endl;
+
+            for(HTTPRequest::Parameters::const_iterator itr = request.getHeaders().begin();
+                itr != request.getHeaders().end();
+                ++itr)
+            {
+                OE_NOTICE << LC << "    Header: " << itr->first << " = " << itr->second << std::endl;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(s_HTTP_DEBUG_mutex);
+                s_HTTP_DEBUG_request_count++;
+                s_HTTP_DEBUG_total_duration += response.getDuration();
+
+                if ( s_HTTP_DEBUG_request_count % 60 == 0 )
+                {
+                    OE_NOTICE << LC << "Average duration = " << s_HTTP_DEBUG_total_duration/(double)s_HTTP_DEBUG_request_count
+                        << std::endl;
+                }
+            }
+
+#if 0
+            // time details - almost 100% of the time is spent in
+            // STARTTRANSFER, which is the time until the first byte is received.
+            double td[7];
+
+            curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME,         &td[0]);
+            curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME,    &td[1]);
+            curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME,       &td[2]);
+            curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME,    &td[3]);
+            curl_easy_getinfo(handle, CURLINFO_PRETRANSFER_TIME,   &td[4]);
+            curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME, &td[5]);
+            curl_easy_getinfo(handle, CURLINFO_REDIRECT_TIME,      &td[6]);
+
+            for(int i=0; i<7; ++i)
+            {
+                OE_NOTICE << LC
+                    << std::setprecision(4)
+                    << "TIMES: total=" <<td[0]
+                    << ", lookup=" <<td[1]<<" ("<<(int)((td[1]/td[0])*100)<<"%)"
+                    << ", connect=" <<td[2]<<" ("<<(int)((td[2]/td[0])*100)<<"%)"
+                    << ", appconn=" <<td[3]<<" ("<<(int)((td[3]/td[0])*100)<<"%)"
+                    << ", prexfer=" <<td[4]<<" ("<<(int)((td[4]/td[0])*100)<<"%)"
+                    << ", startxfer=" <<td[5]<<" ("<<(int)((td[5]/td[0])*100)<<"%)"
+                    << ", redir=" <<td[6]<<" ("<<(int)((td[6]/td[0])*100)<<"%)"
+                    << std::endl;
+            }
+#endif
+        }
+
+        return response;
+    }
+
+    class CURLImplementation : public HTTPClient::Implementation
+    {
+    public:
+        CURLImplementation() : _curl_handle(0), _previousHttpAuthentication(0) { }
+
+        void initialize()
+        {
+            _previousHttpAuthentication = 0L;
+
+            _curl_handle = curl_easy_init();
+
+            curl_easy_setopt( _curl_handle, CURLOPT_WRITEFUNCTION, StreamObjectReadCallback );
+            curl_easy_setopt( _curl_handle, CURLOPT_HEADERFUNCTION, StreamObjectHeaderCallback );
+            curl_easy_setopt( _curl_handle, CURLOPT_FOLLOWLOCATION, (void*)1 );
+            curl_easy_setopt( _curl_handle, CURLOPT_MAXREDIRS, (void*)5 );
+            curl_easy_setopt( _curl_handle, CURLOPT_PROGRESSFUNCTION, &CurlProgressCallback);
+            curl_easy_setopt( _curl_handle, CURLOPT_NOPROGRESS, (void*)0 ); //0=enable.
+            curl_easy_setopt( _curl_handle, CURLOPT_FILETIME, true );
+
+#ifdef OE_CURL_SHARE
+            curl_easy_setopt( _curl_handle, CURLOPT_SHARE, CURL_SHARE);
+#endif
+
+            // Enable automatic CURL decompression of known types. An empty string will automatically add all supported encoding types that are built into curl.
+            // Note that you must have curl built against zlib to support gzip or deflate encoding.
+            curl_easy_setopt( _curl_handle, CURLOPT_ENCODING, "");
+
+            osg::ref_ptr< ConfigHandler > curlConfigHandler = HTTPClient::getConfigHandler();
+            if (curlConfigHandler.valid()) {
+                curlConfigHandler->onInitialize(_curl_handle);
+            }
+        }
+
+        ~CURLImplementation()
+        {
+            if (_curl_handle)
+                curl_easy_cleanup( _curl_handle );
+            _curl_handle = 0;
+        }
+
+        HTTPResponse doGet(
+            const HTTPRequest&    request,
+            const osgDB::Options* options,
+            ProgressCallback*     progress ) const
+        {
+            OE_START_TIMER(http_get);
+
+            CurlGetSetup setup(request, options);
+
+            // Set up proxy server:
+            setup.applyProxy(_curl_handle);
+
+            if (setup.details)
+            {
+                curl_easy_setopt(_curl_handle, CURLOPT_USERPWD, setup.password.c_str());
+                _previousPassword = setup.password;
 
                 // use for https.
                 // curl_easy_setopt(_curl, CURLOPT_KEYPASSWD, password.c_str());
 
 #if LIBCURL_VERSION_NUM >= 0x070a07
-                if (details->httpAuthentication != _previousHttpAuthentication)
+                if (setup.details->httpAuthentication != _previousHttpAuthentication)
                 {
-                    curl_easy_setopt(_curl_handle, CURLOPT_HTTPAUTH, details->httpAuthentication);
-                    _previousHttpAuthentication = details->httpAuthentication;
+                    curl_easy_setopt(_curl_handle, CURLOPT_HTTPAUTH, setup.details->httpAuthentication);
+                    _previousHttpAuthentication = setup.details->httpAuthentication;
                 }
 #endif
             }
@@ -648,36 +916,20 @@ namespace
 #endif
             }
 
-
-            // Set any headers
-            struct curl_slist *headers=NULL;
-            if (!request.getHeaders().empty())
-            {
-                for (HTTPRequest::Parameters::const_iterator itr = request.getHeaders().begin(); itr != request.getHeaders().end(); ++itr)
-                {
-                    std::stringstream buf;
-                    buf << osgEarth::toLower(itr->first) << ": " << itr->second;
-                    headers = curl_slist_append(headers, buf.str().c_str());
-                }
-            }
-
-            // Disable the default Pragma: no-cache that curl adds by default.
-            headers = curl_slist_append(headers, "pragma: ");
-            curl_easy_setopt(_curl_handle, CURLOPT_HTTPHEADER, headers);
+            curl_easy_setopt(_curl_handle, CURLOPT_HTTPHEADER, setup.headers);
 
             osg::ref_ptr<HTTPResponse::Part> part = new HTTPResponse::Part();
             StreamObject sp( &part->_stream );
 
             //Take a temporary ref to the callback (why? dangerous.)
             //osg::ref_ptr<ProgressCallback> progressCallback = callback;
-            curl_easy_setopt( _curl_handle, CURLOPT_URL, url.c_str() );
+            curl_easy_setopt( _curl_handle, CURLOPT_URL, setup.url.c_str() );
             if (progress)
             {
                 curl_easy_setopt(_curl_handle, CURLOPT_PROGRESSDATA, progress);
             }
 
             CURLcode res;
-            long response_code = 0L;
 
             OE_START_TIMER(get_duration);
 
@@ -702,210 +954,402 @@ namespace
             curl_easy_setopt( _curl_handle, CURLOPT_WRITEDATA, (void*)0 );
             curl_easy_setopt( _curl_handle, CURLOPT_PROGRESSDATA, (void*)0);
 
-            // check for cancel or timeout:
-            if (res == CURLE_ABORTED_BY_CALLBACK || res == CURLE_OPERATION_TIMEDOUT)
-            {
-                // CURLE_ABORTED_BY_CALLBACK means ProgressCallback cancelation.
-                HTTPResponse response;
-                response.setCanceled(true);
-                return response;
-            }
-
-            if (!proxy_addr.empty())
-            {
-                long connect_code = 0L;
-                CURLcode r = curl_easy_getinfo(_curl_handle, CURLINFO_HTTP_CONNECTCODE, &connect_code);
-                if ( r != CURLE_OK )
-                {
-                    OE_WARN << LC << "Proxy connect error: " << curl_easy_strerror(r) << std::endl;
-
-                    // Free the headers
-                    if (headers)
-                    {
-                        curl_slist_free_all(headers);
-                    }
-
-                    return HTTPResponse(0);
-                }
-            }
+            return makeCurlResponse(_curl_handle, res, setup, request, part.get(), sp, get_duration_oe_timer);
+        }
 
-            curl_easy_getinfo( _curl_handle, CURLINFO_RESPONSE_CODE, &response_code );
+        void* getHandle() const
+        {
+            return _curl_handle;
+        }
 
-            if (s_simResponseCode > 0)
-            {
-                unsigned hash = std::hash<double>()(osg::Timer::instance()->tick()) % 10;
-                if (hash == 0)
-                    response_code = s_simResponseCode;
-            }
+        void setUserAgent(const std::string& value)
+        {
+            curl_easy_setopt( _curl_handle, CURLOPT_USERAGENT, value.c_str() );
+        }
 
-            HTTPResponse response( response_code );
+        void setTimeout(long value)
+        {
+            curl_easy_setopt( _curl_handle, CURLOPT_TIMEOUT, value );
+        }
 
+        void setConnectTimeout(long value)
+        {
+            curl_easy_setopt( _curl_handle, CURLOPT_CONNECTTIMEOUT, value );
+        }
 
+    private:
+        void* _curl_handle;
+        mutable std::string _previousPassword;
+        mutable long _previousHttpAuthentication;
+    };
 
-            // read the response content type:
-            char* content_type_cp;
+    /**
+     * One GET in flight on the multiplexed engine. Subclasses decide what
+     * happens with the response.
+     */
+    struct AsyncTransfer : public std::enable_shared_from_this<AsyncTransfer>
+    {
+        AsyncTransfer(const HTTPRequest& request_, const osgDB::Options* options_, ProgressCallback* progress_) :
+            request(request_),
+            options(options_),
+            progress(progress_) { }
+
+        virtual ~AsyncTransfer() { }
+
+        //! True if nobody is waiting for the result anymore
+        virtual bool abandoned() const = 0;
+
+        //! Delivers the response. Called on the network thread, so
+        //! anything expensive must be handed off to a job.
+        virtual void complete(HTTPResponse& response) = 0;
+
+        HTTPRequest request;
+        osg::ref_ptr<const osgDB::Options> options;
+        osg::ref_ptr<ProgressCallback> progress;
+
+        // in-flight state, owned by the network thread
+        std::unique_ptr<CurlGetSetup> setup;
+        osg::ref_ptr<HTTPResponse::Part> part;
+        std::unique_ptr<StreamObject> stream;
+        osg::Timer_t startTime = 0;
+        char errorBuf[CURL_ERROR_SIZE];
+    };
 
-            curl_easy_getinfo( _curl_handle, CURLINFO_CONTENT_TYPE, &content_type_cp );
+    using AsyncTransferPtr = std::shared_ptr<AsyncTransfer>;
 
-            if ( content_type_cp != NULL )
-            {
-                response.setMimeType(content_type_cp);
-            }
+    //! Transfer that resolves a future with the raw response.
+    struct ResponseTransfer : public AsyncTransfer
+    {
+        using AsyncTransfer::AsyncTransfer;
 
-            // read the file time:
-            response.setLastModified(getCurlFileTime( _curl_handle ));
+        Future<HTTPResponse> promise;
 
-            if (res == CURLE_OK)
-            {
-                // check for multipart content
-                if (response.getMimeType().length() > 9 &&
-                    ::strstr( response.getMimeType().c_str(), "multipart" ) == response.getMimeType().c_str() )
-                {
-                    OE_TEST << LC << "detected multipart data; decoding..." << std::endl;
+        bool abandoned() const override {
+            return promise.canceled();
+        }
 
-                    //TODO: parse out the "wcs" -- this is WCS-specific
-                    if ( !decodeMultipartStream( "wcs", part.get(), response.getParts() ) )
-                    {
-                        // error decoding an invalid multipart stream.
-                        // should we do anything, or just leave the response empty?
-                    }
-                }
-                else
-                {
-                    for (Headers::iterator itr = sp._headers.begin(); itr != sp._headers.end(); ++itr)
-                    {
-                        part->_headers[itr->first] = itr->second;
-                    }
+        void complete(HTTPResponse& response) override {
+            promise.resolve(response);
+        }
+    };
 
-                    // Write the headers to the metadata
-                    response.getParts().push_back( part.get() );
-                }
-            }
+    /**
+     * Runs many transfers at once on a single curl_multi handle serviced
+     * by one event-loop thread. Connections are reused across requests;
+     * against HTTP/2 servers, concurrent requests to the same host share
+     * one connection as separate streams.
+     */
+    class CURLMultiEngine
+    {
+    public:
+        //! The shared engine, started on first use.
+        static CURLMultiEngine& instance()
+        {
+            return *get(true);
+        }
 
-            else
-            {
-                response.setMessage(curl_easy_strerror(res));
+        //! Stops the shared engine's network thread, if it was ever started.
+        //! Called from HTTPClient::globalShutdown; the engine is never
+        //! destroyed, so static destruction never waits on the thread.
+        static void shutdownInstance()
+        {
+            CURLMultiEngine* engine = get(false);
+            if (engine)
+                engine->shutdown();
+        }
 
-                if (res == CURLE_GOT_NOTHING)
-                {
-                    OE_TEST << LC << "CURLE_GOT_NOTHING for " << url << std::endl;
-                }
-            }
+        //! Queues a transfer. The transfer completes on the network thread.
+        //! After shutdown the transfer is dropped, which abandons its future.
+        void submit(AsyncTransferPtr transfer)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_done)
+                return;
 
-            response.setDuration(OE_STOP_TIMER(get_duration));
+            _incoming.push_back(transfer);
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_wakeup(_multi);
+#endif
+        }
 
-            if ( s_HTTP_DEBUG )
-            {
-                TimeStamp filetime = getCurlFileTime(_curl_handle);
+    private:
+        static CURLMultiEngine* get(bool create)
+        {
+            static std::mutex s_mutex;
+            static CURLMultiEngine* s_engine = nullptr;
 
-                OE_NOTICE << LC
-                    << "GET(" << response_code << ") " << response.getMimeType() << ": \""
-                    << url << "\" (" << DateTime(filetime).asRFC1123() << ") t="
-                    << std::setprecision(4) << response.getDuration() << "s" << std::endl;
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (s_engine == nullptr && create)
+                s_engine = new CURLMultiEngine();
+            return s_engine;
+        }
 
-                for(HTTPRequest::Parameters::const_iterator itr = request.getHeaders().begin();
-                    itr != request.getHeaders().end(); 
-                    ++itr)
-                {
-                    OE_NOTICE << LC << "    Header: " << itr->first << " = " << itr->second << std::endl;
-                }
+        CURLMultiEngine() :
+            _done(false)
+        {
+            _multi = curl_multi_init();
 
-                {
-                    std::lock_guard<std::mutex> lock(s_HTTP_DEBUG_mutex);
-                    s_HTTP_DEBUG_request_count++;
-                    s_HTTP_DEBUG_total_duration += response.getDuration();
+#ifdef CURLPIPE_MULTIPLEX
+            curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x071e00
+            curl_multi_setopt(_multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)getEffectiveMaxConnectionsPerHost());
+#endif
 
-                    if ( s_HTTP_DEBUG_request_count % 60 == 0 )
-                    {
-                        OE_NOTICE << LC << "Average duration = " << s_HTTP_DEBUG_total_duration/(double)s_HTTP_DEBUG_request_count
-                            << std::endl;
-                    }
-                }
+            _thread = std::thread([this]() { run(); });
+        }
 
-#if 0
-                // time details - almost 100% of the time is spent in
-                // STARTTRANSFER, which is the time until the first byte is received.
-                double td[7];
-
-                curl_easy_getinfo(_curl_handle, CURLINFO_TOTAL_TIME,         &td[0]);
-                curl_easy_getinfo(_curl_handle, CURLINFO_NAMELOOKUP_TIME,    &td[1]);
-                curl_easy_getinfo(_curl_handle, CURLINFO_CONNECT_TIME,       &td[2]);
-                curl_easy_getinfo(_curl_handle, CURLINFO_APPCONNECT_TIME,    &td[3]);
-                curl_easy_getinfo(_curl_handle, CURLINFO_PRETRANSFER_TIME,   &td[4]);
-                curl_easy_getinfo(_curl_handle, CURLINFO_STARTTRANSFER_TIME, &td[5]);
-                curl_easy_getinfo(_curl_handle, CURLINFO_REDIRECT_TIME,      &td[6]);
-
-                for(int i=0; i<7; ++i)
-                {
-                    OE_NOTICE << LC
-                        << std::setprecision(4)
-                        << "TIMES: total=" <<td[0]
-                        << ", lookup=" <<td[1]<<" ("<<(int)((td[1]/td[0])*100)<<"%)"
-                        << ", connect=" <<td[2]<<" ("<<(int)((td[2]/td[0])*100)<<"%)"
-                        << ", appconn=" <<td[3]<<" ("<<(int)((td[3]/td[0])*100)<<"%)"
-                        << ", prexfer=" <<td[4]<<" ("<<(int)((td[4]/td[0])*100)<<"%)"
-                        << ", startxfer=" <<td[5]<<" ("<<(int)((td[5]/td[0])*100)<<"%)"
-                        << ", redir=" <<td[6]<<" ("<<(int)((td[6]/td[0])*100)<<"%)"
-                        << std::endl;
-                }
+        //! Stops the network thread and drops any unfinished transfers.
+        void shutdown()
+        {
+            std::vector<AsyncTransferPtr> dropped;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_done)
+                    return;
+
+                _done = true;
+                dropped.swap(_incoming);
+#if LIBCURL_VERSION_NUM >= 0x074400
+                curl_multi_wakeup(_multi);
 #endif
             }
 
-            // Free the headers
-            if (headers)
-            {
-                curl_slist_free_all(headers);
-            }            
+            if (_thread.joinable())
+                _thread.join();
 
-            return response;
-        }
-        
-        void* getHandle() const
-        {
-            return _curl_handle;
+            curl_multi_cleanup(_multi);
+            _multi = nullptr;
         }
 
-        void setUserAgent(const std::string& value)
+        //! Options that stay the same for every request on a handle.
+        void initHandle(CURL* handle)
         {
-            curl_easy_setopt( _curl_handle, CURLOPT_USERAGENT, value.c_str() );
+            curl_easy_setopt( handle, CURLOPT_WRITEFUNCTION, StreamObjectReadCallback );
+            curl_easy_setopt( handle, CURLOPT_HEADERFUNCTION, StreamObjectHeaderCallback );
+            curl_easy_setopt( handle, CURLOPT_FOLLOWLOCATION, (void*)1 );
+            curl_easy_setopt( handle, CURLOPT_MAXREDIRS, (void*)5 );
+            curl_easy_setopt( handle, CURLOPT_PROGRESSFUNCTION, &CurlProgressCallback );
+            curl_easy_setopt( handle, CURLOPT_NOPROGRESS, (void*)0 ); //0=enable.
+            curl_easy_setopt( handle, CURLOPT_FILETIME, true );
+            curl_easy_setopt( handle, CURLOPT_ENCODING, "" );
+            curl_easy_setopt( handle, CURLOPT_SSL_VERIFYPEER, (void*)0 );
+
+#if LIBCURL_VERSION_NUM >= 0x072f00
+            // h2 over TLS when the server offers it; plain http stays on 1.1
+            curl_easy_setopt( handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS );
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072b00
+            // prefer waiting for a multiplexed stream over opening a new connection
+            curl_easy_setopt( handle, CURLOPT_PIPEWAIT, 1L );
+#endif
+
+            osg::ref_ptr< ConfigHandler > configHandler = HTTPClient::getConfigHandler();
+            if (configHandler.valid()) {
+                configHandler->onInitialize(handle);
+            }
         }
 
-        void setTimeout(long value)
+        void start(AsyncTransfer& t, CURL* handle)
         {
-            curl_easy_setopt( _curl_handle, CURLOPT_TIMEOUT, value );
+            t.setup.reset(new CurlGetSetup(t.request, t.options.get()));
+            t.part = new HTTPResponse::Part();
+            t.stream.reset(new StreamObject(&t.part->_stream));
+            t.errorBuf[0] = 0;
+
+            curl_easy_setopt( handle, CURLOPT_WRITEDATA, (void*)t.stream.get() );
+            curl_easy_setopt( handle, CURLOPT_HEADERDATA, (void*)t.stream.get() );
+            curl_easy_setopt( handle, CURLOPT_PROGRESSDATA, t.progress.get() );
+            curl_easy_setopt( handle, CURLOPT_ERRORBUFFER, (void*)t.errorBuf );
+
+            // read per request (like the easy-handle path) so that changes to the
+            // global settings apply to the next transfer; curl copies the string.
+            curl_easy_setopt( handle, CURLOPT_USERAGENT, getEffectiveUserAgent().c_str() );
+            curl_easy_setopt( handle, CURLOPT_TIMEOUT, getEffectiveTimeout() );
+            curl_easy_setopt( handle, CURLOPT_CONNECTTIMEOUT, getEffectiveConnectTimeout() );
+
+            // sets or clears the proxy, so a recycled handle never keeps an old one
+            t.setup->applyProxy(handle);
+
+            if (t.setup->details)
+            {
+                curl_easy_setopt(handle, CURLOPT_USERPWD, t.setup->password.c_str());
+#if LIBCURL_VERSION_NUM >= 0x070a07
+                curl_easy_setopt(handle, CURLOPT_HTTPAUTH, t.setup->details->httpAuthentication);
+#endif
+            }
+            else
+            {
+                curl_easy_setopt(handle, CURLOPT_USERPWD, 0);
+#if LIBCURL_VERSION_NUM >= 0x070a07
+                curl_easy_setopt(handle, CURLOPT_HTTPAUTH, 0);
+#endif
+            }
+
+            curl_easy_setopt( handle, CURLOPT_HTTPHEADER, t.setup->headers );
+            curl_easy_setopt( handle, CURLOPT_URL, t.setup->url.c_str() );
+
+            osg::ref_ptr< ConfigHandler > configHandler = HTTPClient::getConfigHandler();
+            if (configHandler.valid()) {
+                configHandler->onGet(handle);
+            }
+
+            t.startTime = osg::Timer::instance()->tick();
         }
 
-        void setConnectTimeout(long value)
+        void finish(CURL* handle, CURLcode res, std::vector<CURL*>& idle)
         {
-            curl_easy_setopt( _curl_handle, CURLOPT_CONNECTTIMEOUT, value );
+            curl_multi_remove_handle(_multi, handle);
+
+            auto i = _active.find(handle);
+            if (i == _active.end())
+                return;
+
+            AsyncTransferPtr t = i->second;
+            _active.erase(i);
+
+            HTTPResponse response;
+            response = makeCurlResponse(handle, res, *t->setup, t->request, t->part.get(), *t->stream, t->startTime);
+
+            // recycle the handle without resetting it, so the options from
+            // initHandle() and the ConfigHandler survive; just drop the
+            // pointers into this transfer. The multi handle keeps the
+            // connections alive.
+            curl_easy_setopt( handle, CURLOPT_WRITEDATA, (void*)0 );
+            curl_easy_setopt( handle, CURLOPT_HEADERDATA, (void*)0 );
+            curl_easy_setopt( handle, CURLOPT_PROGRESSDATA, (void*)0 );
+            curl_easy_setopt( handle, CURLOPT_ERRORBUFFER, (void*)0 );
+            curl_easy_setopt( handle, CURLOPT_HTTPHEADER, (void*)0 );
+            idle.push_back(handle);
+
+            t->setup.reset();
+            t->stream.reset();
+            t->part = nullptr;
+
+            t->complete(response);
         }
 
-        void readOptions(const osgDB::Options* options, std::string& proxy_host, std::string& proxy_port) const
+        void run()
         {
-            // try to set proxy host/port by reading the CURL proxy options
-            if ( options )
+            setThreadName("oe.http");
+
+            std::vector<CURL*> idle;
+            std::vector<AsyncTransferPtr> incoming;
+            std::vector<CURL*> canceled;
+
+            while (!_done)
             {
-                std::istringstream iss( options->getOptionString() );
-                std::string opt;
-                while( iss >> opt )
+                // admit new transfers:
                 {
-                    int index = opt.find('=');
-                    if( opt.substr( 0, index ) == "OSG_CURL_PROXY" )
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    incoming.swap(_incoming);
+                }
+
+                for (auto& t : incoming)
+                {
+                    if (t->abandoned())
+                        continue;
+
+                    CURL* handle = nullptr;
+                    if (!idle.empty())
                     {
-                        proxy_host = opt.substr( index+1 );
+                        handle = idle.back();
+                        idle.pop_back();
                     }
-                    else if ( opt.substr( 0, index ) == "OSG_CURL_PROXYPORT" )
+                    else
                     {
-                        proxy_port = opt.substr( index+1 );
+                        handle = curl_easy_init();
+                        initHandle(handle);
                     }
+
+                    start(*t, handle);
+                    _active[handle] = t;
+                    curl_multi_add_handle(_multi, handle);
+                }
+                incoming.clear();
+
+                // drop transfers whose consumer went away or canceled; this also
+                // covers transfers that are still queued waiting for a connection.
+                canceled.clear();
+                for (auto& i : _active)
+                {
+                    if (i.second->abandoned() || (i.second->progress.valid() && i.second->progress->isCanceled()))
+                        canceled.push_back(i.first);
                 }
+                for (auto handle : canceled)
+                {
+                    finish(handle, CURLE_ABORTED_BY_CALLBACK, idle);
+                }
+
+                int running = 0;
+                curl_multi_perform(_multi, &running);
+
+                CURLMsg* msg;
+                int remaining = 0;
+                while ((msg = curl_multi_info_read(_multi, &remaining)) != nullptr)
+                {
+                    if (msg->msg == CURLMSG_DONE)
+                    {
+                        finish(msg->easy_handle, msg->data.result, idle);
+                    }
+                }
+
+#if LIBCURL_VERSION_NUM >= 0x074200
+                curl_multi_poll(_multi, nullptr, 0, 100, nullptr);
+#else
+                int numfds = 0;
+                curl_multi_wait(_multi, nullptr, 0, 10, &numfds);
+#endif
+            }
+
+            for (auto& i : _active)
+            {
+                curl_multi_remove_handle(_multi, i.first);
+                curl_easy_cleanup(i.first);
+            }
+            _active.clear();
+
+            for (auto handle : idle)
+            {
+                curl_easy_cleanup(handle);
             }
         }
 
-    private:
-        void* _curl_handle;
-        mutable std::string _previousPassword;
-        mutable long _previousHttpAuthentication;
+        CURLM* _multi;
+        std::thread _thread;
+        std::atomic_bool _done;
+        std::mutex _mutex;
+        std::vector<AsyncTransferPtr> _incoming;
+        std::unordered_map<CURL*, AsyncTransferPtr> _active;
+    };
+
+    /**
+     * Implementation that runs each blocking GET on the shared
+     * multiplexed engine, so all clients share one connection pool.
+     */
+    class CURLMultiImplementation : public HTTPClient::Implementation
+    {
+    public:
+        void initialize() override { }
+
+        HTTPResponse doGet(
+            const HTTPRequest&    request,
+            const osgDB::Options* options,
+            ProgressCallback*     progress ) const override
+        {
+            auto transfer = std::make_shared<ResponseTransfer>(request, options, progress);
+            Future<HTTPResponse> result = transfer->promise;
+            CURLMultiEngine::instance().submit(transfer);
+            transfer = nullptr;
+
+            HTTPResponse response;
+            response = result.join(progress);
+            if (!result.available())
+            {
+                response.setCanceled(true);
+            }
+            return response;
+        }
     };
 }
 
@@ -915,6 +1359,12 @@ CURLHTTPImplementationFactory::create() const
     return new CURLImplementation();
 }
 
+HTTPClient::Implementation*
+CURLMultiHTTPImplementationFactory::create() const
+{
+    return new CURLMultiImplementation();
+}
+
 #ifdef OSGEARTH_USE_WININET_FOR_HTTP
 namespace
 {
@@ -1273,12 +1723,7 @@ HTTPClient::initializeImpl()
     _previousHttpAuthentication = 0;
 
     //Get the user agent
-    std::string userAgent = s_userAgent;
-    const char* userAgentEnv = getenv("OSGEARTH_USERAGENT");
-    if (userAgentEnv)
-    {
-        userAgent = std::string(userAgentEnv);
-    }
+    std::string userAgent = getEffectiveUserAgent();
     OE_TEST << LC << "HTTPClient setting userAgent=" << userAgent << std::endl;
 
     //Check for a response-code simulation (for testing)
@@ -1304,20 +1749,10 @@ HTTPClient::initializeImpl()
         OE_INFO << LC << "HTTP debugging enabled" << std::endl;
     }
 
-    long timeout = s_timeout;
-    const char* timeoutEnv = getenv("OSGEARTH_HTTP_TIMEOUT");
-    if (timeoutEnv)
-    {
-        timeout = osgEarth::as<long>(std::string(timeoutEnv), 0);
-    }
+    long timeout = getEffectiveTimeout();
     OE_TEST << LC << "Setting timeout to " << timeout << std::endl;
 
-    long connectTimeout = s_connectTimeout;
-    const char* connectTimeoutEnv = getenv("OSGEARTH_HTTP_CONNECTTIMEOUT");
-    if (connectTimeoutEnv)
-    {
-        connectTimeout = osgEarth::as<long>(std::string(connectTimeoutEnv), 0);
-    }
+    long connectTimeout = getEffectiveConnectTimeout();
     OE_TEST << LC << "Setting connect timeout to " << connectTimeout << std::endl;
 
     const char* retryDelayEnv = getenv("OSGEARTH_HTTP_RETRY_DELAY");
@@ -1382,6 +1817,16 @@ void HTTPClient::setConnectTimeout( long timeout )
     s_connectTimeout = timeout;
 }
 
+unsigned HTTPClient::getMaxConnectionsPerHost()
+{
+    return s_maxConnectionsPerHost;
+}
+
+void HTTPClient::setMaxConnectionsPerHost(unsigned value)
+{
+    s_maxConnectionsPerHost = value;
+}
+
 void HTTPClient::setRetryDelay(float value_s)
 {
     s_retryDelay_s = value_s;
@@ -1431,6 +1876,12 @@ HTTPClient::globalInit()
 #endif
 }
 
+void
+HTTPClient::globalShutdown()
+{
+    CURLMultiEngine::shutdownInstance();
+}
+
 void
 HTTPClient::readOptions(const osgDB::Options* options, std::string& proxy_host, std::string& proxy_port) const
 {
@@ -1509,46 +1960,46 @@ HTTPClient::download(const std::string& uri,
     return getClient().doDownload( uri, localPath );
 }
 
-HTTPResponse
-HTTPClient::doGet(const HTTPRequest&    request,
-                  const osgDB::Options* options,
-                  ProgressCallback*     progress) const
+namespace
 {
-    OE_PROFILING_ZONE;
-    OE_PROFILING_ZONE_TEXT(Stringify() << "url " << request.getURL());
-
-    initialize();
-
-    URI uri(request.getURL());
-
-    // URL caching
-    CacheBin* bin = nullptr;
-    CacheSettings* cacheSettings = CacheSettings::get(options);
-    osgEarth::optional<CachePolicy> cachePolicy;
-    if (cacheSettings)
+    /**
+     * URL response caching shared by the blocking and asynchronous GETs.
+     */
+    struct ResponseCache
     {
-        cachePolicy = cacheSettings->cachePolicy();
-        if (cacheSettings->isCacheEnabled())
+        osg::ref_ptr<CacheBin> bin;
+        osgEarth::optional<CachePolicy> cachePolicy;
+        std::string key;
+
+        ResponseCache(const HTTPRequest& request, const osgDB::Options* options)
         {
-            // Use the global bin instead of the defined cache bin so all URLs are cached to the same place
-            bin = cacheSettings->getCache()->getOrCreateDefaultBin();
-            //bin = cacheSettings->getCacheBin();
-        }
-    }
+            key = URI(request.getURL()).cacheKey();
 
-    bool expired = false;
+            CacheSettings* cacheSettings = CacheSettings::get(options);
+            if (cacheSettings)
+            {
+                cachePolicy = cacheSettings->cachePolicy();
+                if (cacheSettings->isCacheEnabled())
+                {
+                    // Use the global bin instead of the defined cache bin so all URLs are cached to the same place
+                    bin = cacheSettings->getCache()->getOrCreateDefaultBin();
+                    //bin = cacheSettings->getCacheBin();
+                }
+            }
+        }
 
-    HTTPResponse response;
+        //! Try to read result from the cache. Returns true if found;
+        //! "expired" tells the caller to revalidate with the server.
+        bool read(const osgDB::Options* options, HTTPResponse& response, bool& expired) const
+        {
+            expired = false;
 
-    bool gotFromCache = false;
+            if (!bin.valid())
+                return false;
 
-    //Try to read result from the cache.
-    if (bin)
-    {
-        ReadResult result = bin->readString(uri.cacheKey(), options);
-        if (result.succeeded())
-        {            
-            gotFromCache = true;
+            ReadResult result = bin->readString(key, options);
+            if (!result.succeeded())
+                return false;
 
             // If the cache-control header contains no-cache that means that it's ok to store the result in the cache, but it must be requested
             // from the server each time it is it requested.
@@ -1560,7 +2011,7 @@ HTTPClient::doGet(const HTTPRequest&    request,
             }
 
             expired = noCache || cachePolicy->isExpired(result.lastModifiedTime());
-            result.setIsFromCache(true);            
+            result.setIsFromCache(true);
 
             HTTPResponse cacheResponse(HTTPResponse::CATEGORY_SUCCESS);
             osg::ref_ptr<HTTPResponse::Part> part = new HTTPResponse::Part();
@@ -1571,38 +2022,72 @@ HTTPClient::doGet(const HTTPRequest&    request,
             cacheResponse.setHeadersFromConfig(result.metadata());
             cacheResponse.setFromCache(true);
             response = cacheResponse;
+            return true;
         }
-    }
-
-    if ((expired || !gotFromCache) && cachePolicy->usage() != CachePolicy::USAGE_CACHE_ONLY)
-    {
-        HTTPResponse remoteResponse = _impl->doGet(request, options, progress);
 
-        if (remoteResponse.getCode() == ReadResult::RESULT_NOT_MODIFIED)
+        //! Whether the policy lets us go to the network at all
+        bool allowsNetwork() const
         {
-            // Touch the cached item to update it's last modified timestamp so it doesn't expire again immediately.
-            if (bin)
-                bin->touch(uri.cacheKey());
+            return cachePolicy->usage() != CachePolicy::USAGE_CACHE_ONLY;
         }
-        else
-        {
-            response = remoteResponse;
 
-            if (response.isOK())
+        //! Folds a network response into "response" (which holds the
+        //! cached response, if any) and updates the cache.
+        void update(const HTTPResponse& remoteResponse, HTTPResponse& response, const osgDB::Options* options) const
+        {
+            if (remoteResponse.getCode() == ReadResult::RESULT_NOT_MODIFIED)
+            {
+                // Touch the cached item to update it's last modified timestamp so it doesn't expire again immediately.
+                if (bin.valid())
+                    bin->touch(key);
+            }
+            else
             {
-                if (bin != nullptr)
+                response = remoteResponse;
+
+                if (response.isOK())
                 {
-                    osg::ref_ptr< StringObject> stringObject = new StringObject(response.getPartAsString(0));
-                    bin->write(uri.cacheKey(), stringObject, response.getHeadersAsConfig(), options);
+                    if (bin.valid())
+                    {
+                        osg::ref_ptr< StringObject> stringObject = new StringObject(response.getPartAsString(0));
+                        bin->write(key, stringObject, response.getHeadersAsConfig(), options);
+                    }
                 }
             }
         }
+    };
+}
+
+HTTPResponse
+HTTPClient::doGet(const HTTPRequest&    request,
+                  const osgDB::Options* options,
+                  ProgressCallback*     progress) const
+{
+    OE_PROFILING_ZONE;
+    OE_PROFILING_ZONE_TEXT(Stringify() << "url " << request.getURL());
+
+    initialize();
+
+    // URL caching
+    ResponseCache cache(request, options);
+
+    bool expired = false;
+
+    HTTPResponse response;
+
+    bool gotFromCache = cache.read(options, response, expired);
+
+    if ((expired || !gotFromCache) && cache.allowsNetwork())
+    {
+        HTTPResponse remoteResponse = _impl->doGet(request, options, progress);
+
+        cache.update(remoteResponse, response, options);
 
         OE_PROFILING_ZONE_TEXT(Stringify() << "response_code " << response.getCode());
         if (response.isCanceled())
         {
             OE_PROFILING_ZONE_TEXT("cancelled");
-        }        
+        }
     }
     return response;
 }
@@ -1698,6 +2183,120 @@ namespace
     }
 }
 
+namespace
+{
+    //! Decodes an image from an HTTP response, mapping HTTP errors
+    //! to ReadResult codes.
+    ReadResult decodeImageResponse(
+        const HTTPRequest&    request,
+        const HTTPResponse&   response,
+        const osgDB::Options* options,
+        ProgressCallback*     callback)
+    {
+        ReadResult result;
+
+        if (response.isOK())
+        {
+            osgDB::ReaderWriter* reader = getReader(request.getURL(), response);
+            if (!reader)
+            {
+                result = ReadResult(ReadResult::RESULT_NO_READER);
+                result.setErrorDetail(Stringify() << "Content-Type=" << response.getMimeType());
+            }
+
+            else
+            {
+                osgDB::ReaderWriter::ReadResult rr;
+
+                if (response.getNumParts() > 0)
+                    rr = reader->readImage(response.getPartStream(0), options);
+
+                if ( rr.validImage() )
+                {
+                    result = ReadResult(rr.takeImage());
+                }
+                else
+                {
+                    if ( s_HTTP_DEBUG )
+                    {
+                        OE_WARN << LC << reader->className()
+                            << " failed to read image from " << request.getURL()
+                            << "; message = " << rr.message()
+                            <<  std::endl;
+                    }
+                    result = ReadResult(ReadResult::RESULT_READER_ERROR);
+                    result.setErrorDetail( rr.message() );
+                }
+            }
+
+            // last-modified (file time)
+            result.setLastModifiedTime( response.getLastModified() );
+
+            // Time of query
+            result.setDuration( response.getDuration() );
+        }
+        else
+        {
+            result = ReadResult(
+                response.isCanceled() ? ReadResult::RESULT_CANCELED :
+                response.getCode() == HTTPResponse::NOT_FOUND ? ReadResult::RESULT_NOT_FOUND :
+                response.getCode() == HTTPResponse::NOT_MODIFIED ? ReadResult::RESULT_NOT_MODIFIED :
+                response.getCode() == HTTPResponse::FORBIDDEN ? ReadResult::RESULT_UNAUTHORIZED :
+                response.getCodeCategory() == HTTPResponse::CATEGORY_SERVER_ERROR ? ReadResult::RESULT_SERVER_ERROR :
+                ReadResult::RESULT_UNKNOWN_ERROR);
+
+            // for request errors, return an error result with the part data intact
+            // so the user can parse it as needed. We only do this for readString.
+            if (response.getNumParts() > 0u)
+            {
+                result.setErrorDetail(response.getPartAsString(0));
+
+                if (s_HTTP_DEBUG)
+                {
+                    OE_WARN << LC << "SERVER REPORTS: " << result.errorDetail() << std::endl;
+                }
+            }
+
+            //If we have an error but it's recoverable, like a server error or timeout then set the callback to retry.
+            if (HTTPClient::isRecoverable( result.code() ) )
+            {
+                if (callback)
+                {
+                    callback->setRetryDelay(HTTPClient::getRetryDelay());
+                    callback->cancel();
+
+                    if (response.getCode() == 503)
+                    {
+                        callback->message() = "Server deferral";
+                    }
+
+                    if ( s_HTTP_DEBUG )
+                    {
+                        if (response.isCanceled())
+                        {
+                            OE_NOTICE << LC << "Request was cancelled" << std::endl;
+                        }
+                        else
+                        {
+                            OE_NOTICE << LC << "Recoverable error in HTTPClient for " << request.getURL() << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+
+        // encode headers
+        result.setMetadata( response.getHeadersAsConfig() );
+        result.setIsFromCache(response.getFromCache());
+
+        // set the source name
+        if ( result.getImage() )
+            result.getImage()->setName( request.getURL() );
+
+        return result;
+    }
+}
+
 ReadResult
 HTTPClient::doReadImage(const HTTPRequest&    request,
                         const osgDB::Options* options,
@@ -1705,109 +2304,152 @@ HTTPClient::doReadImage(const HTTPRequest&    request,
 {
     initialize();
 
-    ReadResult result;
-
     HTTPResponse response = this->doGet(request, options, callback);
 
-    if (response.isOK())
+    return decodeImageResponse(request, response, options, callback);
+}
+
+namespace
+{
+    /**
+     * Asynchronous GET through the response cache. The network thread
+     * only stores the response; the cache update and "finish" (e.g. image
+     * decoding) run as a job so they never stall other transfers.
+     */
+    template<typename T>
+    struct CachedTransfer : public AsyncTransfer
     {
-        osgDB::ReaderWriter* reader = getReader(request.getURL(), response);
-        if (!reader)
+        CachedTransfer(const HTTPRequest& request, const osgDB::Options* options, ProgressCallback* progress) :
+            AsyncTransfer(request, options, progress),
+            cache(request, options) { }
+
+        Future<T> promise;
+        ResponseCache cache;
+        HTTPResponse response;
+        std::function<void(CachedTransfer<T>&)> finish; // must resolve the promise
+
+        bool abandoned() const override
         {
-            result = ReadResult(ReadResult::RESULT_NO_READER);
-            result.setErrorDetail(Stringify() << "Content-Type=" << response.getMimeType());
+            return promise.canceled();
         }
 
-        else
+        void complete(HTTPResponse& remoteResponse) override
         {
-            osgDB::ReaderWriter::ReadResult rr;
+            _remoteResponse = remoteResponse;
 
-            if (response.getNumParts() > 0)
-                rr = reader->readImage(response.getPartStream(0), options);
+            auto self = std::static_pointer_cast<CachedTransfer<T>>(shared_from_this());
+
+            jobs::context context;
+            context.name = request.getURL();
+            context.pool = jobs::get_pool("oe.http");
+
+            jobs::dispatch([self]()
+                {
+                    if (!self->promise.canceled())
+                    {
+                        self->cache.update(self->_remoteResponse, self->response, self->options.get());
+                        self->finish(*self);
+                    }
+                },
+                context);
+        }
+
+        //! Resolves from the cache, or submits to the network.
+        Future<T> run(std::shared_ptr<CachedTransfer<T>> self)
+        {
+            Future<T> result = promise;
+
+            bool expired = false;
+            bool gotFromCache = cache.read(options.get(), response, expired);
 
-            if ( rr.validImage() )
+            if ((expired || !gotFromCache) && cache.allowsNetwork())
             {
-                result = ReadResult(rr.takeImage());
+                CURLMultiEngine::instance().submit(self);
             }
             else
             {
-                if ( s_HTTP_DEBUG )
-                {
-                    OE_WARN << LC << reader->className()
-                        << " failed to read image from " << request.getURL()
-                        << "; message = " << rr.message()
-                        <<  std::endl;
-                }
-                result = ReadResult(ReadResult::RESULT_READER_ERROR);
-                result.setErrorDetail( rr.message() );
+                finish(*this);
             }
+            return result;
         }
 
-        // last-modified (file time)
-        result.setLastModifiedTime( response._lastModified );
+    private:
+        HTTPResponse _remoteResponse;
+    };
 
-        // Time of query
-        result.setDuration( response.getDuration() );
-    }
-    else
+    bool canMultiplex(HTTPClient::ImplementationFactory* factory)
     {
-        result = ReadResult(
-            response.isCanceled() ? ReadResult::RESULT_CANCELED :
-            response.getCode() == HTTPResponse::NOT_FOUND ? ReadResult::RESULT_NOT_FOUND :
-            response.getCode() == HTTPResponse::NOT_MODIFIED ? ReadResult::RESULT_NOT_MODIFIED :
-            response.getCode() == HTTPResponse::FORBIDDEN ? ReadResult::RESULT_UNAUTHORIZED :
-            response.getCodeCategory() == HTTPResponse::CATEGORY_SERVER_ERROR ? ReadResult::RESULT_SERVER_ERROR :
-            ReadResult::RESULT_UNKNOWN_ERROR);
+        return
+            dynamic_cast<CURLHTTPImplementationFactory*>(factory) != nullptr ||
+            dynamic_cast<CURLMultiHTTPImplementationFactory*>(factory) != nullptr;
+    }
+}
 
-        // for request errors, return an error result with the part data intact
-        // so the user can parse it as needed. We only do this for readString.
-        if (response.getNumParts() > 0u)
-        {
-            result.setErrorDetail(response.getPartAsString(0));
+Future<HTTPResponse>
+HTTPClient::getAsync(const HTTPRequest&    request,
+                     const osgDB::Options* options,
+                     ProgressCallback*     progress)
+{
+    // applies the environment settings
+    getClient().initialize();
 
-            if (s_HTTP_DEBUG)
-            {
-                OE_WARN << LC << "SERVER REPORTS: " << result.errorDetail() << std::endl;
-            }
-        }
+    // custom implementations don't go through cURL, so just run them in the background
+    if (!canMultiplex(_implFactory))
+    {
+        osg::ref_ptr<const osgDB::Options> options_ref(options);
+        osg::ref_ptr<ProgressCallback> progress_ref(progress);
 
-        //If we have an error but it's recoverable, like a server error or timeout then set the callback to retry.
-        if (HTTPClient::isRecoverable( result.code() ) )
-        {
-            if (callback)
+        return jobs::dispatch([request, options_ref, progress_ref](Cancelable&)
             {
-                callback->setRetryDelay(getRetryDelay());
-                callback->cancel();
+                return HTTPClient::get(request, options_ref.get(), progress_ref.get());
+            },
+            jobs::context{ request.getURL(), jobs::get_pool("oe.http") });
+    }
 
-                if (response.getCode() == 503)
-                {
-                    callback->message() = "Server deferral";
-                }
+    auto transfer = std::make_shared<CachedTransfer<HTTPResponse>>(request, options, progress);
 
-                if ( s_HTTP_DEBUG )
-                {
-                    if (response.isCanceled())
-                    {
-                        OE_NOTICE << LC << "Request was cancelled" << std::endl;
-                    }
-                    else
-                    {
-                        OE_NOTICE << LC << "Recoverable error in HTTPClient for " << request.getURL() << std::endl;
-                    }
-                }
-            }
-        }
+    transfer->finish = [](CachedTransfer<HTTPResponse>& t)
+    {
+        t.promise.resolve(t.response);
+    };
+
+    return transfer->run(transfer);
+}
+
+Future<ReadResult>
+HTTPClient::readImageAsync(const HTTPRequest&    request,
+                           const osgDB::Options* options,
+                           ProgressCallback*     progress,
+                           const std::function<void(ReadResult&)>& postProcess)
+{
+    getClient().initialize();
+
+    if (!canMultiplex(_implFactory))
+    {
+        osg::ref_ptr<const osgDB::Options> options_ref(options);
+        osg::ref_ptr<ProgressCallback> progress_ref(progress);
+
+        return jobs::dispatch([request, options_ref, progress_ref, postProcess](Cancelable&)
+            {
+                ReadResult result = HTTPClient::readImage(request, options_ref.get(), progress_ref.get());
+                if (postProcess)
+                    postProcess(result);
+                return result;
+            },
+            jobs::context{ request.getURL(), jobs::get_pool("oe.http") });
     }
 
-    // encode headers
-    result.setMetadata( response.getHeadersAsConfig() );
-    result.setIsFromCache(response.getFromCache());
+    auto transfer = std::make_shared<CachedTransfer<ReadResult>>(request, options, progress);
 
-    // set the source name
-    if ( result.getImage() )
-        result.getImage()->setName( request.getURL() );
+    transfer->finish = [postProcess](CachedTransfer<ReadResult>& t)
+    {
+        ReadResult result = decodeImageResponse(t.request, t.response, t.options.get(), t.progress.get());
+        if (postProcess)
+            postProcess(result);
+        t.promise.resolve(result);
+    };
 
-    return result;
+    return transfer->run(transfer);
 }
 
 ReadResult
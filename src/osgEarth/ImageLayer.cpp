@@ -377,6 +377,154 @@ ImageLayer::createImage(const TileKey& key)
 
 GeoImage
 ImageLayer::createImage(const TileKey& key, ProgressCallback* progress)
+{
+    return createImage(key, progress, nullptr, nullptr);
+}
+
+namespace
+{
+    // Key under which an image tile is stored in the layer's cache bin
+    std::string makeImageCacheKey(const TileKey& key)
+    {
+        return Cache::makeCacheKey(
+            Stringify() << key.str() << "-" << std::hex << key.getProfile()->getHorizSignature(),
+            "image");
+    }
+}
+
+std::string
+ImageLayer::getCacheKey(const TileKey& key) const
+{
+    return makeImageCacheKey(key);
+}
+
+std::vector<GeoImage>
+ImageLayer::createImages(const std::vector<TileKey>& keys, ProgressCallback* progress)
+{
+    std::vector<GeoImage> output(keys.size(), GeoImage::INVALID);
+
+    if (!isOpen() || keys.empty())
+    {
+        return output;
+    }
+
+    const Profile* profile = keys.front().getProfile();
+    for (auto& key : keys)
+    {
+        if (!key.getProfile()->isHorizEquivalentTo(profile))
+        {
+            // mixed profiles map to different cache bins; do them one at a time.
+            for (unsigned i = 0; i < keys.size(); ++i)
+                output[i] = createImage(keys[i], progress);
+            return output;
+        }
+    }
+
+    const CachePolicy& policy = getCacheSettings()->cachePolicy().get();
+    CacheBin* cacheBin = getCacheBin(profile);
+
+    std::vector<ReadResult> cached;
+    if (cacheBin && policy.isCacheReadable())
+    {
+        std::vector<std::string> cacheKeys;
+        cacheKeys.reserve(keys.size());
+        for (auto& key : keys)
+            cacheKeys.push_back(makeImageCacheKey(key));
+
+        cached = cacheBin->readMany(cacheKeys, true, nullptr);
+    }
+
+    std::vector<CacheBin::WriteRecord> writes;
+    bool deferWrites = cacheBin && policy.isCacheWriteable();
+
+    for (unsigned i = 0; i < keys.size(); ++i)
+    {
+        if (progress && progress->isCanceled())
+            break;
+
+        output[i] = createImage(
+            keys[i],
+            progress,
+            i < cached.size() ? &cached[i] : nullptr,
+            deferWrites ? &writes : nullptr);
+    }
+
+    if (!writes.empty())
+    {
+        cacheBin->writeMany(writes, nullptr);
+    }
+
+    return output;
+}
+
+std::vector<GeoImage>
+ImageLayer::createImages(const std::vector<ImageLayer*>& layers, const TileKey& key, ProgressCallback* progress)
+{
+    std::vector<GeoImage> output(layers.size(), GeoImage::INVALID);
+
+    // Collect a cache read for each layer, grouped by the cache it lives in
+    // so each cache can serve its share of the lookups in one call.
+    std::vector<Cache*> caches;
+    std::vector<std::vector<Cache::BinRead>> reads;
+    std::vector<std::pair<int, int>> lookup(layers.size(), std::make_pair(-1, -1));
+
+    std::string cacheKey = makeImageCacheKey(key);
+
+    for (unsigned i = 0; i < layers.size(); ++i)
+    {
+        ImageLayer* layer = layers[i];
+        if (!layer || !layer->isOpen())
+            continue;
+
+        CacheSettings* settings = layer->getCacheSettings();
+        if (!settings || !settings->getCache() || !settings->cachePolicy()->isCacheReadable())
+            continue;
+
+        CacheBin* bin = layer->getCacheBin(key.getProfile());
+        if (!bin)
+            continue;
+
+        unsigned c = 0;
+        while (c < caches.size() && caches[c] != settings->getCache())
+            ++c;
+        if (c == caches.size())
+        {
+            caches.push_back(settings->getCache());
+            reads.emplace_back();
+        }
+
+        Cache::BinRead read;
+        read.bin = bin;
+        read.key = cacheKey;
+        read.image = true;
+        lookup[i] = std::make_pair((int)c, (int)reads[c].size());
+        reads[c].push_back(read);
+    }
+
+    for (unsigned c = 0; c < caches.size(); ++c)
+    {
+        caches[c]->readMany(reads[c], nullptr);
+    }
+
+    for (unsigned i = 0; i < layers.size(); ++i)
+    {
+        if (progress && progress->isCanceled())
+            break;
+
+        if (!layers[i])
+            continue;
+
+        const ReadResult* cached =
+            lookup[i].first >= 0 ? &reads[lookup[i].first][lookup[i].second].result : nullptr;
+
+        output[i] = layers[i]->createImage(key, progress, cached, nullptr);
+    }
+
+    return output;
+}
+
+GeoImage
+ImageLayer::createImage(const TileKey& key, ProgressCallback* progress, const ReadResult* cached, std::vector<CacheBin::WriteRecord>* deferredWrites)
 {
     OE_PROFILING_ZONE;
     OE_PROFILING_ZONE_TEXT(getName() + " " + key.str());
@@ -388,7 +536,7 @@ ImageLayer::createImage(const TileKey& key, ProgressCallback* progress)
 
     NetworkMonitor::ScopedRequestLayer layerRequest(getName());
 
-    GeoImage result = createImageInKeyProfile(key, progress);
+    GeoImage result = createImageInKeyProfile(key, progress, cached, deferredWrites);
 
     // Post-cache operations:
 
@@ -435,7 +583,7 @@ ImageLayer::createImage(const GeoImage& canvas, const TileKey& key, ProgressCall
 }
 
 GeoImage
-ImageLayer::createImageInKeyProfile(const TileKey& key, ProgressCallback* progress)
+ImageLayer::createImageInKeyProfile(const TileKey& key, ProgressCallback* progress, const ReadResult* cached, std::vector<CacheBin::WriteRecord>* deferredWrites)
 {
     // If the layer is disabled, bail out.
     if ( !isOpen() )
@@ -461,9 +609,7 @@ ImageLayer::createImageInKeyProfile(const TileKey& key, ProgressCallback* progre
     GeoImage result;
 
     // the cache key combines the Key and the horizontal profile.
-    std::string cacheKey = Cache::makeCacheKey(
-        Stringify() << key.str() << "-" << std::hex << key.getProfile()->getHorizSignature(),
-        "image");
+    std::string cacheKey = makeImageCacheKey(key);
 
     // The L2 cache key includes the layer revision of course!
     std::string memCacheKey;
@@ -499,7 +645,8 @@ ImageLayer::createImageInKeyProfile(const TileKey& key, ProgressCallback* progre
     // map profile, we can try this first.
     if ( cacheBin && policy.isCacheReadable() )
     {
-        ReadResult r = cacheBin->readImage(cacheKey, 0L);
+        // the batched callers have already read the record for us
+        ReadResult r = cached ? *cached : cacheBin->readImage(cacheKey, 0L);
         if ( r.succeeded() )
         {
             cachedImage = r.releaseImage();
@@ -604,7 +751,17 @@ ImageLayer::createImageInKeyProfile(const TileKey& key, ProgressCallback* progre
                 OE_INFO << LC << "WARNING! mismatched extents." << std::endl;
             }
 
-            cacheBin->write(cacheKey, result.getImage(), 0L);
+            if (deferredWrites)
+            {
+                CacheBin::WriteRecord record;
+                record.key = cacheKey;
+                record.object = result.getImage();
+                deferredWrites->push_back(record);
+            }
+            else
+            {
+                cacheBin->write(cacheKey, result.getImage(), 0L);
+            }
         }
     }
 
@@ -49,6 +49,8 @@ Layer::Options::getConfig() const
     conf.set("proxy", _proxySettings );
     conf.set("read_options", osgOptionString());
     conf.set("l2_cache_size", l2CacheSize());
+    conf.set("l2_cache_concurrent", l2CacheConcurrent());
+    conf.set("l2_cache_max_size_mb", l2CacheMaxSizeMB());
 
     conf.remove("shader");
     for(auto& shader : shaders())
@@ -70,6 +72,8 @@ Layer::Options::fromConfig(const Config& conf)
     conf.get("attribution", attribution());
     conf.get("cache_policy", cachePolicy());
     conf.get("l2_cache_size", l2CacheSize());
+    conf.get("l2_cache_concurrent", l2CacheConcurrent());
+    conf.get("l2_cache_max_size_mb", l2CacheMaxSizeMB());
 
     // legacy support:
     if (!cachePolicy().isSet())
@@ -221,6 +225,8 @@ Layer::getCacheID() const
         hashConf.remove("enabled");
         hashConf.remove("fid_attribute");
         hashConf.remove("geo_interpolation");
+        hashConf.remove("l2_cache_concurrent");
+        hashConf.remove("l2_cache_max_size_mb");
         hashConf.remove("l2_cache_size");
         hashConf.remove("max_data_level");
         hashConf.remove("max_filter");
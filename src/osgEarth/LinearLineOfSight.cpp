@@ -22,9 +22,11 @@
 #include <osgEarth/LinearLineOfSight>
 #include <osgEarth/TerrainEngineNode>
 #include <osgEarth/GLUtils>
+#include <osgEarth/Viewshed>
 
 using namespace osgEarth;
 using namespace osgEarth::Contrib;
+using namespace osgEarth::Util;
 
 namespace
 {
@@ -80,7 +82,8 @@ _hasLOS( true ),
 _goodColor(0.0f, 1.0f, 0.0f, 1.0f),
 _badColor(1.0f, 0.0f, 0.0f, 1.0f),
 _displayMode( LineOfSight::MODE_SPLIT ),
-_terrainOnly( false )
+_terrainOnly( false ),
+_useHeightfield( false )
 {
     compute(getNode());
     subscribeToTerrain();    
@@ -98,7 +101,8 @@ _hasLOS( true ),
 _goodColor(0.0f, 1.0f, 0.0f, 1.0f),
 _badColor(1.0f, 0.0f, 0.0f, 1.0f),
 _displayMode( LineOfSight::MODE_SPLIT ),
-_terrainOnly( false )
+_terrainOnly( false ),
+_useHeightfield( false )
 {
     compute(getNode());    
     subscribeToTerrain();    
@@ -147,7 +151,9 @@ LinearLineOfSightNode::setMapNode( MapNode* mapNode )
 void
 LinearLineOfSightNode::terrainChanged( const osgEarth::TileKey& tileKey, osg::Node* terrain )
 {
-    compute( getNode() );
+    // paging does not change the elevation data
+    if (!_useHeightfield)
+        compute( getNode() );
 }
 
 const GeoPoint&
@@ -244,28 +250,50 @@ LinearLineOfSightNode::compute(osg::Node* node, bool backgroundThread)
       const SpatialReference* mapSRS = getMapNode()->getMapSRS();
       const Terrain* terrain = getMapNode()->getTerrain();
 
-      //Computes the LOS and redraws the scene      
-      if (!_start.transform(mapSRS).toWorld( _startWorld, terrain ) || !_end.transform(mapSRS).toWorld( _endWorld, terrain ))
+      if (_useHeightfield)
       {
-          return;
-      }
-
-
-      osgUtil::LineSegmentIntersector* lsi = new osgUtil::LineSegmentIntersector(_startWorld, _endWorld);
-      osgUtil::IntersectionVisitor iv( lsi );
+          Viewshed viewshed(getMapNode()->getMap());
+          if (!viewshed.toWorld( _start, _startWorld ) || !viewshed.toWorld( _end, _endWorld ))
+          {
+              return;
+          }
 
-      node->accept( iv );
+          std::vector<Viewshed::Ray> rays(1);
+          rays[0].start = _startWorld;
+          rays[0].end = _endWorld;
+          viewshed.intersect( rays );
 
-      osgUtil::LineSegmentIntersector::Intersections& hits = lsi->getIntersections();
-      if ( hits.size() > 0 )
-      {
-          _hasLOS = false;
-          _hitWorld = hits.begin()->getWorldIntersectPoint();
-          _hit.fromWorld( mapSRS, _hitWorld );
+          _hasLOS = rays[0].hasLOS;
+          if ( !_hasLOS )
+          {
+              _hitWorld = rays[0].hit;
+              _hit.fromWorld( mapSRS, _hitWorld );
+          }
       }
       else
       {
-          _hasLOS = true;
+          //Computes the LOS and redraws the scene      
+          if (!_start.transform(mapSRS).toWorld( _startWorld, terrain ) || !_end.transform(mapSRS).toWorld( _endWorld, terrain ))
+          {
+              return;
+          }
+
+          osgUtil::LineSegmentIntersector* lsi = new osgUtil::LineSegmentIntersector(_startWorld, _endWorld);
+          osgUtil::IntersectionVisitor iv( lsi );
+
+          node->accept( iv );
+
+          osgUtil::LineSegmentIntersector::Intersections& hits = lsi->getIntersections();
+          if ( hits.size() > 0 )
+          {
+              _hasLOS = false;
+              _hitWorld = hits.begin()->getWorldIntersectPoint();
+              _hit.fromWorld( mapSRS, _hitWorld );
+          }
+          else
+          {
+              _hasLOS = true;
+          }
       }
     }
 
@@ -411,6 +439,22 @@ LinearLineOfSightNode::setTerrainOnly( bool terrainOnly )
     }
 }
 
+bool
+LinearLineOfSightNode::getUseHeightfield() const
+{
+    return _useHeightfield;
+}
+
+void
+LinearLineOfSightNode::setUseHeightfield( bool useHeightfield )
+{
+    if (_useHeightfield != useHeightfield)
+    {
+        _useHeightfield = useHeightfield;
+        compute(getNode());
+    }
+}
+
 osg::Node*
 LinearLineOfSightNode::getNode()
 {
@@ -26,6 +26,7 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
 #include <sqlite3.h>
 
 using namespace osgEarth;
@@ -50,6 +51,40 @@ namespace
         }
         return rw;
     }
+
+    // Packs a tile address into one key for the pending-write tables.
+    inline std::uint64_t packTileKey(int z, int x, int y)
+    {
+        return ((std::uint64_t)z << 58) | ((std::uint64_t)x << 29) | (std::uint64_t)y;
+    }
+
+    inline void unpackTileKey(std::uint64_t key, int& z, int& x, int& y)
+    {
+        z = (int)(key >> 58);
+        x = (int)((key >> 29) & 0x1FFFFFFF);
+        y = (int)(key & 0x1FFFFFFF);
+    }
+
+    const char* SELECT_TILE_SQL = "SELECT tile_data from tiles where zoom_level = ? AND tile_column = ? AND tile_row = ?";
+    const char* INSERT_TILE_SQL = "INSERT OR REPLACE INTO tiles (zoom_level, tile_column, tile_row, tile_data) VALUES (?, ?, ?, ?)";
+
+    // how long a connection waits on another connection's lock
+    const int BUSY_TIMEOUT_MS = 5000;
+
+    // Commits the open transaction, rolling it back if the commit fails.
+    // Records the first error in "status"; returns false on failure.
+    bool commitTransaction(sqlite3* database, Status& status)
+    {
+        if (sqlite3_exec(database, "COMMIT", 0L, 0L, 0L) == SQLITE_OK)
+            return true;
+
+        if (status.isOK())
+            status = Status(Status::GeneralError, Stringify()
+                << "Failed to commit tiles; " << sqlite3_errmsg(database));
+
+        sqlite3_exec(database, "ROLLBACK", 0L, 0L, 0L);
+        return false;
+    }
 }
 
 //...................................................................
@@ -60,6 +95,7 @@ MBTiles::Options::writeTo(Config& conf) const
     conf.set("filename", _url);
     conf.set("format", _format);
     conf.set("compress", _compress);
+    conf.set("write_batch_size", _writeBatchSize);
 }
 
 void
@@ -72,6 +108,7 @@ MBTiles::Options::readFrom(const Config& conf)
     conf.get("url", _url); // compat for consistency with other drivers
     conf.get("format", _format);
     conf.get("compress", _compress);
+    conf.get("write_batch_size", _writeBatchSize);
 }
 
 //...................................................................
@@ -142,6 +179,14 @@ MBTilesImageLayer::openImplementation()
     return Status::NoError;
 }
 
+Status
+MBTilesImageLayer::closeImplementation()
+{
+    Status status = _driver.close();
+    Status parent = super::closeImplementation();
+    return status.isError() ? status : parent;
+}
+
 void
 MBTilesImageLayer::setDataExtents(const DataExtentList& values)
 {
@@ -258,6 +303,14 @@ MBTilesElevationLayer::openImplementation()
     return Status::NoError;
 }
 
+Status
+MBTilesElevationLayer::closeImplementation()
+{
+    Status status = _driver.close();
+    Status parent = super::closeImplementation();
+    return status.isError() ? status : parent;
+}
+
 void
 MBTilesElevationLayer::setDataExtents(const DataExtentList& values)
 {
@@ -329,25 +382,82 @@ bool MBTilesElevationLayer::putMetaData(const std::string& name, const std::stri
 #define LC "[MBTiles] \"" << _name << "\" "
 
 MBTiles::Driver::Driver() :
+    _database(nullptr),
+    _readWrite(false),
     _minLevel(0),
     _maxLevel(19),
     _forceRGB(false),
-    _database(nullptr)
+    _writeBatchSize(256u),
+    _flushRequested(false),
+    _stopWriter(false),
+    _insert(nullptr)
 {
     //nop
 }
 
 Driver::~Driver()
 {
+    close();
+}
+
+Status
+MBTiles::Driver::close()
+{
+    // stop the writer; it commits everything still pending before exiting.
+    if (_writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_writeMutex);
+            _stopWriter = true;
+        }
+        _writeCondition.notify_all();
+        _writer.join();
+    }
+
+    Status result;
+    {
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        result = _writeError;
+        _writeError = Status::NoError;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_readPoolMutex);
+        for (auto& conn : _readPool)
+        {
+            sqlite3_finalize((sqlite3_stmt*)conn._select);
+            sqlite3_close_v2((sqlite3*)conn._db);
+        }
+        _readPool.clear();
+    }
+
     closeDatabase();
+
+    return result;
 }
 
 void
 MBTiles::Driver::closeDatabase()
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_insert != nullptr)
+    {
+        sqlite3_finalize((sqlite3_stmt*)_insert);
+        _insert = nullptr;
+    }
+
     if (_database != nullptr)
     {
         sqlite3* database = (sqlite3*)_database;
+
+        // Fold the WAL back into the main file so the result is a
+        // single self-contained .mbtiles file again.
+        if (_readWrite)
+        {
+            sqlite3_exec(database, "PRAGMA journal_mode=DELETE", 0L, 0L, 0L);
+        }
+
         sqlite3_close_v2(database);
         _database = nullptr;
     }
@@ -403,20 +513,38 @@ MBTiles::Driver::open(
         ? (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX)
         : (SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX);
 
-    sqlite3* database = (sqlite3*)_database;
-
     // close existing database if open
-    closeDatabase();
+    close();
+
+    _fullFilename = fullFilename;
+    _readWrite = readWrite;
+    _writeBatchSize = osg::maximum(options.writeBatchSize().get(), 1u);
+    _stopWriter = false;
+    _flushRequested = false;
 
     sqlite3** dbptr = (sqlite3**)&_database;
     int rc = sqlite3_open_v2(fullFilename.c_str(), dbptr, flags, 0L);
     if (rc != 0)
     {
+        std::string error = sqlite3_errmsg((sqlite3*)_database);
+        sqlite3_close_v2((sqlite3*)_database);
+        _database = nullptr;
+
         if (!osgDB::fileExists(fullFilename))
             return Status(Status::ResourceUnavailable, Stringify() << fullFilename << " File Not Found");
         
         return Status(Status::ResourceUnavailable, Stringify()
-            << "Database \"" << fullFilename << "\": " << sqlite3_errmsg(database));
+            << "Database \"" << fullFilename << "\": " << error);
+    }
+
+    sqlite3_busy_timeout((sqlite3*)_database, BUSY_TIMEOUT_MS);
+
+    if (readWrite)
+    {
+        // WAL lets the read-only connections keep reading while the
+        // writer commits, and makes each commit much cheaper.
+        sqlite3_exec((sqlite3*)_database, "PRAGMA journal_mode=WAL", 0L, 0L, 0L);
+        sqlite3_exec((sqlite3*)_database, "PRAGMA synchronous=NORMAL", 0L, 0L, 0L);
     }
 
     // New database setup:
@@ -609,6 +737,12 @@ MBTiles::Driver::open(
     unsigned char *data = _emptyImage->data(0, 0);
     memset(data, 0, 4 * size * size);
 
+    // start the background writer.
+    if (readWrite)
+    {
+        _writer = std::thread(&Driver::writerLoop, this);
+    }
+
     return Status::OK();
 }
 
@@ -650,8 +784,6 @@ MBTiles::Driver::read(
     ProgressCallback* progress,
     const osgDB::Options* readOptions) const
 {
-    std::lock_guard<std::mutex> exclusiveLock(_mutex);
-
     int z = key.getLevelOfDetail();
     int x = key.getTileX();
     int y = key.getTileY();
@@ -671,33 +803,68 @@ MBTiles::Driver::read(
     key.getProfile()->getNumTiles(key.getLevelOfDetail(), numCols, numRows);
     y  = numRows - y - 1;
 
-    sqlite3* database = (sqlite3*)_database;
+    std::string dataBuffer;
+    bool found = false;
 
-    //Get the image
-    sqlite3_stmt* select = NULL;
-    std::string query = "SELECT tile_data from tiles where zoom_level = ? AND tile_column = ? AND tile_row = ?";
-    int rc = sqlite3_prepare_v2( database, query.c_str(), -1, &select, 0L );
-    if ( rc != SQLITE_OK )
+    // tiles written but not yet committed:
+    if (_readWrite)
     {
-        OE_WARN << LC << "Failed to prepare SQL: " << query << "; " << sqlite3_errmsg(database) << std::endl;
-        return ReadResult::RESULT_READER_ERROR;
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        std::uint64_t tileKey = packTileKey(z, x, y);
+        auto i = _pendingTiles.find(tileKey);
+        if (i != _pendingTiles.end())
+        {
+            dataBuffer = i->second;
+            found = true;
+        }
+        else
+        {
+            i = _committingTiles.find(tileKey);
+            if (i != _committingTiles.end())
+            {
+                dataBuffer = i->second;
+                found = true;
+            }
+        }
     }
 
-    bool valid = true;
+    if (!found)
+    {
+        ReadConnection conn;
+        if (!acquireReadConnection(conn))
+        {
+            return ReadResult::RESULT_READER_ERROR;
+        }
+
+        sqlite3_stmt* select = (sqlite3_stmt*)conn._select;
 
-    sqlite3_bind_int( select, 1, z );
-    sqlite3_bind_int( select, 2, x );
-    sqlite3_bind_int( select, 3, y );
+        sqlite3_bind_int( select, 1, z );
+        sqlite3_bind_int( select, 2, x );
+        sqlite3_bind_int( select, 3, y );
+
+        int rc = sqlite3_step( select );
+        if ( rc == SQLITE_ROW)
+        {
+            // the pointer returned from _blob gets freed internally by sqlite, supposedly
+            const char* data = (const char*)sqlite3_column_blob( select, 0 );
+            int dataLen = sqlite3_column_bytes( select, 0 );
+            dataBuffer.assign( data, dataLen );
+            found = true;
+        }
+        else
+        {
+            OE_DEBUG << LC << "SQL QUERY failed for " << SELECT_TILE_SQL << ": " << std::endl;
+        }
+
+        sqlite3_reset( select );
+        releaseReadConnection(conn);
+    }
 
     osg::Image* result = NULL;
-    rc = sqlite3_step( select );
-    if ( rc == SQLITE_ROW)
-    {
-        // the pointer returned from _blob gets freed internally by sqlite, supposedly
-        const char* data = (const char*)sqlite3_column_blob( select, 0 );
-        int dataLen = sqlite3_column_bytes( select, 0 );
 
-        std::string dataBuffer( data, dataLen );
+    if (found)
+    {
+        bool valid = true;
 
         // decompress if necessary:
         if ( _compressor.valid() )
@@ -727,15 +894,55 @@ MBTiles::Driver::read(
             }
         }
     }
-    else
+
+    return ReadResult(result);
+}
+
+bool
+MBTiles::Driver::acquireReadConnection(ReadConnection& conn) const
+{
     {
-        OE_DEBUG << LC << "SQL QUERY failed for " << query << ": " << std::endl;
-        valid = false;
+        std::lock_guard<std::mutex> lock(_readPoolMutex);
+        if (!_readPool.empty())
+        {
+            conn = _readPool.back();
+            _readPool.pop_back();
+            return true;
+        }
     }
 
-    sqlite3_finalize( select );
+    // none free; open another. The pool grows to the number of
+    // threads that read at the same time.
+    sqlite3* database = nullptr;
+    int rc = sqlite3_open_v2(_fullFilename.c_str(), &database, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, 0L);
+    if (rc != SQLITE_OK)
+    {
+        OE_WARN << LC << "Failed to open read connection: " << sqlite3_errmsg(database) << std::endl;
+        sqlite3_close_v2(database);
+        return false;
+    }
 
-    return ReadResult(result);
+    sqlite3_busy_timeout(database, BUSY_TIMEOUT_MS);
+
+    sqlite3_stmt* select = nullptr;
+    rc = sqlite3_prepare_v2(database, SELECT_TILE_SQL, -1, &select, 0L);
+    if (rc != SQLITE_OK)
+    {
+        OE_WARN << LC << "Failed to prepare SQL: " << SELECT_TILE_SQL << "; " << sqlite3_errmsg(database) << std::endl;
+        sqlite3_close_v2(database);
+        return false;
+    }
+
+    conn._db = database;
+    conn._select = select;
+    return true;
+}
+
+void
+MBTiles::Driver::releaseReadConnection(ReadConnection& conn) const
+{
+    std::lock_guard<std::mutex> lock(_readPoolMutex);
+    _readPool.push_back(conn);
 }
 
 
@@ -748,8 +955,6 @@ MBTiles::Driver::write(
     if (!key.valid() || !image)
         return Status::AssertionFailure;
 
-    std::lock_guard<std::mutex> exclusiveLock(_mutex);
-
     // encode the data stream:
     std::stringstream buf;
     osgDB::ReaderWriter::WriteResult wr;
@@ -791,58 +996,192 @@ MBTiles::Driver::write(
     key.getProfile()->getNumTiles(key.getLevelOfDetail(), numCols, numRows);
     y = numRows - y - 1;
 
-    sqlite3* database = (sqlite3*)_database;
+    // queue the tile for the writer thread.
+    bool batchReady = false;
+    {
+        std::unique_lock<std::mutex> lock(_writeMutex);
 
-    // Prep the insert statement:
-    sqlite3_stmt* insert = NULL;
-    std::string query = "INSERT OR REPLACE INTO tiles (zoom_level, tile_column, tile_row, tile_data) VALUES (?, ?, ?, ?)";
-    int rc = sqlite3_prepare_v2(database, query.c_str(), -1, &insert, 0L);
-    if (rc != SQLITE_OK)
+        if (!_writer.joinable())
+        {
+            return Status(Status::ServiceUnavailable, "Database is not open for writing");
+        }
+
+        // a batch failed to commit since the last write; report it here
+        // since write() itself only queues the tile.
+        if (_writeError.isError())
+        {
+            return _writeError;
+        }
+
+        // don't let a fast producer queue up unbounded memory
+        _writeCondition.wait(lock, [this]() {
+            return _pendingTiles.size() < 4u * _writeBatchSize || _stopWriter; });
+
+        _pendingTiles[packTileKey(z, x, y)] = std::move(value);
+        batchReady = (_pendingTiles.size() >= _writeBatchSize);
+
+        // adjust the level range if necessary
+        if (key.getLOD() > _maxLevel)
+        {
+            _maxLevel = key.getLOD();
+        }
+        if (key.getLOD() < _minLevel)
+        {
+            _minLevel = key.getLOD();
+        }
+    }
+
+    if (batchReady)
     {
-        return Status(Status::GeneralError, Stringify()
-            << "Failed to prepare SQL: " << query << "; " << sqlite3_errmsg(database));
+        _writeCondition.notify_all();
     }
 
-    // bind parameters:
-    sqlite3_bind_int(insert, 1, z);
-    sqlite3_bind_int(insert, 2, x);
-    sqlite3_bind_int(insert, 3, y);
+    return Status::NoError;
+}
+
+Status
+MBTiles::Driver::flush()
+{
+    std::unique_lock<std::mutex> lock(_writeMutex);
+
+    if (!_writer.joinable())
+        return _writeError;
 
-    // bind the data blob:
-    sqlite3_bind_blob(insert, 4, value.c_str(), value.length(), SQLITE_STATIC);
+    _flushRequested = true;
+    _writeCondition.notify_all();
 
-    // run the sql.
-    bool ok = true;
-    int tries = 0;
-    do {
-        rc = sqlite3_step(insert);
-    } while (++tries < 100 && (rc == SQLITE_BUSY || rc == SQLITE_LOCKED));
+    _writeCondition.wait(lock, [this]() {
+        return _pendingTiles.empty() && _committingTiles.empty(); });
+
+    _flushRequested = false;
+
+    return _writeError;
+}
 
-    if (SQLITE_OK != rc && SQLITE_DONE != rc)
+void
+MBTiles::Driver::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(_writeMutex);
+
+    while (true)
+    {
+        // wake up when a batch is ready, on request, or periodically so
+        // that a trickle of tiles still gets committed.
+        _writeCondition.wait_for(lock, std::chrono::milliseconds(500), [this]() {
+            return
+                _stopWriter ||
+                _pendingTiles.size() >= _writeBatchSize ||
+                (_flushRequested && !_pendingTiles.empty()); });
+
+        if (_pendingTiles.empty())
+        {
+            if (_stopWriter)
+                break;
+            else
+                continue;
+        }
+
+        _committingTiles.swap(_pendingTiles);
+
+        // wake any producers waiting for room
+        _writeCondition.notify_all();
+
+        lock.unlock();
+
+        Status status = commit(_committingTiles);
+        if (status.isError())
+        {
+            OE_WARN << LC << status.message() << std::endl;
+        }
+
+        lock.lock();
+
+        if (status.isError() && _writeError.isOK())
+        {
+            _writeError = status;
+        }
+
+        _committingTiles.clear();
+
+        // wake anyone waiting in flush()
+        _writeCondition.notify_all();
+    }
+}
+
+Status
+MBTiles::Driver::commit(const PendingTiles& tiles)
+{
+    std::lock_guard<std::mutex> exclusiveLock(_mutex);
+
+    sqlite3* database = (sqlite3*)_database;
+
+    // Prep the insert statement once and keep it:
+    sqlite3_stmt* insert = (sqlite3_stmt*)_insert;
+    if (insert == nullptr)
     {
+        int rc = sqlite3_prepare_v2(database, INSERT_TILE_SQL, -1, &insert, 0L);
+        if (rc != SQLITE_OK)
+        {
+            return Status(Status::GeneralError, Stringify()
+                << "Failed to prepare SQL: " << INSERT_TILE_SQL << "; " << sqlite3_errmsg(database));
+        }
+        _insert = insert;
+    }
+
+    Status status;
+    unsigned inTransaction = 0u;
+    int z, x, y;
+
+    for (auto& tile : tiles)
+    {
+        if (inTransaction == 0u)
+        {
+            if (sqlite3_exec(database, "BEGIN IMMEDIATE", 0L, 0L, 0L) != SQLITE_OK)
+            {
+                if (status.isOK())
+                    status = Status(Status::GeneralError, Stringify()
+                        << "Failed to begin a write transaction; " << sqlite3_errmsg(database));
+                return status;
+            }
+        }
+
+        unpackTileKey(tile.first, z, x, y);
+
+        // bind parameters:
+        sqlite3_bind_int(insert, 1, z);
+        sqlite3_bind_int(insert, 2, x);
+        sqlite3_bind_int(insert, 3, y);
+
+        // bind the data blob:
+        sqlite3_bind_blob(insert, 4, tile.second.c_str(), tile.second.length(), SQLITE_STATIC);
+
+        // run the sql.
+        int rc = sqlite3_step(insert);
+        if (SQLITE_OK != rc && SQLITE_DONE != rc && status.isOK())
+        {
 #if SQLITE_VERSION_NUMBER >= 3007015
-        return Status(Status::GeneralError, Stringify()<<"Failed query: " << query << "(" << rc << ")" << sqlite3_errstr(rc) << "; " << sqlite3_errmsg(database));
+            status = Status(Status::GeneralError, Stringify()<<"Failed query: " << INSERT_TILE_SQL << "(" << rc << ")" << sqlite3_errstr(rc) << "; " << sqlite3_errmsg(database));
 #else
-        return Status(Status::GeneralError, Stringify()<< "Failed query: " << query << "(" << rc << ")" << rc << "; " << sqlite3_errmsg(database));
+            status = Status(Status::GeneralError, Stringify()<< "Failed query: " << INSERT_TILE_SQL << "(" << rc << ")" << rc << "; " << sqlite3_errmsg(database));
 #endif
-        ok = false;
-    }
+        }
 
-    sqlite3_finalize(insert);
+        sqlite3_reset(insert);
 
-    // adjust the max level if necessary
-    if (key.getLOD() > _maxLevel)
-    {
-        _maxLevel = key.getLOD();
-        //putMetaData("maxlevel", Stringify()<<_maxLevel);
+        if (++inTransaction == _writeBatchSize)
+        {
+            inTransaction = 0u;
+            if (!commitTransaction(database, status))
+                return status;
+        }
     }
-    if (key.getLOD() < _minLevel)
+
+    if (inTransaction > 0u)
     {
-        _minLevel = key.getLOD();
-        //putMetaData("minlevel", Stringify()<<_minLevel);
+        commitTransaction(database, status);
     }
 
-    return Status::NoError;
+    return status;
 }
 
 bool
@@ -27,6 +27,7 @@
 #include <osgEarth/FeatureSource>
 #include <osgDB/Registry>
 #include <list>
+#include <cstring>
 #include <stdio.h>
 #include <stdlib.h>
 #include "vector_tile.pb.h"
@@ -310,7 +311,7 @@ namespace osgEarth { namespace MVT
         }
     }
 
-    bool readTile(std::istream& in, const TileKey& key, FeatureList& features)
+    bool readTileWithProtobuf(std::istream& in, const TileKey& key, FeatureList& features)
     {
         features.clear();
 
@@ -459,6 +460,569 @@ namespace osgEarth { namespace MVT
         return true;
     }
 
+
+    //....................................................................
+    // Streaming decoder
+    //
+    // Reads the protobuf wire format directly from the (decompressed) tile
+    // buffer. Nothing is copied until a feature is built: layers, features
+    // and values are referenced in place, keys and values are converted once
+    // per layer and only if some selected feature uses them, and geometry
+    // commands are expanded into scratch arrays that are reused across the
+    // whole tile.
+
+    // Minimal protobuf wire-format reader over a byte range
+    struct WireReader
+    {
+        const unsigned char* _p;
+        const unsigned char* _end;
+        bool _ok;
+
+        WireReader() : _p(nullptr), _end(nullptr), _ok(true) { }
+
+        WireReader(const void* data, std::size_t length) :
+            _p((const unsigned char*)data), _end((const unsigned char*)data + length), _ok(true) { }
+
+        bool ok() const { return _ok; }
+
+        const char* data() const { return (const char*)_p; }
+
+        std::size_t size() const { return _end - _p; }
+
+        std::uint64_t varint()
+        {
+            std::uint64_t result = 0u;
+            for (unsigned shift = 0; shift < 64u && _p < _end; shift += 7u)
+            {
+                unsigned char b = *_p++;
+                result |= (std::uint64_t)(b & 0x7f) << shift;
+                if ((b & 0x80) == 0)
+                    return result;
+            }
+            _ok = false;
+            return 0u;
+        }
+
+        // fixed-width fields are little-endian regardless of the host
+        std::uint64_t fixed(unsigned bytes)
+        {
+            if (size() < bytes)
+            {
+                _ok = false;
+                return 0u;
+            }
+            std::uint64_t result = 0u;
+            for (unsigned i = 0; i < bytes; ++i)
+                result |= (std::uint64_t)_p[i] << (8u * i);
+            _p += bytes;
+            return result;
+        }
+
+        WireReader bytes()
+        {
+            std::uint64_t length = varint();
+            if (!_ok || length > size())
+            {
+                _ok = false;
+                return WireReader();
+            }
+            WireReader sub(_p, (std::size_t)length);
+            _p += length;
+            return sub;
+        }
+
+        std::string string()
+        {
+            WireReader sub = bytes();
+            return std::string(sub.data(), sub.size());
+        }
+
+        //! Reads the next field tag; false at the end of the buffer or on error
+        bool next(unsigned& field, unsigned& wireType)
+        {
+            if (!_ok || _p >= _end)
+                return false;
+            std::uint64_t tag = varint();
+            field = (unsigned)(tag >> 3);
+            wireType = (unsigned)(tag & 0x7);
+            return _ok;
+        }
+
+        void skip(unsigned wireType)
+        {
+            switch (wireType)
+            {
+            case 0: varint(); break;
+            case 1: fixed(8); break;
+            case 2: bytes(); break;
+            case 5: fixed(4); break;
+            default: _ok = false; // groups are not used by MVT
+            }
+        }
+
+        //! Appends a repeated uint32 field, packed or not
+        void uint32s(unsigned wireType, std::vector<std::uint32_t>& out)
+        {
+            if (wireType == 2)
+            {
+                WireReader packed = bytes();
+                while (packed._ok && packed._p < packed._end)
+                    out.push_back((std::uint32_t)packed.varint());
+                _ok = _ok && packed._ok;
+            }
+            else if (wireType == 0)
+            {
+                out.push_back((std::uint32_t)varint());
+            }
+            else skip(wireType);
+        }
+    };
+
+    // A tile_value, decoded on first use
+    struct LayerValue
+    {
+        WireReader source;
+        bool decoded = false;
+        bool valid = false;
+        AttributeValue value;
+        std::string stringValue;
+    };
+
+    void decodeValue(LayerValue& v)
+    {
+        v.decoded = true;
+
+        // Mirror the precedence of the protobuf reader:
+        // bool, double, float, int, sint, string, uint.
+        enum { HAS_STRING = 1, HAS_FLOAT = 2, HAS_DOUBLE = 4, HAS_INT = 8, HAS_UINT = 16, HAS_SINT = 32, HAS_BOOL = 64 };
+        unsigned has = 0u;
+        float floatValue = 0.0f;
+        double doubleValue = 0.0;
+        std::int64_t intValue = 0, sintValue = 0;
+        std::uint64_t uintValue = 0u;
+        bool boolValue = false;
+
+        WireReader r = v.source;
+        unsigned field, wire;
+        while (r.next(field, wire))
+        {
+            if (field == 1 && wire == 2) {
+                v.stringValue = r.string(); has |= HAS_STRING;
+            }
+            else if (field == 2 && wire == 5) {
+                std::uint32_t bits = (std::uint32_t)r.fixed(4);
+                ::memcpy(&floatValue, &bits, 4); has |= HAS_FLOAT;
+            }
+            else if (field == 3 && wire == 1) {
+                std::uint64_t bits = r.fixed(8);
+                ::memcpy(&doubleValue, &bits, 8); has |= HAS_DOUBLE;
+            }
+            else if (field == 4 && wire == 0) {
+                intValue = (std::int64_t)r.varint(); has |= HAS_INT;
+            }
+            else if (field == 5 && wire == 0) {
+                uintValue = r.varint(); has |= HAS_UINT;
+            }
+            else if (field == 6 && wire == 0) {
+                std::uint64_t n = r.varint();
+                sintValue = (std::int64_t)(n >> 1) ^ -(std::int64_t)(n & 1); has |= HAS_SINT;
+            }
+            else if (field == 7 && wire == 0) {
+                boolValue = r.varint() != 0; has |= HAS_BOOL;
+            }
+            else r.skip(wire);
+        }
+
+        if (!r.ok())
+            return;
+
+        AttributeValue& a = v.value;
+        a.value.set = true;
+        v.valid = true;
+
+        if (has & HAS_BOOL) {
+            a.type = ATTRTYPE_BOOL; a.value.boolValue = boolValue;
+        }
+        else if (has & HAS_DOUBLE) {
+            a.type = ATTRTYPE_DOUBLE; a.value.doubleValue = doubleValue;
+        }
+        else if (has & HAS_FLOAT) {
+            a.type = ATTRTYPE_DOUBLE; a.value.doubleValue = floatValue;
+        }
+        else if (has & HAS_INT) {
+            a.type = ATTRTYPE_INT; a.value.intValue = (long long)intValue;
+        }
+        else if (has & HAS_SINT) {
+            a.type = ATTRTYPE_INT; a.value.intValue = (long long)sintValue;
+        }
+        else if (has & HAS_STRING) {
+            a.type = ATTRTYPE_STRING; a.value.stringValue = v.stringValue;
+        }
+        else if (has & HAS_UINT) {
+            a.type = ATTRTYPE_INT; a.value.intValue = (long long)uintValue;
+        }
+        else {
+            v.valid = false;
+        }
+    }
+
+    // Scratch state shared by every feature in a tile
+    struct TileDecoder
+    {
+        const TileKey& key;
+        const Selection& selection;
+        osg::ref_ptr<const SpatialReference> srs;
+        GeoExtent extent;
+        double xMin, yMax, width, height;
+
+        std::vector<std::uint32_t> tags;
+        std::vector<std::uint32_t> commands;
+        osg::ref_ptr<Ring> ring; // pooled ring/line coordinates
+        std::vector<WireReader> features;
+        std::vector<std::string> keys;
+        std::vector<char> keySelected;
+        std::vector<LayerValue> values;
+
+        TileDecoder(const TileKey& k, const Selection& s) :
+            key(k), selection(s)
+        {
+            srs = key.getProfile()->getSRS();
+            extent = key.getExtent();
+            xMin = extent.xMin(), yMax = extent.yMax();
+            width = extent.width(), height = extent.height();
+            ring = new Ring();
+        }
+
+        // Walks the command stream, calling "emit" for each vertex and
+        // "close" at each ClosePath. Same arithmetic as the protobuf path.
+        template<typename EMIT, typename CLOSE>
+        void walk(unsigned tileres, EMIT emit, CLOSE close)
+        {
+            unsigned length = 0;
+            int cmd = -1;
+            int x = 0, y = 0;
+            unsigned k = 0;
+            const unsigned n = commands.size();
+
+            while (k < n)
+            {
+                if (!length)
+                {
+                    unsigned cmd_length = commands[k++];
+                    cmd = cmd_length & ((1 << CMD_BITS) - 1);
+                    length = cmd_length >> CMD_BITS;
+                }
+                if (length > 0)
+                {
+                    length--;
+                    if (cmd == SEG_MOVETO || cmd == SEG_LINETO)
+                    {
+                        if (k + 2 > n)
+                            return;
+                        x += zig_zag_decode(commands[k++]);
+                        y += zig_zag_decode(commands[k++]);
+                        double geoX = xMin + (width / (double)tileres) * (double)x;
+                        double geoY = yMax - (height / (double)tileres) * (double)y;
+                        emit(cmd, geoX, geoY);
+                    }
+                    else if (cmd == CMD_CLOSEPATH)
+                    {
+                        close();
+                    }
+                }
+            }
+        }
+
+        Geometry* decodePoint(unsigned tileres)
+        {
+            osg::ref_ptr<PointSet> points = new PointSet(commands.size() / 2);
+            walk(tileres,
+                [&](int, double gx, double gy) { points->push_back(gx, gy, 0); },
+                [&]() { });
+            return points.release();
+        }
+
+        Geometry* decodeLine(unsigned tileres)
+        {
+            std::vector<osg::ref_ptr<osgEarth::LineString>> lines;
+            bool active = false;
+            auto flush = [&]() {
+                if (active)
+                    lines.push_back(new osgEarth::LineString(&ring->asVector()));
+                ring->clear();
+            };
+            ring->clear();
+            walk(tileres,
+                [&](int cmd, double gx, double gy) {
+                    if (cmd == SEG_MOVETO) {
+                        flush();
+                        active = true;
+                    }
+                    if (active)
+                        ring->push_back(gx, gy, 0);
+                },
+                [&]() { });
+            flush();
+
+            if (lines.empty())
+                return nullptr;
+            if (lines.size() == 1)
+                return lines[0].release();
+
+            MultiGeometry* multi = new MultiGeometry;
+            for (auto& line : lines)
+                multi->add(line.get());
+            return multi;
+        }
+
+        Geometry* decodePolygon(unsigned tileres)
+        {
+            std::vector<osg::ref_ptr<osgEarth::Polygon>> polygons;
+            osgEarth::Polygon* current = nullptr;
+            bool active = false;
+            ring->clear();
+            walk(tileres,
+                [&](int, double gx, double gy) {
+                    active = true;
+                    ring->push_back(gx, gy, 0);
+                },
+                [&]() {
+                    if (!active)
+                        return;
+                    double area = ring->getSignedArea2D();
+                    ring->close();
+                    if (area > 0)
+                    {
+                        ring->rewind(Geometry::ORIENTATION_CCW);
+                        polygons.push_back(new osgEarth::Polygon(&ring->asVector()));
+                        current = polygons.back().get();
+                    }
+                    else if (area < 0)
+                    {
+                        if (current)
+                        {
+                            ring->rewind(Geometry::ORIENTATION_CW);
+                            current->getHoles().push_back(new Ring(&ring->asVector()));
+                        }
+                        else
+                        {
+                            OE_DEBUG << LC << "Discarding improperly wound polygon (hole without an outer ring)\n";
+                        }
+                    }
+                    ring->clear();
+                    active = false;
+                });
+
+            if (polygons.empty())
+                return nullptr;
+            if (polygons.size() == 1)
+                return polygons[0].release();
+
+            MultiGeometry* multi = new MultiGeometry;
+            for (auto& polygon : polygons)
+                multi->add(polygon.get());
+            return multi;
+        }
+
+        void setOtherTags(Feature* feature, const std::string& other_tags)
+        {
+            // Special path for getting heights from our test dataset.
+            StringTokenizer tok("=>");
+            StringVector tized;
+            tok.tokenize(other_tags, tized);
+            if (tized.size() == 3 && tized[0] == "height")
+            {
+                float height = as<float>(tized[2], FLT_MAX);
+                if (height != FLT_MAX)
+                    feature->set("height", height);
+            }
+        }
+
+        bool readFeature(WireReader r, const std::string& layerName, unsigned tileres, FeatureList& output)
+        {
+            std::uint64_t id = 0u;
+            unsigned type = MVT::Unknown;
+            tags.clear();
+            commands.clear();
+
+            unsigned field, wire;
+            while (r.next(field, wire))
+            {
+                if (field == 1 && wire == 0) id = r.varint();
+                else if (field == 2) r.uint32s(wire, tags);
+                else if (field == 3 && wire == 0) type = (unsigned)r.varint();
+                else if (field == 4) r.uint32s(wire, commands);
+                else r.skip(wire);
+            }
+            if (!r.ok())
+                return false;
+
+            osg::ref_ptr<Feature> feature = new Feature(nullptr, srs.get());
+            feature->set("mvt_layer", layerName);
+
+            for (unsigned k = 0; k + 1 < tags.size(); k += 2)
+            {
+                unsigned keyIndex = tags[k], valueIndex = tags[k + 1];
+                if (keyIndex >= keys.size() || valueIndex >= values.size() || !keySelected[keyIndex])
+                    continue;
+
+                LayerValue& value = values[valueIndex];
+                if (!value.decoded)
+                    decodeValue(value);
+
+                const std::string& name = keys[keyIndex];
+                if (value.valid && (selection.attributes.empty() || selection.attributes.count(name) > 0))
+                    feature->set(name, value.value);
+
+                if (name == "other_tags")
+                    setOtherTags(feature.get(), value.stringValue);
+            }
+
+            osg::ref_ptr<Geometry> geometry;
+            if (type == MVT::Polygon)
+            {
+                geometry = decodePolygon(tileres);
+            }
+            else if (type == MVT::Point)
+            {
+                geometry = decodePoint(tileres);
+
+                // As in the protobuf reader, drop points outside the tile
+                if (geometry.valid() && !extent.contains(geometry->getBounds().center()))
+                    geometry = nullptr;
+            }
+            else
+            {
+                geometry = decodeLine(tileres);
+            }
+
+            if (geometry.valid())
+            {
+                feature->setFID(id);
+                feature->setGeometry(geometry.get());
+                output.push_back(feature.get());
+            }
+            return true;
+        }
+
+        bool readLayer(WireReader r, FeatureList& output)
+        {
+            std::string name;
+            unsigned tileres = 4096u;
+            features.clear();
+            keys.clear();
+            values.clear();
+
+            // Fields may come in any order, so index the layer first.
+            unsigned field, wire;
+            while (r.next(field, wire))
+            {
+                if (field == 1 && wire == 2) name = r.string();
+                else if (field == 2 && wire == 2) features.push_back(r.bytes());
+                else if (field == 3 && wire == 2) keys.push_back(r.string());
+                else if (field == 4 && wire == 2) {
+                    values.emplace_back();
+                    values.back().source = r.bytes();
+                }
+                else if (field == 5 && wire == 0) tileres = (unsigned)r.varint();
+                else r.skip(wire);
+            }
+            if (!r.ok())
+                return false;
+
+            if (!selection.layers.empty() && selection.layers.count(name) == 0)
+                return true;
+
+            // resolve the attribute selection once per key, not per feature;
+            // other_tags is kept when it can produce a selected height.
+            keySelected.resize(keys.size());
+            for (unsigned i = 0; i < keys.size(); ++i)
+            {
+                keySelected[i] =
+                    selection.attributes.empty() ||
+                    selection.attributes.count(keys[i]) > 0 ||
+                    (keys[i] == "other_tags" && selection.attributes.count("height") > 0);
+            }
+
+            for (auto& feature : features)
+            {
+                if (!readFeature(feature, name, tileres, output))
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    // Exposes a memory buffer as a stream without copying it
+    struct MemoryStreamBuf : public std::streambuf
+    {
+        MemoryStreamBuf(const char* data, std::size_t length)
+        {
+            char* p = const_cast<char*>(data);
+            setg(p, p, p + length);
+        }
+    };
+
+    bool isCompressed(const char* data, std::size_t length)
+    {
+        if (length < 2)
+            return false;
+        unsigned char b0 = data[0], b1 = data[1];
+        bool gzip = (b0 == 0x1f && b1 == 0x8b);
+        bool zlib = (b0 & 0x0f) == 8 && ((b0 << 8) | b1) % 31 == 0;
+        return gzip || zlib;
+    }
+
+    bool readTile(const char* data, std::size_t length, const TileKey& key, const Selection& selection, FeatureList& features)
+    {
+        features.clear();
+
+        std::string inflated;
+        if (isCompressed(data, length))
+        {
+            osg::ref_ptr<osgDB::BaseCompressor> compressor = osgDB::Registry::instance()->getObjectWrapperManager()->findCompressor("zlib");
+            if (!compressor.valid())
+            {
+                return false;
+            }
+
+            MemoryStreamBuf buf(data, length);
+            std::istream in(&buf);
+            if (compressor->decompress(in, inflated))
+            {
+                data = inflated.data();
+                length = inflated.size();
+            }
+        }
+
+        TileDecoder decoder(key, selection);
+
+        WireReader tile(data, length);
+        bool ok = true;
+        unsigned field, wire;
+        while (ok && tile.next(field, wire))
+        {
+            if (field == 3 && wire == 2)
+                ok = decoder.readLayer(tile.bytes(), features);
+            else
+                tile.skip(wire);
+        }
+
+        if (!ok || !tile.ok())
+        {
+            OE_WARN << "Failed to parse mvt" << key.str() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool readTile(std::istream& in, const TileKey& key, FeatureList& features)
+    {
+        std::string buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return readTile(buffer.data(), buffer.size(), key, Selection(), features);
+    }
+
 }} // namespace osgEarth::MVT
 
 //........................................................................
@@ -470,6 +1034,8 @@ MVTFeatureSourceOptions::getConfig() const
     conf.set("url", url());
     conf.set("min_level", _minLevel);
     conf.set("max_level", _maxLevel);
+    conf.set("layers", layers());
+    conf.set("attributes", attributes());
     return conf;
 }
 
@@ -479,6 +1045,8 @@ MVTFeatureSourceOptions::fromConfig(const Config& conf)
     conf.get("url", url());
     conf.get("min_level", _minLevel);
     conf.get("max_level", _maxLevel);
+    conf.get("layers", layers());
+    conf.get("attributes", attributes());
 }
 
 //........................................................................
@@ -486,6 +1054,8 @@ MVTFeatureSourceOptions::fromConfig(const Config& conf)
 REGISTER_OSGEARTH_LAYER(mvtfeatures, MVTFeatureSource);
 
 OE_LAYER_PROPERTY_IMPL(MVTFeatureSource, URI, URL, url);
+OE_LAYER_PROPERTY_IMPL(MVTFeatureSource, std::string, Layers, layers);
+OE_LAYER_PROPERTY_IMPL(MVTFeatureSource, std::string, Attributes, attributes);
 
 void
 MVTFeatureSource::init()
@@ -530,6 +1100,15 @@ MVTFeatureSource::openImplementation()
 
     setFeatureProfile(createFeatureProfile());
 
+    // layers and attributes to decode (empty = everything)
+    _selection = MVT::Selection();
+    StringVector tokens;
+    StringTokenizer(options().layers().get(), tokens, ",", "", false, true);
+    _selection.layers.insert(tokens.begin(), tokens.end());
+    tokens.clear();
+    StringTokenizer(options().attributes().get(), tokens, ",", "", false, true);
+    _selection.attributes.insert(tokens.begin(), tokens.end());
+
     return Status::NoError;
 }
 
@@ -585,9 +1164,7 @@ MVTFeatureSource::createFeatureCursorImplementation(const Query& query, Progress
         // the pointer returned from _blob gets freed internally by sqlite, supposedly
         const char* data = (const char*)sqlite3_column_blob(select, 0);
         int dataLen = sqlite3_column_bytes(select, 0);
-        std::string dataBuffer(data, dataLen);
-        std::stringstream in(dataBuffer);
-        MVT::readTile(in, key, features);
+        MVT::readTile(data, dataLen, key, _selection, features);
     }
     else
     {
@@ -678,12 +1255,10 @@ MVTFeatureSource::iterateTiles(int zoomLevel, int limit, int offset, const GeoEx
         // the pointer returned from _blob gets freed internally by sqlite, supposedly
         const char* data = (const char*)sqlite3_column_blob(select, 3);
         int dataLen = sqlite3_column_bytes(select, 3);
-        std::string dataBuffer(data, dataLen);
-        std::stringstream in(dataBuffer);
 
         FeatureList features;
 
-        MVT::readTile(in, key, features);
+        MVT::readTile(data, dataLen, key, _selection, features);
 
         // If we have any features and we have an fid attribute, override the fid of the features
         // NOTE: FeatureSource normally does this, but we're bypassing it here... consider a refactoring...
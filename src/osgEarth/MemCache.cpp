@@ -17,6 +17,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>
  */
 #include <osgEarth/MemCache>
+#include <osg/Image>
 
 using namespace osgEarth;
 
@@ -30,20 +31,29 @@ namespace
 {
     typedef std::pair<osg::ref_ptr<const osg::Object>, Config> MemCacheEntry;
     typedef LRUCache<std::string, MemCacheEntry> MemCacheLRU;
+    typedef ConcurrentLRUCache<std::string, MemCacheEntry> MemCacheConcurrentLRU;
 
-    struct MemCacheBin : public CacheBin
+    struct MemCacheBinBase : public CacheBin
     {
-        MemCacheBin( const std::string& id, unsigned maxSize )
-            : CacheBin( id, true ),
-              _lru    ( true /* MT-safe */, maxSize )
+        MemCacheBinBase(const std::string& id) : CacheBin(id, true) { }
+
+        virtual CacheStats getStats() const = 0;
+    };
+
+    template<typename LRU>
+    struct MemCacheBin : public MemCacheBinBase
+    {
+        MemCacheBin( const std::string& id, LRU* lru )
+            : MemCacheBinBase( id ),
+              _lru( lru )
         {
             //nop
         }
 
         ReadResult readObject(const std::string& key, const osgDB::Options*)
         {
-            MemCacheLRU::Record rec;
-            _lru.get(key, rec);
+            typename LRU::Record rec;
+            _lru->get(key, rec);
 
             // clone required since the cache is in memory
 
@@ -79,9 +89,9 @@ namespace
             {
 #ifdef CLONE_DATA
                 osg::ref_ptr<const osg::Object> cloned = osg::clone(object, osg::CopyOp::DEEP_COPY_ALL);
-                _lru.insert( key, std::make_pair(cloned.get(), meta) );
+                _lru->insert( key, std::make_pair(cloned.get(), meta) );
 #else
-                _lru.insert( key, std::make_pair(object, meta) );
+                _lru->insert( key, std::make_pair(object, meta) );
 #endif
                 return true;
             }
@@ -91,26 +101,26 @@ namespace
 
         bool remove(const std::string& key)
         {
-            _lru.erase(key);
+            _lru->erase(key);
             return true;
         }
 
         bool touch(const std::string& key)
         {
             // just doing a get will put it at the front of the LRU list
-            MemCacheLRU::Record dummy;
-            return _lru.get(key, dummy);
+            typename LRU::Record dummy;
+            return _lru->get(key, dummy);
         }
 
         RecordStatus getRecordStatus( const std::string& key )
         {
             // ignore minTime; MemCache does not support expiration
-            return _lru.has(key) ? STATUS_OK : STATUS_NOT_FOUND;
+            return _lru->has(key) ? STATUS_OK : STATUS_NOT_FOUND;
         }
 
         bool purge()
         {
-            _lru.clear();
+            _lru->clear();
             return true;
         }
 
@@ -119,8 +129,19 @@ namespace
             return key;
         }
 
-        MemCacheLRU _lru;
+        CacheStats getStats() const
+        {
+            return _lru->getStats();
+        }
+
+        std::unique_ptr<LRU> _lru;
     };
+
+    std::size_t sizeOfEntry(const MemCacheEntry& entry)
+    {
+        const osg::Image* image = dynamic_cast<const osg::Image*>(entry.first.get());
+        return image ? image->getTotalSizeInBytesIncludingMipmaps() : 0u;
+    }
     
 
     static std::mutex s_defaultBinMutex;
@@ -128,16 +149,36 @@ namespace
 
 //------------------------------------------------------------------------
 
-MemCache::MemCache( unsigned maxBinSize ) :
-_maxBinSize( osg::maximum(maxBinSize, 1u) )
+MemCache::MemCache( unsigned maxBinSize, bool concurrent ) :
+_maxBinSize( osg::maximum(maxBinSize, 1u) ),
+_concurrent( concurrent ),
+_maxBinBytes( 0u )
 {
     //nop
 }
 
+CacheBin*
+MemCache::createBin(const std::string& binID) const
+{
+    if (_concurrent)
+    {
+        // small bins get fewer shards so each shard still holds a useful number of entries
+        unsigned numShards = osg::clampBetween(_maxBinSize / 8u, 1u, 16u);
+        auto* lru = new MemCacheConcurrentLRU(_maxBinSize, numShards);
+        if (_maxBinBytes > 0u)
+            lru->setMaxBytes(_maxBinBytes, sizeOfEntry);
+        return new MemCacheBin<MemCacheConcurrentLRU>(binID, lru);
+    }
+    else
+    {
+        return new MemCacheBin<MemCacheLRU>(binID, new MemCacheLRU(true /* MT-safe */, _maxBinSize));
+    }
+}
+
 CacheBin*
 MemCache::addBin( const std::string& binID )
 {
-    return _bins.getOrCreate( binID, new MemCacheBin(binID, _maxBinSize) );
+    return _bins.getOrCreate( binID, createBin(binID) );
 }
 
 CacheBin*
@@ -158,7 +199,7 @@ MemCache::getOrCreateDefaultBin()
         // double check
         if ( !_defaultBin.valid() )
         {
-            _defaultBin = new MemCacheBin("__default", _maxBinSize);
+            _defaultBin = createBin("__default");
         }
     }
 
@@ -169,7 +210,9 @@ MemCache::getOrCreateDefaultBin()
 void
 MemCache::dumpStats(const std::string& binID)
 {
-    MemCacheBin* bin = static_cast<MemCacheBin*>(getBin(binID));
-    CacheStats stats = bin->_lru.getStats();
+    MemCacheBinBase* bin = static_cast<MemCacheBinBase*>(getBin(binID));
+    if (!bin)
+        return;
+    CacheStats stats = bin->getStats();
     OE_INFO << LC << "hit ratio = " << stats._hitRatio << std::endl;
 }
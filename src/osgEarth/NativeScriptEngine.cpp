@@ -0,0 +1,1486 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+ * Copyright 2020 Pelican Mapping
+ * http://osgearth.org
+ *
+ * osgEarth is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include <osgEarth/NativeScriptEngine>
+#include <osgEarth/Geometry>
+#include <osgEarth/StringUtils>
+#include <osgEarth/Math>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+#define LC "[NativeScriptEngine] "
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    // Deepest operand stack a script may need. Anything deeper is
+    // left to the fallback engine.
+    constexpr int MAX_STACK = 32;
+
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+    const double Inf = std::numeric_limits<double>::infinity();
+
+    enum Op
+    {
+        OP_CONST,           // push constant [a]
+        OP_PROP,            // push feature.properties[key a]
+        OP_ID,              // push feature.id
+        OP_GEOMETRY_TYPE,   // push feature.geometry.type
+        OP_NOT, OP_NEG, OP_POS,
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+        OP_LT, OP_LE, OP_GT, OP_GE,
+        OP_EQ, OP_NE, OP_STRICT_EQ, OP_STRICT_NE,
+        OP_JUMP,            // jump to [a]
+        OP_JUMP_IF_FALSE,   // pop; jump to [a] if falsy
+        OP_AND,             // if top is falsy jump to [a], else pop
+        OP_OR,              // if top is truthy jump to [a], else pop
+        OP_MATH,            // Math function [a] with [b] arguments
+        OP_METHOD,          // String method [a] with [b] arguments
+        OP_LENGTH           // .length
+    };
+
+    enum MathFunction
+    {
+        MATH_ABS, MATH_CEIL, MATH_FLOOR, MATH_ROUND, MATH_SQRT,
+        MATH_LOG, MATH_EXP, MATH_SIN, MATH_COS, MATH_TAN,
+        MATH_ASIN, MATH_ACOS, MATH_ATAN, MATH_ATAN2, MATH_POW,
+        MATH_MIN, MATH_MAX
+    };
+
+    enum Method
+    {
+        METHOD_TO_UPPER_CASE, METHOD_TO_LOWER_CASE, METHOD_TRIM,
+        METHOD_SUBSTRING, METHOD_INDEX_OF, METHOD_CHAR_AT, METHOD_TO_STRING
+    };
+
+    struct Instruction
+    {
+        Op op;
+        int a, b;
+    };
+
+    // A JavaScript primitive value. Strings either own their text or point
+    // at text that outlives the evaluation (a constant or an attribute).
+    struct Value
+    {
+        enum Type { UNDEFINED, NUL, BOOLEAN, NUMBER, STRING };
+
+        Type type = UNDEFINED;
+        bool b = false;
+        double n = 0.0;
+        const std::string* ref = nullptr;
+        std::string own;
+
+        const std::string& str() const { return ref ? *ref : own; }
+
+        void setUndefined() { type = UNDEFINED; }
+        void setBool(bool v) { type = BOOLEAN; b = v; }
+        void setNumber(double v) { type = NUMBER; n = v; }
+        void setString(const std::string& s) { type = STRING; ref = &s; }
+        void setString(std::string&& s) { type = STRING; ref = nullptr; own = std::move(s); }
+    };
+
+    inline bool isASCII(const std::string& s)
+    {
+        for (auto c : s)
+            if ((unsigned char)c >= 0x80)
+                return false;
+        return true;
+    }
+
+    inline bool isWhiteSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    inline bool isHexDigit(char c)
+    {
+        return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    inline int hexValue(char c)
+    {
+        return isDigit(c) ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : c - 'A' + 10;
+    }
+
+    // Length of the decimal literal (digits, fraction, exponent) at s[i],
+    // or 0 if there isn't one.
+    std::size_t scanDecimal(const std::string& s, std::size_t i)
+    {
+        std::size_t start = i;
+        std::size_t digits = 0;
+        while (i < s.size() && isDigit(s[i])) ++i, ++digits;
+        if (i < s.size() && s[i] == '.')
+        {
+            ++i;
+            while (i < s.size() && isDigit(s[i])) ++i, ++digits;
+        }
+        if (digits == 0)
+            return 0;
+        if (i < s.size() && (s[i] == 'e' || s[i] == 'E'))
+        {
+            std::size_t j = i + 1;
+            if (j < s.size() && (s[j] == '+' || s[j] == '-')) ++j;
+            if (j < s.size() && isDigit(s[j]))
+            {
+                while (j < s.size() && isDigit(s[j])) ++j;
+                i = j;
+            }
+        }
+        return i - start;
+    }
+
+    // JavaScript ToNumber for a string (ASCII only)
+    double stringToNumber(const std::string& input)
+    {
+        std::size_t first = 0, last = input.size();
+        while (first < last && isWhiteSpace(input[first])) ++first;
+        while (last > first && isWhiteSpace(input[last - 1])) --last;
+        if (first == last)
+            return 0.0;
+
+        std::string s = input.substr(first, last - first);
+
+        if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+        {
+            double value = 0.0;
+            for (std::size_t i = 2; i < s.size(); ++i)
+            {
+                if (!isHexDigit(s[i]))
+                    return NaN;
+                value = value * 16.0 + (double)hexValue(s[i]);
+            }
+            return value;
+        }
+
+        std::size_t i = 0;
+        bool negative = false;
+        if (s[0] == '+' || s[0] == '-')
+        {
+            negative = (s[0] == '-');
+            ++i;
+        }
+
+        if (s.compare(i, std::string::npos, "Infinity") == 0)
+            return negative ? -Inf : Inf;
+
+        std::size_t len = scanDecimal(s, i);
+        if (len == 0 || i + len != s.size())
+            return NaN;
+
+        return ::strtod(s.c_str(), nullptr);
+    }
+
+    // JavaScript ToString for a number: the shortest digit string that
+    // round-trips, laid out per ECMAScript Number::toString.
+    std::string numberToString(double v)
+    {
+        if (std::isnan(v))
+            return "NaN";
+        if (v == 0.0)
+            return "0";
+        if (std::isinf(v))
+            return v < 0.0 ? "-Infinity" : "Infinity";
+
+        std::string sign;
+        if (v < 0.0)
+        {
+            sign = "-";
+            v = -v;
+        }
+
+        char buf[40];
+        for (int precision = 1; precision <= 17; ++precision)
+        {
+            snprintf(buf, sizeof(buf), "%.*e", precision - 1, v);
+            if (::strtod(buf, nullptr) == v)
+                break;
+        }
+
+        std::string digits;
+        const char* c = buf;
+        for (; *c && *c != 'e'; ++c)
+            if (isDigit(*c))
+                digits.push_back(*c);
+        int exponent = *c == 'e' ? atoi(c + 1) : 0;
+
+        while (digits.size() > 1 && digits.back() == '0')
+            digits.pop_back();
+
+        int k = (int)digits.size();
+        int n = exponent + 1;
+
+        if (k <= n && n <= 21)
+            return sign + digits + std::string(n - k, '0');
+
+        if (0 < n && n <= 21)
+            return sign + digits.substr(0, n) + "." + digits.substr(n);
+
+        if (-6 < n && n <= 0)
+            return sign + "0." + std::string(-n, '0') + digits;
+
+        std::string e = (n - 1 >= 0 ? "e+" : "e-") + std::to_string(std::abs(n - 1));
+        if (k == 1)
+            return sign + digits + e;
+
+        return sign + digits.substr(0, 1) + "." + digits.substr(1) + e;
+    }
+
+    // JavaScript ToInteger
+    inline double toInteger(double v)
+    {
+        return std::isnan(v) ? 0.0 : std::trunc(v);
+    }
+
+    //........................................................................
+
+    struct Token
+    {
+        enum Kind { END, NUMBER, STRING, IDENT, PUNCT };
+        Kind kind = END;
+        std::string text;
+        double number = 0.0;
+    };
+
+    bool encodeUTF8(unsigned cp, std::string& out)
+    {
+        if (cp >= 0xD800 && cp <= 0xDFFF)
+            return false; // surrogate halves; leave to the full engine
+        if (cp < 0x80) {
+            out.push_back((char)cp);
+        }
+        else if (cp < 0x800) {
+            out.push_back((char)(0xC0 | (cp >> 6)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+        else {
+            out.push_back((char)(0xE0 | (cp >> 12)));
+            out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+        return true;
+    }
+
+    bool tokenize(const std::string& code, std::vector<Token>& tokens)
+    {
+        static const char* punctuators[] = {
+            "===", "!==", "==", "!=", "<=", ">=", "&&", "||", "++", "--",
+            "<", ">", "+", "-", "*", "/", "%", "!", "?", ":",
+            "(", ")", "[", "]", ".", ",", ";"
+        };
+
+        std::size_t i = 0;
+        while (i < code.size())
+        {
+            char c = code[i];
+
+            if (isWhiteSpace(c))
+            {
+                ++i;
+                continue;
+            }
+
+            Token t;
+
+            if (isDigit(c) || (c == '.' && i + 1 < code.size() && isDigit(code[i + 1])))
+            {
+                if (c == '0' && i + 1 < code.size() && (code[i + 1] == 'x' || code[i + 1] == 'X'))
+                {
+                    std::size_t j = i + 2;
+                    while (j < code.size() && isHexDigit(code[j]))
+                        t.number = t.number * 16.0 + (double)hexValue(code[j++]);
+                    if (j == i + 2)
+                        return false;
+                    i = j;
+                }
+                else
+                {
+                    // no legacy octal literals
+                    if (c == '0' && i + 1 < code.size() && isDigit(code[i + 1]))
+                        return false;
+                    std::size_t len = scanDecimal(code, i);
+                    t.number = ::strtod(code.substr(i, len).c_str(), nullptr);
+                    i += len;
+                }
+                t.kind = Token::NUMBER;
+            }
+
+            else if (c == '\'' || c == '\"')
+            {
+                char quote = c;
+                ++i;
+                for (;;)
+                {
+                    if (i >= code.size() || code[i] == '\n' || code[i] == '\r')
+                        return false;
+                    c = code[i++];
+                    if (c == quote)
+                        break;
+                    if (c != '\\')
+                    {
+                        t.text.push_back(c);
+                        continue;
+                    }
+                    if (i >= code.size())
+                        return false;
+                    c = code[i++];
+                    switch (c)
+                    {
+                    case 'n': t.text.push_back('\n'); break;
+                    case 't': t.text.push_back('\t'); break;
+                    case 'r': t.text.push_back('\r'); break;
+                    case 'b': t.text.push_back('\b'); break;
+                    case 'f': t.text.push_back('\f'); break;
+                    case 'v': t.text.push_back('\v'); break;
+                    case '0':
+                        if (i < code.size() && isDigit(code[i]))
+                            return false;
+                        t.text.push_back('\0');
+                        break;
+                    case 'x':
+                    case 'u':
+                    {
+                        std::size_t count = (c == 'x') ? 2 : 4;
+                        if (i + count > code.size())
+                            return false;
+                        unsigned cp = 0;
+                        for (std::size_t j = 0; j < count; ++j)
+                        {
+                            if (!isHexDigit(code[i + j]))
+                                return false;
+                            cp = (cp << 4) | (unsigned)hexValue(code[i + j]);
+                        }
+                        if (!encodeUTF8(cp, t.text))
+                            return false;
+                        i += count;
+                        break;
+                    }
+                    default:
+                        // octal escapes and line continuations aren't supported
+                        if (isDigit(c) || c == '\n' || c == '\r')
+                            return false;
+                        t.text.push_back(c);
+                    }
+                }
+                t.kind = Token::STRING;
+            }
+
+            else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$')
+            {
+                std::size_t j = i;
+                while (j < code.size() && (
+                    (code[j] >= 'a' && code[j] <= 'z') || (code[j] >= 'A' && code[j] <= 'Z') ||
+                    isDigit(code[j]) || code[j] == '_' || code[j] == '$'))
+                {
+                    ++j;
+                }
+                t.kind = Token::IDENT;
+                t.text = code.substr(i, j - i);
+                i = j;
+            }
+
+            else
+            {
+                // comments are left to the full engine
+                if (code.compare(i, 2, "//") == 0 || code.compare(i, 2, "/*") == 0)
+                    return false;
+
+                for (auto p : punctuators)
+                {
+                    std::size_t len = strlen(p);
+                    if (code.compare(i, len, p) == 0)
+                    {
+                        t.kind = Token::PUNCT;
+                        t.text = p;
+                        i += len;
+                        break;
+                    }
+                }
+                if (t.kind != Token::PUNCT)
+                    return false;
+            }
+
+            tokens.push_back(t);
+        }
+
+        tokens.push_back(Token());
+        return true;
+    }
+}
+
+//........................................................................
+
+struct NativeScript::Program
+{
+    std::vector<Instruction> code;
+    std::vector<std::string> strings;
+    std::vector<double> numbers;
+    std::vector<Value> constants;
+    std::vector<std::string> keys;
+};
+
+namespace
+{
+    // Recursive-descent compiler for a single JavaScript expression.
+    class Compiler
+    {
+    public:
+        Compiler(const std::vector<Token>& tokens, NativeScript::Program& program) :
+            _tokens(tokens), _program(program) { }
+
+        bool compile()
+        {
+            if (!expression())
+                return false;
+            if (isPunct(";"))
+                ++_pos;
+            return _tokens[_pos].kind == Token::END && _maxDepth <= MAX_STACK;
+        }
+
+    private:
+        const std::vector<Token>& _tokens;
+        NativeScript::Program& _program;
+        std::size_t _pos = 0;
+        int _depth = 0;
+        int _maxDepth = 0;
+        int _nesting = 0;
+
+        // Bounds the parser's recursion on pathological input
+        struct Nest
+        {
+            int& n;
+            Nest(int& n_) : n(n_) { ++n; }
+            ~Nest() { --n; }
+            bool ok() const { return n <= 64; }
+        };
+
+        const Token& peek() const { return _tokens[_pos]; }
+
+        bool isPunct(const char* p) const {
+            return peek().kind == Token::PUNCT && peek().text == p;
+        }
+
+        bool isIdent(const char* name) const {
+            return peek().kind == Token::IDENT && peek().text == name;
+        }
+
+        bool expect(const char* p) {
+            if (!isPunct(p)) return false;
+            ++_pos;
+            return true;
+        }
+
+        int emit(Op op, int stackChange, int a = 0, int b = 0)
+        {
+            _program.code.push_back(Instruction{ op, a, b });
+            _depth += stackChange;
+            _maxDepth = std::max(_maxDepth, _depth);
+            return (int)_program.code.size() - 1;
+        }
+
+        void patch(int instruction)
+        {
+            _program.code[instruction].a = (int)_program.code.size();
+        }
+
+        void constant(const Value& value)
+        {
+            _program.constants.push_back(value);
+            emit(OP_CONST, +1, (int)_program.constants.size() - 1);
+        }
+
+        void numberConstant(double n)
+        {
+            Value v;
+            v.setNumber(n);
+            constant(v);
+        }
+
+        void stringConstant(const std::string& s)
+        {
+            // Strings are stored apart from the constant values so the
+            // constants can point at them; fixed up in finish().
+            Value v;
+            v.type = Value::STRING;
+            v.n = (double)_program.strings.size();
+            _program.strings.push_back(s);
+            constant(v);
+        }
+
+        bool expression()
+        {
+            return conditional();
+        }
+
+        bool conditional()
+        {
+            Nest nest(_nesting);
+            if (!nest.ok() || !logicalOr())
+                return false;
+            if (!isPunct("?"))
+                return true;
+            ++_pos;
+            int jumpToElse = emit(OP_JUMP_IF_FALSE, -1);
+            if (!conditional() || !expect(":"))
+                return false;
+            int jumpToEnd = emit(OP_JUMP, 0);
+            patch(jumpToElse);
+            --_depth;
+            if (!conditional())
+                return false;
+            patch(jumpToEnd);
+            return true;
+        }
+
+        bool logicalOr()
+        {
+            if (!logicalAnd())
+                return false;
+            while (isPunct("||"))
+            {
+                ++_pos;
+                int jump = emit(OP_OR, -1);
+                if (!logicalAnd())
+                    return false;
+                patch(jump);
+            }
+            return true;
+        }
+
+        bool logicalAnd()
+        {
+            if (!equality())
+                return false;
+            while (isPunct("&&"))
+            {
+                ++_pos;
+                int jump = emit(OP_AND, -1);
+                if (!equality())
+                    return false;
+                patch(jump);
+            }
+            return true;
+        }
+
+        bool equality()
+        {
+            if (!relational())
+                return false;
+            for (;;)
+            {
+                Op op;
+                if (isPunct("==")) op = OP_EQ;
+                else if (isPunct("!=")) op = OP_NE;
+                else if (isPunct("===")) op = OP_STRICT_EQ;
+                else if (isPunct("!==")) op = OP_STRICT_NE;
+                else return true;
+                ++_pos;
+                if (!relational())
+                    return false;
+                emit(op, -1);
+            }
+        }
+
+        bool relational()
+        {
+            if (!additive())
+                return false;
+            for (;;)
+            {
+                Op op;
+                if (isPunct("<")) op = OP_LT;
+                else if (isPunct("<=")) op = OP_LE;
+                else if (isPunct(">")) op = OP_GT;
+                else if (isPunct(">=")) op = OP_GE;
+                else return true;
+                ++_pos;
+                if (!additive())
+                    return false;
+                emit(op, -1);
+            }
+        }
+
+        bool additive()
+        {
+            if (!multiplicative())
+                return false;
+            for (;;)
+            {
+                Op op;
+                if (isPunct("+")) op = OP_ADD;
+                else if (isPunct("-")) op = OP_SUB;
+                else return true;
+                ++_pos;
+                if (!multiplicative())
+                    return false;
+                emit(op, -1);
+            }
+        }
+
+        bool multiplicative()
+        {
+            if (!unary())
+                return false;
+            for (;;)
+            {
+                Op op;
+                if (isPunct("*")) op = OP_MUL;
+                else if (isPunct("/")) op = OP_DIV;
+                else if (isPunct("%")) op = OP_MOD;
+                else return true;
+                ++_pos;
+                if (!unary())
+                    return false;
+                emit(op, -1);
+            }
+        }
+
+        bool unary()
+        {
+            Op op;
+            if (isPunct("!")) op = OP_NOT;
+            else if (isPunct("-")) op = OP_NEG;
+            else if (isPunct("+")) op = OP_POS;
+            else return postfix();
+            ++_pos;
+            Nest nest(_nesting);
+            if (!nest.ok() || !unary())
+                return false;
+            emit(op, 0);
+            return true;
+        }
+
+        bool arguments(int& count)
+        {
+            count = 0;
+            if (!expect("("))
+                return false;
+            if (expect(")"))
+                return true;
+            for (;;)
+            {
+                if (!conditional())
+                    return false;
+                ++count;
+                if (expect(")"))
+                    return true;
+                if (!expect(","))
+                    return false;
+            }
+        }
+
+        bool postfix()
+        {
+            if (!primary())
+                return false;
+
+            while (isPunct("."))
+            {
+                ++_pos;
+                if (peek().kind != Token::IDENT)
+                    return false;
+                std::string name = peek().text;
+                ++_pos;
+
+                if (name == "length")
+                {
+                    emit(OP_LENGTH, 0);
+                    continue;
+                }
+
+                Method method;
+                if (name == "toUpperCase") method = METHOD_TO_UPPER_CASE;
+                else if (name == "toLowerCase") method = METHOD_TO_LOWER_CASE;
+                else if (name == "trim") method = METHOD_TRIM;
+                else if (name == "substring") method = METHOD_SUBSTRING;
+                else if (name == "indexOf") method = METHOD_INDEX_OF;
+                else if (name == "charAt") method = METHOD_CHAR_AT;
+                else if (name == "toString") method = METHOD_TO_STRING;
+                else return false;
+
+                int count;
+                if (!arguments(count))
+                    return false;
+                emit(OP_METHOD, -count, method, count);
+            }
+            return true;
+        }
+
+        bool featureAccess()
+        {
+            // "feature" already consumed
+            if (!expect(".") || peek().kind != Token::IDENT)
+                return false;
+            std::string member = peek().text;
+            ++_pos;
+
+            if (member == "id")
+            {
+                emit(OP_ID, +1);
+                return true;
+            }
+
+            if (member == "geometry")
+            {
+                if (!expect(".") || !isIdent("type"))
+                    return false;
+                ++_pos;
+                emit(OP_GEOMETRY_TYPE, +1);
+                return true;
+            }
+
+            if (member == "properties")
+            {
+                std::string key;
+                if (expect("."))
+                {
+                    if (peek().kind != Token::IDENT)
+                        return false;
+                    key = peek().text;
+                    ++_pos;
+                }
+                else if (expect("["))
+                {
+                    if (peek().kind != Token::STRING)
+                        return false;
+                    key = peek().text;
+                    ++_pos;
+                    if (!expect("]"))
+                        return false;
+                }
+                else return false;
+
+                _program.keys.push_back(key);
+                emit(OP_PROP, +1, (int)_program.keys.size() - 1);
+                return true;
+            }
+
+            return false;
+        }
+
+        bool mathAccess()
+        {
+            // "Math" already consumed
+            if (!expect(".") || peek().kind != Token::IDENT)
+                return false;
+            std::string name = peek().text;
+            ++_pos;
+
+            if (name == "PI") { numberConstant(osg::PI); return true; }
+            if (name == "E") { numberConstant(2.718281828459045); return true; }
+            if (name == "LN2") { numberConstant(0.6931471805599453); return true; }
+            if (name == "LN10") { numberConstant(2.302585092994046); return true; }
+            if (name == "SQRT2") { numberConstant(1.4142135623730951); return true; }
+
+            static const std::pair<const char*, MathFunction> functions[] = {
+                { "abs", MATH_ABS }, { "ceil", MATH_CEIL }, { "floor", MATH_FLOOR },
+                { "round", MATH_ROUND }, { "sqrt", MATH_SQRT }, { "log", MATH_LOG },
+                { "exp", MATH_EXP }, { "sin", MATH_SIN }, { "cos", MATH_COS },
+                { "tan", MATH_TAN }, { "asin", MATH_ASIN }, { "acos", MATH_ACOS },
+                { "atan", MATH_ATAN }, { "atan2", MATH_ATAN2 }, { "pow", MATH_POW },
+                { "min", MATH_MIN }, { "max", MATH_MAX }
+            };
+
+            for (auto& f : functions)
+            {
+                if (name == f.first)
+                {
+                    int count;
+                    if (!arguments(count))
+                        return false;
+                    emit(OP_MATH, 1 - count, f.second, count);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool primary()
+        {
+            const Token& t = peek();
+
+            if (t.kind == Token::NUMBER)
+            {
+                ++_pos;
+                numberConstant(t.number);
+                return true;
+            }
+
+            if (t.kind == Token::STRING)
+            {
+                ++_pos;
+                stringConstant(t.text);
+                return true;
+            }
+
+            if (t.kind == Token::PUNCT && t.text == "(")
+            {
+                ++_pos;
+                return expression() && expect(")");
+            }
+
+            if (t.kind != Token::IDENT)
+                return false;
+
+            ++_pos;
+            Value v;
+            if (t.text == "true") { v.setBool(true); constant(v); return true; }
+            if (t.text == "false") { v.setBool(false); constant(v); return true; }
+            if (t.text == "null") { v.type = Value::NUL; constant(v); return true; }
+            if (t.text == "undefined") { constant(v); return true; }
+            if (t.text == "NaN") { numberConstant(NaN); return true; }
+            if (t.text == "Infinity") { numberConstant(Inf); return true; }
+            if (t.text == "feature") return featureAccess();
+            if (t.text == "Math") return mathAccess();
+
+            return false;
+        }
+    };
+
+    //........................................................................
+
+    // Evaluation state for one run of a program.
+    struct Machine
+    {
+        const NativeScript::Program& program;
+        const Feature* feature;
+        Value stack[MAX_STACK];
+        int sp = 0;
+        bool unsupported = false;
+        std::string error;
+
+        Machine(const NativeScript::Program& p, const Feature* f) :
+            program(p), feature(f) { }
+
+        bool toBoolean(const Value& v) const
+        {
+            switch (v.type)
+            {
+            case Value::BOOLEAN: return v.b;
+            case Value::NUMBER: return !(v.n == 0.0 || std::isnan(v.n));
+            case Value::STRING: return !v.str().empty();
+            default: return false;
+            }
+        }
+
+        double toNumber(const Value& v)
+        {
+            switch (v.type)
+            {
+            case Value::NUL: return 0.0;
+            case Value::BOOLEAN: return v.b ? 1.0 : 0.0;
+            case Value::NUMBER: return v.n;
+            case Value::STRING:
+                if (!isASCII(v.str())) {
+                    unsupported = true;
+                    return NaN;
+                }
+                return stringToNumber(v.str());
+            default: return NaN;
+            }
+        }
+
+        std::string toString(const Value& v) const
+        {
+            switch (v.type)
+            {
+            case Value::NUL: return "null";
+            case Value::BOOLEAN: return v.b ? "true" : "false";
+            case Value::NUMBER: return numberToString(v.n);
+            case Value::STRING: return v.str();
+            default: return "undefined";
+            }
+        }
+
+        bool strictEquals(const Value& a, const Value& b) const
+        {
+            if (a.type != b.type)
+                return false;
+            switch (a.type)
+            {
+            case Value::BOOLEAN: return a.b == b.b;
+            case Value::NUMBER: return a.n == b.n;
+            case Value::STRING: return a.str() == b.str();
+            default: return true;
+            }
+        }
+
+        bool looseEquals(const Value& a, const Value& b)
+        {
+            if (a.type == b.type)
+                return strictEquals(a, b);
+
+            bool aNullish = a.type == Value::UNDEFINED || a.type == Value::NUL;
+            bool bNullish = b.type == Value::UNDEFINED || b.type == Value::NUL;
+            if (aNullish || bNullish)
+                return aNullish && bNullish;
+
+            // the remaining mixes of boolean, number and string all
+            // compare as numbers
+            return toNumber(a) == toNumber(b);
+        }
+
+        // Returns false (and sets unsupported) if the comparison needs UTF-16
+        // ordering. "result" is -1, 0, 1, or 2 for "undefined" (NaN operand).
+        int compare(const Value& a, const Value& b)
+        {
+            if (a.type == Value::STRING && b.type == Value::STRING)
+            {
+                if (!isASCII(a.str()) || !isASCII(b.str()))
+                {
+                    unsupported = true;
+                    return 2;
+                }
+                int c = a.str().compare(b.str());
+                return c < 0 ? -1 : c > 0 ? 1 : 0;
+            }
+
+            double x = toNumber(a), y = toNumber(b);
+            if (std::isnan(x) || std::isnan(y))
+                return 2;
+            return x < y ? -1 : x > y ? 1 : 0;
+        }
+
+        void loadProperty(const std::string& key, Value& out) const
+        {
+            // JavaScript property names are case-sensitive, so match exactly
+            // rather than with the table's case-insensitive find().
+            for (auto& entry : feature->getAttrs())
+            {
+                if (entry.first == key)
+                {
+                    const AttributeValue& a = entry.second;
+                    switch (a.type)
+                    {
+                    case ATTRTYPE_DOUBLE: out.setNumber(a.getDouble()); break;
+                    case ATTRTYPE_INT: out.setNumber((double)a.getInt()); break;
+                    case ATTRTYPE_BOOL: out.setBool(a.getBool()); break;
+                    case ATTRTYPE_STRING:
+                        if (a.value.set)
+                        {
+                            out.setString(a.value.stringValue);
+                            break;
+                        }
+                        // fall through
+                    default:
+                        out.setString(a.getString());
+                    }
+                    return;
+                }
+            }
+            out.setUndefined();
+        }
+
+        bool typeError(const std::string& message)
+        {
+            error = "TypeError: " + message;
+            return false;
+        }
+
+        bool callMath(MathFunction f, Value* args, int count, Value& out)
+        {
+            double x = count > 0 ? toNumber(args[0]) : NaN;
+            double y = count > 1 ? toNumber(args[1]) : NaN;
+            double r;
+
+            switch (f)
+            {
+            case MATH_ABS: r = std::fabs(x); break;
+            case MATH_CEIL: r = std::ceil(x); break;
+            case MATH_FLOOR: r = std::floor(x); break;
+            case MATH_ROUND:
+                // ties round toward +Infinity
+                r = std::floor(x);
+                if (x - r >= 0.5) r += 1.0;
+                break;
+            case MATH_SQRT: r = std::sqrt(x); break;
+            case MATH_LOG: r = std::log(x); break;
+            case MATH_EXP: r = std::exp(x); break;
+            case MATH_SIN: r = std::sin(x); break;
+            case MATH_COS: r = std::cos(x); break;
+            case MATH_TAN: r = std::tan(x); break;
+            case MATH_ASIN: r = std::asin(x); break;
+            case MATH_ACOS: r = std::acos(x); break;
+            case MATH_ATAN: r = std::atan(x); break;
+            case MATH_ATAN2: r = std::atan2(x, y); break;
+            case MATH_POW:
+                // C's pow returns 1 in these cases; JavaScript returns NaN
+                if (std::isnan(y) || (std::fabs(x) == 1.0 && std::isinf(y)))
+                    r = NaN;
+                else
+                    r = std::pow(x, y);
+                break;
+            case MATH_MIN:
+            case MATH_MAX:
+            {
+                bool isMin = (f == MATH_MIN);
+                r = isMin ? Inf : -Inf;
+                for (int i = 0; i < count; ++i)
+                {
+                    double v = toNumber(args[i]);
+                    if (std::isnan(v) || std::isnan(r))
+                        r = NaN;
+                    else if (isMin ? (v < r || (v == r && std::signbit(v))) : (v > r || (v == r && !std::signbit(v))))
+                        r = v;
+                }
+                break;
+            }
+            default:
+                r = NaN;
+            }
+
+            out.setNumber(r);
+            return true;
+        }
+
+        bool callMethod(Method m, Value& self, Value* args, int count, Value& out)
+        {
+            static const char* names[] = {
+                "toUpperCase", "toLowerCase", "trim", "substring", "indexOf", "charAt", "toString"
+            };
+
+            if (self.type == Value::UNDEFINED || self.type == Value::NUL)
+                return typeError(std::string("cannot read property '") + names[m] + "' of " + toString(self));
+
+            if (m == METHOD_TO_STRING)
+            {
+                out.setString(toString(self));
+                return true;
+            }
+
+            if (self.type != Value::STRING)
+                return typeError(std::string(names[m]) + " not callable");
+
+            const std::string& s = self.str();
+            if (!isASCII(s))
+            {
+                unsupported = true;
+                return true;
+            }
+
+            double len = (double)s.size();
+
+            switch (m)
+            {
+            case METHOD_TO_UPPER_CASE:
+            case METHOD_TO_LOWER_CASE:
+            {
+                std::string r(s);
+                for (auto& c : r)
+                {
+                    if (m == METHOD_TO_UPPER_CASE && c >= 'a' && c <= 'z') c -= 32;
+                    else if (m == METHOD_TO_LOWER_CASE && c >= 'A' && c <= 'Z') c += 32;
+                }
+                out.setString(std::move(r));
+                break;
+            }
+
+            case METHOD_TRIM:
+            {
+                std::size_t first = 0, last = s.size();
+                while (first < last && isWhiteSpace(s[first])) ++first;
+                while (last > first && isWhiteSpace(s[last - 1])) --last;
+                out.setString(s.substr(first, last - first));
+                break;
+            }
+
+            case METHOD_SUBSTRING:
+            {
+                double start = count > 0 ? toInteger(toNumber(args[0])) : 0.0;
+                double end = (count > 1 && args[1].type != Value::UNDEFINED) ? toInteger(toNumber(args[1])) : len;
+                start = clamp(start, 0.0, len);
+                end = clamp(end, 0.0, len);
+                if (start > end) std::swap(start, end);
+                out.setString(s.substr((std::size_t)start, (std::size_t)(end - start)));
+                break;
+            }
+
+            case METHOD_INDEX_OF:
+            {
+                std::string search = count > 0 ? toString(args[0]) : "undefined";
+                double pos = count > 1 ? clamp(toInteger(toNumber(args[1])), 0.0, len) : 0.0;
+                std::size_t i = s.find(search, (std::size_t)pos);
+                out.setNumber(i == std::string::npos ? -1.0 : (double)i);
+                break;
+            }
+
+            case METHOD_CHAR_AT:
+            {
+                double pos = count > 0 ? toInteger(toNumber(args[0])) : 0.0;
+                if (pos < 0.0 || pos >= len)
+                    out.setString(std::string());
+                else
+                    out.setString(std::string(1, s[(std::size_t)pos]));
+                break;
+            }
+
+            default:
+                break;
+            }
+            return true;
+        }
+
+        bool run()
+        {
+            const std::vector<Instruction>& code = program.code;
+            std::size_t pc = 0;
+
+            while (pc < code.size() && !unsupported)
+            {
+                const Instruction& i = code[pc++];
+                switch (i.op)
+                {
+                case OP_CONST:
+                {
+                    Value& v = stack[sp++];
+                    const Value& c = program.constants[i.a];
+                    v.type = c.type;
+                    v.b = c.b;
+                    v.n = c.n;
+                    v.ref = c.ref;
+                    break;
+                }
+
+                case OP_PROP:
+                    loadProperty(program.keys[i.a], stack[sp++]);
+                    break;
+
+                case OP_ID:
+                    stack[sp++].setNumber((double)feature->getFID());
+                    break;
+
+                case OP_GEOMETRY_TYPE:
+                {
+                    Value& v = stack[sp++];
+                    if (feature->getGeometry())
+                        v.setString(Geometry::toString(feature->getGeometry()->getComponentType()));
+                    else
+                        v.setUndefined();
+                    break;
+                }
+
+                case OP_NOT:
+                    stack[sp - 1].setBool(!toBoolean(stack[sp - 1]));
+                    break;
+
+                case OP_NEG:
+                    stack[sp - 1].setNumber(-toNumber(stack[sp - 1]));
+                    break;
+
+                case OP_POS:
+                    stack[sp - 1].setNumber(toNumber(stack[sp - 1]));
+                    break;
+
+                case OP_ADD:
+                {
+                    Value& a = stack[sp - 2];
+                    Value& b = stack[--sp];
+                    if (a.type == Value::STRING || b.type == Value::STRING)
+                        a.setString(toString(a) + toString(b));
+                    else
+                        a.setNumber(toNumber(a) + toNumber(b));
+                    break;
+                }
+
+                case OP_SUB:
+                case OP_MUL:
+                case OP_DIV:
+                case OP_MOD:
+                {
+                    Value& a = stack[sp - 2];
+                    double x = toNumber(a);
+                    double y = toNumber(stack[--sp]);
+                    a.setNumber(
+                        i.op == OP_SUB ? x - y :
+                        i.op == OP_MUL ? x * y :
+                        i.op == OP_DIV ? x / y :
+                        std::fmod(x, y));
+                    break;
+                }
+
+                case OP_LT:
+                case OP_LE:
+                case OP_GT:
+                case OP_GE:
+                {
+                    Value& a = stack[sp - 2];
+                    int c = compare(a, stack[--sp]);
+                    a.setBool(c != 2 && (
+                        i.op == OP_LT ? c < 0 :
+                        i.op == OP_LE ? c <= 0 :
+                        i.op == OP_GT ? c > 0 :
+                        c >= 0));
+                    break;
+                }
+
+                case OP_EQ:
+                case OP_NE:
+                {
+                    Value& a = stack[sp - 2];
+                    bool eq = looseEquals(a, stack[--sp]);
+                    a.setBool(i.op == OP_EQ ? eq : !eq);
+                    break;
+                }
+
+                case OP_STRICT_EQ:
+                case OP_STRICT_NE:
+                {
+                    Value& a = stack[sp - 2];
+                    bool eq = strictEquals(a, stack[--sp]);
+                    a.setBool(i.op == OP_STRICT_EQ ? eq : !eq);
+                    break;
+                }
+
+                case OP_JUMP:
+                    pc = i.a;
+                    break;
+
+                case OP_JUMP_IF_FALSE:
+                    if (!toBoolean(stack[--sp]))
+                        pc = i.a;
+                    break;
+
+                case OP_AND:
+                    if (!toBoolean(stack[sp - 1]))
+                        pc = i.a;
+                    else
+                        --sp;
+                    break;
+
+                case OP_OR:
+                    if (toBoolean(stack[sp - 1]))
+                        pc = i.a;
+                    else
+                        --sp;
+                    break;
+
+                case OP_MATH:
+                {
+                    sp -= i.b;
+                    if (!callMath((MathFunction)i.a, &stack[sp], i.b, stack[sp]))
+                        return false;
+                    ++sp;
+                    break;
+                }
+
+                case OP_METHOD:
+                {
+                    sp -= i.b;
+                    Value result;
+                    if (!callMethod((Method)i.a, stack[sp - 1], &stack[sp], i.b, result))
+                        return false;
+                    std::swap(stack[sp - 1], result);
+                    break;
+                }
+
+                case OP_LENGTH:
+                {
+                    Value& v = stack[sp - 1];
+                    if (v.type == Value::UNDEFINED || v.type == Value::NUL)
+                        return typeError("cannot read property 'length' of " + toString(v));
+                    if (v.type != Value::STRING)
+                        v.setUndefined();
+                    else if (!isASCII(v.str()))
+                        unsupported = true;
+                    else
+                        v.setNumber((double)v.str().size());
+                    break;
+                }
+                }
+            }
+
+            return true;
+        }
+    };
+}
+
+//........................................................................
+
+NativeScript::NativeScript() :
+    _program(new Program()),
+    _warned(false)
+{
+    //nop
+}
+
+NativeScript::~NativeScript()
+{
+    //nop
+}
+
+NativeScript*
+NativeScript::compile(const std::string& code)
+{
+    std::vector<Token> tokens;
+    if (!tokenize(code, tokens))
+        return nullptr;
+
+    osg::ref_ptr<NativeScript> script = new NativeScript();
+    Program& program = *script->_program;
+
+    Compiler compiler(tokens, program);
+    if (!compiler.compile())
+        return nullptr;
+
+    // point string constants at their (now stable) storage
+    for (auto& c : program.constants)
+    {
+        if (c.type == Value::STRING)
+            c.ref = &program.strings[(std::size_t)c.n];
+    }
+
+    script->_code = code;
+    return script.release();
+}
+
+NativeScript::Status
+NativeScript::run(const Feature* feature, ScriptResult& result) const
+{
+    if (!feature)
+    {
+        result = ScriptResult(EMPTY_STRING, false, "Feature is null");
+        return STATUS_ERROR;
+    }
+
+    Machine m(*_program, feature);
+
+    if (!m.run())
+    {
+        // the same error usually repeats for every feature
+        if (!_warned.exchange(true))
+        {
+            OE_WARN << LC << "Runtime error: " << m.error << " (further errors from this script are logged at debug level)" << std::endl;
+        }
+        else
+        {
+            OE_DEBUG << LC << "Runtime error: " << m.error << std::endl;
+        }
+        result = ScriptResult(EMPTY_STRING, false, m.error);
+        return STATUS_ERROR;
+    }
+
+    if (m.unsupported)
+        return STATUS_UNSUPPORTED;
+
+    result = ScriptResult(m.toString(m.stack[0]), true);
+    return STATUS_OK;
+}
+
+//........................................................................
+
+NativeScriptEngine::NativeScriptEngine(ScriptEngine* fallback) :
+    _fallback(fallback)
+{
+    if (_fallback.valid())
+    {
+        setProfile(_fallback->getProfile());
+    }
+}
+
+bool
+NativeScriptEngine::supported(std::string lang)
+{
+    if (_fallback.valid())
+        return _fallback->supported(lang);
+
+    return osgEarth::Util::toLower(lang) == "javascript";
+}
+
+const NativeScript*
+NativeScriptEngine::getScript(const std::string& code)
+{
+    Cache& cache = _caches.get();
+
+    if (code == cache._lastCode)
+        return cache._lastScript;
+
+    auto i = cache._scripts.find(code);
+    if (i == cache._scripts.end())
+    {
+        osg::ref_ptr<NativeScript> script = NativeScript::compile(code);
+        i = cache._scripts.emplace(code, script).first;
+    }
+
+    cache._lastCode = code;
+    cache._lastScript = i->second.get();
+    return cache._lastScript;
+}
+
+ScriptResult
+NativeScriptEngine::run(
+    const std::string& code,
+    Feature const* feature,
+    FilterContext const* context)
+{
+    if (code.empty())
+        return ScriptResult(EMPTY_STRING, false, "Script is empty");
+
+    if (!feature)
+        return ScriptResult(EMPTY_STRING, false, "Feature is null");
+
+    const NativeScript* script = getScript(code);
+    if (script)
+    {
+        ScriptResult result;
+        if (script->run(feature, result) != NativeScript::STATUS_UNSUPPORTED)
+            return result;
+    }
+
+    if (_fallback.valid())
+        return _fallback->run(code, feature, context);
+
+    return ScriptResult(EMPTY_STRING, false, "Script is not supported by the native engine");
+}
+
+bool
+NativeScriptEngine::run(
+    const std::string& code,
+    const FeatureList& features,
+    std::vector<ScriptResult>& results,
+    FilterContext const* context)
+{
+    const NativeScript* script = code.empty() ? nullptr : getScript(code);
+    if (!script)
+    {
+        if (_fallback.valid())
+            return _fallback->run(code, features, results, context);
+
+        return ScriptEngine::run(code, features, results, context);
+    }
+
+    for (auto& feature : features)
+    {
+        ScriptResult result;
+        if (script->run(feature.get(), result) == NativeScript::STATUS_UNSUPPORTED)
+        {
+            if (_fallback.valid())
+                result = _fallback->run(code, feature.get(), context);
+            else
+                result = ScriptResult(EMPTY_STRING, false, "Script is not supported by the native engine");
+        }
+        results.push_back(result);
+    }
+
+    return true;
+}
@@ -151,7 +151,7 @@ PagedNode2::touch()
     // (and should not be removed from the scene graph)
     if (_pagingManager)
     {
-        _token = _pagingManager->use(this, _token);
+        _pagingManager->use(this, _usage);
     }
 }
 
@@ -299,7 +299,6 @@ void PagedNode2::unload()
     _merged.reset();
 
     _loadGate.exchange(false);
-    _token = nullptr;
 
     // prevents a node in the PagingManager's merge queue from being merged with old data.
     _revision++;
@@ -358,17 +357,23 @@ PagingManager::traverse(osg::NodeVisitor& nv)
 
     if (nv.getVisitorType() == nv.CULL_VISITOR)
     {
-        // After culling is complete, update all of the ranges for all of the node
+        // After culling is complete, update all of the ranges for all of the node.
+        // Touching a node (use()) takes no lock, but this pass still does:
+        // - it walks the tracker's entry list, which update() rearranges, and
+        //   update() is public and may run on another thread;
+        // - with a cull thread per camera, several passes can write the same
+        //   node's _lastRange at once.
+        // It runs once per cull rather than once per node, so the lock is cheap.
         scoped_lock_if lock(_trackerMutex, _threadsafe);
 
-        for (auto& entry : _tracker._list)
-        {
-            if (entry._data.valid())
-            {               
-                float range = std::max(0.0f, nv.getDistanceToViewPoint(entry._data->getBound().center(), true) - entry._data->getBound().radius());
-                entry._data->_lastRange = std::min(entry._data->_lastRange, range);
-            }
-        }
+        _tracker.forEach([&](osg::ref_ptr<PagedNode2>& node)
+            {
+                if (node.valid())
+                {
+                    float range = std::max(0.0f, nv.getDistanceToViewPoint(node->getBound().center(), true) - node->getBound().radius());
+                    node->_lastRange = std::min(node->_lastRange, range);
+                }
+            });
     }
 }
 
@@ -410,13 +415,13 @@ PagingManager::update()
             });
 
         // Reset the lastRange on the nodes for the next frame.
-        for (auto& entry : _tracker._list)
-        {
-            if (entry._data.valid())
+        _tracker.forEach([](osg::ref_ptr<PagedNode2>& node)
             {
-                entry._data->_lastRange = FLT_MAX;
-            }
-        }
+                if (node.valid())
+                {
+                    node->_lastRange = FLT_MAX;
+                }
+            });
     }
 
     // Handle merges
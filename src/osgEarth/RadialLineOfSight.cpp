@@ -22,9 +22,11 @@
 #include <osgEarth/RadialLineOfSight>
 #include <osgEarth/TerrainEngineNode>
 #include <osgEarth/GLUtils>
+#include <osgEarth/Viewshed>
 
 using namespace osgEarth;
 using namespace osgEarth::Contrib;
+using namespace osgEarth::Util;
 
 namespace
 {
@@ -86,7 +88,8 @@ _outlineColor( 1.0f, 1.0f, 1.0f, 1.0f),
 _displayMode( LineOfSight::MODE_SPLIT ),
 //_altitudeMode( ALTMODE_ABSOLUTE ),
 _fill(false),
-_terrainOnly( false )
+_terrainOnly( false ),
+_useHeightfield( false )
 {
     //compute(getNode());
     _terrainChangedCallback = new RadialLineOfSightNodeTerrainChangedCallback( this );
@@ -211,6 +214,21 @@ void RadialLineOfSightNode::setTerrainOnly( bool terrainOnly )
     }
 }
 
+bool
+RadialLineOfSightNode::getUseHeightfield() const
+{
+    return _useHeightfield;
+}
+
+void RadialLineOfSightNode::setUseHeightfield( bool useHeightfield )
+{
+    if (_useHeightfield != useHeightfield)
+    {
+        _useHeightfield = useHeightfield;
+        compute(getNode());
+    }
+}
+
 osg::Node*
 RadialLineOfSightNode::getNode()
 {
@@ -223,7 +241,9 @@ RadialLineOfSightNode::getNode()
 void
 RadialLineOfSightNode::terrainChanged( const osgEarth::TileKey& tileKey, osg::Node* terrain )
 {
-    compute( getNode() );    
+    // paging does not change the elevation data
+    if (!_useHeightfield)
+        compute( getNode() );    
 }
 
 void
@@ -239,15 +259,71 @@ RadialLineOfSightNode::compute(osg::Node* node )
     }
 }
 
+void
+RadialLineOfSightNode::computeRays(osg::Node* node, const osg::Vec3d& up, const osg::Vec3d& side, std::vector<Viewshed::Ray>& rays)
+{
+    //Get the number of spokes
+    double delta = osg::PI * 2.0 / (double)_numSpokes;
+
+    rays.resize(_numSpokes);
+    for (unsigned int i = 0; i < (unsigned int)_numSpokes; i++)
+    {
+        double angle = delta * (double)i;
+        osg::Quat quat(angle, up );
+        osg::Vec3d spoke = quat * (side * _radius);
+        rays[i].start = _centerWorld;
+        rays[i].end = _centerWorld + spoke;
+    }
+
+    if (_useHeightfield)
+    {
+        Viewshed viewshed(getMapNode()->getMap());
+        viewshed.intersect(rays);
+        return;
+    }
+
+    osg::ref_ptr<osgUtil::IntersectorGroup> ivGroup = new osgUtil::IntersectorGroup();
+
+    for (unsigned int i = 0; i < (unsigned int)_numSpokes; i++)
+    {
+        osg::ref_ptr<osgUtil::LineSegmentIntersector> dplsi = new osgUtil::LineSegmentIntersector( rays[i].start, rays[i].end );
+        ivGroup->addIntersector( dplsi.get() );
+    }
+
+    osgUtil::IntersectionVisitor iv;
+    iv.setIntersector( ivGroup.get() );
+
+    node->accept( iv );
+
+    for (unsigned int i = 0; i < (unsigned int)_numSpokes; i++)
+    {
+        osgUtil::LineSegmentIntersector* los = static_cast<osgUtil::LineSegmentIntersector*>(ivGroup->getIntersectors()[i].get());
+        osgUtil::LineSegmentIntersector::Intersections& hits = los->getIntersections();
+
+        rays[i].hasLOS = hits.empty();
+        if (!rays[i].hasLOS)
+        {
+            rays[i].hit = hits.begin()->getWorldIntersectPoint();
+        }
+    }
+}
+
 void
 RadialLineOfSightNode::compute_line(osg::Node* node)
 {    
     if ( !getMapNode() )
         return;
 
-    GeoPoint centerMap;
-    _center.transform( getMapNode()->getMapSRS(), centerMap );
-    centerMap.toWorld( _centerWorld, getMapNode()->getTerrain() );
+    if (_useHeightfield)
+    {
+        Viewshed(getMapNode()->getMap()).toWorld( _center, _centerWorld );
+    }
+    else
+    {
+        GeoPoint centerMap;
+        _center.transform( getMapNode()->getMapSRS(), centerMap );
+        centerMap.toWorld( _centerWorld, getMapNode()->getTerrain() );
+    }
 
     bool isProjected = getMapNode()->getMapSRS()->isProjected();
     osg::Vec3d up = isProjected ? osg::Vec3d(0,0,1) : osg::Vec3d(_centerWorld);
@@ -257,9 +333,6 @@ RadialLineOfSightNode::compute_line(osg::Node* node)
     osg::Vec3d side = isProjected ? osg::Vec3d(1,0,0) : up ^ osg::Vec3d(0,0,1);
     side.normalize();
 
-    //Get the number of spokes
-    double delta = osg::PI * 2.0 / (double)_numSpokes;
-    
     osg::Geometry* geometry = new osg::Geometry;
     geometry->setUseVertexBufferObjects(true);
 
@@ -275,40 +348,16 @@ RadialLineOfSightNode::compute_line(osg::Node* node)
     osg::Vec3d previousEnd;
     osg::Vec3d firstEnd;
 
-    osg::ref_ptr<osgUtil::IntersectorGroup> ivGroup = new osgUtil::IntersectorGroup();
+    std::vector<Viewshed::Ray> rays;
+    computeRays(node, up, side, rays);
 
     for (unsigned int i = 0; i < (unsigned int)_numSpokes; i++)
     {
-        double angle = delta * (double)i;
-        osg::Quat quat(angle, up );
-        osg::Vec3d spoke = quat * (side * _radius);
-        osg::Vec3d end = _centerWorld + spoke;
-        osg::ref_ptr<osgUtil::LineSegmentIntersector> dplsi = new osgUtil::LineSegmentIntersector( _centerWorld, end );
-        ivGroup->addIntersector( dplsi.get() );
-    }
+        osg::Vec3d start = rays[i].start;
+        osg::Vec3d end = rays[i].end;
 
-    osgUtil::IntersectionVisitor iv;
-    iv.setIntersector( ivGroup.get() );
-
-    node->accept( iv );
-
-    for (unsigned int i = 0; i < (unsigned int)_numSpokes; i++)
-    {
-        osgUtil::LineSegmentIntersector* los = dynamic_cast<osgUtil::LineSegmentIntersector*>(ivGroup->getIntersectors()[i].get());
-        if ( !los )
-            continue;
-
-        osgUtil::LineSegmentIntersector::Intersections& hits = los->getIntersections();
-
-        osg::Vec3d start = los->getStart();
-        osg::Vec3d end = los->getEnd();
-
-        osg::Vec3d hit;
-        bool hasLOS = hits.empty();
-        if (!hasLOS)
-        {
-            hit = hits.begin()->getWorldIntersectPoint();
-        }
+        bool hasLOS = rays[i].hasLOS;
+        osg::Vec3d hit = rays[i].hit;
 
         if (hasLOS)
         {
@@ -390,9 +439,16 @@ RadialLineOfSightNode::compute_fill(osg::Node* node)
     if ( !getMapNode() )
         return;
 
-    GeoPoint centerMap;
-    _center.transform( getMapNode()->getMapSRS(), centerMap );
-    centerMap.toWorld( _centerWorld, getMapNode()->getTerrain() );
+    if (_useHeightfield)
+    {
+        Viewshed(getMapNode()->getMap()).toWorld( _center, _centerWorld );
+    }
+    else
+    {
+        GeoPoint centerMap;
+        _center.transform( getMapNode()->getMapSRS(), centerMap );
+        centerMap.toWorld( _centerWorld, getMapNode()->getTerrain() );
+    }
 
     bool isProjected = getMapNode()->getMapSRS()->isProjected();
 
@@ -403,9 +459,6 @@ RadialLineOfSightNode::compute_fill(osg::Node* node)
     osg::Vec3d side = isProjected ? osg::Vec3d(1,0,0) : up ^ osg::Vec3d(0,0,1);
     side.normalize();
 
-    //Get the number of spokes
-    double delta = osg::PI * 2.0 / (double)_numSpokes;
-    
     osg::Geometry* geometry = new osg::Geometry;
     geometry->setUseVertexBufferObjects(true);
 
@@ -418,46 +471,23 @@ RadialLineOfSightNode::compute_fill(osg::Node* node)
 
     geometry->setColorArray( colors );
 
-    osg::ref_ptr<osgUtil::IntersectorGroup> ivGroup = new osgUtil::IntersectorGroup();
-
-    for (unsigned int i = 0; i < (unsigned int)_numSpokes; i++)
-    {
-        double angle = delta * (double)i;
-        osg::Quat quat(angle, up );
-        osg::Vec3d spoke = quat * (side * _radius);
-        osg::Vec3d end = _centerWorld + spoke;        
-        osg::ref_ptr<osgUtil::LineSegmentIntersector> dplsi = new osgUtil::LineSegmentIntersector( _centerWorld, end );
-        if (dplsi)
-            ivGroup->addIntersector( dplsi.get() );
-    }
-
-    osgUtil::IntersectionVisitor iv;
-    iv.setIntersector( ivGroup.get() );
-
-    node->accept( iv );
+    std::vector<Viewshed::Ray> rays;
+    computeRays(node, up, side, rays);
 
     for (unsigned int i = 0; i < (unsigned int)_numSpokes; i++)
     {
         //Get the current hit
-        osgUtil::LineSegmentIntersector* los = dynamic_cast<osgUtil::LineSegmentIntersector*>(ivGroup->getIntersectors()[i].get());
-        if ( !los )
-            continue;
-
-        osgUtil::LineSegmentIntersector::Intersections& hits = los->getIntersections();
-
-        osg::Vec3d currEnd = los->getEnd();
-        bool currHasLOS = hits.empty();
-        osg::Vec3d currHit = currHasLOS ? osg::Vec3d() : hits.begin()->getWorldIntersectPoint();
+        osg::Vec3d currEnd = rays[i].end;
+        bool currHasLOS = rays[i].hasLOS;
+        osg::Vec3d currHit = currHasLOS ? osg::Vec3d() : rays[i].hit;
 
         //Get the next hit
         unsigned int nextIndex = i + 1;
         if (nextIndex == _numSpokes) nextIndex = 0;
-        osgUtil::LineSegmentIntersector* losNext = static_cast<osgUtil::LineSegmentIntersector*>(ivGroup->getIntersectors()[nextIndex].get());
-        osgUtil::LineSegmentIntersector::Intersections& hitsNext = losNext->getIntersections();
 
-        osg::Vec3d nextEnd = losNext->getEnd();
-        bool nextHasLOS = hitsNext.empty();
-        osg::Vec3d nextHit = nextHasLOS ? osg::Vec3d() : hitsNext.begin()->getWorldIntersectPoint();
+        osg::Vec3d nextEnd = rays[nextIndex].end;
+        bool nextHasLOS = rays[nextIndex].hasLOS;
+        osg::Vec3d nextHit = nextHasLOS ? osg::Vec3d() : rays[nextIndex].hit;
         
         if (currHasLOS && nextHasLOS)
         {
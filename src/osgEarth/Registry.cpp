@@ -270,6 +270,9 @@ Registry::~Registry()
     // Release any GL objects
     release();
 
+    // Stop the network thread before static destruction
+    HTTPClient::globalShutdown();
+
     OE_INFO << "Goodbye." << std::endl;
 }
 
@@ -22,6 +22,8 @@
 #include "FeatureSource"
 #include "FeatureRasterizer"
 #include "Session"
+#include "Threading"
+#include <limits>
 
 using namespace osgEarth;
 using namespace osgEarth::Util;
@@ -225,7 +227,7 @@ SDFGenerator::createNearestNeighborField(
     //}
     //else
     {
-        compute_nnf_on_cpu(nnimage);
+        computeNearestNeighborField(nnimage);
     }
 
     return true;
@@ -368,8 +370,8 @@ inline void writeRGFloatPixel(float* grid, unsigned int w, unsigned int h, osg::
     *data++ = pixel.y();
 }
 
-void
-SDFGenerator::compute_nnf_on_cpu(osg::Image* buf) const
+static void
+jumpFlood(osg::Image* buf)
 {
     OE_PROFILING_ZONE;
 
@@ -443,135 +445,242 @@ SDFGenerator::compute_nnf_on_cpu(osg::Image* buf) const
     }
 }
 
-#define INF 1E20
+namespace
+{
+    // Images smaller than this many pixels run on the calling thread only
+    const std::uint64_t MIN_PIXELS_TO_SPLIT = 256 * 256;
+
+    //! https://www.theoryofcomputing.org/articles/v008a019/v008a019.pdf
+    //! Lower envelope of the parabolas rooted at the columns that have a seed.
+    //! @param f Squared distance to the nearest seed in each column, or -1 if none
+    //! @param d Output squared distance, or -1 if the row has no seed at all
+    //! @param src Output column holding the nearest seed, or -1
+    //! @param v Temporary work array of size at least n
+    //! @param z Temporary work array of size at least n + 1
+    //! @param n The size of f
+    void edt1d(const int* f, int* d, int* src, int* v, double* z, unsigned n)
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+        int k = -1;
+        for (int q = 0; q < (int)n; ++q)
+        {
+            if (f[q] < 0)
+                continue;
 
-    
-//! https://www.theoryofcomputing.org/articles/v008a019/v008a019.pdf
-//! @param f Array of values to compute the distance transform function
-//! @param d Temporary work array of size at least n
-//! @param v Temporary work array of size at least n
-//! @param z Temporary work array of size at least n + 1
-//! @param n The size of f
-static void edt1d(const float* f, float* d, int* v, float* z, unsigned int n) {
-    int k = 0;
-    v[0] = 0;
-    z[0] = -INF;
-    z[1] = INF;
-    for (int q = 1; q <= (int)(n - 1); ++q) {
-        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
-        while (s <= z[k]) {
-            k--;
-            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            if (k < 0)
+            {
+                k = 0;
+                v[0] = q;
+                z[0] = -inf;
+                continue;
+            }
+
+            // z[0] is -inf, so k never drops below zero
+            double s;
+            for (;;)
+            {
+                int r = v[k];
+                s = (double)((f[q] + q * q) - (f[r] + r * r)) / (double)(2 * (q - r));
+                if (s > z[k])
+                    break;
+                --k;
+            }
+            ++k;
+            v[k] = q;
+            z[k] = s;
+        }
+
+        if (k < 0)
+        {
+            std::fill(d, d + n, -1);
+            std::fill(src, src + n, -1);
+            return;
+        }
+
+        z[k + 1] = inf;
+        k = 0;
+        for (int q = 0; q < (int)n; ++q)
+        {
+            while (z[k + 1] < q)
+                ++k;
+            int r = v[k];
+            d[q] = (q - r) * (q - r) + f[r];
+            src[q] = r;
         }
-        k++;
-        v[k] = q;
-        z[k] = s;
-        z[k + 1] = INF;
     }
 
-    k = 0;
-    for (int q = 0; q <= (int)(n - 1); ++q) {
-        while (z[k + 1] < q)
-            k++;
-        int r = v[k];
-        d[q] = (q - r) * (q - r) + f[r];
+    //! Exact Euclidean distance transform of a seed mask.
+    //! https://www.theoryofcomputing.org/articles/v008a019/v008a019.pdf
+    //!
+    //! The column pass finds the nearest seed in each column with a forward
+    //! and a backward scan; it works on strips of columns a whole row at a
+    //! time so the inner loop is branch-free and vectorizes. The row pass
+    //! runs edt1d on each row. Both passes are split across the job pool.
+    //!
+    //! For each row y, calls emit(y, d, src, nearestRow): d[x] is the squared
+    //! distance to the nearest seed (or -1 if there are no seeds at all), and
+    //! the seed is at column src[x], row nearestRow[src[x] + y * width].
+    template<typename EMIT>
+    void edt2d(const std::uint8_t* seeds, unsigned width, unsigned height, const EMIT& emit)
+    {
+        std::vector<int> nearestRow(width * height);
+        const int far = 1 << 28;
+
+        // both passes split across a job pool once the image is big enough
+        jobs::jobpool* pool = (std::uint64_t)width * height >= MIN_PIXELS_TO_SPLIT ?
+            jobs::get_pool("oe.sdf") : nullptr;
+
+        // process columns
+        const unsigned stripWidth = 64;
+        auto columns = [&](unsigned begin, unsigned end)
+        {
+            for (unsigned x0 = begin * stripWidth; x0 < std::min(end * stripWidth, width); x0 += stripWidth)
+            {
+                const unsigned n = std::min(stripWidth, width - x0);
+
+                // forward: nearest seed at or above
+                int* row = &nearestRow[x0];
+                const std::uint8_t* seed = &seeds[x0];
+                for (unsigned i = 0; i < n; ++i)
+                    row[i] = seed[i] ? 0 : -far;
+
+                for (unsigned y = 1; y < height; ++y)
+                {
+                    const int* prev = row;
+                    row += width;
+                    seed += width;
+                    for (unsigned i = 0; i < n; ++i)
+                        row[i] = seed[i] ? (int)y : prev[i];
+                }
+
+                // backward: nearest seed at or below, then keep the closer one
+                int below[stripWidth];
+                for (unsigned i = 0; i < n; ++i)
+                    below[i] = far;
+
+                for (int y = (int)height - 1; y >= 0; --y)
+                {
+                    row = &nearestRow[x0 + y * width];
+                    seed = &seeds[x0 + y * width];
+                    for (unsigned i = 0; i < n; ++i)
+                    {
+                        int b = seed[i] ? y : below[i];
+                        below[i] = b;
+                        row[i] = (y - row[i] <= b - y) ? row[i] : b;
+                    }
+                }
+            }
+        };
+        jobs::parallel_for(pool, (width + stripWidth - 1) / stripWidth, 1, columns);
+
+        // process rows
+        auto rows = [&](unsigned begin, unsigned end)
+        {
+            std::vector<int> f(width), d(width), src(width), v(width);
+            std::vector<double> z(width + 1);
+
+            for (unsigned y = begin; y < end; ++y)
+            {
+                const int* row = &nearestRow[y * width];
+                for (unsigned x = 0; x < width; ++x)
+                {
+                    int dy = (int)y - row[x];
+                    f[x] = (row[x] >= 0 && row[x] < (int)height) ? dy * dy : -1;
+                }
+
+                edt1d(f.data(), d.data(), src.data(), v.data(), z.data(), width);
+
+                emit(y, d.data(), src.data(), nearestRow.data());
+            }
+        };
+        jobs::parallel_for(pool, height, 16, rows);
     }
 }
 
-//! https://www.theoryofcomputing.org/articles/v008a019/v008a019.pdf
-//! Compute the 2d distance transform of a grid of floats
-//! @param grid A 2d grid of floats
-//! @param width The width of the grid
-//! @param height The height of the grid
-void edt2d(float* grid, unsigned int width, unsigned int height)
+void
+SDFGenerator::computeNearestNeighborField(osg::Image* buf, Algorithm algorithm)
 {
-    unsigned int maxLength = std::max(width, height);
-    float* f = new float[maxLength];
-    float* d = new float[maxLength];
-    int* v = new int[maxLength];
-    float* z = new float[maxLength + 1u];
-
-    // process columns
-    for (unsigned x = 0; x < width; ++x) {
-        for (unsigned y = 0; y < height; ++y) {
-            f[y] = grid[width * y + x];
-        }
-        // Do the distance transform.
-        edt1d(f, d, v, z, height);
-        // Copy d back into the grid
-        for (unsigned y = 0; y < height; ++y) {
-            grid[width * y + x] = d[y];
-        }        
+    OE_PROFILING_ZONE;
+
+    OE_SOFT_ASSERT_AND_RETURN(buf != nullptr, void());
+    OE_SOFT_ASSERT_AND_RETURN(buf->getPixelFormat() == GL_RG && buf->getDataType() == GL_FLOAT, void());
+
+    if (algorithm == ALGORITHM_JFA)
+    {
+        jumpFlood(buf);
+        return;
     }
 
-    // process rows
-    for (unsigned y = 0; y < height; ++y) {
-        for (unsigned x = 0; x < width; ++x) {
-            f[x] = grid[width * y + x];
-        }
+    constexpr float NODATA = 32767;
 
-        // Do the distance transform
-        edt1d(f, d, v, z, width);
+    const unsigned width = buf->s();
+    const unsigned height = buf->t();
+    float* imageData = (float*)(buf->data());
 
-        // Copy d back into the grid
-        for (unsigned x = 0; x < width; ++x) {
-            grid[width * y + x] = d[x];
-        }
-    }
+    std::vector<std::uint8_t> seeds(width * height);
+    for (unsigned i = 0; i < width * height; ++i)
+        seeds[i] = imageData[i * 2] != NODATA ? 1 : 0;
 
-    delete[] f;
-    delete[] d;
-    delete[] v;
-    delete[] z;
+    // Seeds are their own nearest neighbor, so only the empty pixels are
+    // written. That also means no row ever writes a pixel another row reads.
+    edt2d(seeds.data(), width, height,
+        [&](unsigned y, const int* d, const int* src, const int* nearestRow)
+        {
+            float* row = &imageData[y * width * 2];
+            for (unsigned x = 0; x < width; ++x)
+            {
+                if (d[x] > 0)
+                {
+                    const float* seed = &imageData[(nearestRow[y * width + src[x]] * width + src[x]) * 2];
+                    row[x * 2 + 0] = seed[0];
+                    row[x * 2 + 1] = seed[1];
+                }
+            }
+        });
 }
 
 osg::Image* SDFGenerator::createDistanceField(const osg::Image* image, float minPixels, float maxPixels) const
 {
     OE_PROFILING_ZONE;
 
-    ImageUtils::PixelReader read(image);
-
     unsigned int width = image->s();
     unsigned int height = image->t();
 
-    // Initialize the grid to INF
-    std::vector<float> grid(width * height, INF);
-
-    // Mark pixels with alpha > 0 as having a distance of 0
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
+    // Mark pixels with alpha > 0 as seeds
+    std::vector<std::uint8_t> seeds(width * height);
+    jobs::jobpool* pool = (std::uint64_t)width * height >= MIN_PIXELS_TO_SPLIT ?
+        jobs::get_pool("oe.sdf") : nullptr;
+    jobs::parallel_for(pool, height, 16, [&](unsigned begin, unsigned end)
+        {
+            ImageUtils::PixelReader read(image);
             osg::Vec4 pixel;
-            read(pixel, x, y);
-            float a = pixel.a();
-            if (a > 0.0f) {
-                grid[y * width + x] = 0;
+            for (unsigned int y = begin; y < end; ++y) {
+                for (unsigned int x = 0; x < width; ++x) {
+                    read(pixel, x, y);
+                    seeds[y * width + x] = pixel.a() > 0.0f ? 1 : 0;
+                }
             }
-        }
-    }
-
-    // Compute the distance transform
-    edt2d(grid.data(), width, height);
+        });
 
-    // Copy the distance transform back into the image
     osg::ref_ptr<osg::Image> sdf = new osg::Image();
     sdf->allocateImage(width, height, 1, GL_RED, GL_UNSIGNED_BYTE);
     sdf->setInternalTextureFormat(GL_R8);
 
-    osg::Vec4 p;
-
-    ImageUtils::PixelWriter write(sdf.get());
-    write.assign(Color(1, 1, 1, 1));
-    for (unsigned y = 0; y < height; ++y)
-    {
-        for (unsigned x = 0; x < width; ++x)
+    // Compute the distance transform and write it out a row at a time
+    edt2d(seeds.data(), width, height,
+        [&](unsigned y, const int* d, const int*, const int*)
         {
-            // The distance computed is the square distance, so take the square root here to get the actual distance
-            float d = sqrt(grid[width * y + x]);
-            // Remap the value between 0 and 1
-            float value = unitremap(d, minPixels, maxPixels);
-            p.set(value, 1.0, 1.0, 1.0);
-            write(p, x, y);
-        }
-    }
+            ImageUtils::PixelWriter write(sdf.get());
+            osg::Vec4 p;
+            for (unsigned x = 0; x < width; ++x)
+            {
+                // The distance computed is the square distance, so take the square root here to get the actual distance.
+                // With no seeds at all, every pixel is as far away as it gets.
+                float value = d[x] >= 0 ? unitremap(sqrtf((float)d[x]), minPixels, maxPixels) : 1.0f;
+                p.set(value, 1.0, 1.0, 1.0);
+                write(p, x, y);
+            }
+        });
+
     return sdf.release();
-}
\ No newline at end of file
+}
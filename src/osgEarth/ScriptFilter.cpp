@@ -17,7 +17,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>
  */
 #include <osgEarth/ScriptFilter>
+#include <osgEarth/NativeScriptEngine>
 #include <osgEarth/FilterContext>
+#include <osgEarth/StringUtils>
 
 using namespace osgEarth;
 
@@ -53,6 +55,11 @@ ScriptFilter::ctor()
         {
             _engine->setProfile(profile().get());
         }
+
+        if (ciEquals(language().get(), "javascript"))
+        {
+            _engine = new NativeScriptEngine(_engine.get());
+        }
     }
 }
 
@@ -20,6 +20,7 @@
 #include <osgEarth/Session>
 #include <osgEarth/Script>
 #include <osgEarth/ScriptEngine>
+#include <osgEarth/NativeScriptEngine>
 #include <osgEarth/FeatureSource>
 
 #include <osgEarth/ResourceCache>
@@ -197,6 +198,14 @@ Session::initScriptEngine()
             // and NumericExpression style values.
             _styleScriptEngine = ScriptEngineFactory::create("javascript", "", true);
         }
+
+        // Run simple JavaScript expressions natively and only hand the
+        // rest to the script engine.
+        const std::string language = _styles->getScript() ? _styles->getScript()->language : "javascript";
+        if (_styleScriptEngine.valid() && ciEquals(language, "javascript"))
+        {
+            _styleScriptEngine = new NativeScriptEngine(_styleScriptEngine.get());
+        }
     }
 }
 
@@ -58,6 +58,156 @@ namespace
         }
     }
 
+    // Built-in transformation kernels for the most common SRS pairs, so we can
+    // skip OGR entirely. All of them go through WGS84 geographic (degrees).
+    // They run over plain arrays so the compiler is free to vectorize them.
+    namespace Native
+    {
+        const double WGS84_A = 6378137.0;
+        const double WGS84_F = 1.0 / 298.257223563;
+        const double UTM_K0 = 0.9996;
+        const double UTM_FALSE_EASTING = 500000.0;
+        const double UTM_FALSE_NORTHING_SOUTH = 10000000.0;
+
+        // Same wrapping PROJ applies to longitudes outside [-180..180].
+        inline double wrapLongitude(double lon)
+        {
+            if (lon < -180.0 || lon > 180.0)
+                lon = fmod(fmod(lon + 180.0, 360.0) + 360.0, 360.0) - 180.0;
+            return lon;
+        }
+
+        void geographicToSphericalMercator(double* x, double* y, unsigned count)
+        {
+            for (unsigned i = 0; i < count; ++i)
+            {
+                double lon = osg::DegreesToRadians(wrapLongitude(x[i]));
+                double lat = osg::DegreesToRadians(y[i]);
+                x[i] = WGS84_A * lon;
+                y[i] = WGS84_A * log(tan(0.25*osg::PI + 0.5*lat));
+            }
+        }
+
+        void sphericalMercatorToGeographic(double* x, double* y, unsigned count)
+        {
+            for (unsigned i = 0; i < count; ++i)
+            {
+                x[i] = wrapLongitude(osg::RadiansToDegrees(x[i] / WGS84_A));
+                y[i] = osg::RadiansToDegrees(2.0*atan(exp(y[i] / WGS84_A)) - 0.5*osg::PI);
+            }
+        }
+
+        // Transverse mercator on the WGS84 ellipsoid using Krueger's series
+        // to order n^6, which is what PROJ uses for UTM. Accurate to a few
+        // nanometers within a zone.
+        // Reference: C.F.F. Karney, "Transverse Mercator with an accuracy
+        // of a few nanometers", J. Geodesy 85(8), 2011.
+        struct TransverseMercator
+        {
+            double e, e2m, A;
+            double alpha[7], beta[7];
+
+            TransverseMercator()
+            {
+                double f = WGS84_F;
+                double n = f / (2.0 - f);
+                double n2 = n*n, n3 = n2*n, n4 = n3*n, n5 = n4*n, n6 = n5*n;
+                e = sqrt(f*(2.0 - f));
+                e2m = 1.0 - e*e;
+                A = WGS84_A / (1.0 + n) * (1.0 + n2/4.0 + n4/64.0 + n6/256.0);
+
+                alpha[0] = beta[0] = 0.0;
+                alpha[1] = n/2 - 2*n2/3 + 5*n3/16 + 41*n4/180 - 127*n5/288 + 7891*n6/37800;
+                alpha[2] = 13*n2/48 - 3*n3/5 + 557*n4/1440 + 281*n5/630 - 1983433*n6/1935360;
+                alpha[3] = 61*n3/240 - 103*n4/140 + 15061*n5/26880 + 167603*n6/181440;
+                alpha[4] = 49561*n4/161280 - 179*n5/168 + 6601661*n6/7257600;
+                alpha[5] = 34729*n5/80640 - 3418889*n6/1995840;
+                alpha[6] = 212378941*n6/319334400;
+
+                beta[1] = n/2 - 2*n2/3 + 37*n3/96 - n4/360 - 81*n5/512 + 96199*n6/604800;
+                beta[2] = n2/48 + n3/15 - 437*n4/1440 + 46*n5/105 - 1118711*n6/3870720;
+                beta[3] = 17*n3/480 - 37*n4/840 - 209*n5/4480 + 5569*n6/90720;
+                beta[4] = 4397*n4/161280 - 11*n5/504 - 830251*n6/7257600;
+                beta[5] = 4583*n5/161280 - 108847*n6/3991680;
+                beta[6] = 20648693*n6/638668800;
+            }
+
+            // conformal latitude (as tan) from geographic latitude (as tan)
+            inline double taupf(double tau) const
+            {
+                double tau1 = sqrt(1.0 + tau*tau);
+                double sig = sinh(e * atanh(e * tau / tau1));
+                return sqrt(1.0 + sig*sig) * tau - sig * tau1;
+            }
+
+            // inverse of taupf by Newton's method
+            inline double tauf(double taup) const
+            {
+                double tau = taup / e2m;
+                for (int i = 0; i < 4; ++i)
+                {
+                    double taupa = taupf(tau);
+                    double dtau = (taup - taupa) * (1.0 + e2m*tau*tau) /
+                        (e2m * sqrt(1.0 + tau*tau) * sqrt(1.0 + taupa*taupa));
+                    tau += dtau;
+                }
+                return tau;
+            }
+
+            void forward(double* x, double* y, unsigned count, int zone, bool north) const
+            {
+                double lon0 = (double)(zone * 6 - 183);
+                for (unsigned i = 0; i < count; ++i)
+                {
+                    double lam = osg::DegreesToRadians(wrapLongitude(x[i] - lon0));
+                    double phi = osg::DegreesToRadians(y[i]);
+                    double taup = taupf(tan(phi));
+                    double clam = cos(lam);
+                    double xip = atan2(taup, clam);
+                    double etap = asinh(sin(lam) / sqrt(taup*taup + clam*clam));
+                    double xi = xip, eta = etap;
+                    for (int j = 1; j <= 6; ++j)
+                    {
+                        xi  += alpha[j] * sin(2*j*xip) * cosh(2*j*etap);
+                        eta += alpha[j] * cos(2*j*xip) * sinh(2*j*etap);
+                    }
+                    x[i] = UTM_K0 * A * eta + UTM_FALSE_EASTING;
+                    y[i] = UTM_K0 * A * xi + (north ? 0.0 : UTM_FALSE_NORTHING_SOUTH);
+                }
+            }
+
+            void inverse(double* x, double* y, unsigned count, int zone, bool north) const
+            {
+                double lon0 = (double)(zone * 6 - 183);
+                for (unsigned i = 0; i < count; ++i)
+                {
+                    double xi = (y[i] - (north ? 0.0 : UTM_FALSE_NORTHING_SOUTH)) / (UTM_K0 * A);
+                    double eta = (x[i] - UTM_FALSE_EASTING) / (UTM_K0 * A);
+                    double xip = xi, etap = eta;
+                    for (int j = 1; j <= 6; ++j)
+                    {
+                        xip  -= beta[j] * sin(2*j*xi) * cosh(2*j*eta);
+                        etap -= beta[j] * cos(2*j*xi) * sinh(2*j*eta);
+                    }
+                    double sxip = sin(xip), cxip = cos(xip), shetap = sinh(etap);
+                    double taup = sxip / sqrt(shetap*shetap + cxip*cxip);
+                    double lam = atan2(shetap, cxip);
+                    x[i] = wrapLongitude(osg::RadiansToDegrees(lam) + lon0);
+                    y[i] = osg::RadiansToDegrees(atan(tauf(taup)));
+                }
+            }
+        };
+
+        const TransverseMercator& utm()
+        {
+            static TransverseMercator s_tm;
+            return s_tm;
+        }
+    }
+
+    // toggled at runtime, read from any thread
+    std::atomic<bool> s_nativeTransformsEnabled(true);
+
     // Make a MatrixTransform suitable for use with a Locator object based on the given extents.
     // Calling Locator::setTransformAsExtents doesn't work with OSG 2.6 due to the fact that the
     // _inverse member isn't updated properly.  Calling Locator::setTransform works correctly.
@@ -138,7 +288,10 @@ SpatialReference::SpatialReference(void* handle) :
     _is_user_defined(false),
     _is_ltp(false),
     _is_spherical_mercator(false),
-    _ellipsoidId(0u)
+    _ellipsoidId(0u),
+    _nativeType(NATIVE_NONE),
+    _utmZone(0),
+    _utmNorth(true)
 {
     _setup.srcHandle = handle;
 
@@ -157,7 +310,10 @@ SpatialReference::SpatialReference(const Key& key) :
     _is_user_defined(false),
     _is_ltp(false),
     _is_spherical_mercator(false),
-    _ellipsoidId(0u)
+    _ellipsoidId(0u),
+    _nativeType(NATIVE_NONE),
+    _utmZone(0),
+    _utmNorth(true)
 {
     // shortcut for spherical-mercator:
     // https://wiki.openstreetmap.org/wiki/EPSG:3857
@@ -639,6 +795,7 @@ SpatialReference::getGeocentricSRS() const
                     Key key(std::string(wktbuf), ""); // to vdatum in ECEF
                     _geocentric_srs = new SpatialReference(key);
                     _geocentric_srs->_domain = GEOCENTRIC;
+                    _geocentric_srs->_nativeType = NATIVE_NONE;
                     CPLFree(wktbuf);
                 }
             }
@@ -825,6 +982,9 @@ SpatialReference::transform(const osg::Vec3d&       input,
     if (!valid())
         return false;
 
+    if (transformNative(input, outputSRS, output))
+        return true;
+
     std::vector<osg::Vec3d> v(1, input);
 
     if ( transform(v, outputSRS) )
@@ -976,6 +1136,9 @@ SpatialReference::transformXYPointArrays(
     if (!valid())
         return false;
 
+    if (transformXYPointArraysNative(x, y, count, out_srs))
+        return true;
+
     // Transform the X and Y values inside an exclusive GDAL/OGR lock
     optional<TransformInfo>& xform = local._xformCache[out_srs->getWKT()];
     if (!xform.isSet())
@@ -1011,6 +1174,119 @@ SpatialReference::transformXYPointArrays(
 }
 
 
+bool
+SpatialReference::transformXYPointArraysNative(
+    double*  x,
+    double*  y,
+    unsigned count,
+    const SpatialReference* out_srs) const
+{
+    if (!s_nativeTransformsEnabled ||
+        _nativeType == NATIVE_NONE ||
+        out_srs->_nativeType == NATIVE_NONE)
+    {
+        return false;
+    }
+
+    if (_nativeType == out_srs->_nativeType &&
+        (_nativeType != NATIVE_WGS84_UTM || (_utmZone == out_srs->_utmZone && _utmNorth == out_srs->_utmNorth)))
+    {
+        return true;
+    }
+
+    // Mercator can't reach the poles and OGR fails them, so leave those
+    // points to OGR; check before touching the arrays.
+    if (out_srs->_nativeType == NATIVE_SPHERICAL_MERCATOR)
+    {
+        for (unsigned i = 0; i < count; ++i)
+        {
+            double lon = x[i], lat = y[i];
+            if (_nativeType == NATIVE_WGS84_UTM)
+                Native::utm().inverse(&lon, &lat, 1, _utmZone, _utmNorth);
+
+            if (!(fabs(lat) < 90.0))
+                return false;
+        }
+    }
+
+    // to geographic:
+    if (_nativeType == NATIVE_SPHERICAL_MERCATOR)
+        Native::sphericalMercatorToGeographic(x, y, count);
+    else if (_nativeType == NATIVE_WGS84_UTM)
+        Native::utm().inverse(x, y, count, _utmZone, _utmNorth);
+
+    // and from geographic:
+    if (out_srs->_nativeType == NATIVE_SPHERICAL_MERCATOR)
+        Native::geographicToSphericalMercator(x, y, count);
+    else if (out_srs->_nativeType == NATIVE_WGS84_UTM)
+        Native::utm().forward(x, y, count, out_srs->_utmZone, out_srs->_utmNorth);
+
+    return true;
+}
+
+bool
+SpatialReference::transformNative(
+    const osg::Vec3d& input,
+    const SpatialReference* outputSRS,
+    osg::Vec3d& output) const
+{
+    if (!s_nativeTransformsEnabled)
+        return false;
+
+    if (outputSRS == this)
+    {
+        output = input;
+        return true;
+    }
+
+    // subclasses may have custom pre/post transforms
+    if (_is_user_defined || _is_cube || outputSRS->_is_user_defined || outputSRS->_is_cube)
+        return false;
+
+    // geodetic <-> geocentric, same thing the vector version does
+    if (isGeodetic() && outputSRS->isGeocentric() && _ellipsoidId == outputSRS->_ellipsoidId)
+    {
+        output = outputSRS->getEllipsoid().geodeticToGeocentric(input);
+        return true;
+    }
+
+    if (isGeocentric() && outputSRS->isGeodetic())
+    {
+        output = outputSRS->getEllipsoid().geocentricToGeodetic(input);
+        return true;
+    }
+
+    // XY kernels; Z passes through when the vertical datums match
+    if (_vdatum.get() == outputSRS->_vdatum.get())
+    {
+        double x = input.x(), y = input.y();
+        if (transformXYPointArraysNative(&x, &y, 1, outputSRS))
+        {
+            if (isProjected() && outputSRS->isGeographic())
+            {
+                x = osg::clampBetween(x, -180.0, 180.0);
+                y = osg::clampBetween(y, -90.0, 90.0);
+            }
+            output.set(x, y, input.z());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+SpatialReference::setNativeTransformsEnabled(bool value)
+{
+    s_nativeTransformsEnabled = value;
+}
+
+bool
+SpatialReference::getNativeTransformsEnabled()
+{
+    return s_nativeTransformsEnabled;
+}
+
 bool
 SpatialReference::transformZ(std::vector<osg::Vec3d>& points,
                              const SpatialReference*  outputSRS,
@@ -1485,6 +1761,50 @@ SpatialReference::init()
         CPLFree( wktbuf );
     }
 
+    // Check whether we have a built-in transformation kernel for this SRS.
+    _nativeType = NATIVE_NONE;
+    if (!_is_user_defined && !_is_cube && !isGeocentric() && !_proj4.empty())
+    {
+        StringTable tok;
+        StringTokenizer(_proj4, tok);
+
+        auto zero = [&](const std::string& key) {
+            return tok.count(key) == 0 || as<double>(tok[key], 1.0) == 0.0;
+        };
+
+        bool wgs84 =
+            osg::equivalent(_ellipsoid.getSemiMajorAxis(), Native::WGS84_A) &&
+            osg::equivalent(_ellipsoid.getSemiMinorAxis(), Native::WGS84_A*(1.0 - Native::WGS84_F)) &&
+            tok.count("+pm") == 0 &&
+            (tok.count("+towgs84") == 0 || tok["+towgs84"] == "0,0,0" || tok["+towgs84"] == "0,0,0,0,0,0,0");
+
+        bool meters =
+            (tok.count("+units") == 0 || tok["+units"] == "m") &&
+            tok.count("+to_meter") == 0;
+
+        int isNorth = 0;
+        int zone = 0;
+
+        if (tok["+proj"] == "longlat" && wgs84)
+        {
+            _nativeType = NATIVE_WGS84_GEOGRAPHIC;
+        }
+        else if (
+            _is_spherical_mercator && meters &&
+            osg::equivalent(_ellipsoid.getSemiMajorAxis(), Native::WGS84_A) &&
+            zero("+lon_0") && zero("+lat_ts") && zero("+x_0") && zero("+y_0") &&
+            as<double>(tok.count("+k") ? tok["+k"] : tok.count("+k_0") ? tok["+k_0"] : "1", 0.0) == 1.0)
+        {
+            _nativeType = NATIVE_SPHERICAL_MERCATOR;
+        }
+        else if (wgs84 && meters && (zone = OSRGetUTMZone(handle, &isNorth)) > 0)
+        {
+            _nativeType = NATIVE_WGS84_UTM;
+            _utmZone = zone;
+            _utmNorth = (isNorth != 0);
+        }
+    }
+
     if ( _name == "unnamed" || _name == "unknown" || _name.empty() )
     {
         StringTable proj4_tok;
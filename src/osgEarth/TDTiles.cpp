@@ -33,6 +33,9 @@
 #include <osg/PolygonMode>
 #include <osgEarth/LineDrawable>
 #include <osgEarth/GLUtils>
+#include <climits>
+#include <cstring>
+#include <cstdlib>
 
 using namespace osgEarth;
 using namespace osgEarth::Threading;
@@ -92,6 +95,512 @@ namespace osgEarth { namespace Contrib { namespace ThreeDTiles
 
 //........................................................................
 
+namespace
+{
+    /**
+     * Forward-only (SAX-style) JSON scanner over a range of a string.
+     *
+     * Reads objects and arrays member by member without building a tree,
+     * so the caller decides what to materialize. skipValue() jumps over a
+     * whole subtree by matching brackets; it does not validate the skipped
+     * text, which is checked when (and if) it is read later.
+     *
+     * The range must live inside a std::string, which guarantees a null
+     * terminator after the last number for strtod().
+     */
+    class JSONScanner
+    {
+    public:
+        JSONScanner(const std::string& json, std::size_t begin, std::size_t end) :
+            _base(json.data()),
+            _p(json.data() + begin),
+            _end(json.data() + end),
+            _ok(true),
+            _depth(0)
+        {
+            //nop
+        }
+
+        //! False once a syntax error was found
+        bool ok() const { return _ok; }
+
+        //! Offset of the read position in the source string
+        std::size_t offset() const { return _p - _base; }
+
+        void skipSpace()
+        {
+            while (_p < _end && (*_p == ' ' || *_p == '\n' || *_p == '\r' || *_p == '\t'))
+                ++_p;
+        }
+
+        //! Peeks at the next significant character, or 0 at the end
+        char peek()
+        {
+            skipSpace();
+            return _p < _end ? *_p : 0;
+        }
+
+        //! Consumes the opening bracket of an object ('{') or array ('[')
+        bool enter(char bracket)
+        {
+            if (peek() != bracket)
+                return fail();
+            ++_p;
+            return true;
+        }
+
+        //! Moves to the next member of the current object and reads its key.
+        //! Returns false after the closing brace (or on error).
+        bool nextMember(std::string& key)
+        {
+            if (!_ok)
+                return false;
+            if (peek() == ',')
+                ++_p;
+            if (peek() == '}')
+            {
+                ++_p;
+                return false;
+            }
+            if (!readString(key) || peek() != ':')
+                return fail();
+            ++_p;
+            return true;
+        }
+
+        //! Moves to the next element of the current array.
+        //! Returns false after the closing bracket (or on error).
+        bool nextElement()
+        {
+            if (!_ok)
+                return false;
+            if (peek() == ',')
+                ++_p;
+            char c = peek();
+            if (c == ']')
+            {
+                ++_p;
+                return false;
+            }
+            return c != 0 ? true : fail();
+        }
+
+        //! Skips over the next value, including any nested objects and arrays.
+        bool skipValue()
+        {
+            char c = peek();
+            if (c == '"')
+            {
+                return skipString();
+            }
+            else if (c == '{' || c == '[')
+            {
+                int depth = 0;
+                while (_p < _end)
+                {
+                    c = *_p;
+                    if (c == '"')
+                    {
+                        if (!skipString())
+                            return false;
+                        continue;
+                    }
+                    ++_p;
+                    if (c == '{' || c == '[')
+                        ++depth;
+                    else if ((c == '}' || c == ']') && --depth == 0)
+                        return true;
+                }
+                return fail();
+            }
+            else
+            {
+                const char* start = _p;
+                while (_p < _end && !isDelimiter(*_p))
+                    ++_p;
+                return _p > start ? true : fail();
+            }
+        }
+
+        //! Reads the next value into a JSON tree. Meant for the small
+        //! values of a tile, not for whole subtrees.
+        bool readValue(Json::Value& value)
+        {
+            char c = peek();
+            if (c == '{')
+            {
+                if (++_depth > MAX_DEPTH)
+                    return fail();
+                ++_p;
+                value = Json::Value(Json::objectValue);
+                std::string key;
+                while (nextMember(key))
+                {
+                    if (!readValue(value[key]))
+                        return false;
+                }
+                --_depth;
+                return _ok;
+            }
+            else if (c == '[')
+            {
+                if (++_depth > MAX_DEPTH)
+                    return fail();
+                ++_p;
+                value = Json::Value(Json::arrayValue);
+                while (nextElement())
+                {
+                    if (!readValue(value.append(Json::Value())))
+                        return false;
+                }
+                --_depth;
+                return _ok;
+            }
+            else if (c == '"')
+            {
+                std::string s;
+                if (!readString(s))
+                    return false;
+                value = s;
+                return true;
+            }
+            else if (c == '-' || (c >= '0' && c <= '9'))
+            {
+                return readNumber(value);
+            }
+            else if (readLiteral("true"))
+            {
+                value = true;
+                return true;
+            }
+            else if (readLiteral("false"))
+            {
+                value = false;
+                return true;
+            }
+            else if (readLiteral("null"))
+            {
+                value = Json::Value();
+                return true;
+            }
+            return fail();
+        }
+
+        //! Reads a string value, decoding escapes to UTF-8.
+        bool readString(std::string& out)
+        {
+            if (peek() != '"')
+                return fail();
+            ++_p;
+            out.clear();
+            while (_p < _end)
+            {
+                const char* start = _p;
+                while (_p < _end && *_p != '"' && *_p != '\\')
+                    ++_p;
+                out.append(start, _p);
+                if (_p >= _end)
+                    break;
+                if (*_p++ == '"')
+                    return true;
+                if (_p >= _end)
+                    break;
+                switch (*_p++)
+                {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u':
+                {
+                    unsigned cp;
+                    if (!readHex4(cp))
+                        return false;
+                    if (cp >= 0xD800 && cp < 0xDC00)
+                    {
+                        unsigned lo;
+                        if (_end - _p < 6 || _p[0] != '\\' || _p[1] != 'u')
+                            return fail();
+                        _p += 2;
+                        if (!readHex4(lo) || lo < 0xDC00 || lo > 0xDFFF)
+                            return fail();
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    }
+                    appendUTF8(cp, out);
+                    break;
+                }
+                default:
+                    return fail();
+                }
+            }
+            return fail();
+        }
+
+    private:
+        enum { MAX_DEPTH = 256 };
+
+        const char* _base;
+        const char* _p;
+        const char* _end;
+        bool _ok;
+        int _depth;
+
+        bool fail()
+        {
+            _ok = false;
+            return false;
+        }
+
+        static bool isDelimiter(char c)
+        {
+            return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+        bool skipString()
+        {
+            // an unescaped quote is one preceded by an even number of backslashes
+            ++_p;
+            while (_p < _end)
+            {
+                const char* q = (const char*)::memchr(_p, '"', _end - _p);
+                if (!q)
+                    break;
+                const char* b = q;
+                while (b > _p && b[-1] == '\\')
+                    --b;
+                _p = q + 1;
+                if (((q - b) & 1) == 0)
+                    return true;
+            }
+            return fail();
+        }
+
+        bool readLiteral(const char* literal)
+        {
+            std::size_t len = ::strlen(literal);
+            if ((std::size_t)(_end - _p) < len || ::strncmp(_p, literal, len) != 0)
+                return false;
+            if (_p + len < _end && !isDelimiter(_p[len]))
+                return false;
+            _p += len;
+            return true;
+        }
+
+        bool readNumber(Json::Value& value)
+        {
+            const char* start = _p;
+            bool integral = true;
+            while (_p < _end && !isDelimiter(*_p))
+            {
+                if (*_p == '.' || *_p == 'e' || *_p == 'E')
+                    integral = false;
+                ++_p;
+            }
+
+            char* stop = nullptr;
+            double d = ::strtod(start, &stop);
+            if (stop != _p)
+                return fail();
+
+            // same integer typing as Json::Reader
+            if (integral && d >= (double)INT_MIN && d <= (double)INT_MAX)
+                value = Json::Value((Json::Value::Int)d);
+            else if (integral && d >= 0.0 && d <= (double)UINT_MAX)
+                value = Json::Value((Json::Value::UInt)d);
+            else
+                value = Json::Value(d);
+            return true;
+        }
+
+        bool readHex4(unsigned& cp)
+        {
+            if (_end - _p < 4)
+                return fail();
+            cp = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                char c = *_p++;
+                cp <<= 4;
+                if (c >= '0' && c <= '9') cp |= c - '0';
+                else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+                else return fail();
+            }
+            return true;
+        }
+
+        static void appendUTF8(unsigned cp, std::string& out)
+        {
+            if (cp < 0x80)
+            {
+                out.push_back((char)cp);
+            }
+            else if (cp < 0x800)
+            {
+                out.push_back((char)(0xC0 | (cp >> 6)));
+                out.push_back((char)(0x80 | (cp & 0x3F)));
+            }
+            else if (cp < 0x10000)
+            {
+                out.push_back((char)(0xE0 | (cp >> 12)));
+                out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back((char)(0x80 | (cp & 0x3F)));
+            }
+            else
+            {
+                out.push_back((char)(0xF0 | (cp >> 18)));
+                out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back((char)(0x80 | (cp & 0x3F)));
+            }
+        }
+    };
+}
+
+namespace osgEarth { namespace Contrib { namespace ThreeDTiles
+{
+    struct TilesetSource
+    {
+        std::string _json;
+        mutable LoadContext _lc;
+
+        using Ptr = std::shared_ptr<const TilesetSource>;
+
+        //! Reads a tile object, materializing "levels" levels of children
+        //! below it. Deeper children stay in the source as a byte range.
+        static bool readTile(JSONScanner& s, Tile& tile, const Ptr& source, unsigned levels)
+        {
+            if (!s.enter('{'))
+                return false;
+
+            Json::Value value(Json::objectValue);
+            std::string key;
+            while (s.nextMember(key))
+            {
+                if (key == "children")
+                {
+                    if (levels > 0u)
+                    {
+                        if (!s.enter('['))
+                            return false;
+                        while (s.nextElement())
+                        {
+                            osg::ref_ptr<Tile> child = new Tile();
+                            if (!readTile(s, *child, source, levels - 1u))
+                                return false;
+                            tile.children().push_back(child);
+                        }
+                    }
+                    else
+                    {
+                        s.skipSpace();
+                        std::size_t begin = s.offset();
+                        if (!s.skipValue())
+                            return false;
+
+                        // defer anything but an empty array
+                        const char* c = source->_json.data() + begin;
+                        if (*c++ == '[')
+                        {
+                            while (*c == ' ' || *c == '\n' || *c == '\r' || *c == '\t')
+                                ++c;
+                            if (*c != ']')
+                            {
+                                tile._source = source;
+                                tile._childrenBegin = begin;
+                                tile._childrenEnd = s.offset();
+                                tile._expanded = false;
+                            }
+                        }
+                    }
+                }
+                else if (
+                    key == "boundingVolume" ||
+                    key == "viewerRequestVolume" ||
+                    key == "geometricError" ||
+                    key == "content" ||
+                    key == "refine" ||
+                    key == "transform")
+                {
+                    if (!s.readValue(value[key]))
+                        return false;
+                }
+                else if (!s.skipValue())
+                {
+                    return false;
+                }
+            }
+
+            if (!s.ok())
+                return false;
+
+            tile.fromJSON(value, source->_lc);
+            return true;
+        }
+
+        //! Reads the deferred children of a tile, one level deep
+        static bool readChildren(Tile& tile, const Ptr& source)
+        {
+            JSONScanner s(source->_json, tile._childrenBegin, tile._childrenEnd);
+            if (!s.enter('['))
+                return false;
+            while (s.nextElement())
+            {
+                osg::ref_ptr<Tile> child = new Tile();
+                if (!readTile(s, *child, source, 0u))
+                    return false;
+                tile.children().push_back(child);
+            }
+            return s.ok();
+        }
+
+        //! Reads a whole tileset document
+        static bool readTileset(Tileset& tileset, const Ptr& source, unsigned levels)
+        {
+            JSONScanner s(source->_json, 0u, source->_json.size());
+            if (!s.enter('{'))
+                return false;
+
+            Json::Value value(Json::objectValue);
+            std::string key;
+            while (s.nextMember(key))
+            {
+                if (key == "root")
+                {
+                    osg::ref_ptr<Tile> root = new Tile();
+                    if (!readTile(s, *root, source, levels))
+                        return false;
+                    tileset.root() = root;
+                }
+                else if (
+                    key == "asset" ||
+                    key == "boundingVolume" ||
+                    key == "geometricError")
+                {
+                    if (!s.readValue(value[key]))
+                        return false;
+                }
+                else if (!s.skipValue())
+                {
+                    return false;
+                }
+            }
+
+            if (!s.ok() || s.peek() != 0)
+                return false;
+
+            tileset.fromJSON(value, source->_lc);
+            return true;
+        }
+    };
+} } }
+
+//........................................................................
+
 void
 Asset::fromJSON(const Json::Value& value)
 {
@@ -337,7 +846,14 @@ Tile::getJSON() const
         value["content"] = content()->getJSON();
 
 
-    if (!children().empty())
+    if (!_expanded && _source)
+    {
+        JSONScanner s(_source->_json, _childrenBegin, _childrenEnd);
+        Json::Value collection;
+        if (s.readValue(collection))
+            value["children"] = collection;
+    }
+    else if (!children().empty())
     {
         Json::Value collection(Json::arrayValue);
         for(unsigned i=0; i<children().size(); ++i)
@@ -399,6 +915,41 @@ Tile::getBoundingSphere()
     return bsphere;
 }
 
+bool
+Tile::hasChildren() const
+{
+    return !_expanded || !children().empty();
+}
+
+bool
+Tile::expand()
+{
+    if (_expanded)
+        return true;
+
+    _expanded = true;
+
+    if (!TilesetSource::readChildren(*this, _source))
+    {
+        OE_WARN << LC << "Invalid JSON in tile children" << std::endl;
+        children().clear();
+        _source = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool
+Tile::collapse()
+{
+    if (!_source)
+        return false;
+
+    children().clear();
+    _expanded = false;
+    return true;
+}
+
 //........................................................................
 
 void
@@ -432,15 +983,21 @@ Tileset::getJSON() const
 Tileset*
 Tileset::create(const std::string& json, const URIContext& uc)
 {
-    Json::Reader reader;
-    Json::Value root(Json::objectValue);
-    if (!reader.parse(json, root, false))
-        return NULL;
+    OE_PROFILING_ZONE;
+
+    // Scan the document instead of parsing it into a tree; tiles below the
+    // first few levels keep a reference to their text and expand on demand.
+    auto source = std::make_shared<TilesetSource>();
+    source->_json = json;
+    source->_lc._uc = uc;
 
-    LoadContext lc;
-    lc._uc = uc;
+    unsigned levels = source->_lc._maxLevels > 0u ? source->_lc._maxLevels - 1u : ~0u;
+
+    osg::ref_ptr<Tileset> tileset = new Tileset();
+    if (!TilesetSource::readTileset(*tileset, source, levels))
+        return NULL;
 
-    return new Tileset(root, lc);
+    return tileset.release();
 }
 
 static VirtualProgram* getOrCreateDebugVirtualProgram()
@@ -606,6 +1163,8 @@ ThreeDTileNode::ThreeDTileNode(ThreeDTilesetNode* tileset, Tile* tile, bool imme
     _trackerItrValid(false),
     _lastCulledFrameNumber(0),
     _lastCulledFrameTime(0.0f),
+    _childrenCreated(false),
+    _lastTraversalTime(0.0f),
     _refine(REFINE_ADD)
 {
     OE_PROFILING_ZONE;
@@ -662,22 +1221,7 @@ ThreeDTileNode::ThreeDTileNode(ThreeDTilesetNode* tileset, Tile* tile, bool imme
         OE_PROFILING_ZONE_TEXT("Immediate load");
     }
 
-    if (_tile->children().size() > 0)
-    {
-        _children = new osg::Group;
-        for (unsigned int i = 0; i < _tile->children().size(); ++i)
-        {
-            ThreeDTileNode* child = new ThreeDTileNode(_tileset, _tile->children()[i].get(), false, _options.get());
-            child->setParentTile(this);
-            _children->addChild(child);
-        }
-
-        if (_children->getNumChildren() == 0)
-        {
-            _children = 0;
-        }
-        addChild(_children.get());
-    }
+    // Child tiles are created by createChildren() once traversal reaches this tile.
 
     _debugColor = randomColor();
 
@@ -698,6 +1242,90 @@ void ThreeDTileNode::setParentTile(ThreeDTileNode* parentTile)
     }
 }
 
+void ThreeDTileNode::createChildren()
+{
+    if (_childrenCreated)
+        return;
+
+    bool created = false;
+    {
+        std::lock_guard<std::mutex> lock(_childrenMutex);
+        if (_childrenCreated)
+            return;
+
+        if (!_tile->isExpanded())
+        {
+            OE_PROFILING_ZONE;
+            _tile->expand();
+        }
+
+        if (_tile->children().size() > 0)
+        {
+            _children = new osg::Group;
+            for (unsigned int i = 0; i < _tile->children().size(); ++i)
+            {
+                ThreeDTileNode* child = new ThreeDTileNode(_tileset, _tile->children()[i].get(), false, _options.get());
+                child->setParentTile(this);
+                _children->addChild(child);
+            }
+            addChild(_children.get());
+            created = true;
+        }
+
+        _childrenCreated = true;
+    }
+
+    // outside the lock; the tileset locks the other way around when collapsing
+    if (created)
+    {
+        _tileset->addExpandedTile(this);
+    }
+}
+
+bool ThreeDTileNode::collapseChildren(TileTracker& tracker)
+{
+    std::lock_guard<std::mutex> lock(_childrenMutex);
+
+    if (!_children.valid())
+    {
+        _childrenCreated = false;
+        return true;
+    }
+
+    // Keep the children while any of them holds content or children of its own.
+    for (unsigned int i = 0; i < _children->getNumChildren(); i++)
+    {
+        ThreeDTileNode* childTile = dynamic_cast<ThreeDTileNode*>(_children->getChild(i));
+        if (childTile && (childTile->_content.valid() || childTile->_children.valid()))
+        {
+            return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < _children->getNumChildren(); i++)
+    {
+        ThreeDTileNode* childTile = dynamic_cast<ThreeDTileNode*>(_children->getChild(i));
+        if (childTile)
+        {
+            childTile->unloadContent();
+            if (childTile->_trackerItrValid)
+            {
+                tracker.erase(childTile->_trackerItr);
+                childTile->_trackerItrValid = false;
+            }
+        }
+    }
+
+    removeChild(_children.get());
+    _children = nullptr;
+
+    // Tiles that came from deferred JSON go back to it; the others keep their Tile objects.
+    _tile->collapse();
+
+    _childrenCreated = false;
+    return true;
+}
+
 void ThreeDTileNode::computeBoundingVolume()
 {
     if (_tile->boundingVolume()->region().isSet())
@@ -1073,6 +1701,11 @@ void ThreeDTileNode::traverse(osg::NodeVisitor& nv)
             }
         }
 
+        _lastTraversalTime = cv->getFrameStamp()->getReferenceTime();
+
+        // Expand the next level so its content can be requested ahead of refinement
+        createChildren();
+
         // Get the ICO so we can do incremental compiliation
         ICO* ico = 0;
         osgViewer::View* osgView = dynamic_cast<osgViewer::View*>(cv->getCurrentCamera()->getView());
@@ -1425,6 +2058,14 @@ void ThreeDTilesetNode::expireTiles(const osg::NodeVisitor& nv)
         }
     }
 
+    // Release the child nodes of tiles that traversal hasn't reached in a while
+    endTime = osg::Timer::instance()->tick();
+    float timeLeft = maxTime - (float)osg::Timer::instance()->delta_m(startTime, endTime);
+    if (timeLeft > 0.0f)
+    {
+        collapseTiles(frameTime, timeLeft);
+    }
+
 #if 0
     if (numErased > 0 || numSkipped > 0)
     {
@@ -1439,6 +2080,48 @@ void ThreeDTilesetNode::expireTiles(const osg::NodeVisitor& nv)
     _sentryItr = --_tracker.end();
 }
 
+void ThreeDTilesetNode::addExpandedTile(ThreeDTileNode* node)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _expandedTiles.push_back(node);
+}
+
+unsigned ThreeDTilesetNode::getNumExpandedTiles() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (unsigned)_expandedTiles.size();
+}
+
+void ThreeDTilesetNode::collapseTiles(float frameTime, float maxTime)
+{
+    osg::Timer_t startTime = osg::Timer::instance()->tick();
+
+    // Tiles expand top-down, so walking backwards tends to release children
+    // before their parents. Order is only a hint; what a pass can't collapse
+    // yet gets another chance next frame.
+    for (int i = (int)_expandedTiles.size() - 1; i >= 0; --i)
+    {
+        osg::ref_ptr<ThreeDTileNode> tile;
+        bool remove = !_expandedTiles[i].lock(tile);
+
+        if (!remove && frameTime - tile->getLastTraversalTime() >= _maxAge)
+        {
+            remove = tile->collapseChildren(_tracker);
+        }
+
+        if (remove)
+        {
+            _expandedTiles[i] = _expandedTiles.back();
+            _expandedTiles.pop_back();
+        }
+
+        if (osg::Timer::instance()->delta_m(startTime, osg::Timer::instance()->tick()) > maxTime)
+        {
+            break;
+        }
+    }
+}
+
 void ThreeDTilesetNode::traverse(osg::NodeVisitor& nv)
 {
     if (nv.getVisitorType() == nv.UPDATE_VISITOR)
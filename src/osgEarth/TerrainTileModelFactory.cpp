@@ -222,7 +222,8 @@ TerrainTileModelFactory::addImageLayer(
     ImageLayer* imageLayer,
     const TileKey& key,
     const TerrainEngineRequirements& require,
-    ProgressCallback* progress)
+    ProgressCallback* progress,
+    const GeoImage* prefetched)
 {
     OE_PROFILING_ZONE;
     OE_PROFILING_ZONE_TEXT(imageLayer->getName());
@@ -264,7 +265,7 @@ TerrainTileModelFactory::addImageLayer(
 
         else
         {
-            GeoImage geoImage = imageLayer->createImage(key, progress);
+            GeoImage geoImage = prefetched ? *prefetched : imageLayer->createImage(key, progress);
 
             if (geoImage.valid())
             {
@@ -331,7 +332,8 @@ TerrainTileModelFactory::addStandaloneImageLayer(
     ImageLayer* imageLayer,
     const TileKey& key,
     const TerrainEngineRequirements& require,
-    ProgressCallback* progress)
+    ProgressCallback* progress,
+    const GeoImage* prefetched)
 {
     //TerrainTileImageLayerModel* layerModel = NULL;
     TileKey keyToUse = key;
@@ -339,7 +341,9 @@ TerrainTileModelFactory::addStandaloneImageLayer(
     bool added = false;
     while (keyToUse.valid() && !added)
     {
-        added = addImageLayer(model, imageLayer, keyToUse, require, progress);
+        // the prefetched image only applies to the original key
+        added = addImageLayer(model, imageLayer, keyToUse, require, progress,
+            keyToUse == key ? prefetched : nullptr);
         if (!added)
         {
             TileKey parentKey = keyToUse.createParentKey();
@@ -376,6 +380,31 @@ TerrainTileModelFactory::addColorLayers(
     LayerVector layers;
     map->getLayers(layers);
 
+    // Create the images of all the synchronous image layers together,
+    // so their cache records are looked up in one batch.
+    std::vector<ImageLayer*> batch;
+    for (auto& layer : layers)
+    {
+        ImageLayer* imageLayer = dynamic_cast<ImageLayer*>(layer.get());
+        if (imageLayer &&
+            imageLayer->isOpen() &&
+            imageLayer->getRenderType() == imageLayer->RENDERTYPE_TERRAIN_SURFACE &&
+            !manifest.excludes(imageLayer) &&
+            !imageLayer->useCreateTexture() &&
+            !imageLayer->getAsyncLoading() &&
+            imageLayer->isKeyInLegalRange(key) &&
+            imageLayer->mayHaveData(key))
+        {
+            batch.push_back(imageLayer);
+        }
+    }
+
+    std::vector<GeoImage> prefetched;
+    if (batch.size() > 1)
+    {
+        prefetched = ImageLayer::createImages(batch, key, progress);
+    }
+
     for (LayerVector::const_iterator i = layers.begin(); i != layers.end(); ++i)
     {
         Layer* layer = i->get();
@@ -393,13 +422,23 @@ TerrainTileModelFactory::addColorLayers(
         ImageLayer* imageLayer = dynamic_cast<ImageLayer*>(layer);
         if (imageLayer)
         {
+            const GeoImage* image = nullptr;
+            for (unsigned b = 0; b < prefetched.size(); ++b)
+            {
+                if (batch[b] == imageLayer)
+                {
+                    image = &prefetched[b];
+                    break;
+                }
+            }
+
             if (standalone)
             {
-                addStandaloneImageLayer(model, imageLayer, key, require, progress);
+                addStandaloneImageLayer(model, imageLayer, key, require, progress, image);
             }
             else
             {
-                addImageLayer(model, imageLayer, key, require, progress);
+                addImageLayer(model, imageLayer, key, require, progress, image);
             }
         }
         else // non-image kind of TILE layer (e.g., splatting)
@@ -30,6 +30,28 @@ bool TileHandler::handleTile(const TileKey& key, const TileVisitor& tv)
     return true;    
 }
 
+std::vector<bool> TileHandler::handleTiles(const std::vector<TileKey>& keys, const TileVisitor& tv)
+{
+    std::vector<bool> results;
+    results.reserve(keys.size());
+    for (auto& key : keys)
+    {
+        results.push_back(handleTile(key, tv));
+    }
+    return results;
+}
+
+std::vector<TileHandler::TileData> TileHandler::readTiles(const std::vector<TileKey>& keys, const TileVisitor& tv)
+{
+    handleTiles(keys, tv);
+    return std::vector<TileData>(keys.size());
+}
+
+void TileHandler::writeTiles(const std::vector<TileKey>& keys, const std::vector<TileData>& data, const TileVisitor& tv)
+{
+    //nop
+}
+
 bool TileHandler::hasData( const TileKey& key ) const
 {
     return true;
@@ -402,7 +402,14 @@ TileLayer::setUpL2Cache(unsigned minSize)
     // Initialize the l2 cache if it's size is > 0
     if (l2CacheSize > 0)
     {
-        _memCache = new MemCache(l2CacheSize);
+        // a byte budget is only enforced by the concurrent bins
+        unsigned maxSizeMB = options().l2CacheMaxSizeMB().get();
+        bool concurrent = options().l2CacheConcurrent().get() || maxSizeMB > 0u;
+
+        _memCache = new MemCache(l2CacheSize, concurrent);
+        if (maxSizeMB > 0u)
+            _memCache->setMaxBinBytes((std::size_t)maxSizeMB * 1048576u);
+
         OE_DEBUG << LC << "L2 cache size = " << l2CacheSize << std::endl;
     }
 }
@@ -726,7 +733,13 @@ TileLayer::isCached(const TileKey& key) const
     if ( !bin )
         return false;
 
-    return bin->getRecordStatus( key.str() ) == CacheBin::STATUS_OK;
+    return bin->getRecordStatus( getCacheKey(key) ) == CacheBin::STATUS_OK;
+}
+
+std::string
+TileLayer::getCacheKey(const TileKey& key) const
+{
+    return Cache::makeCacheKey(key.str() + "-" + key.getProfile()->getHorizSignature());
 }
 
 unsigned int TileLayer::getDataExtentsSize() const
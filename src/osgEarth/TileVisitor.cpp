@@ -21,6 +21,14 @@
 #include <osgEarth/FileUtils>
 #include <thread>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <map>
 
 #include <osg/os_utils>
 #define OS_SYSTEM osg_system
@@ -150,6 +158,11 @@ void TileVisitor::estimate()
 }
 
 void TileVisitor::processKey( const TileKey& key )
+{
+    processKeys(std::vector<TileKey>{ key });
+}
+
+void TileVisitor::processKeys( const std::vector<TileKey>& keys )
 {
     // If we've been cancelled then just return.
     if (_progress && _progress->isCanceled())
@@ -157,40 +170,59 @@ void TileVisitor::processKey( const TileKey& key )
         return;
     }
 
-    unsigned int x, y, lod;
-    key.getTileXY(x, y);
-    lod = key.getLevelOfDetail();
+    std::vector<bool> traverseChildren(keys.size(), false);
 
-    // Only process this key if it has a chance of succeeding.
-    if (!hasData(key))
+    // the keys to hand to the tile handler, and their positions in "keys"
+    std::vector<TileKey> batch;
+    std::vector<unsigned> batchIndex;
+
+    for (unsigned i = 0; i < keys.size(); ++i)
     {
-        return;
-    }
+        const TileKey& key = keys[i];
 
-    bool traverseChildren = false;
+        // Only process this key if it has a chance of succeeding.
+        if (!hasData(key))
+        {
+            continue;
+        }
 
-    // If the key intersects the extent attempt to traverse
-    if (intersects(key.getExtent()))
-    {
-        // If the lod is less than the min level don't do anything but do traverse the children.
-        if (lod < _minLevel)
+        // If the key intersects the extent attempt to traverse
+        if (intersects(key.getExtent()))
         {
-            traverseChildren = true;
+            // If the lod is less than the min level don't do anything but do traverse the children.
+            if (key.getLevelOfDetail() < _minLevel)
+            {
+                traverseChildren[i] = true;
+            }
+            else
+            {
+                batch.push_back(key);
+                batchIndex.push_back(i);
+            }
         }
-        else
+    }
+
+    // Process the keys
+    if (!batch.empty())
+    {
+        std::vector<bool> handled = handleTiles(batch);
+        for (unsigned k = 0; k < batchIndex.size() && k < handled.size(); ++k)
         {
-            // Process the key
-            traverseChildren = handleTile(key);
+            traverseChildren[batchIndex[k]] = handled[k];
         }
     }
 
     // Traverse the children
-    if (traverseChildren && lod < _maxLevel)
+    for (unsigned i = 0; i < keys.size(); ++i)
     {
-        for (unsigned int i = 0; i < 4; i++)
+        if (traverseChildren[i] && keys[i].getLevelOfDetail() < _maxLevel)
         {
-            TileKey k = key.createChildKey(i);
-            processKey( k );
+            std::vector<TileKey> children;
+            for (unsigned int c = 0; c < 4; c++)
+            {
+                children.push_back(keys[i].createChildKey(c));
+            }
+            processKeys( children );
         }
     }
 }
@@ -214,13 +246,19 @@ void TileVisitor::incrementProgress(unsigned int amount)
 
 bool TileVisitor::handleTile( const TileKey& key )
 {
-    bool result = false;
-    if (_tileHandler.valid() )
+    std::vector<bool> result = handleTiles(std::vector<TileKey>{ key });
+    return !result.empty() && result.front();
+}
+
+std::vector<bool> TileVisitor::handleTiles( const std::vector<TileKey>& keys )
+{
+    std::vector<bool> result(keys.size(), false);
+    if (_tileHandler.valid())
     {
-        result = _tileHandler->handleTile( key, *this );
+        result = _tileHandler->handleTiles( keys, *this );
     }
 
-    incrementProgress(1);
+    incrementProgress(keys.size());
 
     return result;
 }
@@ -229,19 +267,217 @@ bool TileVisitor::handleTile( const TileKey& key )
 
 /*****************************************************************************************/
 
+#define LC "[MultithreadedTileVisitor] "
+
+namespace
+{
+    // Fixed-capacity FIFO between pipeline stages. push blocks while the
+    // queue is full, so a fast stage cannot run away from a slow one; pop
+    // blocks while it is empty and returns false once it is closed and drained.
+    template<typename T>
+    class BoundedQueue
+    {
+    public:
+        BoundedQueue(unsigned capacity) : _capacity(std::max(capacity, 1u)) { }
+
+        void push(T&& value)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notFull.wait(lock, [this]() { return _queue.size() < _capacity; });
+            _queue.emplace_back(std::move(value));
+            _notEmpty.notify_one();
+        }
+
+        bool pop(T& value)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notEmpty.wait(lock, [this]() { return !_queue.empty() || _closed; });
+            if (_queue.empty())
+                return false;
+            value = std::move(_queue.front());
+            _queue.pop_front();
+            _notFull.notify_one();
+            return true;
+        }
+
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+            _notEmpty.notify_all();
+        }
+
+        unsigned size() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _queue.size();
+        }
+
+    private:
+        const unsigned _capacity;
+        std::deque<T> _queue;
+        bool _closed = false;
+        mutable std::mutex _mutex;
+        std::condition_variable _notFull;
+        std::condition_variable _notEmpty;
+    };
+
+    // A set of sibling tiles moving through the pipeline
+    struct Batch
+    {
+        std::uint64_t index = 0;
+        std::vector<TileKey> keys;
+        std::vector<TileHandler::TileData> data;
+    };
+
+    // Throughput counters for one pipeline stage
+    struct Stage
+    {
+        Stage(const char* name_, unsigned threads_) : name(name_), threads(threads_) { }
+
+        const char* name;
+        unsigned threads;
+        std::atomic<std::uint64_t> tiles = { 0 };
+        std::atomic<std::uint64_t> busyMicros = { 0 };
+
+        void add(std::size_t count, std::chrono::steady_clock::time_point start)
+        {
+            tiles += count;
+            busyMicros += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+        void report(std::ostream& out, double seconds) const
+        {
+            double busy = seconds > 0.0 ? 1e-4 * (double)busyMicros / (seconds * (double)threads) : 0.0;
+            out << name << ": " << tiles << " tiles, "
+                << std::fixed << std::setprecision(1)
+                << (seconds > 0.0 ? (double)tiles / seconds : 0.0) << "/s, "
+                << busy << "% busy";
+        }
+    };
+
+    // How far a run has gotten: every set of siblings before "batches" is
+    // done, and "last" is the first key of the last of them.
+    struct Checkpoint
+    {
+        std::uint64_t batches = 0;
+        TileKey last;
+    };
+
+    // Checkpoint file format: the batch count on the first line, then
+    // the last key as "lod, x, y" (like a TaskList).
+    bool readCheckpoint(const std::string& filename, const Profile* profile, Checkpoint& out)
+    {
+        std::ifstream in(filename.c_str(), std::ios::in);
+        std::string line;
+        if (!getline(in, line))
+            return false;
+        out.batches = as<unsigned long long>(line, 0ull);
+
+        if (out.batches > 0)
+        {
+            if (!getline(in, line))
+                return false;
+
+            std::vector<std::string> parts;
+            StringTokenizer(line, parts, ",");
+            if (parts.size() < 3)
+                return false;
+
+            out.last = TileKey(
+                as<unsigned int>(parts[0], 0u),
+                as<unsigned int>(parts[1], 0u),
+                as<unsigned int>(parts[2], 0u),
+                profile);
+        }
+        return true;
+    }
+
+    // Writes to a temporary file first so a crash never leaves a partial checkpoint.
+    void writeCheckpoint(const std::string& filename, const Checkpoint& checkpoint)
+    {
+        std::string temp = filename + ".tmp";
+        {
+            std::ofstream out(temp.c_str());
+            out << checkpoint.batches << std::endl;
+            if (checkpoint.last.valid())
+            {
+                out << checkpoint.last.getLevelOfDetail() << ", "
+                    << checkpoint.last.getTileX() << ", "
+                    << checkpoint.last.getTileY() << std::endl;
+            }
+            if (!out)
+            {
+                OE_WARN << LC << "Failed to write checkpoint " << temp << std::endl;
+                return;
+            }
+        }
+        std::remove(filename.c_str());
+        if (std::rename(temp.c_str(), filename.c_str()) != 0)
+        {
+            OE_WARN << LC << "Failed to write checkpoint " << filename << std::endl;
+        }
+    }
+
+    // The Hilbert curve as a quadtree walk: for each of the four orientations
+    // of the curve, the order in which to visit the child quadrants (numbered
+    // as in TileKey::createChildKey) and the orientation of each child.
+    const unsigned hilbertOrder[4][4] = { {0,2,3,1}, {0,1,3,2}, {3,1,0,2}, {3,2,0,1} };
+    const unsigned hilbertNext[4][4]  = { {1,0,0,3}, {0,1,1,2}, {3,2,2,1}, {2,3,3,0} };
+
+    // Calls emit(siblings) for each set of sibling keys at "level" under "key",
+    // in Hilbert order, skipping the subtrees that the visitor rules out.
+    // Returns false if emit asked to stop.
+    template<typename EMIT>
+    bool visitLevel(TileVisitor& tv, const TileKey& key, unsigned level, unsigned orientation, const EMIT& emit)
+    {
+        if (!tv.intersects(key.getExtent()) || !tv.hasData(key))
+            return true;
+
+        if (key.getLevelOfDetail() + 1 == level)
+        {
+            std::vector<TileKey> siblings;
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                TileKey child = key.createChildKey(hilbertOrder[orientation][i]);
+                if (tv.intersects(child.getExtent()) && tv.hasData(child))
+                    siblings.push_back(child);
+            }
+            return siblings.empty() || emit(siblings);
+        }
+
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            TileKey child = key.createChildKey(hilbertOrder[orientation][i]);
+            if (!visitLevel(tv, child, level, hilbertNext[orientation][i], emit))
+                return false;
+        }
+        return true;
+    }
+}
+
 MultithreadedTileVisitor::MultithreadedTileVisitor() :
-    _numThreads(std::max(1u, std::thread::hardware_concurrency()))
+    _numThreads(std::max(1u, std::thread::hardware_concurrency())),
+    _numWriteThreads(1u),
+    _checkpointInterval(30.0),
+    _resume(false),
+    _shardIndex(0u),
+    _shardCount(1u)
 {
     // We must do this to avoid an error message in OpenSceneGraph b/c the findWrapper method doesn't appear to be threadsafe.
     // This really isn't a big deal b/c this only effects data that is already cached.
     osgDB::ObjectWrapper* wrapper = osgDB::Registry::instance()->getObjectWrapperManager()->findWrapper("osg::Image");
-
-    _group = jobs::jobgroup::create();
 }
 
 MultithreadedTileVisitor::MultithreadedTileVisitor(TileHandler* handler) :
     TileVisitor(handler),
-    _numThreads(std::max(1u, std::thread::hardware_concurrency()))
+    _numThreads(std::max(1u, std::thread::hardware_concurrency())),
+    _numWriteThreads(1u),
+    _checkpointInterval(30.0),
+    _resume(false),
+    _shardIndex(0u),
+    _shardCount(1u)
 {
 }
 
@@ -255,50 +491,265 @@ void MultithreadedTileVisitor::setNumThreads( unsigned int numThreads)
     _numThreads = numThreads;
 }
 
+void MultithreadedTileVisitor::setShard(unsigned int index, unsigned int count)
+{
+    _shardCount = std::max(count, 1u);
+    _shardIndex = std::min(index, _shardCount - 1);
+}
+
 #define MTTV "oe.mttilevisitor"
+#define MTTV_WRITE "oe.mttilevisitor.write"
 
 void MultithreadedTileVisitor::run(const Profile* mapProfile)
 {
-    // Start up the task service
-    OE_DEBUG << "Starting " << _numThreads << " threads " << std::endl;
+    _profile = mapProfile;
+
+    // Reset the progress in case this visitor has been ran before.
+    resetProgress();
 
-    jobs::get_pool(MTTV)->set_concurrency(_numThreads);
+    estimate();
 
-    // Produce the tiles
-    TileVisitor::run( mapProfile );
+    if (!_tileHandler.valid())
+        return;
 
-    _group->join();
-}
+    const unsigned numReaders = std::max(1u, _numThreads);
+    const unsigned numWriters = std::max(1u, _numWriteThreads);
 
-bool MultithreadedTileVisitor::handleTile(const TileKey& key)
-{
-    // atomically increment the task count
-    //_numTiles++;
+    OE_DEBUG << LC << "Starting " << numReaders << " read threads and " << numWriters << " write threads" << std::endl;
+
+    jobs::get_pool(MTTV)->set_concurrency(numReaders);
+    jobs::get_pool(MTTV_WRITE)->set_concurrency(numWriters);
+
+    auto canceled = [this]()
+    {
+        return _progress.valid() && _progress->isCanceled();
+    };
+
+    BoundedQueue<Batch> readQueue(2 * numReaders);
+    BoundedQueue<Batch> writeQueue(4 * numReaders);
+
+    Stage read("read", numReaders);
+    Stage write("write", numWriters);
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto report = [&](std::ostream& out)
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        read.report(out, seconds);
+        out << "; ";
+        write.report(out, seconds);
+        out << "; queued " << readQueue.size() << " / " << writeQueue.size();
+    };
+
+    // Batches finish out of order, so track the ones that finished past
+    // the first gap; the checkpoint only ever covers a gap-free prefix.
+    std::mutex completionMutex;
+    Checkpoint checkpoint;
+    std::map<std::uint64_t, TileKey> finished;
+    auto lastCheckpoint = start;
+
+    auto complete = [&](std::uint64_t index, const TileKey& firstKey)
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+
+        finished[index] = firstKey;
+        while (!finished.empty() && finished.begin()->first == checkpoint.batches)
+        {
+            checkpoint.last = finished.begin()->second;
+            ++checkpoint.batches;
+            finished.erase(finished.begin());
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - lastCheckpoint).count() >= _checkpointInterval)
+        {
+            lastCheckpoint = now;
+
+            if (!_checkpointFile.empty())
+                writeCheckpoint(_checkpointFile, checkpoint);
+
+            std::stringstream buf;
+            report(buf);
+            OE_INFO << LC << buf.str() << std::endl;
+        }
+    };
+
+    auto readWork = [&]()
+    {
+        Batch batch;
+        while (readQueue.pop(batch))
+        {
+            if (canceled())
+                continue;
+
+            auto t0 = std::chrono::steady_clock::now();
+            batch.data = _tileHandler->readTiles(batch.keys, *this);
+            batch.data.resize(batch.keys.size());
+            read.add(batch.keys.size(), t0);
+
+            writeQueue.push(std::move(batch));
+        }
+    };
+
+    auto writeWork = [&]()
+    {
+        Batch batch;
+        while (writeQueue.pop(batch))
+        {
+            if (canceled())
+                continue;
+
+            auto t0 = std::chrono::steady_clock::now();
+            _tileHandler->writeTiles(batch.keys, batch.data, *this);
+            write.add(batch.keys.size(), t0);
 
-    // don't let the task queue get too large...?
-    while(jobs::get_metrics()->total_pending() > 1000)
+            incrementProgress(batch.keys.size());
+            complete(batch.index, batch.keys.front());
+        }
+    };
+
+    auto readers = jobs::jobgroup::create();
+    for (unsigned i = 0; i < numReaders; ++i)
+    {
+        jobs::context job;
+        job.name = "readTiles";
+        job.pool = jobs::get_pool(MTTV);
+        job.group = readers;
+        jobs::dispatch(readWork, job);
+    }
+
+    auto writers = jobs::jobgroup::create();
+    for (unsigned i = 0; i < numWriters; ++i)
     {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        jobs::context job;
+        job.name = "writeTiles";
+        job.pool = jobs::get_pool(MTTV_WRITE);
+        job.group = writers;
+        jobs::dispatch(writeWork, job);
     }
 
-    // Add the tile to the task queue.
-    auto task = [this, key]()
+    // Shards take turns at runs of this many sets of siblings
+    const std::uint64_t shardRunLength = 16u;
+
+    // Produces the batches level by level, skipping the first "skip" of them.
+    // Returns false if the batch at the skip point is not the one expected,
+    // in which case nothing has been queued.
+    auto produce = [&](std::uint64_t skip, const TileKey& expected)
     {
-        if ((_tileHandler.valid()) && (!_progress.valid() || !_progress->isCanceled()))
+        std::uint64_t index = 0;
+        unsigned skippedTiles = 0;
+        bool mismatch = false;
+        bool emitted = false;
+
+        auto emit = [&](const std::vector<TileKey>& keys)
         {
-            _tileHandler->handleTile(key, *this);
-            this->incrementProgress(1);
+            emitted = true;
+
+            if (index < skip)
+            {
+                skippedTiles += keys.size();
+                if (++index == skip)
+                {
+                    if (keys.front() != expected)
+                    {
+                        mismatch = true;
+                        return false;
+                    }
+                    incrementProgress(skippedTiles);
+                }
+                return true;
+            }
+
+            if (canceled())
+                return false;
+
+            // Another shard's tiles count as done here.
+            if ((index / shardRunLength) % _shardCount != _shardIndex)
+            {
+                incrementProgress(keys.size());
+                complete(index++, keys.front());
+                return true;
+            }
+
+            Batch batch;
+            batch.index = index++;
+            batch.keys = keys;
+            readQueue.push(std::move(batch));
+            return true;
+        };
+
+        std::vector<TileKey> roots;
+        mapProfile->getRootKeys(roots);
+
+        bool keepGoing = true;
+        for (unsigned level = _minLevel; level <= _maxLevel && keepGoing; ++level)
+        {
+            emitted = false;
+
+            if (level == 0)
+            {
+                std::vector<TileKey> keys;
+                for (auto& root : roots)
+                {
+                    if (intersects(root.getExtent()) && hasData(root))
+                        keys.push_back(root);
+                }
+                keepGoing = keys.empty() || emit(keys);
+            }
+            else
+            {
+                for (unsigned i = 0; i < roots.size() && keepGoing; ++i)
+                {
+                    keepGoing = visitLevel(*this, roots[i], level, 0, emit);
+                }
+            }
+
+            // nothing at this level means nothing deeper either
+            if (!emitted)
+                break;
         }
+
+        return !mismatch && index >= skip;
     };
 
-    jobs::context job;
-    job.name = "handleTile";
-    job.pool = jobs::get_pool(MTTV);
-    job.group = _group;
+    Checkpoint resumeFrom;
+    if (_resume && !_checkpointFile.empty())
+    {
+        if (readCheckpoint(_checkpointFile, mapProfile, resumeFrom))
+        {
+            OE_NOTICE << LC << "Resuming after " << resumeFrom.batches << " completed tile sets" << std::endl;
+        }
+        else
+        {
+            OE_WARN << LC << "No checkpoint in " << _checkpointFile << "; starting from the beginning" << std::endl;
+        }
+    }
 
-    jobs::dispatch(task, job);
+    // Batch indices pick up where the checkpoint left off
+    checkpoint = resumeFrom;
 
-    return true;
+    if (!produce(resumeFrom.batches, resumeFrom.last))
+    {
+        OE_WARN << LC << "Checkpoint " << _checkpointFile << " does not match this run; starting from the beginning" << std::endl;
+        checkpoint = Checkpoint();
+        produce(0u, TileKey::INVALID);
+    }
+
+    readQueue.close();
+    readers->join();
+
+    writeQueue.close();
+    writers->join();
+
+    if (!_checkpointFile.empty())
+    {
+        writeCheckpoint(_checkpointFile, checkpoint);
+    }
+
+    std::stringstream buf;
+    report(buf);
+    OE_NOTICE << LC << buf.str() << std::endl;
 }
 
 /*****************************************************************************************/
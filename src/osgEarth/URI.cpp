@@ -727,6 +727,80 @@ URI::readImage(const osgDB::Options* dbOptions,
     return doRead<ReadImage>( *this, dbOptions, progress );
 }
 
+Future<ReadResult>
+URI::readImageAsync(const osgDB::Options* dbOptions,
+                    ProgressCallback*     progress ) const
+{
+    const osgDB::Options* options = dbOptions ? dbOptions : Registry::instance()->getDefaultOptions();
+
+    // Only a plain remote read can skip doRead(); anything that hooks into
+    // it (callbacks, aliases, the result cache) runs the blocking read in a job.
+    bool direct =
+        !empty() &&
+        isRemote() &&
+        !optionString().isSet() &&
+        Registry::instance()->getURIReadCallback() == nullptr &&
+        URIAliasMap::from(options) == nullptr &&
+        URIResultCache::from(options) == nullptr &&
+        URIPostReadCallback::from(dbOptions) == nullptr;
+
+    if (!direct)
+    {
+        URI uri = *this;
+        osg::ref_ptr<const osgDB::Options> options_ref(dbOptions);
+        osg::ref_ptr<ProgressCallback> progress_ref(progress);
+
+        return jobs::dispatch([uri, options_ref, progress_ref](Cancelable&)
+            {
+                return uri.readImage(options_ref.get(), progress_ref.get());
+            },
+            jobs::context{ full(), jobs::get_pool("oe.uri") });
+    }
+
+    if (osgEarth::Registry::instance()->isBlacklisted(full()))
+    {
+        Future<ReadResult> result;
+        result.resolve(ReadResult());
+        return result;
+    }
+
+    osg::ref_ptr<osgDB::Options> remoteOptions = Registry::cloneOrCreateOptions(options);
+    URIContext(full()).store(remoteOptions.get());
+    remoteOptions->getDatabasePathList().push_front(osgDB::getFilePath(full()));
+
+    HTTPRequest req(full());
+    req.getHeaders() = context().getHeaders();
+
+    unsigned long handle = NetworkMonitor::begin(full(), "pending", "URI");
+
+    URI uri = *this;
+
+    // same finishing steps doRead() applies to a remote image
+    auto postProcess = [uri, remoteOptions, handle](ReadResult& result)
+    {
+        if (result.getImage())
+            result.getImage()->setFileName(uri.full());
+
+        result = ReadImage().postProcess(result, remoteOptions.get());
+
+        if (result.getObject())
+            result.getObject()->setName(uri.base());
+
+        if (result.failed() && result.code() == ReadResult::RESULT_NOT_FOUND)
+            osgEarth::Registry::instance()->blacklist(uri.full());
+
+        std::stringstream buf;
+        buf << result.getResultCodeString();
+        if (result.isFromCache() && result.succeeded())
+        {
+            buf << " (from cache)";
+        }
+        NetworkMonitor::end(handle, buf.str());
+    };
+
+    return HTTPClient::readImageAsync(req, remoteOptions.get(), progress, postProcess);
+}
+
 ReadResult
 URI::readString(const osgDB::Options* dbOptions,
                 ProgressCallback*     progress ) const
@@ -0,0 +1,344 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+ * Copyright 2020 Pelican Mapping
+ * http://osgearth.org
+ *
+ * osgEarth is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include <osgEarth/Viewshed>
+#include <osgEarth/Map>
+#include <osgEarth/ElevationPool>
+#include <osgEarth/Threading>
+#include <osgEarth/Metrics>
+#include <limits>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+#define LC "[Viewshed] "
+
+namespace
+{
+    // Grids smaller than this many cells run on the calling thread only
+    const std::uint64_t MIN_CELLS_TO_SPLIT = 256 * 256;
+
+    // round(a / b) with halves rounded up, for b > 0
+    inline int roundDiv(long long a, long long b)
+    {
+        long long n = 2 * a + b, d = 2 * b;
+        return (int)(n >= 0 ? n / d : -((-n + d - 1) / d));
+    }
+}
+
+Viewshed::Viewshed(const Map* map) :
+    _map(map),
+    _cellSize(30.0, Units::METERS),
+    _targetHeight(0.0),
+    _refraction(0.13)
+{
+    //nop
+}
+
+GeoImage
+Viewshed::compute(const GeoPoint& observer, const Distance& radius, ProgressCallback* progress) const
+{
+    OE_PROFILING_ZONE;
+
+    osg::ref_ptr<const Map> map;
+    if (_map.lock(map) == false || map->getProfile() == nullptr)
+        return GeoImage::INVALID;
+
+    ElevationPool* pool = map->getElevationPool();
+    const SpatialReference* srs = map->getSRS();
+
+    GeoPoint center = observer.transform(srs);
+    OE_SOFT_ASSERT_AND_RETURN(center.isValid(), GeoImage::INVALID);
+
+    const double earthRadius = srs->getEllipsoid().getSemiMajorAxis();
+    const double cellSize = osg::maximum(_cellSize.as(Units::METERS), 0.01);
+    const double radiusInCells = radius.as(Units::METERS) / cellSize;
+
+    // All size and index math below is in std::size_t; this check keeps
+    // the grid (and the int radius) well within range.
+    const double maxRadiusInCells = (std::sqrt((double)MAX_CELLS) - 1.0) / 2.0;
+    if (!(radiusInCells <= maxRadiusInCells))
+    {
+        OE_WARN << LC << "Radius of " << radiusInCells << " cells exceeds the limit of "
+            << (int)maxRadiusInCells << "; increase the cell size" << std::endl;
+        return GeoImage::INVALID;
+    }
+
+    const int r = osg::maximum((int)std::ceil(radiusInCells), 1);
+    const std::size_t n = 2 * (std::size_t)r + 1;
+
+    // each pass below splits across a job pool once the grid is big enough
+    jobs::jobpool* jobPool = (std::uint64_t)n * n >= MIN_CELLS_TO_SPLIT ?
+        jobs::get_pool("oe.viewshed") : nullptr;
+
+    // Cells are square on the ground at the observer.
+    double dx, dy;
+    if (srs->isGeographic())
+    {
+        dy = osg::RadiansToDegrees(cellSize / earthRadius);
+        dx = dy / osg::maximum(cos(osg::DegreesToRadians(center.y())), 0.01);
+    }
+    else
+    {
+        dx = dy = Distance(cellSize, Units::METERS).as(srs->getUnits());
+    }
+
+    // Sample the terrain, one row (south to north) at a time.
+    std::vector<float> elevation(n * n);
+    std::atomic_bool canceled = { false };
+
+    jobs::parallel_for(jobPool, n, 16, [&](unsigned begin, unsigned end)
+        {
+            std::vector<osg::Vec3d> points(n);
+            for (unsigned row = begin; row < end && !canceled; ++row)
+            {
+                double y = center.y() + (double)((int)row - r) * dy;
+                for (unsigned col = 0; col < n; ++col)
+                    points[col].set(center.x() + (double)((int)col - r) * dx, y, 0.0);
+
+                if (pool->sampleMapCoords(points.begin(), points.end(), _cellSize, nullptr, progress) < 0 &&
+                    progress && progress->isCanceled())
+                {
+                    canceled = true;
+                    return;
+                }
+
+                float* out = &elevation[(std::size_t)row * n];
+                for (unsigned col = 0; col < n; ++col)
+                    out[col] = points[col].z() != NO_DATA_VALUE ? (float)points[col].z() : 0.0f;
+            }
+        });
+
+    if (canceled)
+        return GeoImage::INVALID;
+
+    const double eye =
+        center.altitudeMode() == ALTMODE_ABSOLUTE ? center.z() :
+        (double)elevation[(std::size_t)r * n + r] + center.z();
+
+    // Replace each elevation with its height relative to the eye,
+    // dropped by the curvature of the earth.
+    const double curvature = (1.0 - _refraction) / (2.0 * earthRadius);
+
+    jobs::parallel_for(jobPool, n, 64, [&](unsigned begin, unsigned end)
+        {
+            for (unsigned row = begin; row < end; ++row)
+            {
+                double y = (double)((int)row - r) * cellSize;
+                float* h = &elevation[(std::size_t)row * n];
+                for (unsigned col = 0; col < n; ++col)
+                {
+                    double x = (double)((int)col - r) * cellSize;
+                    h[col] = (float)((double)h[col] - eye - curvature * (x * x + y * y));
+                }
+            }
+        });
+
+    osg::ref_ptr<osg::Image> image = new osg::Image();
+    image->allocateImage((int)n, (int)n, 1, GL_RED, GL_UNSIGNED_BYTE);
+    image->setInternalTextureFormat(GL_R8);
+    unsigned char* visibility = image->data();
+    visibility[(std::size_t)r * n + r] = VISIBLE;
+
+    // Radial sweep (R2). Each quadrant is swept by 2r rays cast from the
+    // observer to the cells along its edge. Each ray carries the steepest
+    // slope to the terrain seen so far, interpolated where it passes
+    // between cells, and decides the visibility of the cells it passes
+    // closest to. Every cell belongs to exactly one ray, so the rays can run
+    // in parallel without sharing any output.
+    //
+    // A quadrant is given in (u, v) with u > 0 pointing away from the
+    // observer and -u < v <= u; these map to the grid by rotation.
+    const int raysPerQuadrant = 2 * r;
+    const double maxDistance2 = radiusInCells * radiusInCells;
+    const double targetHeight = _targetHeight;
+
+    jobs::parallel_for(jobPool, 4 * raysPerQuadrant, 64, [&](unsigned begin, unsigned end)
+        {
+            if (progress && progress->isCanceled())
+            {
+                canceled = true;
+                return;
+            }
+
+            for (unsigned ray = begin; ray < end; ++ray)
+            {
+                const int quadrant = (int)ray / raysPerQuadrant;
+                const int j = (int)ray % raysPerQuadrant - r + 1; // (-r, r]
+
+                auto index = [&](int u, int v)
+                {
+                    int x, y;
+                    switch (quadrant) {
+                    case 0:  x = u;  y = v;  break;
+                    case 1:  x = -v; y = u;  break;
+                    case 2:  x = -u; y = -v; break;
+                    default: x = v;  y = -u; break;
+                    }
+                    return (std::size_t)(y + r) * n + (std::size_t)(x + r);
+                };
+
+                double horizon = -std::numeric_limits<double>::infinity();
+
+                for (int u = 1; u <= r; ++u)
+                {
+                    // the cell this ray passes closest to, if no other ray does
+                    int v = roundDiv((long long)j * u, r);
+                    if (v > -u && v <= u && roundDiv((long long)v * r, u) == j)
+                    {
+                        double d2 = (double)u * u + (double)v * v;
+                        std::size_t i = index(u, v);
+                        if (d2 > maxDistance2)
+                        {
+                            visibility[i] = OUT_OF_RANGE;
+                        }
+                        else
+                        {
+                            double slope = ((double)elevation[i] + targetHeight) / (sqrt(d2) * cellSize);
+                            visibility[i] = slope >= horizon ? VISIBLE : HIDDEN;
+                        }
+                    }
+
+                    // terrain under the ray at this step
+                    double vf = (double)j * u / (double)r;
+                    int v0 = (int)std::floor(vf);
+                    double t = vf - (double)v0;
+                    double h = elevation[index(u, v0)];
+                    if (t > 0.0)
+                        h += t * ((double)elevation[index(u, v0 + 1)] - h);
+
+                    double slope = h / (sqrt((double)u * u + vf * vf) * cellSize);
+                    horizon = osg::maximum(horizon, slope);
+                }
+            }
+        });
+
+    if (canceled)
+        return GeoImage::INVALID;
+
+    GeoExtent extent(
+        srs,
+        center.x() - ((double)r + 0.5) * dx,
+        center.y() - ((double)r + 0.5) * dy,
+        center.x() + ((double)r + 0.5) * dx,
+        center.y() + ((double)r + 0.5) * dy);
+
+    return GeoImage(image.get(), extent);
+}
+
+bool
+Viewshed::toWorld(const GeoPoint& point, osg::Vec3d& out_world) const
+{
+    osg::ref_ptr<const Map> map;
+    if (_map.lock(map) == false || map->getProfile() == nullptr)
+        return false;
+
+    GeoPoint p = point.transform(map->getSRS());
+    if (!p.isValid())
+        return false;
+
+    if (p.altitudeMode() == ALTMODE_RELATIVE)
+    {
+        ElevationSample sample = map->getElevationPool()->getSample(p, _cellSize, nullptr, nullptr);
+        if (sample.hasData())
+            p.z() += sample.elevation().as(Units::METERS);
+        p.altitudeMode() = ALTMODE_ABSOLUTE;
+    }
+
+    return p.toWorld(out_world);
+}
+
+bool
+Viewshed::intersect(std::vector<Ray>& rays, ProgressCallback* progress) const
+{
+    OE_PROFILING_ZONE;
+
+    osg::ref_ptr<const Map> map;
+    if (_map.lock(map) == false || map->getProfile() == nullptr)
+        return false;
+
+    ElevationPool* pool = map->getElevationPool();
+    const SpatialReference* srs = map->getSRS();
+    const double cellSize = osg::maximum(_cellSize.as(Units::METERS), 0.01);
+
+    std::atomic_bool canceled = { false };
+
+    // sampling dominates, so split even a modest number of rays
+    jobs::jobpool* jobPool = rays.size() >= 64u ? jobs::get_pool("oe.viewshed") : nullptr;
+
+    jobs::parallel_for(jobPool, rays.size(), 4, [&](unsigned begin, unsigned end)
+        {
+            std::vector<osg::Vec3d> points;
+            std::vector<double> heights;
+
+            for (unsigned i = begin; i < end && !canceled; ++i)
+            {
+                Ray& ray = rays[i];
+                ray.hasLOS = true;
+
+                osg::Vec3d delta = ray.end - ray.start;
+                double length = delta.length();
+                if (length <= 0.0)
+                    continue;
+
+                // at least 64 samples, and never more than a cell apart
+                double step = osg::minimum(cellSize, length / 64.0);
+                unsigned numSamples = (unsigned)std::ceil(length / step);
+
+                points.resize(numSamples);
+                heights.resize(numSamples);
+                for (unsigned k = 0; k < numSamples; ++k)
+                {
+                    double t = (double)(k + 1) / (double)numSamples;
+                    srs->transformFromWorld(ray.start + delta * t, points[k]);
+                    heights[k] = points[k].z();
+                }
+
+                if (pool->sampleMapCoords(points.begin(), points.end(), Distance(step, Units::METERS), nullptr, progress) < 0)
+                {
+                    if (progress && progress->isCanceled())
+                        canceled = true;
+                    continue;
+                }
+
+                // first sample under the terrain, interpolated back to
+                // where the ray crossed it
+                double prevT = 0.0, prevAbove = -1.0;
+                for (unsigned k = 0; k < numSamples; ++k)
+                {
+                    if (points[k].z() == NO_DATA_VALUE)
+                        continue;
+
+                    double t = (double)(k + 1) / (double)numSamples;
+                    double above = heights[k] - points[k].z();
+                    if (above < -0.01)
+                    {
+                        if (prevAbove >= 0.0)
+                            t = prevT + (t - prevT) * prevAbove / (prevAbove - above);
+                        ray.hasLOS = false;
+                        ray.hit = ray.start + delta * t;
+                        break;
+                    }
+                    prevT = t;
+                    prevAbove = above;
+                }
+            }
+        });
+
+    return !canceled;
+}
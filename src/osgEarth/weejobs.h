@@ -9,9 +9,11 @@
 #include <cfloat>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <type_traits>
@@ -474,12 +476,24 @@ namespace WEEJOBS_NAMESPACE
         {
             context ctx;
             std::function<bool()> _delegate;
+            float _priority = 0.0f; // last evaluated value of ctx.priority()
+            std::uint64_t _seq = 0u; // dispatch order, breaks ties FIFO
 
-            bool operator < (const job& rhs) const
+            //! Re-evaluates and caches the priority function, if there is one.
+            inline void update_priority()
             {
-                float lp = ctx.priority ? ctx.priority() : -FLT_MAX;
-                float rp = rhs.ctx.priority ? rhs.ctx.priority() : -FLT_MAX;
-                return lp < rp;
+                _priority = ctx.priority ? ctx.priority() : 0.0f;
+            }
+        };
+
+        // Heap ordering for the job queue: the job at the top of the heap has the
+        // highest cached priority; equal priorities run in dispatch order.
+        struct job_heap_order
+        {
+            bool operator()(const job& lhs, const job& rhs) const
+            {
+                return lhs._priority < rhs._priority ||
+                    (lhs._priority == rhs._priority && lhs._seq > rhs._seq);
             }
         };
 
@@ -549,12 +563,32 @@ namespace WEEJOBS_NAMESPACE
             _can_steal_work = value;
         }
 
+        //! Minimum time between re-evaluations of queued jobs' priority
+        //! functions. Priorities are sampled once when a job is dispatched
+        //! and then refreshed for the whole queue at most this often, so
+        //! dequeuing does not call every priority function every time.
+        //! A value of zero refreshes on every dequeue. Default = 16ms.
+        void set_priority_refresh_interval(std::chrono::steady_clock::duration value)
+        {
+            std::lock_guard<std::mutex> lock(_queue_mutex);
+            _priority_refresh_interval = value;
+        }
+
+        //! Forces the next dequeue to re-evaluate all queued job priorities.
+        //! Call this once per frame if priorities depend on the camera.
+        void reprioritize()
+        {
+            std::lock_guard<std::mutex> lock(_queue_mutex);
+            _priority_refresh_due = {};
+        }
+
         //! Discard all queued jobs
         void cancel_all()
         {
             std::lock_guard<std::mutex> lock(_queue_mutex);
             _queue.clear();
             _queue_size = 0;
+            _num_prioritized = 0;
             _metrics.canceled += _metrics.pending;
             _metrics.pending = 0;
         }
@@ -575,9 +609,17 @@ namespace WEEJOBS_NAMESPACE
 
                 if (_target_concurrency > 0)
                 {
+                    detail::job new_job{ context, delegate };
+                    new_job.update_priority(); // outside the lock
+
                     std::lock_guard<std::mutex> lock(_queue_mutex);
 
-                    _queue.emplace_back(detail::job{ context, delegate });
+                    new_job._seq = _next_seq++;
+                    if (new_job.ctx.priority)
+                        _num_prioritized++;
+
+                    _queue.emplace_back(std::move(new_job));
+                    std::push_heap(_queue.begin(), _queue.end(), detail::job_heap_order());
                     _queue_size++;
 
                     _metrics.pending++;
@@ -609,26 +651,32 @@ namespace WEEJOBS_NAMESPACE
             }
             else if (!_done && _queue_size > 0)
             {
-                auto ptr = _queue.end();
-                float highest_priority = -FLT_MAX;
-                for (auto iter = _queue.begin(); iter != _queue.end(); ++iter)
+                // Priorities are dynamic, so periodically re-sample them all
+                // and rebuild the heap. In between, dequeue is O(log n).
+                if (_num_prioritized > 0)
                 {
-                    float priority = iter->ctx.priority != nullptr ?
-                        iter->ctx.priority() :
-                        0.0f;
-
-                    if (ptr == _queue.end() || priority > highest_priority)
+                    auto now = std::chrono::steady_clock::now();
+                    if (now >= _priority_refresh_due)
                     {
-                        ptr = iter;
-                        highest_priority = priority;
+                        for (auto& queued : _queue)
+                            queued.update_priority();
+
+                        std::make_heap(_queue.begin(), _queue.end(), detail::job_heap_order());
+
+                        // with a very large queue the refresh itself is expensive,
+                        // so never let it take more than a fraction of the time.
+                        auto end = std::chrono::steady_clock::now();
+                        _priority_refresh_due = end + std::max(_priority_refresh_interval, 4 * (end - now));
                     }
                 }
 
-                if (ptr == _queue.end())
-                    ptr = _queue.begin();
+                std::pop_heap(_queue.begin(), _queue.end(), detail::job_heap_order());
+                output = std::move(_queue.back());
+                _queue.pop_back();
+
+                if (output.ctx.priority)
+                    _num_prioritized--;
 
-                output = std::move(*ptr);
-                _queue.erase(ptr);
                 _queue_size--;
                 _metrics.pending--;
                 return true;
@@ -659,8 +707,12 @@ namespace WEEJOBS_NAMESPACE
         inline void join_threads();
 
         bool _can_steal_work = true;
-        std::list<detail::job> _queue;
-        std::atomic_int _queue_size = { 0 }; // don't use list::size(), it's slow and not atomic
+        std::vector<detail::job> _queue; // binary heap, see detail::job_heap_order
+        std::atomic_int _queue_size = { 0 }; // readable without locking the queue
+        std::uint64_t _next_seq = 0u; // dispatch counter for FIFO tie-breaking
+        std::size_t _num_prioritized = 0u; // queued jobs with a priority function
+        std::chrono::steady_clock::time_point _priority_refresh_due; // next priority re-evaluation
+        std::chrono::steady_clock::duration _priority_refresh_interval = std::chrono::milliseconds(16);
         mutable std::mutex _queue_mutex; // protect access to the queue
         mutable std::mutex _quit_mutex; // protects access to _done
         std::atomic<unsigned> _target_concurrency; // target number of concurrent threads in the pool
@@ -829,6 +881,65 @@ namespace WEEJOBS_NAMESPACE
         return promise;
     }
 
+    //! Runs func(begin, end) over the range [0, count) in chunks of "grain"
+    //! items, sharing the chunks between the calling thread and up to
+    //! pool->concurrency() helper jobs. The calling thread works too, so this
+    //! never waits on an idle pool; it returns once every chunk is done.
+    //! Helpers that start after the work runs out never touch func, so func
+    //! may safely capture the caller's stack by reference.
+    //! @param pool Pool for the helper jobs; nullptr runs everything on the calling thread
+    //! @param count Number of items
+    //! @param grain Number of items in each chunk
+    //! @param func Function to run for each chunk. Prototype is void(std::size_t, std::size_t)
+    template<typename F>
+    inline void parallel_for(jobpool* pool, std::size_t count, std::size_t grain, const F& func)
+    {
+        if (count == 0)
+            return;
+
+        grain = std::max(grain, (std::size_t)1);
+        const std::size_t num_chunks = (count + grain - 1) / grain;
+
+        if (pool == nullptr || num_chunks == 1)
+        {
+            func((std::size_t)0, count);
+            return;
+        }
+
+        struct state_t {
+            std::atomic<std::size_t> next = { 0 };
+            std::atomic<std::size_t> done = { 0 };
+            detail::event finished;
+        };
+        auto state = std::make_shared<state_t>();
+
+        auto work = [state, &func, count, grain, num_chunks]()
+        {
+            std::size_t chunk;
+            while ((chunk = state->next++) < num_chunks)
+            {
+                func(chunk * grain, std::min((chunk + 1) * grain, count));
+
+                if (++state->done == num_chunks)
+                    state->finished.set();
+            }
+        };
+
+        std::size_t num_helpers = std::min((std::size_t)pool->concurrency(), num_chunks - 1);
+        for (std::size_t i = 0; i < num_helpers; ++i)
+        {
+            context c;
+            c.name = pool->name();
+            c.pool = pool;
+            dispatch(work, c);
+        }
+
+        work();
+
+        if (state->done < num_chunks)
+            state->finished.wait();
+    }
+
     //! Metrics for all job pool
     inline metrics* get_metrics()
     {
@@ -1000,6 +1111,7 @@ namespace WEEJOBS_NAMESPACE
         }
         _queue.clear();
         _queue_size = 0;
+        _num_prioritized = 0;
 
         // wake up all threads so they can exit
         _block.notify_all();
@@ -0,0 +1,231 @@
+/* -*-c++-*- */
+/* osgEarth - Dynamic map generation toolkit for OpenSceneGraph
+ * Copyright 2020 Pelican Mapping
+ * http://osgearth.org
+ *
+ * osgEarth is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "AccessIndex"
+#include <osgEarth/FileUtils>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+using namespace osgEarth::Drivers::FileSystem;
+
+namespace
+{
+    const char MAGIC[4] = { 'O', 'E', 'A', 'I' };
+    const std::uint32_t VERSION = 1u;
+
+    template<typename T>
+    bool get(std::FILE* f, T& value)
+    {
+        return std::fread(&value, sizeof(T), 1, f) == 1;
+    }
+
+    template<typename T>
+    bool put(std::FILE* f, const T& value)
+    {
+        return std::fwrite(&value, sizeof(T), 1, f) == 1;
+    }
+}
+
+AccessIndex::AccessIndex(const std::string& path) :
+    _path(path),
+    _totalSize(0u),
+    _dirty(false)
+{
+    //nop
+}
+
+AccessIndex::Shard&
+AccessIndex::shard(const std::string& key)
+{
+    return _shards[std::hash<std::string>()(key) % NUM_SHARDS];
+}
+
+void
+AccessIndex::recordWrite(const std::string& key, std::uint64_t size, std::int64_t time)
+{
+    Shard& s = shard(key);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        Entry& entry = s.entries[key];
+        _totalSize -= entry.size;
+        _totalSize += size;
+        entry.size = size;
+        entry.lastAccess = time;
+        entry.hits++;
+    }
+    _dirty = true;
+}
+
+void
+AccessIndex::recordAccess(const std::string& key, std::int64_t time)
+{
+    Shard& s = shard(key);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto i = s.entries.find(key);
+        if (i == s.entries.end())
+            return;
+        i->second.lastAccess = time;
+        i->second.hits++;
+    }
+    _dirty = true;
+}
+
+void
+AccessIndex::insert(const std::string& key, const Entry& entry)
+{
+    Shard& s = shard(key);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.entries.emplace(key, entry).second)
+            _totalSize += entry.size;
+    }
+    _dirty = true;
+}
+
+void
+AccessIndex::recordRemove(const std::string& key)
+{
+    Shard& s = shard(key);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto i = s.entries.find(key);
+        if (i == s.entries.end())
+            return;
+        _totalSize -= i->second.size;
+        s.entries.erase(i);
+    }
+    _dirty = true;
+}
+
+void
+AccessIndex::clear()
+{
+    for (auto& s : _shards)
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (auto& i : s.entries)
+            _totalSize -= i.second.size;
+        s.entries.clear();
+    }
+    _dirty = true;
+}
+
+void
+AccessIndex::getEntries(Entries& out)
+{
+    // one shard at a time, so readers only ever wait on a short copy
+    for (auto& s : _shards)
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        out.insert(out.end(), s.entries.begin(), s.entries.end());
+    }
+}
+
+bool
+AccessIndex::load()
+{
+    std::lock_guard<std::mutex> lock(_fileMutex);
+
+    std::FILE* f = std::fopen(_path.c_str(), "rb");
+    if (!f)
+        return false;
+
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint64_t count = 0;
+    bool ok =
+        std::fread(magic, 1, 4, f) == 4 &&
+        std::memcmp(magic, MAGIC, 4) == 0 &&
+        get(f, version) && version == VERSION &&
+        get(f, count);
+
+    std::string key;
+    for (std::uint64_t n = 0; ok && n < count; ++n)
+    {
+        std::uint32_t keyLength = 0;
+        Entry entry;
+        ok = get(f, keyLength) && keyLength > 0 && keyLength < 4096;
+        if (ok)
+        {
+            key.resize(keyLength);
+            ok =
+                std::fread(&key[0], 1, keyLength, f) == keyLength &&
+                get(f, entry.size) &&
+                get(f, entry.lastAccess) &&
+                get(f, entry.hits);
+        }
+        if (ok)
+        {
+            // entries recorded since startup are newer than the file's
+            insert(key, entry);
+        }
+    }
+
+    std::fclose(f);
+    return ok;
+}
+
+bool
+AccessIndex::save()
+{
+    if (!_dirty.exchange(false))
+        return true;
+
+    std::lock_guard<std::mutex> lock(_fileMutex);
+
+    Entries entries;
+    getEntries(entries);
+
+    std::string tempPath = _path + ".tmp";
+    std::FILE* f = std::fopen(tempPath.c_str(), "wb");
+    if (!f)
+    {
+        _dirty = true;
+        return false;
+    }
+
+    std::uint64_t count = entries.size();
+    bool ok =
+        std::fwrite(MAGIC, 1, 4, f) == 4 &&
+        put(f, VERSION) &&
+        put(f, count);
+
+    for (auto i = entries.begin(); ok && i != entries.end(); ++i)
+    {
+        std::uint32_t keyLength = (std::uint32_t)i->first.size();
+        ok =
+            put(f, keyLength) &&
+            std::fwrite(i->first.data(), 1, keyLength, f) == keyLength &&
+            put(f, i->second.size) &&
+            put(f, i->second.lastAccess) &&
+            put(f, i->second.hits);
+    }
+
+    ok = std::fclose(f) == 0 && ok;
+
+    if (!ok || !replaceFile(tempPath, _path))
+    {
+        std::remove(tempPath.c_str());
+        _dirty = true;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,815 @@
+/* -*-c++-*- */
+/* osgEarth - Dynamic map generation toolkit for OpenSceneGraph
+ * Copyright 2020 Pelican Mapping
+ * http://osgearth.org
+ *
+ * osgEarth is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "Bundle"
+#include <osgEarth/FileUtils>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using namespace osgEarth;
+using namespace osgEarth::Threading;
+using namespace osgEarth::Drivers::FileSystem;
+
+#define BUNDLE_VERSION 1u
+#define RECORD_MAGIC 0x4f45524bu // "OERK"
+#define INITIAL_CAPACITY 1024u
+#define EMPTY_SLOT 0u
+#define REMOVED_SLOT 1u
+
+namespace osgEarth { namespace Drivers { namespace FileSystem
+{
+    // Read-write shared mapping of an entire existing file. The file
+    // handles are released once mapped; the mapping keeps the file open.
+    class MappedFile
+    {
+    public:
+        ~MappedFile() { unmap(); }
+
+        bool map(const std::string& path)
+        {
+#ifdef _WIN32
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size;
+            if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            {
+                HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, 0, NULL);
+                if (mapping != NULL)
+                {
+                    _data = (char*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+                    _size = (std::size_t)size.QuadPart;
+                    CloseHandle(mapping);
+                }
+            }
+            CloseHandle(file);
+#else
+            int fd = ::open(path.c_str(), O_RDWR);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (::fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                void* ptr = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (ptr != MAP_FAILED)
+                {
+                    _data = (char*)ptr;
+                    _size = (std::size_t)st.st_size;
+                }
+            }
+            ::close(fd);
+#endif
+            return _data != nullptr;
+        }
+
+        void unmap()
+        {
+            if (_data)
+            {
+#ifdef _WIN32
+                UnmapViewOfFile(_data);
+#else
+                ::munmap(_data, _size);
+#endif
+            }
+            _data = nullptr;
+            _size = 0;
+        }
+
+        char* data() const { return _data; }
+        std::size_t size() const { return _size; }
+
+    private:
+        char* _data = nullptr;
+        std::size_t _size = 0;
+    };
+} } }
+
+namespace
+{
+    int seek64(std::FILE* file, std::uint64_t offset, int origin)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, (__int64)offset, origin);
+#else
+        return fseeko(file, (off_t)offset, origin);
+#endif
+    }
+
+    std::uint64_t tell64(std::FILE* file)
+    {
+#ifdef _WIN32
+        return (std::uint64_t)_ftelli64(file);
+#else
+        return (std::uint64_t)ftello(file);
+#endif
+    }
+
+    std::size_t indexFileSize(std::uint32_t capacity)
+    {
+        return sizeof(Bundle::IndexHeader) + (std::size_t)capacity * sizeof(Bundle::IndexSlot);
+    }
+
+    // Inserts into a table known not to contain the hash (used when rebuilding)
+    void insertNew(Bundle::IndexHeader* header, Bundle::IndexSlot* slots, const Bundle::IndexSlot& value)
+    {
+        std::uint64_t mask = header->capacity - 1;
+        for (std::uint64_t i = value.hash & mask; ; i = (i + 1) & mask)
+        {
+            if (slots[i].hash == EMPTY_SLOT)
+            {
+                slots[i] = value;
+                header->count++;
+                header->used++;
+                header->liveBytes += value.size;
+                return;
+            }
+        }
+    }
+}
+
+std::uint64_t
+Bundle::hash(const std::string& key)
+{
+    // FNV-1a; values 0 and 1 mark empty and removed slots
+    std::uint64_t h = 14695981039346656037ull;
+    for (char c : key)
+    {
+        h ^= (std::uint8_t)c;
+        h *= 1099511628211ull;
+    }
+    return h > REMOVED_SLOT ? h : h + 2u;
+}
+
+Bundle::Bundle(const std::string& basePath) :
+    _basePath(basePath),
+    _data(nullptr),
+    _index(nullptr),
+    _absent(false)
+{
+    //nop
+}
+
+Bundle::~Bundle()
+{
+    closeUnlocked();
+}
+
+Bundle::IndexHeader*
+Bundle::header() const
+{
+    return reinterpret_cast<IndexHeader*>(_index->data());
+}
+
+Bundle::IndexSlot*
+Bundle::slots() const
+{
+    return reinterpret_cast<IndexSlot*>(_index->data() + sizeof(IndexHeader));
+}
+
+Bundle::IndexSlot*
+Bundle::find(std::uint64_t hash) const
+{
+    IndexSlot* table = slots();
+    std::uint64_t mask = header()->capacity - 1;
+    for (std::uint64_t i = hash & mask; ; i = (i + 1) & mask)
+    {
+        if (table[i].hash == hash)
+            return &table[i];
+        if (table[i].hash == EMPTY_SLOT)
+            return nullptr;
+    }
+}
+
+bool
+Bundle::createIndex(const std::string& path, std::uint32_t capacity)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    IndexHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "OEBI", 4);
+    h.version = BUNDLE_VERSION;
+    h.capacity = capacity;
+
+    bool ok = std::fwrite(&h, sizeof(h), 1, file) == 1;
+
+    std::vector<IndexSlot> empty(std::min(capacity, 4096u));
+    std::memset(empty.data(), 0, empty.size() * sizeof(IndexSlot));
+    for (std::uint32_t written = 0; ok && written < capacity; written += empty.size())
+    {
+        std::size_t n = std::min((std::size_t)(capacity - written), empty.size());
+        ok = std::fwrite(empty.data(), sizeof(IndexSlot), n, file) == n;
+    }
+
+    return std::fclose(file) == 0 && ok;
+}
+
+bool
+Bundle::openIfNecessary(bool create)
+{
+    {
+        ScopedReadLock lock(_mutex);
+        if (_index != nullptr)
+            return true;
+        if (_absent && !create)
+            return false;
+    }
+
+    ScopedWriteLock lock(_mutex);
+    return _index != nullptr || openUnlocked(create);
+}
+
+bool
+Bundle::openUnlocked(bool create)
+{
+    std::string dataPath = _basePath + ".dat";
+    std::string indexPath = _basePath + ".idx";
+
+    _data = std::fopen(dataPath.c_str(), "r+b");
+    if (_data == nullptr)
+    {
+        if (!create)
+        {
+            _absent = true;
+            return false;
+        }
+
+        _data = std::fopen(dataPath.c_str(), "w+b");
+        if (_data == nullptr || !createIndex(indexPath, INITIAL_CAPACITY))
+        {
+            closeUnlocked();
+            return false;
+        }
+    }
+    _absent = false;
+
+    _index = new MappedFile();
+    bool valid = _index->map(indexPath);
+    if (valid)
+    {
+        const IndexHeader* h = header();
+        valid =
+            _index->size() >= sizeof(IndexHeader) &&
+            std::memcmp(h->magic, "OEBI", 4) == 0 &&
+            h->version == BUNDLE_VERSION &&
+            h->capacity > 0 && (h->capacity & (h->capacity - 1)) == 0 &&
+            _index->size() == indexFileSize(h->capacity);
+    }
+
+    if (!valid)
+    {
+        delete _index;
+        _index = nullptr;
+
+        if (!rebuildIndex())
+        {
+            closeUnlocked();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+Bundle::closeUnlocked()
+{
+    if (_index)
+    {
+        delete _index;
+        _index = nullptr;
+    }
+    if (_data)
+    {
+        std::fclose(_data);
+        _data = nullptr;
+    }
+}
+
+void
+Bundle::close()
+{
+    ScopedWriteLock lock(_mutex);
+    closeUnlocked();
+    _absent = false;
+}
+
+bool
+Bundle::rebuildIndex()
+{
+    // Recovers the index from the data file. Later records replace
+    // earlier ones with the same key, so only removals are lost.
+    std::string indexPath = _basePath + ".idx";
+
+    std::lock_guard<std::mutex> lock(_fileMutex);
+
+    seek64(_data, 0, SEEK_END);
+    std::uint64_t fileSize = tell64(_data);
+
+    std::vector<IndexSlot> found;
+    std::uint64_t offset = 0;
+    RecordHeader rh;
+    while (offset + sizeof(rh) <= fileSize)
+    {
+        if (seek64(_data, offset, SEEK_SET) != 0 ||
+            std::fread(&rh, sizeof(rh), 1, _data) != 1 ||
+            rh.magic != RECORD_MAGIC)
+        {
+            break;
+        }
+
+        std::uint64_t size = sizeof(rh) + rh.keyLength + rh.metaLength + rh.dataLength;
+        if (offset + size > fileSize)
+            break; // truncated by a crash mid-write
+
+        IndexSlot slot;
+        slot.hash = rh.hash;
+        slot.offset = offset;
+        slot.size = size;
+        slot.timestamp = rh.timestamp;
+        found.push_back(slot);
+
+        offset += size;
+    }
+
+    // keep the latest record for each hash
+    std::stable_sort(found.begin(), found.end(),
+        [](const IndexSlot& a, const IndexSlot& b) { return a.hash < b.hash; });
+
+    std::vector<IndexSlot> latest;
+    for (std::size_t i = 0; i < found.size(); ++i)
+    {
+        if (i + 1 < found.size() && found[i + 1].hash == found[i].hash)
+            continue;
+        latest.push_back(found[i]);
+    }
+
+    std::uint32_t capacity = INITIAL_CAPACITY;
+    while ((std::uint64_t)latest.size() * 2 > capacity)
+        capacity *= 2;
+
+    if (!createIndex(indexPath, capacity))
+        return false;
+
+    _index = new MappedFile();
+    if (!_index->map(indexPath))
+    {
+        delete _index;
+        _index = nullptr;
+        return false;
+    }
+
+    for (auto& slot : latest)
+    {
+        insertNew(header(), slots(), slot);
+    }
+
+    return true;
+}
+
+bool
+Bundle::resize(std::uint32_t capacity)
+{
+    std::string indexPath = _basePath + ".idx";
+    std::string tempPath = indexPath + ".tmp";
+
+    if (!createIndex(tempPath, capacity))
+        return false;
+
+    {
+        MappedFile next;
+        if (!next.map(tempPath))
+            return false;
+
+        IndexHeader* nextHeader = reinterpret_cast<IndexHeader*>(next.data());
+        IndexSlot* nextSlots = reinterpret_cast<IndexSlot*>(next.data() + sizeof(IndexHeader));
+
+        const IndexSlot* table = slots();
+        for (std::uint32_t i = 0; i < header()->capacity; ++i)
+        {
+            if (table[i].hash > REMOVED_SLOT)
+                insertNew(nextHeader, nextSlots, table[i]);
+        }
+    }
+
+    _index->unmap();
+
+    if (!replaceFile(tempPath, indexPath) || !_index->map(indexPath))
+    {
+        // the data file is intact, so the next open will rebuild the index
+        std::remove(indexPath.c_str());
+        closeUnlocked();
+        return false;
+    }
+
+    return true;
+}
+
+bool
+Bundle::readRecord(std::uint64_t offset, std::uint64_t size, std::string& out)
+{
+    std::lock_guard<std::mutex> lock(_fileMutex);
+
+    out.resize(size);
+    return
+        seek64(_data, offset, SEEK_SET) == 0 &&
+        std::fread(&out[0], 1, size, _data) == size;
+}
+
+bool
+Bundle::append(const std::string& bytes, std::uint64_t& offset)
+{
+    std::lock_guard<std::mutex> lock(_fileMutex);
+
+    if (seek64(_data, 0, SEEK_END) != 0)
+        return false;
+
+    offset = tell64(_data);
+
+    return
+        std::fwrite(bytes.data(), 1, bytes.size(), _data) == bytes.size() &&
+        std::fflush(_data) == 0;
+}
+
+bool
+Bundle::read(const std::string& key, Record& out)
+{
+    std::uint64_t h = hash(key);
+
+    if (!openIfNecessary(false))
+        return false;
+
+    ScopedReadLock lock(_mutex);
+    if (_index == nullptr)
+        return false;
+
+    const IndexSlot* slot = find(h);
+    if (slot == nullptr)
+        return false;
+
+    std::string buf;
+    if (!readRecord(slot->offset, slot->size, buf) || buf.size() < sizeof(RecordHeader))
+        return false;
+
+    RecordHeader rh;
+    std::memcpy(&rh, buf.data(), sizeof(rh));
+
+    if (rh.magic != RECORD_MAGIC ||
+        rh.hash != h ||
+        sizeof(rh) + rh.keyLength + rh.metaLength + rh.dataLength != buf.size() ||
+        key.compare(0, std::string::npos, buf, sizeof(rh), rh.keyLength) != 0)
+    {
+        return false;
+    }
+
+    std::size_t pos = sizeof(rh) + rh.keyLength;
+    out.key = key;
+    out.meta.assign(buf, pos, rh.metaLength);
+    out.data.assign(buf, pos + rh.metaLength, rh.dataLength);
+    out.timestamp = slot->timestamp;
+    return true;
+}
+
+bool
+Bundle::getTimestamp(const std::string& key, std::int64_t& out)
+{
+    std::uint64_t h = hash(key);
+
+    if (!openIfNecessary(false))
+        return false;
+
+    ScopedReadLock lock(_mutex);
+    if (_index == nullptr)
+        return false;
+
+    const IndexSlot* slot = find(h);
+    if (slot == nullptr)
+        return false;
+
+    out = slot->timestamp;
+    return true;
+}
+
+bool
+Bundle::write(const std::string& key, const std::string& meta, const std::string& data, std::int64_t timestamp)
+{
+    RecordHeader rh;
+    std::memset(&rh, 0, sizeof(rh));
+    rh.magic = RECORD_MAGIC;
+    rh.keyLength = key.size();
+    rh.metaLength = meta.size();
+    rh.dataLength = data.size();
+    rh.timestamp = timestamp;
+    rh.hash = hash(key);
+
+    std::string bytes;
+    bytes.reserve(sizeof(rh) + key.size() + meta.size() + data.size());
+    bytes.append(reinterpret_cast<const char*>(&rh), sizeof(rh));
+    bytes.append(key);
+    bytes.append(meta);
+    bytes.append(data);
+
+    ScopedWriteLock lock(_mutex);
+
+    if (_index == nullptr && !openUnlocked(true))
+        return false;
+
+    // grow before appending so a failure leaves no orphan record behind
+    if ((std::uint64_t)(header()->used + 1) * 4 > (std::uint64_t)header()->capacity * 3)
+    {
+        if (!resize(header()->capacity * 2))
+            return false;
+    }
+
+    std::uint64_t offset;
+    if (!append(bytes, offset))
+        return false;
+
+    IndexHeader* h = header();
+    IndexSlot* table = slots();
+    IndexSlot* target = nullptr;
+    std::uint64_t mask = h->capacity - 1;
+
+    for (std::uint64_t i = rh.hash & mask; ; i = (i + 1) & mask)
+    {
+        if (table[i].hash == rh.hash)
+        {
+            // replacing; the old record becomes garbage
+            target = &table[i];
+            h->liveBytes -= target->size;
+            break;
+        }
+        else if (table[i].hash == REMOVED_SLOT)
+        {
+            if (target == nullptr)
+                target = &table[i];
+        }
+        else if (table[i].hash == EMPTY_SLOT)
+        {
+            if (target == nullptr)
+            {
+                target = &table[i];
+                h->used++;
+            }
+            h->count++;
+            break;
+        }
+    }
+
+    target->hash = rh.hash;
+    target->offset = offset;
+    target->size = bytes.size();
+    target->timestamp = timestamp;
+    h->liveBytes += bytes.size();
+
+    return true;
+}
+
+bool
+Bundle::remove(const std::string& key)
+{
+    std::uint64_t h = hash(key);
+
+    if (!openIfNecessary(false))
+        return false;
+
+    ScopedWriteLock lock(_mutex);
+    if (_index == nullptr)
+        return false;
+
+    IndexSlot* slot = find(h);
+    if (slot == nullptr)
+        return false;
+
+    header()->count--;
+    header()->liveBytes -= slot->size;
+    slot->hash = REMOVED_SLOT;
+    return true;
+}
+
+bool
+Bundle::touch(const std::string& key, std::int64_t timestamp)
+{
+    std::uint64_t h = hash(key);
+
+    if (!openIfNecessary(false))
+        return false;
+
+    ScopedWriteLock lock(_mutex);
+    if (_index == nullptr)
+        return false;
+
+    IndexSlot* slot = find(h);
+    if (slot == nullptr)
+        return false;
+
+    slot->timestamp = timestamp;
+    return true;
+}
+
+bool
+Bundle::compact()
+{
+    if (!openIfNecessary(false))
+        return _absent; // nothing to compact
+
+    ScopedWriteLock lock(_mutex);
+    if (_index == nullptr)
+        return false;
+
+    std::string dataPath = _basePath + ".dat";
+    std::string indexPath = _basePath + ".idx";
+    std::string tempDataPath = dataPath + ".tmp";
+    std::string tempIndexPath = indexPath + ".tmp";
+
+    // live records in file order, so the copy reads sequentially
+    std::vector<IndexSlot> live;
+    live.reserve(header()->count);
+    for (std::uint32_t i = 0; i < header()->capacity; ++i)
+    {
+        if (slots()[i].hash > REMOVED_SLOT)
+            live.push_back(slots()[i]);
+    }
+    std::sort(live.begin(), live.end(),
+        [](const IndexSlot& a, const IndexSlot& b) { return a.offset < b.offset; });
+
+    std::uint32_t capacity = INITIAL_CAPACITY;
+    while ((std::uint64_t)live.size() * 2 > capacity)
+        capacity *= 2;
+
+    if (!createIndex(tempIndexPath, capacity))
+        return false;
+
+    std::FILE* out = std::fopen(tempDataPath.c_str(), "wb");
+    if (out == nullptr)
+    {
+        std::remove(tempIndexPath.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    {
+        MappedFile next;
+        ok = next.map(tempIndexPath);
+
+        IndexHeader* nextHeader = reinterpret_cast<IndexHeader*>(next.data());
+        IndexSlot* nextSlots = reinterpret_cast<IndexSlot*>(next.data() + sizeof(IndexHeader));
+
+        std::string buf;
+        std::uint64_t offset = 0;
+        for (auto& slot : live)
+        {
+            if (!ok)
+                break;
+
+            ok = readRecord(slot.offset, slot.size, buf);
+            if (ok)
+            {
+                // carry touch() updates into the record so a rebuilt index keeps them
+                RecordHeader rh;
+                std::memcpy(&rh, buf.data(), sizeof(rh));
+                rh.timestamp = slot.timestamp;
+                std::memcpy(&buf[0], &rh, sizeof(rh));
+
+                ok = std::fwrite(buf.data(), 1, buf.size(), out) == buf.size();
+            }
+            if (ok)
+            {
+                IndexSlot moved = slot;
+                moved.offset = offset;
+                insertNew(nextHeader, nextSlots, moved);
+                offset += slot.size;
+            }
+        }
+    }
+
+    ok = (std::fclose(out) == 0) && ok;
+
+    if (!ok)
+    {
+        std::remove(tempDataPath.c_str());
+        std::remove(tempIndexPath.c_str());
+        return false;
+    }
+
+    closeUnlocked();
+
+    // A crash between these two leaves a mismatched pair; reads verify
+    // each record's key, and a rebuild from the data file recovers.
+    ok =
+        replaceFile(tempDataPath, dataPath) &&
+        replaceFile(tempIndexPath, indexPath);
+
+    return openUnlocked(false) && ok;
+}
+
+bool
+Bundle::list(std::vector<Listing>& out)
+{
+    if (!openIfNecessary(false))
+        return false;
+
+    ScopedReadLock lock(_mutex);
+    if (_index == nullptr)
+        return false;
+
+    const IndexSlot* table = slots();
+    for (std::uint32_t i = 0; i < header()->capacity; ++i)
+    {
+        if (table[i].hash <= REMOVED_SLOT)
+            continue;
+
+        // the key follows the record header
+        std::string buf;
+        RecordHeader rh;
+        if (!readRecord(table[i].offset, sizeof(rh), buf))
+            continue;
+
+        std::memcpy(&rh, buf.data(), sizeof(rh));
+        if (rh.magic != RECORD_MAGIC || rh.hash != table[i].hash ||
+            !readRecord(table[i].offset + sizeof(rh), rh.keyLength, buf))
+        {
+            continue;
+        }
+
+        Listing listing;
+        listing.key = buf;
+        listing.size = table[i].size;
+        listing.timestamp = table[i].timestamp;
+        out.push_back(std::move(listing));
+    }
+
+    return true;
+}
+
+unsigned
+Bundle::getNumRecords()
+{
+    if (!openIfNecessary(false))
+        return 0u;
+
+    ScopedReadLock lock(_mutex);
+    return _index ? header()->count : 0u;
+}
+
+std::uint64_t
+Bundle::getLiveSize()
+{
+    if (!openIfNecessary(false))
+        return 0u;
+
+    ScopedReadLock lock(_mutex);
+    return _index ? header()->liveBytes : 0u;
+}
+
+std::uint64_t
+Bundle::getDataSize()
+{
+    if (!openIfNecessary(false))
+        return 0u;
+
+    ScopedReadLock lock(_mutex);
+    if (_data == nullptr)
+        return 0u;
+
+    std::lock_guard<std::mutex> fileLock(_fileMutex);
+    seek64(_data, 0, SEEK_END);
+    return tell64(_data);
+}
@@ -17,6 +17,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>
  */
 #include "FileSystemCache"
+#include "Bundle"
+#include "AccessIndex"
 #include <osgEarth/Cache>
 #include <osgEarth/StringUtils>
 #include <osgEarth/Threading>
@@ -30,19 +32,42 @@
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
 #include <osgDB/WriteFile>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <memory>
 #include <sys/stat.h>
+#include <thread>
 
 using namespace osgEarth;
 using namespace osgEarth::Drivers;
+using namespace osgEarth::Drivers::FileSystem;
 
 #ifndef _WIN32
 #   include <unistd.h>
+#else
+#   include <direct.h>
+#   define rmdir _rmdir
 #endif
 
 #define OSG_FORMAT "osgb"
 #define OSG_EXT   ".osgb"
 
+// number of bundle files per bin in the "bundles" layout
+#define NUM_BUNDLES 64u
+
+// env var that sets the size budget (overrides the max_size_mb option)
+#define OSGEARTH_ENV_CACHE_MAX_SIZE_MB "OSGEARTH_CACHE_MAX_SIZE_MB"
+
+// seconds between checks of the size budget
+#define EVICTION_PERIOD 5
+
+// eviction brings the cache down to this fraction of the budget, so that
+// it doesn't run again as soon as the next record arrives
+#define EVICTION_TARGET 0.9
+
 //#define IMAGE_FORMAT "tif"
 //#define IMAGE_EXT "." IMAGE_FORMAT
 
@@ -73,10 +98,32 @@ namespace
 
         void setNumThreads(unsigned) override;
 
+        bool compact() override;
+
+        off_t getApproximateSize() const override;
+
     protected:
+        virtual ~FileSystemCache();
+
         std::string _rootPath;
         FileSystemCacheOptions _options;
         jobs::jobpool* _pool = nullptr;
+
+        // size budget (see FileSystemCacheOptions::maxSizeMB), enforced
+        // by a background thread that evicts records across all bins
+        std::uint64_t _maxBytes = 0u;
+        std::vector<osg::ref_ptr<CacheBin>> _budgetBins;
+        std::atomic<bool> _budgetBinsReady{ false };
+        mutable std::mutex _budgetMutex;
+        std::condition_variable _evictCondition;
+        std::atomic<bool> _stopEvictor{ false };
+        std::thread _evictor;
+
+        CacheBin* trackBin(CacheBin* bin);
+
+        void evictionLoop();
+
+        void evict(const std::vector<osg::ref_ptr<CacheBin>>& bins, std::uint64_t bytes);
     };
 
     struct WriteCacheRecord {
@@ -118,9 +165,47 @@ namespace
 
         bool clear() override;
 
+        bool compact() override;
+
+        off_t getStorageSize() override;
+
+    public: // size budget support (see FileSystemCache::evictionLoop)
+
+        //! Loads the access index, or rebuilds it if its file is missing
+        void loadAccessIndex();
+
+        //! Saves the access index if it changed
+        void saveAccessIndex();
+
+        //! Appends the access record of every record in the bin to "out"
+        void getAccessEntries(AccessIndex::Entries& out);
+
+        //! Compacts the bundles that are mostly garbage
+        void compactSparseBundles();
+
     protected:
         bool purgeDirectory( const std::string& dir );
 
+        void noteAccess(const std::string& key);
+
+        void indexDirectory(const std::string& dir);
+
+        bool isAccessIndexFile(const std::string& path) const;
+
+        Bundle* getBundle(const std::string& key) const;
+
+        bool makeBundlePath();
+
+        bool readBundleRecord(const std::string& key, const std::string& legacyPath, Bundle::Record& record);
+
+        //! Copies a "files" layout record into its bundle; the caller holds _fileGate for it
+        bool importLegacyFile(const std::string& key, const std::string& path, Bundle::Record* record);
+
+        bool importLegacyDirectory(const std::string& dir, bool& empty);
+
+        bool writeBundleRecord(const std::string& key, const osg::Object* object, const Config& meta,
+            const osgDB::Options* dbo, osgDB::ReaderWriter::WriteResult& r);
+
         bool binValidForReading(bool silent =true);
 
         bool binValidForWriting(bool silent =false);
@@ -135,6 +220,18 @@ namespace
         osg::ref_ptr<osgDB::Options>      _zlibOptions;
         FileSystemCacheOptions _options;
 
+        // "bundles" layout: records packed into bundle files, selected by key hash
+        std::vector<std::unique_ptr<Bundle>> _bundles;
+        std::string _bundlePath;
+        std::atomic<bool> _bundlePathExists;
+        std::atomic<bool> _hasLegacyFiles; // records remain in the "files" layout
+
+        // record sizes and access times, when the cache has a size budget
+        std::unique_ptr<AccessIndex> _accessIndex;
+        std::string _accessIndexPath;
+        std::atomic<bool> _accessIndexLoaded;
+        std::mutex _accessIndexMutex;
+
         // pool for asynchronous writes
         jobs::jobpool* _pool = nullptr;
 
@@ -163,6 +260,32 @@ namespace
         }
     }
 
+    std::uint64_t getFileSize(const std::string& path)
+    {
+        struct stat s;
+        return ::stat(path.c_str(), &s) == 0 ? (std::uint64_t)s.st_size : 0u;
+    }
+
+    // Total size of the files under a folder, less the "skip" subfolder
+    std::uint64_t getDirectorySize(const std::string& dir, const std::string& skip = std::string())
+    {
+        std::uint64_t total = 0u;
+        osgDB::DirectoryContents dc = osgDB::getDirectoryContents(dir);
+        for (auto& name : dc)
+        {
+            std::string full = osgDB::concatPaths(dir, name);
+            if (name == "." || name == ".." || full == skip)
+                continue;
+
+            osgDB::FileType type = osgDB::fileType(full);
+            if (type == osgDB::DIRECTORY)
+                total += getDirectorySize(full, skip);
+            else if (type == osgDB::REGULAR_FILE)
+                total += getFileSize(full);
+        }
+        return total;
+    }
+
     void readMeta( const std::string& fullPath, Config& meta )
     {
         std::ifstream inmeta( fullPath.c_str() );
@@ -216,6 +339,186 @@ namespace
 
         // create a thread pool dedicated to asynchronous cache writes
         setNumThreads(_options.threads().get());
+
+        const char* maxsize = ::getenv(OSGEARTH_ENV_CACHE_MAX_SIZE_MB);
+        if (maxsize)
+        {
+            unsigned mb = as<unsigned>(std::string(maxsize), 0u);
+            if (mb > 0)
+                _options.maxSizeMB() = mb;
+            else
+                OE_WARN << LC << "Env var \"" OSGEARTH_ENV_CACHE_MAX_SIZE_MB "\" set to an invalid value" << std::endl;
+        }
+
+        if (_options.maxSizeMB().isSet() && _options.maxSizeMB().get() > 0u)
+        {
+            _maxBytes = (std::uint64_t)_options.maxSizeMB().get() * 1048576u;
+            _evictor = std::thread(&FileSystemCache::evictionLoop, this);
+
+            OE_INFO << LC << "Cache size budget is " << _options.maxSizeMB().get() << " MB ("
+                << _options.eviction().get() << " eviction)" << std::endl;
+        }
+    }
+
+    FileSystemCache::~FileSystemCache()
+    {
+        if (_evictor.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(_budgetMutex);
+                _stopEvictor = true;
+            }
+            _evictCondition.notify_all();
+            _evictor.join();
+
+            for (auto& bin : _budgetBins)
+                static_cast<FileSystemCacheBin*>(bin.get())->saveAccessIndex();
+        }
+    }
+
+    CacheBin*
+    FileSystemCache::trackBin(CacheBin* bin)
+    {
+        if (bin && _maxBytes > 0u)
+        {
+            std::lock_guard<std::mutex> lock(_budgetMutex);
+            if (std::find(_budgetBins.begin(), _budgetBins.end(), bin) == _budgetBins.end())
+                _budgetBins.push_back(bin);
+        }
+        return bin;
+    }
+
+    void
+    FileSystemCache::evictionLoop()
+    {
+        // the budget covers the whole cache, so open every bin on disk
+        // and not just the ones the application asks for.
+        osgDB::DirectoryContents dc = osgDB::getDirectoryContents(_rootPath);
+        for (auto& name : dc)
+        {
+            if (name != "." && name != ".." &&
+                osgDB::fileType(osgDB::concatPaths(_rootPath, name)) == osgDB::DIRECTORY)
+            {
+                if (name == "__default")
+                    getOrCreateDefaultBin();
+                else
+                    addBin(name);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(_budgetMutex);
+
+        while (!_stopEvictor)
+        {
+            std::vector<osg::ref_ptr<CacheBin>> bins(_budgetBins);
+
+            lock.unlock();
+
+            // loads each index once (including bins opened since the last pass)
+            for (auto& bin : bins)
+                static_cast<FileSystemCacheBin*>(bin.get())->loadAccessIndex();
+
+            _budgetBinsReady = true;
+
+            std::uint64_t total = 0u;
+            for (auto& bin : bins)
+                total += bin->getStorageSize();
+
+            std::uint64_t target = (std::uint64_t)(EVICTION_TARGET * (double)_maxBytes);
+            if (total > _maxBytes)
+            {
+                evict(bins, total - target);
+            }
+
+            for (auto& bin : bins)
+                static_cast<FileSystemCacheBin*>(bin.get())->saveAccessIndex();
+
+            lock.lock();
+
+            _evictCondition.wait_for(lock, std::chrono::seconds(EVICTION_PERIOD), [this]() {
+                return _stopEvictor; });
+        }
+    }
+
+    void
+    FileSystemCache::evict(const std::vector<osg::ref_ptr<CacheBin>>& bins, std::uint64_t bytes)
+    {
+        struct Candidate
+        {
+            FileSystemCacheBin* bin;
+            std::string key;
+            AccessIndex::Entry entry;
+        };
+
+        std::vector<Candidate> candidates;
+        for (auto& bin : bins)
+        {
+            FileSystemCacheBin* fsbin = static_cast<FileSystemCacheBin*>(bin.get());
+
+            AccessIndex::Entries entries;
+            fsbin->getAccessEntries(entries);
+            for (auto& e : entries)
+                candidates.push_back(Candidate{ fsbin, std::move(e.first), e.second });
+        }
+
+        if (_options.eviction() == "lfu")
+        {
+            std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+                return
+                    a.entry.hits < b.entry.hits ||
+                    (a.entry.hits == b.entry.hits && a.entry.lastAccess < b.entry.lastAccess); });
+        }
+        else
+        {
+            std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+                return a.entry.lastAccess < b.entry.lastAccess; });
+        }
+
+        // records go one at a time, so readers only wait on the record
+        // being removed.
+        std::uint64_t freed = 0u;
+        unsigned count = 0u;
+        for (auto& c : candidates)
+        {
+            if (freed >= bytes || _stopEvictor)
+                break;
+
+            if (c.bin->remove(c.key))
+            {
+                freed += c.entry.size;
+                ++count;
+            }
+        }
+
+        // bundles only give back space when they are compacted
+        for (auto& bin : bins)
+            static_cast<FileSystemCacheBin*>(bin.get())->compactSparseBundles();
+
+        OE_INFO << LC << "Evicted " << count << " records (" << (freed / 1048576u) << " MB) to stay within "
+            << _options.maxSizeMB().get() << " MB" << std::endl;
+    }
+
+    off_t
+    FileSystemCache::getApproximateSize() const
+    {
+        if (getStatus().isError())
+            return 0;
+
+        if (_budgetBinsReady)
+        {
+            std::vector<osg::ref_ptr<CacheBin>> bins;
+            {
+                std::lock_guard<std::mutex> lock(_budgetMutex);
+                bins = _budgetBins;
+            }
+
+            off_t total = 0;
+            for (auto& bin : bins)
+                total += bin->getStorageSize();
+            return total;
+        }
+
+        return (off_t)getDirectorySize(_rootPath);
     }
 
     void
@@ -233,13 +536,40 @@ namespace
         }
     }
 
+    bool
+    FileSystemCache::compact()
+    {
+        if (getStatus().isError() || _options.layout() != "bundles")
+            return false;
+
+        // compact every bin on disk, not just the ones opened so far
+        bool ok = true;
+        osgDB::DirectoryContents dc = osgDB::getDirectoryContents(_rootPath);
+        for (auto& name : dc)
+        {
+            if (name == "." || name == ".." ||
+                osgDB::fileType(osgDB::concatPaths(_rootPath, name)) != osgDB::DIRECTORY)
+            {
+                continue;
+            }
+
+            CacheBin* bin = name == "__default" ? getOrCreateDefaultBin() : addBin(name);
+            if (bin)
+            {
+                OE_INFO << LC << "Compacting cache bin \"" << name << "\"" << std::endl;
+                ok = bin->compact() && ok;
+            }
+        }
+        return ok;
+    }
+
     CacheBin*
     FileSystemCache::addBin( const std::string& name )
     {
         if (getStatus().isError())
             return NULL;
 
-        return _bins.getOrCreate(name, new FileSystemCacheBin(name, _rootPath, _options, _pool));
+        return trackBin(_bins.getOrCreate(name, new FileSystemCacheBin(name, _rootPath, _options, _pool)));
     }
 
     CacheBin*
@@ -255,6 +585,7 @@ namespace
             if ( !_defaultBin.valid() ) // double-check
             {
                 _defaultBin = new FileSystemCacheBin("__default", _rootPath, _options, _pool);
+                trackBin(_defaultBin.get());
             }
         }
         return _defaultBin.get();
@@ -332,6 +663,9 @@ namespace
         _pool(pool),
         _binPathExists(false),
         _options(options),
+        _bundlePathExists(false),
+        _hasLegacyFiles(false),
+        _accessIndexLoaded(false),
         _ok(true)
     {
         _binPath = osgDB::concatPaths(rootPath, binID);
@@ -356,6 +690,239 @@ namespace
         }
 
         _s_debug = ::getenv("OSGEARTH_CACHE_DEBUG") != 0L;
+
+        if (_options.maxSizeMB().isSet() && _options.maxSizeMB().get() > 0u)
+        {
+            _accessIndexPath = osgDB::concatPaths(_binPath, "osgearth_access.idx");
+            _accessIndex.reset(new AccessIndex(_accessIndexPath));
+        }
+
+        if (_options.layout() == "bundles")
+        {
+            _bundlePath = osgDB::concatPaths(_binPath, "bundles");
+
+            for (unsigned i = 0; i < NUM_BUNDLES; ++i)
+            {
+                _bundles.emplace_back(new Bundle(
+                    osgDB::concatPaths(_bundlePath, "bundle_" + std::to_string(i))));
+            }
+
+            // anything else in the bin folder is a record in the "files" layout
+            osgDB::DirectoryContents dc = osgDB::getDirectoryContents(_binPath);
+            for (auto& name : dc)
+            {
+                std::string full = osgDB::concatPaths(_binPath, name);
+                if (name != "." && name != ".." && name != "bundles" &&
+                    full != _metaPath && !isAccessIndexFile(full))
+                {
+                    _hasLegacyFiles = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    Bundle*
+    FileSystemCacheBin::getBundle(const std::string& key) const
+    {
+        // high bits, since the bundle's own index probes from the low bits
+        return _bundles[(Bundle::hash(key) >> 56) % NUM_BUNDLES].get();
+    }
+
+    bool
+    FileSystemCacheBin::makeBundlePath()
+    {
+        if (!_bundlePathExists)
+            _bundlePathExists = osgDB::makeDirectory(_bundlePath);
+        return _bundlePathExists;
+    }
+
+    bool
+    FileSystemCacheBin::readBundleRecord(const std::string& key, const std::string& legacyPath, Bundle::Record& record)
+    {
+        if (getBundle(key)->read(key, record))
+            return true;
+
+        if (!_hasLegacyFiles)
+            return false;
+
+        // migrate a record from the "files" layout on first access. Hold the
+        // key's gate so a write can't land between the lookup and the copy,
+        // and look again in case one landed before we got the gate.
+        ScopedGate<std::string> lockFile(_fileGate, osgDB::getNameLessExtension(legacyPath));
+
+        if (getBundle(key)->read(key, record))
+            return true;
+
+        return
+            osgDB::fileExists(legacyPath) &&
+            importLegacyFile(key, legacyPath, &record);
+    }
+
+    bool
+    FileSystemCacheBin::importLegacyFile(const std::string& key, const std::string& path, Bundle::Record* out)
+    {
+        Bundle::Record temp;
+        Bundle::Record& record = out ? *out : temp;
+
+        std::ifstream input(path.c_str(), std::ios::in | std::ios::binary);
+        if (!input.is_open())
+            return false;
+
+        std::stringstream buf;
+        buf << input.rdbuf();
+        input.close();
+
+        record.key = key;
+        record.data = buf.str();
+        record.meta.clear();
+        record.timestamp = osgEarth::getLastModifiedTime(path);
+
+        std::string metafile = osgDB::getNameLessExtension(path) + ".meta";
+        if (osgDB::fileExists(metafile))
+        {
+            std::ifstream inmeta(metafile.c_str());
+            std::stringstream metabuf;
+            metabuf << inmeta.rdbuf();
+            record.meta = metabuf.str();
+        }
+
+        if (!makeBundlePath() || !getBundle(key)->write(key, record.meta, record.data, record.timestamp))
+            return false;
+
+        ::unlink(path.c_str());
+        ::unlink(metafile.c_str());
+
+        if (_accessIndex)
+        {
+            _accessIndex->recordWrite(key,
+                sizeof(Bundle::RecordHeader) + key.size() + record.meta.size() + record.data.size(),
+                record.timestamp);
+        }
+
+        if (_s_debug)
+            OE_NOTICE << LC << "Migrated \"" << path << "\" into a bundle" << std::endl;
+
+        return true;
+    }
+
+    bool
+    FileSystemCacheBin::importLegacyDirectory(const std::string& dir, bool& empty)
+    {
+        bool ok = true;
+
+        osgDB::DirectoryContents dc = osgDB::getDirectoryContents(dir);
+        for (auto& name : dc)
+        {
+            std::string full = osgDB::concatPaths(dir, name);
+
+            if (name == "." || name == ".." || full == _metaPath || full == _bundlePath || isAccessIndexFile(full))
+                continue;
+
+            osgDB::FileType type = osgDB::fileType(full);
+
+            if (type == osgDB::DIRECTORY)
+            {
+                bool subdirEmpty = false;
+                ok = importLegacyDirectory(full, subdirEmpty) && ok;
+                if (subdirEmpty)
+                    ::rmdir(full.c_str());
+            }
+
+            else if (type == osgDB::REGULAR_FILE && osgDB::getFileExtension(full) != "meta")
+            {
+                // the record key is the path relative to the bin, less the extension
+                std::string key = osgDB::convertFileNameToUnixStyle(
+                    osgDB::getNameLessExtension(full.substr(_binPath.length() + 1)));
+
+                // check the bundle under the gate, so a concurrent write
+                // can't be overwritten by the older file
+                ScopedGate<std::string> lockFile(_fileGate, osgDB::getNameLessExtension(full));
+
+                std::int64_t timestamp;
+                if (getBundle(key)->getTimestamp(key, timestamp))
+                {
+                    // the bundle already holds a newer copy
+                    ::unlink(full.c_str());
+                    ::unlink((osgDB::getNameLessExtension(full) + ".meta").c_str());
+                }
+                else
+                {
+                    ok = importLegacyFile(key, full, nullptr) && ok;
+                }
+            }
+        }
+
+        // re-list, since .meta files go away with their records
+        empty = true;
+        dc = osgDB::getDirectoryContents(dir);
+        for (auto& name : dc)
+        {
+            if (name != "." && name != "..")
+                empty = false;
+        }
+
+        return ok;
+    }
+
+    bool
+    FileSystemCacheBin::writeBundleRecord(
+        const std::string& key,
+        const osg::Object* object,
+        const Config& meta,
+        const osgDB::Options* dbo,
+        osgDB::ReaderWriter::WriteResult& r)
+    {
+        std::stringstream buf(std::ios::in | std::ios::out | std::ios::binary);
+
+        if (dynamic_cast<const osg::Image*>(object))
+        {
+            const osg::Image* image = static_cast<const osg::Image*>(object);
+            OE_SOFT_ASSERT_AND_RETURN(image->isCompressed() == false, false);
+
+            osg::ref_ptr<osgDB::ReaderWriter> image_rw =
+                osgDB::Registry::instance()->getReaderWriterForExtension(_options.format().get());
+
+            if (!image_rw.valid())
+            {
+                r = osgDB::ReaderWriter::WriteResult(Stringify() << "Unknown image format \"" << _options.format().get() << "\"");
+                return false;
+            }
+
+            r = image_rw->writeImage(*image, buf, dbo);
+        }
+        else if (dynamic_cast<const osg::Node*>(object))
+        {
+            r = _rw->writeNode(*static_cast<const osg::Node*>(object), buf, dbo);
+        }
+        else
+        {
+            r = _rw->writeObject(*object, buf, dbo);
+        }
+
+        if (!r.success())
+            return false;
+
+        std::string metaJSON = meta.empty() ? std::string() : meta.toJSON();
+
+        std::string data = buf.str();
+        TimeStamp now = DateTime().asTimeStamp();
+
+        if (!makeBundlePath() ||
+            !getBundle(key)->write(key, metaJSON, data, now))
+        {
+            r = osgDB::ReaderWriter::WriteResult(Stringify() << "Failed to append to bundle in " << _bundlePath);
+            return false;
+        }
+
+        if (_accessIndex)
+        {
+            _accessIndex->recordWrite(key,
+                sizeof(Bundle::RecordHeader) + key.size() + metaJSON.size() + data.size(),
+                now);
+        }
+
+        return true;
     }
 
     const osgDB::Options*
@@ -417,6 +984,39 @@ namespace
             }
         }        
 
+        if (!_bundles.empty())
+        {
+            Bundle::Record record;
+            if (!readBundleRecord(key, path, record))
+                return ReadResult(ReadResult::RESULT_NOT_FOUND);
+
+            osg::ref_ptr<osgDB::ReaderWriter> image_rw =
+                osgDB::Registry::instance()->getReaderWriterForExtension(_options.format().get());
+
+            if (!image_rw.valid())
+                return ReadResult(Stringify() << "Unknown image format \"" << _options.format().get() << "\"");
+
+            std::istringstream input(record.data, std::ios::in | std::ios::binary);
+            osgDB::ReaderWriter::ReadResult r = image_rw->readImage(input, dbo.get());
+            if (!r.success())
+                return ReadResult(r.message());
+
+            Config meta;
+            if (!record.meta.empty())
+                meta.fromJSON(record.meta);
+
+            ReadResult rr(r.getImage(), meta);
+            rr.setLastModifiedTime(record.timestamp);
+
+            OE_SOFT_ASSERT_AND_RETURN(
+                rr.getImage() == nullptr || rr.getImage()->isCompressed() == false,
+                ReadResult());
+
+            noteAccess(key);
+
+            return rr;
+        }
+
         // Not in the pool, now check the file system
         if (!osgDB::fileExists(path))
         {
@@ -462,6 +1062,8 @@ namespace
             rr.getImage() == nullptr || rr.getImage()->isCompressed() == false, 
             ReadResult());
 
+        noteAccess(key);
+
         return rr;
     }
     
@@ -503,6 +1105,29 @@ namespace
             }
         }
 
+        if (!_bundles.empty())
+        {
+            Bundle::Record record;
+            if (!readBundleRecord(key, path, record))
+                return ReadResult(ReadResult::RESULT_NOT_FOUND);
+
+            std::istringstream input(record.data, std::ios::in | std::ios::binary);
+            osgDB::ReaderWriter::ReadResult r = _rw->readObject(input, dbo.get());
+            if (!r.success())
+                return ReadResult(r.message());
+
+            Config meta;
+            if (!record.meta.empty())
+                meta.fromJSON(record.meta);
+
+            ReadResult rr(r.getObject(), meta);
+            rr.setLastModifiedTime(record.timestamp);
+
+            noteAccess(key);
+
+            return rr;
+        }
+
         // Not in the pool, now check the file system
         if (!osgDB::fileExists(path))
         {            
@@ -535,6 +1160,8 @@ namespace
         if (_s_debug)
             OE_NOTICE << LC << "Read object \"" << key << "\" from cache bin [" << getID() << "] path=" << fileURI.full() << "." << OSG_EXT << std::endl;
 
+        noteAccess(key);
+
         return rr;
     }
 
@@ -602,7 +1229,7 @@ namespace
             ScopedGate<std::string> lockFile(_fileGate, fileURI.full());
 
             // make a home for it..
-            if (!osgDB::fileExists(osgDB::getFilePath(fileURI.full())))
+            if (_bundles.empty() && !osgDB::fileExists(osgDB::getFilePath(fileURI.full())))
             {
                 osgEarth::makeDirectoryForFile(fileURI.full());
             }
@@ -610,10 +1237,15 @@ namespace
             osgDB::ReaderWriter::WriteResult r;
 
             bool writeOK = false;
+            std::string filename;
 
-            if (dynamic_cast<const osg::Image*>(object.get()))
+            if (!_bundles.empty())
             {
-                std::string filename = fileURI.full() + "." + _options.format().get();
+                writeOK = writeBundleRecord(key, object.get(), meta, writeOptions.get(), r);
+            }
+            else if (dynamic_cast<const osg::Image*>(object.get()))
+            {
+                filename = fileURI.full() + "." + _options.format().get();
                 const osg::Image* image = static_cast<const osg::Image*>(object.get());
 
                 if (image->isCompressed())
@@ -627,24 +1259,32 @@ namespace
             }
             else if (dynamic_cast<const osg::Node*>(object.get()))
             {
-                std::string filename = fileURI.full() + OSG_EXT;
+                filename = fileURI.full() + OSG_EXT;
                 r = _rw->writeNode(*static_cast<const osg::Node*>(object.get()), filename, writeOptions.get());
                 writeOK = r.success();
             }
             else
             {
-                std::string filename = fileURI.full() + OSG_EXT;
+                filename = fileURI.full() + OSG_EXT;
                 r = _rw->writeObject(*object.get(), filename, writeOptions.get());
                 writeOK = r.success();
             }
 
-            // write metadata
-            if (!meta.empty() && writeOK)
+            // write metadata (bundle records carry their own)
+            std::string metaname = fileURI.full() + ".meta";
+            if (!meta.empty() && writeOK && _bundles.empty())
             {
-                std::string metaname = fileURI.full() + ".meta";
                 writeMeta(metaname, meta);
             }
 
+            // bundle writes account for themselves
+            if (writeOK && _accessIndex && _bundles.empty())
+            {
+                _accessIndex->recordWrite(key,
+                    getFileSize(filename) + getFileSize(metaname),
+                    DateTime().asTimeStamp());
+            }
+
             if (!writeOK)
             {
                 OE_WARN << LC << "FAILED to write \"" << fileURI.full() << "\" to cache bin \"" <<
@@ -692,6 +1332,15 @@ namespace
         if ( !binValidForReading() )
             return STATUS_NOT_FOUND;
 
+        if (!_bundles.empty())
+        {
+            std::int64_t timestamp;
+            if (getBundle(key)->getTimestamp(key, timestamp))
+                return STATUS_OK;
+            else if (!_hasLegacyFiles)
+                return STATUS_NOT_FOUND;
+        }
+
         URI fileURI( key, _metaPath );
         std::string path( fileURI.full() + OSG_EXT );
         if ( !osgDB::fileExists(path) )
@@ -704,18 +1353,54 @@ namespace
     FileSystemCacheBin::remove(const std::string& key)
     {
         if ( !binValidForReading() ) return false;
+
+        if (_accessIndex)
+            _accessIndex->recordRemove(key);
+
+        bool removed = false;
+        if (!_bundles.empty())
+        {
+            removed = getBundle(key)->remove(key);
+            if (!_hasLegacyFiles)
+                return removed;
+        }
+
         URI fileURI( key, _metaPath );
-        std::string path( fileURI.full() + OSG_EXT );
 
         // exclusive file access:
         ScopedGate<std::string> lockFile(_fileGate, fileURI.full());
-        return ::unlink( path.c_str() ) == 0;
+
+        // images are stored in the configured image format
+        std::string imagePath( fileURI.full() + "." + _options.format().get() );
+        std::string path( fileURI.full() + OSG_EXT );
+
+        if (::unlink(imagePath.c_str()) == 0)
+            removed = true;
+
+        if (imagePath != path && ::unlink(path.c_str()) == 0)
+            removed = true;
+
+        if (removed)
+            ::unlink((fileURI.full() + ".meta").c_str());
+
+        return removed;
     }
 
     bool
     FileSystemCacheBin::touch(const std::string& key)
     {
         if ( !binValidForReading() ) return false;
+
+        noteAccess(key);
+
+        if (!_bundles.empty())
+        {
+            if (getBundle(key)->touch(key, DateTime().asTimeStamp()))
+                return true;
+            else if (!_hasLegacyFiles)
+                return false;
+        }
+
         URI fileURI( key, _metaPath );
         std::string path( fileURI.full() + OSG_EXT );
 
@@ -773,9 +1458,187 @@ namespace
         if ( !binValidForReading() )
             return false;
 
+        // release the bundle files before deleting them
+        for (auto& bundle : _bundles)
+            bundle->close();
+
+        _hasLegacyFiles = false;
+
+        if (_accessIndex)
+            _accessIndex->clear();
+
         std::string binDir = osgDB::getFilePath( _metaPath );
         return purgeDirectory( binDir );
     }
+
+    bool
+    FileSystemCacheBin::compact()
+    {
+        if (_bundles.empty() || !binValidForReading())
+            return false;
+
+        bool ok = true;
+
+        // move any records left in the "files" layout into the bundles
+        if (_hasLegacyFiles)
+        {
+            bool empty = false;
+            ok = importLegacyDirectory(_binPath, empty);
+            _hasLegacyFiles = !ok;
+        }
+
+        for (auto& bundle : _bundles)
+        {
+            ok = bundle->compact() && ok;
+        }
+
+        return ok;
+    }
+
+    off_t
+    FileSystemCacheBin::getStorageSize()
+    {
+        if (!binValidForReading())
+            return 0;
+
+        // the access index accounts for every record in the "files" layout
+        if (_accessIndex && _accessIndexLoaded && _bundles.empty())
+        {
+            return (off_t)_accessIndex->getTotalSize();
+        }
+
+        if (!_bundles.empty())
+        {
+            std::uint64_t total = 0u;
+            for (auto& bundle : _bundles)
+                total += bundle->getDataSize();
+
+            if (_hasLegacyFiles)
+                total += getDirectorySize(_binPath, _bundlePath);
+
+            return (off_t)total;
+        }
+
+        return (off_t)getDirectorySize(_binPath);
+    }
+
+    bool
+    FileSystemCacheBin::isAccessIndexFile(const std::string& path) const
+    {
+        // the index itself, or the temporary file it is saved through
+        return
+            !_accessIndexPath.empty() &&
+            path.compare(0, _accessIndexPath.length(), _accessIndexPath) == 0;
+    }
+
+    void
+    FileSystemCacheBin::noteAccess(const std::string& key)
+    {
+        if (_accessIndex)
+            _accessIndex->recordAccess(key, DateTime().asTimeStamp());
+    }
+
+    void
+    FileSystemCacheBin::loadAccessIndex()
+    {
+        if (!_accessIndex || _accessIndexLoaded)
+            return;
+
+        std::lock_guard<std::mutex> lock(_accessIndexMutex);
+        if (_accessIndexLoaded) // double-check
+            return;
+
+        if (!_accessIndex->load() && binValidForReading())
+        {
+            OE_INFO << LC << "Indexing cache bin \"" << getID() << "\"" << std::endl;
+
+            for (auto& bundle : _bundles)
+            {
+                std::vector<Bundle::Listing> listings;
+                bundle->list(listings);
+                for (auto& listing : listings)
+                {
+                    AccessIndex::Entry entry;
+                    entry.size = listing.size;
+                    entry.lastAccess = listing.timestamp;
+                    _accessIndex->insert(listing.key, entry);
+                }
+            }
+
+            if (_bundles.empty() || _hasLegacyFiles)
+            {
+                indexDirectory(_binPath);
+            }
+        }
+
+        _accessIndexLoaded = true;
+    }
+
+    void
+    FileSystemCacheBin::indexDirectory(const std::string& dir)
+    {
+        osgDB::DirectoryContents dc = osgDB::getDirectoryContents(dir);
+        for (auto& name : dc)
+        {
+            std::string full = osgDB::concatPaths(dir, name);
+
+            if (name == "." || name == ".." || full == _metaPath || full == _bundlePath || isAccessIndexFile(full))
+                continue;
+
+            osgDB::FileType type = osgDB::fileType(full);
+
+            if (type == osgDB::DIRECTORY)
+            {
+                indexDirectory(full);
+            }
+
+            else if (type == osgDB::REGULAR_FILE && osgDB::getFileExtension(full) != "meta")
+            {
+                // the record key is the path relative to the bin, less the extension
+                std::string key = osgDB::convertFileNameToUnixStyle(
+                    osgDB::getNameLessExtension(full.substr(_binPath.length() + 1)));
+
+                AccessIndex::Entry entry;
+                entry.size = getFileSize(full) + getFileSize(osgDB::getNameLessExtension(full) + ".meta");
+                entry.lastAccess = osgEarth::getLastModifiedTime(full);
+                _accessIndex->insert(key, entry);
+            }
+        }
+    }
+
+    void
+    FileSystemCacheBin::saveAccessIndex()
+    {
+        // don't write a partial index over one that hasn't been read yet
+        if (_accessIndex && _accessIndexLoaded && _binPathExists)
+        {
+            if (!_accessIndex->save() && _s_debug)
+            {
+                OE_NOTICE << LC << "Failed to save the access index of cache bin " << getID() << std::endl;
+            }
+        }
+    }
+
+    void
+    FileSystemCacheBin::getAccessEntries(AccessIndex::Entries& out)
+    {
+        if (_accessIndex)
+            _accessIndex->getEntries(out);
+    }
+
+    void
+    FileSystemCacheBin::compactSparseBundles()
+    {
+        for (auto& bundle : _bundles)
+        {
+            // compact once a quarter of the file is garbage
+            std::uint64_t dataSize = bundle->getDataSize();
+            if (dataSize > 0u && bundle->getLiveSize() < dataSize - dataSize / 4u)
+            {
+                bundle->compact();
+            }
+        }
+    }
 }
 
 //------------------------------------------------------------------------
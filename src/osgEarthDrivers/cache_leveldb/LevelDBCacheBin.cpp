@@ -251,28 +251,54 @@ LevelDBCacheBin::read(const std::string& key, const Reader& reader)
     if ( !binValidForReading() ) 
         return ReadResult(ReadResult::RESULT_NOT_FOUND);
 
-    ++_tracker->reads;
-
-    Config metadata;
-    leveldb::Status status;
     leveldb::ReadOptions ro;
 
     // first read the metadata record.
     std::string metavalue;
-    status = _db->Get( ro, metaKey(key), &metavalue );
+    leveldb::Status metaStatus = _db->Get( ro, metaKey(key), &metavalue );
+        
+    // next read the data record.
+    std::string datavalue;
+    leveldb::Status dataStatus = _db->Get( ro, dataKey(key), &datavalue );
+
+    return decode(key, metaStatus, metavalue, dataStatus, datavalue, reader);
+}
+
+ReadResult
+LevelDBCacheBin::decode(const std::string&     key,
+                        const leveldb::Status& metaStatus,
+                        const std::string&     metavalue,
+                        const leveldb::Status& dataStatus,
+                        std::string&           datavalue,
+                        bool                   image,
+                        const osgDB::Options*  readOptions)
+{
+    if (image)
+        return decode(key, metaStatus, metavalue, dataStatus, datavalue, ImageReader(_rw.get(), readOptions));
+    else
+        return decode(key, metaStatus, metavalue, dataStatus, datavalue, ObjectReader(_rw.get(), readOptions));
+}
+
+ReadResult
+LevelDBCacheBin::decode(const std::string&     key,
+                        const leveldb::Status& metaStatus,
+                        const std::string&     metavalue,
+                        const leveldb::Status& dataStatus,
+                        std::string&           datavalue,
+                        const Reader&          reader)
+{
+    ++_tracker->reads;
+
+    Config metadata;
     TimeStamp lastModified = (TimeStamp)0;
-    if ( status.ok() )
+    if ( metaStatus.ok() )
     {        
         decodeMeta(metavalue, metadata);
         DateTime t( metadata.value(TIME_FIELD));
         lastModified = t.asTimeStamp();
     }
-        
-    // next read the data record.
-    std::string datakey = dataKey(key);
-    std::string datavalue;
-    status = _db->Get( ro, datakey, &datavalue );
-    if ( !status.ok() )
+
+    if ( !dataStatus.ok() )
     {
         // main record not found for some reason.
         return ReadResult(ReadResult::RESULT_NOT_FOUND);
@@ -315,6 +341,32 @@ LevelDBCacheBin::read(const std::string& key, const Reader& reader)
     return rr;
 }
 
+std::vector<ReadResult>
+LevelDBCacheBin::readMany(const std::vector<std::string>& keys, bool images, const osgDB::Options* readOptions)
+{
+    if ( !binValidForReading() )
+        return std::vector<ReadResult>(keys.size(), ReadResult(ReadResult::RESULT_NOT_FOUND));
+
+    // LevelDB has no multi-key get; read everything from one snapshot
+    // instead so the batch sees a consistent view of the database.
+    leveldb::ReadOptions ro;
+    ro.snapshot = _db->GetSnapshot();
+
+    std::vector<ReadResult> results;
+    results.reserve(keys.size());
+    for (auto& key : keys)
+    {
+        std::string metavalue, datavalue;
+        leveldb::Status metaStatus = _db->Get( ro, metaKey(key), &metavalue );
+        leveldb::Status dataStatus = _db->Get( ro, dataKey(key), &datavalue );
+        results.push_back(decode(key, metaStatus, metavalue, dataStatus, datavalue, images, readOptions));
+    }
+
+    _db->ReleaseSnapshot(ro.snapshot);
+
+    return results;
+}
+
 ReadResult
 LevelDBCacheBin::readString(const std::string& key, const osgDB::Options* readOptions)
 {
@@ -333,11 +385,12 @@ LevelDBCacheBin::readString(const std::string& key, const osgDB::Options* readOp
 }
 
 bool
-LevelDBCacheBin::write(const std::string& key, const osg::Object* object, const Config& meta, const osgDB::Options* writeOptions)
+LevelDBCacheBin::encode(const std::string&    key,
+                        const osg::Object*    object,
+                        const Config&         meta,
+                        const osgDB::Options* writeOptions,
+                        leveldb::WriteBatch&  batch)
 {
-    if ( !binValidForWriting() || !object ) 
-        return false;
-        
     osgDB::ReaderWriter::WriteResult r;
     bool objWriteOK = false;
 
@@ -378,7 +431,6 @@ LevelDBCacheBin::write(const std::string& key, const osg::Object* object, const
     if (objWriteOK)
     {
         DateTime now;
-        leveldb::WriteBatch batch;
 
         // write the data:
         data = datastream.str();
@@ -394,29 +446,85 @@ LevelDBCacheBin::write(const std::string& key, const osg::Object* object, const
         metadata.set( TIME_FIELD, now.asCompactISO8601() );
         encodeMeta( metadata, data );
         batch.Put( metaKey(key), data );
+    }
+    else
+    {
+        OE_WARN << LC << "Bin " << getID() << ": FAILED to write (" << key << "); msg = \"" 
+            << r.message() << "\"\n";
+    }
+
+    return objWriteOK;
+}
 
-        objWriteOK = _db->Write( leveldb::WriteOptions(), &batch ).ok();
+bool
+LevelDBCacheBin::write(const std::string& key, const osg::Object* object, const Config& meta, const osgDB::Options* writeOptions)
+{
+    if ( !binValidForWriting() || !object ) 
+        return false;
 
-        if ( objWriteOK )
-        {
-            ++_tracker->writes;
-            postWrite();
+    leveldb::WriteBatch batch;
+
+    if ( !encode(key, object, meta, writeOptions, batch) )
+        return false;
+
+    if ( !_db->Write( leveldb::WriteOptions(), &batch ).ok() )
+    {
+        OE_WARN << LC << "Bin " << getID() << ": FAILED to write (" << key << ")\n";
+        return false;
+    }
+
+    ++_tracker->writes;
+    postWrite();
             
-            if ( _debug )
-            {
-                OE_NOTICE << LC << "Bin " << getID() << ": wrote (" << key << ")\n";
-            }
-        }
+    if ( _debug )
+    {
+        OE_NOTICE << LC << "Bin " << getID() << ": wrote (" << key << ")\n";
     }
 
-        
-    if ( !objWriteOK )
+    return true;
+}
+
+bool
+LevelDBCacheBin::writeMany(const std::vector<WriteRecord>& records, const osgDB::Options* writeOptions)
+{
+    if ( !binValidForWriting() ) 
+        return false;
+
+    // commit all the records in one batch
+    leveldb::WriteBatch batch;
+    unsigned count = 0;
+    bool ok = true;
+
+    for (auto& record : records)
     {
-        OE_WARN << LC << "Bin " << getID() << ": FAILED to write (" << key << "); msg = \"" 
-            << r.message() << "\"\n";
+        if ( record.object.valid() && encode(record.key, record.object.get(), record.metadata, writeOptions, batch) )
+            ++count;
+        else
+            ok = false;
     }
 
-    return objWriteOK;
+    if ( count == 0 )
+        return ok;
+
+    if ( !_db->Write( leveldb::WriteOptions(), &batch ).ok() )
+    {
+        OE_WARN << LC << "Bin " << getID() << ": FAILED to write a batch of " << count << " records\n";
+        return false;
+    }
+
+    // one count per record so the periodic size checks still fire
+    for (unsigned i = 0; i < count; ++i)
+    {
+        ++_tracker->writes;
+        postWrite();
+    }
+
+    if ( _debug )
+    {
+        OE_NOTICE << LC << "Bin " << getID() << ": wrote " << count << " records\n";
+    }
+
+    return ok;
 }
 
 void
@@ -592,11 +700,11 @@ LevelDBCacheBin::compact()
     return false;
 }
 
-unsigned
+off_t
 LevelDBCacheBin::getStorageSize()
 {
     if ( !binValidForReading() )
-        return false;
+        return 0;
 
     //Note: doesn't work..
     leveldb::Range ranges[3];
@@ -608,7 +716,7 @@ LevelDBCacheBin::getStorageSize()
     sizes[0] = sizes[1] = sizes[2] = 0;
 
     _db->GetApproximateSizes( ranges, 3, sizes );
-    return sizes[0] + sizes[1] + sizes[2];
+    return (off_t)(sizes[0] + sizes[1] + sizes[2]);
 }
 
 Config
@@ -256,3 +256,42 @@ RocksDBCacheImpl::clear()
 
     return true;
 }
+
+void
+RocksDBCacheImpl::readMany(std::vector<BinRead>& reads, const osgDB::Options* dbo)
+{
+    if ( !_db )
+        return;
+
+    // All bins share one database, so a single lookup covers every request.
+    std::vector<RocksDBCacheBin*> bins;
+    std::vector<unsigned> indices;
+    std::vector<std::string> dbkeys;
+
+    for (unsigned i = 0; i < reads.size(); ++i)
+    {
+        RocksDBCacheBin* bin = dynamic_cast<RocksDBCacheBin*>(reads[i].bin);
+        if ( bin && bin->getRecordKeys(reads[i].key, dbkeys) )
+        {
+            bins.push_back(bin);
+            indices.push_back(i);
+        }
+    }
+
+    if ( indices.empty() )
+        return;
+
+    std::vector<rocksdb::Slice> slices(dbkeys.begin(), dbkeys.end());
+    std::vector<std::string> values;
+    std::vector<rocksdb::Status> statuses = _db->MultiGet(rocksdb::ReadOptions(), slices, &values);
+
+    for (unsigned k = 0; k < indices.size(); ++k)
+    {
+        BinRead& read = reads[indices[k]];
+        read.result = bins[k]->decode(
+            read.key,
+            statuses[2*k], values[2*k],
+            statuses[2*k+1], values[2*k+1],
+            read.image, dbo);
+    }
+}
@@ -245,28 +245,54 @@ RocksDBCacheBin::read(const std::string& key, const Reader& reader)
     if ( !binValidForReading() ) 
         return ReadResult(ReadResult::RESULT_NOT_FOUND);
 
-    ++_tracker->reads;
-
-    Config metadata;
-    rocksdb::Status status;
     rocksdb::ReadOptions ro;
 
     // first read the metadata record.
     std::string metavalue;
-    status = _db->Get( ro, metaKey(key), &metavalue );
+    rocksdb::Status metaStatus = _db->Get( ro, metaKey(key), &metavalue );
+        
+    // next read the data record.
+    std::string datavalue;
+    rocksdb::Status dataStatus = _db->Get( ro, dataKey(key), &datavalue );
+
+    return decode(key, metaStatus, metavalue, dataStatus, datavalue, reader);
+}
+
+ReadResult
+RocksDBCacheBin::decode(const std::string&     key,
+                        const rocksdb::Status& metaStatus,
+                        const std::string&     metavalue,
+                        const rocksdb::Status& dataStatus,
+                        std::string&           datavalue,
+                        bool                   image,
+                        const osgDB::Options*  readOptions)
+{
+    if (image)
+        return decode(key, metaStatus, metavalue, dataStatus, datavalue, ImageReader(_rw.get(), readOptions));
+    else
+        return decode(key, metaStatus, metavalue, dataStatus, datavalue, ObjectReader(_rw.get(), readOptions));
+}
+
+ReadResult
+RocksDBCacheBin::decode(const std::string&     key,
+                        const rocksdb::Status& metaStatus,
+                        const std::string&     metavalue,
+                        const rocksdb::Status& dataStatus,
+                        std::string&           datavalue,
+                        const Reader&          reader)
+{
+    ++_tracker->reads;
+
+    Config metadata;
     TimeStamp lastModified = (TimeStamp)0;
-    if ( status.ok() )
+    if ( metaStatus.ok() )
     {        
         decodeMeta(metavalue, metadata);
         DateTime t( metadata.value(TIME_FIELD));
         lastModified = t.asTimeStamp();
     }
-        
-    // next read the data record.
-    std::string datakey = dataKey(key);
-    std::string datavalue;
-    status = _db->Get( ro, datakey, &datavalue );
-    if ( !status.ok() )
+
+    if ( !dataStatus.ok() )
     {
         // main record not found for some reason.
         return ReadResult(ReadResult::RESULT_NOT_FOUND);
@@ -309,6 +335,47 @@ RocksDBCacheBin::read(const std::string& key, const Reader& reader)
     return rr;
 }
 
+bool
+RocksDBCacheBin::getRecordKeys(const std::string& key, std::vector<std::string>& out)
+{
+    if ( !binValidForReading() )
+        return false;
+
+    out.push_back(metaKey(key));
+    out.push_back(dataKey(key));
+    return true;
+}
+
+std::vector<ReadResult>
+RocksDBCacheBin::readMany(const std::vector<std::string>& keys, bool images, const osgDB::Options* readOptions)
+{
+    if ( !binValidForReading() )
+        return std::vector<ReadResult>(keys.size(), ReadResult(ReadResult::RESULT_NOT_FOUND));
+
+    // fetch every metadata and data record in one lookup
+    std::vector<std::string> dbkeys;
+    dbkeys.reserve(keys.size() * 2);
+    for (auto& key : keys)
+        getRecordKeys(key, dbkeys);
+
+    std::vector<rocksdb::Slice> slices(dbkeys.begin(), dbkeys.end());
+    std::vector<std::string> values;
+    std::vector<rocksdb::Status> statuses = _db->MultiGet(rocksdb::ReadOptions(), slices, &values);
+
+    std::vector<ReadResult> results;
+    results.reserve(keys.size());
+    for (unsigned i = 0; i < keys.size(); ++i)
+    {
+        results.push_back(decode(
+            keys[i],
+            statuses[2*i], values[2*i],
+            statuses[2*i+1], values[2*i+1],
+            images, readOptions));
+    }
+
+    return results;
+}
+
 ReadResult
 RocksDBCacheBin::readString(const std::string& key, const osgDB::Options* readOptions)
 {
@@ -327,11 +394,12 @@ RocksDBCacheBin::readString(const std::string& key, const osgDB::Options* readOp
 }
 
 bool
-RocksDBCacheBin::write(const std::string& key, const osg::Object* object, const Config& meta, const osgDB::Options* writeOptions)
+RocksDBCacheBin::encode(const std::string&    key,
+                        const osg::Object*    object,
+                        const Config&         meta,
+                        const osgDB::Options* writeOptions,
+                        rocksdb::WriteBatch&  batch)
 {
-    if ( !binValidForWriting() || !object ) 
-        return false;
-        
     osgDB::ReaderWriter::WriteResult r;
     bool objWriteOK = false;
 
@@ -372,7 +440,6 @@ RocksDBCacheBin::write(const std::string& key, const osg::Object* object, const
     if (objWriteOK)
     {
         DateTime now;
-        rocksdb::WriteBatch batch;
 
         // write the data:
         data = datastream.str();
@@ -388,29 +455,85 @@ RocksDBCacheBin::write(const std::string& key, const osg::Object* object, const
         metadata.set( TIME_FIELD, now.asCompactISO8601() );
         encodeMeta( metadata, data );
         batch.Put( metaKey(key), data );
+    }
+    else
+    {
+        OE_WARN << LC << "Bin " << getID() << ": FAILED to write (" << key << "); msg = \"" 
+            << r.message() << "\"\n";
+    }
 
-        objWriteOK = _db->Write( rocksdb::WriteOptions(), &batch ).ok();
+    return objWriteOK;
+}
 
-        if ( objWriteOK )
-        {
-            ++_tracker->writes;
-            postWrite();
+bool
+RocksDBCacheBin::write(const std::string& key, const osg::Object* object, const Config& meta, const osgDB::Options* writeOptions)
+{
+    if ( !binValidForWriting() || !object ) 
+        return false;
+
+    rocksdb::WriteBatch batch;
+
+    if ( !encode(key, object, meta, writeOptions, batch) )
+        return false;
+
+    if ( !_db->Write( rocksdb::WriteOptions(), &batch ).ok() )
+    {
+        OE_WARN << LC << "Bin " << getID() << ": FAILED to write (" << key << ")\n";
+        return false;
+    }
+
+    ++_tracker->writes;
+    postWrite();
             
-            if ( _debug )
-            {
-                OE_NOTICE << LC << "Bin " << getID() << ": wrote (" << key << ")\n";
-            }
-        }
+    if ( _debug )
+    {
+        OE_NOTICE << LC << "Bin " << getID() << ": wrote (" << key << ")\n";
     }
 
-        
-    if ( !objWriteOK )
+    return true;
+}
+
+bool
+RocksDBCacheBin::writeMany(const std::vector<WriteRecord>& records, const osgDB::Options* writeOptions)
+{
+    if ( !binValidForWriting() ) 
+        return false;
+
+    // commit all the records in one batch
+    rocksdb::WriteBatch batch;
+    unsigned count = 0;
+    bool ok = true;
+
+    for (auto& record : records)
     {
-        OE_WARN << LC << "Bin " << getID() << ": FAILED to write (" << key << "); msg = \"" 
-            << r.message() << "\"\n";
+        if ( record.object.valid() && encode(record.key, record.object.get(), record.metadata, writeOptions, batch) )
+            ++count;
+        else
+            ok = false;
     }
 
-    return objWriteOK;
+    if ( count == 0 )
+        return ok;
+
+    if ( !_db->Write( rocksdb::WriteOptions(), &batch ).ok() )
+    {
+        OE_WARN << LC << "Bin " << getID() << ": FAILED to write a batch of " << count << " records\n";
+        return false;
+    }
+
+    // one count per record so the periodic size checks still fire
+    for (unsigned i = 0; i < count; ++i)
+    {
+        ++_tracker->writes;
+        postWrite();
+    }
+
+    if ( _debug )
+    {
+        OE_NOTICE << LC << "Bin " << getID() << ": wrote " << count << " records\n";
+    }
+
+    return ok;
 }
 
 void
@@ -586,11 +709,11 @@ RocksDBCacheBin::compact()
     return false;
 }
 
-unsigned
+off_t
 RocksDBCacheBin::getStorageSize()
 {
     if ( !binValidForReading() )
-        return false;
+        return 0;
 
     //Note: doesn't work..
     rocksdb::Range ranges[3];
@@ -602,7 +725,7 @@ RocksDBCacheBin::getStorageSize()
     sizes[0] = sizes[1] = sizes[2] = 0;
 
     _db->GetApproximateSizes( ranges, 3, sizes );
-    return sizes[0] + sizes[1] + sizes[2];
+    return (off_t)(sizes[0] + sizes[1] + sizes[2]);
 }
 
 Config
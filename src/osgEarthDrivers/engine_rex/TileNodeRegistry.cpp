@@ -78,9 +78,9 @@ TileNodeRegistry::add(TileNode* tile)
     std::lock_guard<std::mutex> lock(_mutex);
 
     auto& entry = _tiles[tile->getKey()];
+    bool recyclingOrphan = entry._tile.valid();
     entry._tile = tile;
-    bool recyclingOrphan = entry._trackerToken != nullptr;
-    entry._trackerToken = _tracker.use(tile, nullptr);
+    _tracker.use(tile, tile->getUsageStamp());
 
     // Start waiting on our neighbors.
     // (If we're recycling and orphaned record, we need to remove old listeners first)
@@ -190,16 +190,11 @@ TileNodeRegistry::releaseAll(osg::State* state)
 void
 TileNodeRegistry::touch(TileNode* tile, osg::NodeVisitor& nv)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-
-    TileTable::iterator i = _tiles.find(tile->getKey());
-
-    OE_SOFT_ASSERT_AND_RETURN(i != _tiles.end(), void());
-
-    _tracker.use(tile, i->second._trackerToken);
+    _tracker.use(tile, tile->getUsageStamp());
 
     if (tile->updateRequired())
     {
+        std::lock_guard<std::mutex> lock(_mutex);
         _tilesToUpdate.push_back(tile->getKey());
     }
 }
@@ -259,17 +254,23 @@ TileNodeRegistry::collectDormantTiles(
             tile->getLastTraversalRange() > farthestAllowableRange &&
             tile->areSiblingsDormant())
         {
-            if (_notifyNeighbors)
+            // A tile touched again after leaving the registry is tracked
+            // without a table entry, and a newer tile may own its key.
+            auto i = _tiles.find(key);
+            if (i != _tiles.end() && i->second._tile == tile)
             {
-                // remove neighbor listeners:
-                stopListeningFor(key.createNeighborKey(1, 0), key);
-                stopListeningFor(key.createNeighborKey(0, 1), key);
+                if (_notifyNeighbors)
+                {
+                    // remove neighbor listeners:
+                    stopListeningFor(key.createNeighborKey(1, 0), key);
+                    stopListeningFor(key.createNeighborKey(0, 1), key);
+                }
+
+                _tiles.erase(i);
             }
 
             output.push_back(tile);
 
-            _tiles.erase(key);
-
             return true; // dispose it
         }
         else
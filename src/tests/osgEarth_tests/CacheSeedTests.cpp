@@ -0,0 +1,163 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/CacheBin>
+#include <osgEarth/CacheSeed>
+#include <osgEarth/GDAL>
+#include <osgEarth/ImageLayer>
+#include <osgEarth/Map>
+#include <osgEarth/MemCache>
+#include <cstring>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+using namespace osgEarth::Contrib;
+
+namespace
+{
+    const unsigned maxLevel = 3u;
+
+    // Each seed gets a map of its own, like a separate process would.
+    osg::ref_ptr<Map> createMap(Cache* cache, osg::ref_ptr<ImageLayer>& out_layer)
+    {
+        osg::ref_ptr<Map> map = new Map();
+        map->setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+        map->setCache(cache);
+
+        GDALImageLayer* layer = new GDALImageLayer();
+        layer->setName("world");
+        layer->setURL("../data/world.tif");
+        map->addLayer(layer);
+
+        out_layer = layer;
+        return map;
+    }
+
+    MultithreadedTileVisitor* createVisitor(const Map* map, unsigned shard, unsigned numShards)
+    {
+        MultithreadedTileVisitor* visitor = new MultithreadedTileVisitor();
+        visitor->setNumThreads(2);
+        visitor->setMaxLevel(maxLevel);
+        visitor->setShard(shard, numShards);
+        visitor->addExtentToVisit(map->getProfile()->getExtent());
+        return visitor;
+    }
+
+    void collectKeys(const TileKey& key, std::vector<TileKey>& keys)
+    {
+        keys.push_back(key);
+        if (key.getLevelOfDetail() < maxLevel)
+        {
+            for (unsigned c = 0; c < 4; ++c)
+                collectKeys(key.createChildKey(c), keys);
+        }
+    }
+}
+
+TEST_CASE("CacheSeed shards merge into the same cache as a single seed")
+{
+    const unsigned numShards = 3;
+
+    // Seed each shard into its own cache
+    std::vector<osg::ref_ptr<Cache> > shards;
+    for (unsigned i = 0; i < numShards; ++i)
+    {
+        osg::ref_ptr<Cache> cache = new MemCache(4096u, true);
+        osg::ref_ptr<ImageLayer> layer;
+        osg::ref_ptr<Map> map = createMap(cache.get(), layer);
+        REQUIRE(layer->isOpen());
+
+        CacheSeed seeder;
+        seeder.setVisitor(createVisitor(map.get(), i, numShards));
+        seeder.run(layer.get(), map.get());
+        shards.push_back(cache);
+    }
+
+    // Seed the whole thing in one go
+    osg::ref_ptr<Cache> single = new MemCache(4096u, true);
+    {
+        osg::ref_ptr<ImageLayer> layer;
+        osg::ref_ptr<Map> map = createMap(single.get(), layer);
+
+        CacheSeed seeder;
+        seeder.setVisitor(createVisitor(map.get(), 0, 1));
+        seeder.run(layer.get(), map.get());
+    }
+
+    // Merge the shards
+    osg::ref_ptr<Cache> merged = new MemCache(4096u, true);
+    osg::ref_ptr<ImageLayer> layer;
+    osg::ref_ptr<Map> map = createMap(merged.get(), layer);
+
+    CacheSeed seeder;
+    seeder.setVisitor(createVisitor(map.get(), 0, 1));
+    unsigned numMerged = seeder.merge(layer.get(), map.get(), shards);
+
+    // Every tile in the single seed is in exactly one shard, and in the merged cache
+    std::vector<TileKey> keys, roots;
+    map->getProfile()->getRootKeys(roots);
+    for (auto& root : roots)
+        collectKeys(root, keys);
+
+    const std::string binID = layer->getCacheID();
+    std::vector<unsigned> perShard(numShards, 0u);
+    unsigned numTiles = 0;
+
+    for (auto& key : keys)
+    {
+        std::string cacheKey = layer->getCacheKey(key);
+
+        ReadResult expected = single->addBin(binID)->readImage(cacheKey, nullptr);
+        ReadResult actual = merged->addBin(binID)->readImage(cacheKey, nullptr);
+        REQUIRE(expected.succeeded() == actual.succeeded());
+
+        if (expected.succeeded())
+        {
+            ++numTiles;
+
+            const osg::Image* a = expected.getImage();
+            const osg::Image* b = actual.getImage();
+            REQUIRE(a->s() == b->s());
+            REQUIRE(a->t() == b->t());
+            REQUIRE(a->getTotalSizeInBytes() == b->getTotalSizeInBytes());
+            REQUIRE(std::memcmp(a->data(), b->data(), a->getTotalSizeInBytes()) == 0);
+
+            unsigned found = 0;
+            for (unsigned i = 0; i < numShards; ++i)
+            {
+                if (shards[i]->addBin(binID)->getRecordStatus(cacheKey) == CacheBin::STATUS_OK)
+                {
+                    ++found;
+                    ++perShard[i];
+                }
+            }
+            REQUIRE(found == 1u);
+        }
+    }
+
+    REQUIRE(numTiles == keys.size());
+    REQUIRE(numMerged == numTiles);
+
+    for (unsigned i = 0; i < numShards; ++i)
+        REQUIRE(perShard[i] > 0u);
+}
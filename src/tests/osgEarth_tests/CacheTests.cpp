@@ -24,8 +24,18 @@
 #include <osgEarth/GeoData>
 #include <osgEarth/Registry>
 #include <osgEarth/MemCache>
+#include <osgEarth/CachePolicy>
+#include <osgEarth/DateTime>
+#include <osgEarth/ImageUtils>
+#include <osgEarth/Containers>
+#include <osgEarth/StringUtils>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
 
 using namespace osgEarth;
+using namespace osgEarth::Util;
 
 TEST_CASE( "Cache" ) {
 
@@ -83,3 +93,502 @@ TEST_CASE( "Cache" ) {
         REQUIRE(r2.failed());
     }  
 }
+
+TEST_CASE("Concurrent MemCache") {
+
+    osg::ref_ptr<Cache> cache = new MemCache(64u, true);
+    osg::ref_ptr<CacheBin> bin = cache->addBin("test_bin");
+    REQUIRE(bin.valid());
+
+    osg::ref_ptr<StringObject> s = new StringObject("value");
+    REQUIRE(bin->write("key", s.get(), 0L));
+    REQUIRE(bin->readString("key", 0L).succeeded());
+    REQUIRE(bin->getRecordStatus("key") == CacheBin::STATUS_OK);
+    REQUIRE(bin->remove("key"));
+    REQUIRE(bin->readString("key", 0L).failed());
+}
+
+TEST_CASE("MemCache byte budget") {
+
+    // 8 entries => a single shard, so the whole budget applies to one LRU
+    osg::ref_ptr<MemCache> cache = new MemCache(8u, true);
+    cache->setMaxBinBytes(4u * 64u * 64u * 4u);
+    osg::ref_ptr<CacheBin> bin = cache->addBin("test_bin");
+
+    for (int i = 0; i < 8; ++i)
+    {
+        osg::ref_ptr<osg::Image> image = new osg::Image();
+        image->allocateImage(64, 64, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+        REQUIRE(bin->write(Stringify() << i, image.get(), 0L));
+    }
+
+    unsigned cached = 0u;
+    for (int i = 0; i < 8; ++i)
+        if (bin->readImage(Stringify() << i, 0L).succeeded())
+            ++cached;
+
+    REQUIRE(cached == 4u);
+}
+
+namespace
+{
+    // Writes 8 images, half with writeMany and half one at a time, then
+    // checks that readMany returns what single reads return for them and
+    // for 2 keys that were never written.
+    void checkBatchedReads(Cache* cache)
+    {
+        osg::ref_ptr<CacheBin> bin = cache->addBin("batch_bin");
+        REQUIRE(bin.valid());
+        bin->clear();
+
+        std::vector<std::string> keys;
+        for (int i = 0; i < 10; ++i)
+            keys.push_back(Stringify() << "batch_" << i);
+
+        std::vector<CacheBin::WriteRecord> records;
+        for (int i = 0; i < 4; ++i)
+        {
+            CacheBin::WriteRecord record;
+            record.key = keys[i];
+            record.object = ImageUtils::createOnePixelImage(osg::Vec4((float)i / 8.0f, 0, 0, 1));
+            records.push_back(record);
+        }
+        REQUIRE(bin->writeMany(records, nullptr));
+
+        for (int i = 4; i < 8; ++i)
+        {
+            osg::ref_ptr<osg::Image> image = ImageUtils::createOnePixelImage(osg::Vec4((float)i / 8.0f, 0, 0, 1));
+            REQUIRE(bin->write(keys[i], image.get(), nullptr));
+        }
+
+        // a policy under which every record written so far is expired
+        CachePolicy expireAll;
+        expireAll.minTime() = DateTime().asTimeStamp() + 3600;
+
+        std::vector<ReadResult> batched = bin->readMany(keys, true, nullptr);
+        REQUIRE(batched.size() == keys.size());
+
+        for (unsigned i = 0; i < keys.size(); ++i)
+        {
+            ReadResult single = bin->readImage(keys[i], nullptr);
+            REQUIRE(single.succeeded() == (i < 8));
+            REQUIRE(batched[i].succeeded() == single.succeeded());
+            REQUIRE(batched[i].code() == single.code());
+            if (single.succeeded())
+            {
+                REQUIRE(ImageUtils::areEquivalent(batched[i].getImage(), single.getImage()));
+                REQUIRE(batched[i].lastModifiedTime() == single.lastModifiedTime());
+                REQUIRE(expireAll.isExpired(batched[i].lastModifiedTime()));
+                REQUIRE(expireAll.isExpired(single.lastModifiedTime()));
+            }
+        }
+
+        // the same keys through Cache::readMany, spread over two bins
+        osg::ref_ptr<CacheBin> other = cache->addBin("batch_bin_2");
+        REQUIRE(other.valid());
+        other->clear();
+        osg::ref_ptr<osg::Image> image = ImageUtils::createOnePixelImage(osg::Vec4(0, 1, 0, 1));
+        REQUIRE(other->write(keys[0], image.get(), nullptr));
+
+        std::vector<Cache::BinRead> reads;
+        for (unsigned i = 0; i < keys.size(); ++i)
+        {
+            Cache::BinRead read;
+            read.bin = (i % 2 == 0) ? bin.get() : other.get();
+            read.key = keys[i];
+            read.image = true;
+            reads.push_back(read);
+        }
+        cache->readMany(reads, nullptr);
+
+        for (auto& read : reads)
+        {
+            ReadResult single = read.bin->readImage(read.key, nullptr);
+            REQUIRE(read.result.succeeded() == single.succeeded());
+            if (single.succeeded())
+            {
+                REQUIRE(ImageUtils::areEquivalent(read.result.getImage(), single.getImage()));
+                REQUIRE(read.result.lastModifiedTime() == single.lastModifiedTime());
+            }
+        }
+
+        bin->clear();
+        other->clear();
+    }
+
+    osg::ref_ptr<Cache> openCache(const std::string& driver)
+    {
+        Config conf;
+        conf.set("driver", driver);
+        conf.set("path", driver + "_batch_test");
+        return CacheFactory::create(CacheOptions(ConfigOptions(conf)));
+    }
+}
+
+TEST_CASE("CacheBin batched reads match single reads") {
+
+    SECTION("MemCache")
+    {
+        osg::ref_ptr<Cache> cache = new MemCache(64u, true);
+        checkBatchedReads(cache.get());
+    }
+
+    // LevelDB and RocksDB are optional plugins
+    SECTION("LevelDB (snapshot reads)")
+    {
+        osg::ref_ptr<Cache> cache = openCache("leveldb");
+        if (cache.valid() && cache->getStatus().isOK())
+            checkBatchedReads(cache.get());
+        else
+            WARN("Skipped: the leveldb cache driver is not available");
+    }
+
+    SECTION("RocksDB (MultiGet and WriteBatch)")
+    {
+        osg::ref_ptr<Cache> cache = openCache("rocksdb");
+        if (cache.valid() && cache->getStatus().isOK())
+            checkBatchedReads(cache.get());
+        else
+            WARN("Skipped: the rocksdb cache driver is not available");
+    }
+}
+
+TEST_CASE("ConcurrentLRUCache") {
+
+    SECTION("Entry budget")
+    {
+        ConcurrentLRUCache<int, int> cache(100u, 4u);
+        for (int i = 0; i < 1000; ++i)
+            cache.insert(i, i * 2);
+
+        REQUIRE(cache.getStats()._entries <= 100u);
+
+        // most recent insert is always retained
+        ConcurrentLRUCache<int, int>::Record rec;
+        REQUIRE(cache.get(999, rec));
+        REQUIRE(rec.value() == 1998);
+
+        unsigned evictions = 0u;
+        for (auto& shard : cache.getShardStats())
+            evictions += (unsigned)shard._evictions;
+        REQUIRE(evictions + cache.getStats()._entries == 1000u);
+    }
+
+    SECTION("Referenced entries survive")
+    {
+        // a single shard makes eviction order deterministic
+        ConcurrentLRUCache<int, int> cache(10u, 1u);
+        for (int i = 0; i < 10; ++i)
+            cache.insert(i, i);
+
+        // insert one more to clear all the reference bits, then touch key 1
+        cache.insert(10, 10);
+        ConcurrentLRUCache<int, int>::Record rec;
+        cache.get(1, rec);
+        for (int i = 11; i < 15; ++i)
+            cache.insert(i, i);
+
+        REQUIRE(cache.has(1));
+        REQUIRE(cache.getStats()._entries == 10u);
+    }
+
+    SECTION("Byte budget")
+    {
+        ConcurrentLRUCache<int, std::string> cache(1000u, 1u);
+        cache.setMaxBytes(100u, [](const std::string& v) { return v.size(); });
+        for (int i = 0; i < 50; ++i)
+            cache.insert(i, std::string(10, 'x'));
+
+        REQUIRE(cache.getShardStats()[0]._bytes <= 100u);
+        REQUIRE(cache.getStats()._entries == 10u);
+    }
+
+    SECTION("Erase and clear")
+    {
+        ConcurrentLRUCache<int, int> cache(100u);
+        cache.insert(1, 1);
+        cache.insert(2, 2);
+        cache.erase(1);
+        REQUIRE(!cache.has(1));
+        REQUIRE(cache.has(2));
+        cache.clear();
+        REQUIRE(cache.getStats()._entries == 0u);
+    }
+}
+
+namespace
+{
+    struct WeakValue : public osg::Referenced
+    {
+        WeakValue(int v) : _v(v) { }
+        int _v;
+    };
+}
+
+TEST_CASE("ConcurrentWeakMap") {
+
+    ConcurrentWeakMap<int, WeakValue> map(4u);
+
+    SECTION("Values live as long as someone holds them")
+    {
+        osg::ref_ptr<WeakValue> value = new WeakValue(1);
+        map.insert(1, value.get());
+
+        osg::ref_ptr<WeakValue> out;
+        REQUIRE(map.get(1, out));
+        REQUIRE(out->_v == 1);
+
+        value = nullptr;
+        out = nullptr;
+        REQUIRE_FALSE(map.get(1, out));
+        REQUIRE(map.size() == 0u); // the orphaned entry is gone
+    }
+
+    SECTION("Concurrent requests for a key share one build")
+    {
+        std::atomic_int builds = { 0 };
+        std::vector<osg::ref_ptr<WeakValue>> results(8);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    results[t] = map.getOrCreate(7, [&]()
+                        {
+                            ++builds;
+                            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                            return osg::ref_ptr<WeakValue>(new WeakValue(7));
+                        });
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(builds == 1);
+        for (auto& result : results)
+            REQUIRE(result.get() == results[0].get());
+
+        std::uint64_t misses = 0u, shared = 0u, hits = 0u;
+        for (auto& shard : map.getShardStats())
+            misses += shard._misses, shared += shard._shared, hits += shard._hits;
+        REQUIRE(misses == 1u);
+        REQUIRE(shared + hits == 7u);
+    }
+
+    SECTION("A failed build is not shared")
+    {
+        bool found = true;
+        auto value = map.getOrCreate(3, []() { return osg::ref_ptr<WeakValue>(); }, &found);
+        REQUIRE_FALSE(value.valid());
+        REQUIRE_FALSE(found);
+        REQUIRE(map.size() == 0u);
+
+        value = map.getOrCreate(3, []() { return osg::ref_ptr<WeakValue>(new WeakValue(3)); });
+        REQUIRE(value->_v == 3);
+        map.getOrCreate(3, []() { return osg::ref_ptr<WeakValue>(); }, &found);
+        REQUIRE(found);
+    }
+
+    SECTION("A canceled waiter stops waiting for another thread's build")
+    {
+        struct AlwaysCanceled : public Cancelable {
+            bool canceled() const override { return true; }
+        } canceled;
+
+        std::atomic_bool building = { false }, release = { false };
+        std::thread builder([&]()
+            {
+                map.getOrCreate(5, [&]()
+                    {
+                        building = true;
+                        while (!release)
+                            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        return osg::ref_ptr<WeakValue>(new WeakValue(5));
+                    });
+            });
+        while (!building)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        bool found = true;
+        auto value = map.getOrCreate(5, []() { return osg::ref_ptr<WeakValue>(new WeakValue(-1)); }, &found, &canceled);
+
+        release = true;
+        builder.join();
+
+        REQUIRE_FALSE(value.valid());
+        REQUIRE_FALSE(found);
+    }
+
+    SECTION("A build that throws releases its waiters")
+    {
+        std::atomic_bool building = { false }, release = { false }, threw = { false };
+        std::thread builder([&]()
+            {
+                try {
+                    map.getOrCreate(9, [&]() -> osg::ref_ptr<WeakValue>
+                        {
+                            building = true;
+                            while (!release)
+                                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                            throw std::runtime_error("build failed");
+                        });
+                }
+                catch (const std::runtime_error&) {
+                    threw = true;
+                }
+            });
+        while (!building)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        osg::ref_ptr<WeakValue> value;
+        std::thread waiter([&]()
+            {
+                value = map.getOrCreate(9, []() { return osg::ref_ptr<WeakValue>(new WeakValue(9)); });
+            });
+
+        // give the waiter time to block on the build
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        release = true;
+        builder.join();
+        waiter.join();
+
+        REQUIRE(threw);
+        REQUIRE(value.valid());
+        REQUIRE(value->_v == 9);
+    }
+
+    SECTION("Expired entries are swept as the map grows")
+    {
+        for (int i = 0; i < 10000; ++i)
+        {
+            osg::ref_ptr<WeakValue> value = new WeakValue(i);
+            map.insert(i, value.get());
+        }
+        REQUIRE(map.size() < 1000u);
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+// Lookups on a table of weak references, about one in nine missing,
+// compared with an unordered_map behind one reader/writer lock.
+TEST_CASE("Weak table contention", "[.][benchmark]") {
+
+    using clock = std::chrono::steady_clock;
+    const int num_keys = 4096;
+    const unsigned lookups_per_thread = 200000u;
+
+    std::vector<osg::ref_ptr<WeakValue>> values(num_keys);
+    for (int i = 0; i < num_keys; ++i)
+        values[i] = new WeakValue(i);
+
+    struct LockedTable {
+        std::unordered_map<int, osg::observer_ptr<WeakValue>> _map;
+        Threading::ReadWriteMutex _mutex;
+        osg::ref_ptr<WeakValue> getOrCreate(int key) {
+            osg::ref_ptr<WeakValue> out;
+            {
+                Threading::ScopedReadLock lock(_mutex);
+                auto i = _map.find(key);
+                if (i != _map.end())
+                    i->second.lock(out);
+            }
+            if (!out.valid()) {
+                out = new WeakValue(key);
+                Threading::ScopedWriteLock lock(_mutex);
+                _map[key] = out.get();
+            }
+            return out;
+        }
+    };
+
+    auto run = [&](unsigned num_threads, bool sharded)
+    {
+        LockedTable locked;
+        ConcurrentWeakMap<int, WeakValue> map;
+        for (int i = 0; i < num_keys; ++i)
+        {
+            locked._map[i] = values[i].get();
+            map.insert(i, values[i].get());
+        }
+
+        auto t0 = clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    unsigned k = t * 7919u;
+                    for (unsigned i = 0; i < lookups_per_thread; ++i)
+                    {
+                        k = k * 1664525u + 1013904223u;
+                        int key = (int)((k >> 8) % (unsigned)(num_keys + num_keys / 8));
+                        if (sharded)
+                            map.getOrCreate(key, [key]() { return osg::ref_ptr<WeakValue>(new WeakValue(key)); });
+                        else
+                            locked.getOrCreate(key);
+                    }
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        return (double)(num_threads * lookups_per_thread) / s;
+    };
+
+    for (unsigned num_threads = 1u; num_threads <= 32u; num_threads *= 2u)
+    {
+        double a = run(num_threads, false);
+        double b = run(num_threads, true);
+        std::cout << "weak table: " << num_threads << " threads: "
+            << "locked " << (unsigned)(a / 1e6) << "M lookups/s, "
+            << "ConcurrentWeakMap " << (unsigned)(b / 1e6) << "M lookups/s" << std::endl;
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("LRUCache read contention", "[.][benchmark]") {
+
+    using clock = std::chrono::steady_clock;
+    const unsigned num_keys = 4096u;
+    const unsigned reads_per_thread = 200000u;
+
+    LRUCache<int, int> locked(true, num_keys);
+    ConcurrentLRUCache<int, int> sharded(num_keys);
+    for (unsigned i = 0; i < num_keys; ++i)
+    {
+        locked.insert(i, i);
+        sharded.insert(i, i);
+    }
+
+    auto run = [&](unsigned num_threads, auto& cache)
+    {
+        auto t0 = clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    typename std::decay<decltype(cache)>::type::Record rec;
+                    unsigned k = t * 7919u;
+                    for (unsigned i = 0; i < reads_per_thread; ++i)
+                    {
+                        k = k * 1664525u + 1013904223u;
+                        cache.get((int)(k % num_keys), rec);
+                    }
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        return (double)(num_threads * reads_per_thread) / s;
+    };
+
+    for (unsigned num_threads = 1u; num_threads <= 64u; num_threads *= 2u)
+    {
+        double a = run(num_threads, locked);
+        double b = run(num_threads, sharded);
+        std::cout << "lru cache: " << num_threads << " threads: "
+            << "LRUCache " << (unsigned)(a / 1e6) << "M reads/s, "
+            << "ConcurrentLRUCache " << (unsigned)(b / 1e6) << "M reads/s" << std::endl;
+    }
+}
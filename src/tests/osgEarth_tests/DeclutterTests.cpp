@@ -0,0 +1,165 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/ScreenSpaceLayoutImpl>
+#include <osg/Group>
+#include <chrono>
+#include <cfloat>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace osgEarth;
+using namespace osgEarth::Internal;
+
+namespace
+{
+    // synthetic window-space label boxes, a few per parent, front to back
+    std::vector<RenderLeafBox> createLeafBoxes(unsigned count, std::vector<osg::ref_ptr<osg::Node>>& parents)
+    {
+        std::mt19937 prng(count);
+        std::uniform_real_distribution<float> x(-100.0f, 2020.0f), y(-100.0f, 1180.0f);
+        std::uniform_real_distribution<float> w(10.0f, 160.0f), h(8.0f, 24.0f);
+
+        std::vector<RenderLeafBox> boxes;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (i % 3 == 0)
+                parents.push_back(new osg::Group());
+
+            float x0 = x(prng), y0 = y(prng);
+            boxes.emplace_back(parents.back().get(), osg::BoundingBox(x0, y0, 0, x0 + w(prng), y0 + h(prng), 0));
+        }
+        return boxes;
+    }
+
+    // the original brute-force declutter test
+    bool isClearBruteForce(const std::vector<RenderLeafBox>& used, const osg::BoundingBox& box, const osg::Node* parent)
+    {
+        for (auto& j : used)
+        {
+            bool isClear =
+                box.xMin() > j.second.xMax() ||
+                box.xMax() < j.second.xMin() ||
+                box.yMin() > j.second.yMax() ||
+                box.yMax() < j.second.yMin();
+
+            if (!isClear && parent != j.first)
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<bool> declutterBruteForce(const std::vector<RenderLeafBox>& boxes)
+    {
+        std::vector<RenderLeafBox> used;
+        std::vector<bool> visible;
+        for (auto& b : boxes)
+        {
+            visible.push_back(isClearBruteForce(used, b.second, b.first));
+            if (visible.back())
+                used.push_back(b);
+        }
+        return visible;
+    }
+
+    std::vector<bool> declutterGrid(DeclutterGrid& grid, const std::vector<RenderLeafBox>& boxes)
+    {
+        grid.reset(0, 0, 1920, 1080);
+        std::vector<bool> visible;
+        for (auto& b : boxes)
+        {
+            visible.push_back(grid.isClear(b.second, b.first));
+            if (visible.back())
+                grid.insert(b);
+        }
+        return visible;
+    }
+}
+
+TEST_CASE("DeclutterGrid matches the brute force declutter test")
+{
+    std::vector<osg::ref_ptr<osg::Node>> parents;
+    auto boxes = createLeafBoxes(5000, parents);
+
+    DeclutterGrid grid;
+    REQUIRE(declutterGrid(grid, boxes) == declutterBruteForce(boxes));
+
+    // re-use after a reset, with a different window size
+    grid.reset(0, 0, 800, 600);
+    REQUIRE(grid.size() == 0u);
+    REQUIRE(declutterGrid(grid, boxes) == declutterBruteForce(boxes));
+}
+
+TEST_CASE("DeclutterGrid handles off-screen and degenerate boxes")
+{
+    std::vector<osg::ref_ptr<osg::Node>> parents;
+    for (unsigned i = 0; i < 4; ++i)
+        parents.push_back(new osg::Group());
+
+    const float big = FLT_MAX, inf = std::numeric_limits<float>::infinity();
+    std::vector<RenderLeafBox> boxes = {
+        { parents[0].get(), osg::BoundingBox(-big, -big, 0, -big * 0.5f, -big * 0.5f, 0) },
+        { parents[1].get(), osg::BoundingBox(1e30f, 1e30f, 0, inf, inf, 0) },
+        { parents[2].get(), osg::BoundingBox(-inf, 10.0f, 0, inf, 20.0f, 0) },
+        { parents[3].get(), osg::BoundingBox(100.0f, 15.0f, 0, 120.0f, 25.0f, 0) }
+    };
+
+    DeclutterGrid grid;
+    REQUIRE(declutterGrid(grid, boxes) == declutterBruteForce(boxes));
+
+    // a NaN box is always clear and never claims space
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    osg::BoundingBox degenerate(nan, 0, 0, nan, 10.0f, 0);
+    grid.reset(0, 0, 1920, 1080);
+    REQUIRE(grid.isClear(degenerate, parents[0].get()));
+    grid.insert(std::make_pair(parents[0].get(), degenerate));
+    REQUIRE(grid.size() == 0u);
+    REQUIRE(grid.isClear(boxes[3].second, parents[3].get()));
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("Declutter cost per frame", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    for (unsigned count : { 1000u, 5000u, 20000u, 50000u })
+    {
+        std::vector<osg::ref_ptr<osg::Node>> parents;
+        auto boxes = createLeafBoxes(count, parents);
+        DeclutterGrid grid;
+
+        auto t0 = clock::now();
+        auto a = declutterBruteForce(boxes);
+        auto t1 = clock::now();
+        auto b = declutterGrid(grid, boxes);
+        auto t2 = clock::now();
+
+        REQUIRE(a == b);
+
+        std::cout << "declutter: " << count << " labels: "
+            << "brute force " << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms, "
+            << "grid " << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms"
+            << std::endl;
+    }
+}
@@ -0,0 +1,161 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/HeightFieldUtils>
+#include <atomic>
+
+using namespace osgEarth;
+
+namespace
+{
+    // Elevation layer with a planar surface (so bilinear resampling is exact)
+    // and no data west of "_east" or inside the ["_holeWest", "_holeEast"] band.
+    class PlaneElevationLayer : public ElevationLayer
+    {
+    public:
+        META_Layer(osgEarth, PlaneElevationLayer, Options, ElevationLayer, plane_elevation);
+
+        double _base = 0.0, _dhdx = 0.0, _dhdy = 0.0;
+        double _east = 1000.0, _holeWest = 1000.0, _holeEast = 1000.0;
+        mutable std::atomic<int> _calls{ 0 };
+
+        float height(double x, double y) const
+        {
+            return (float)(_base + _dhdx * x + _dhdy * y);
+        }
+
+    protected:
+        Status openImplementation() override
+        {
+            Status parent = ElevationLayer::openImplementation();
+            if (parent.isError())
+                return parent;
+
+            setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+            return Status::NoError;
+        }
+
+        GeoHeightField createHeightFieldImplementation(const TileKey& key, ProgressCallback*) const override
+        {
+            ++_calls;
+            const unsigned size = getTileSize();
+            const GeoExtent& ex = key.getExtent();
+            osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(ex, size, size, 0u);
+            for (unsigned row = 0; row < size; ++row)
+            {
+                double y = ex.yMin() + ex.height() * (double)row / (double)(size - 1);
+                for (unsigned col = 0; col < size; ++col)
+                {
+                    double x = ex.xMin() + ex.width() * (double)col / (double)(size - 1);
+                    bool empty = x >= _east || (x >= _holeWest && x <= _holeEast);
+                    hf->setHeight(col, row, empty ? NO_DATA_VALUE : height(x, y));
+                }
+            }
+            return GeoHeightField(hf.get(), ex);
+        }
+    };
+}
+
+TEST_CASE("ElevationLayerVector compositing")
+{
+    osg::ref_ptr<PlaneElevationLayer> base = new PlaneElevationLayer();
+    base->_base = 100.0;
+    base->_dhdx = 1.0;
+    base->open();
+
+    // coarser layer with a hole and a ragged eastern edge, so
+    // the compositor has to resample it and fall through to the base.
+    osg::ref_ptr<PlaneElevationLayer> top = new PlaneElevationLayer();
+    top->setTileSize(129);
+    top->_base = 2000.0;
+    top->_dhdy = 2.0;
+    top->_east = 10.4;
+    top->_holeWest = 10.0;
+    top->_holeEast = 10.2;
+    top->open();
+
+    REQUIRE(base->isOpen());
+    REQUIRE(top->isOpen());
+
+    ElevationLayerVector layers;
+    layers.push_back(base.get());
+    layers.push_back(top.get()); // highest priority last
+
+    TileKey key(8, 270, 90, Profile::create(Profile::GLOBAL_GEODETIC));
+    const GeoExtent& ex = key.getExtent();
+    const unsigned size = 257u;
+
+    osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(ex, size, size, 0u, true);
+    std::vector<float> resolutions(size * size, FLT_MAX);
+
+    REQUIRE(layers.populateHeightField(hf.get(), &resolutions, key, nullptr, INTERP_BILINEAR, nullptr));
+
+    // stay a couple of source posts away from the edges of the holes,
+    // where bilinear filtering blends the two layers.
+    const double margin = 0.03;
+    auto nearEdge = [&](double x, double edge) { return fabs(x - edge) < margin; };
+
+    for (unsigned row = 0; row < size; ++row)
+    {
+        double y = ex.yMin() + ex.height() * (double)row / (double)(size - 1);
+        for (unsigned col = 0; col < size; ++col)
+        {
+            double x = ex.xMin() + ex.width() * (double)col / (double)(size - 1);
+            if (nearEdge(x, 10.0) || nearEdge(x, 10.2) || nearEdge(x, 10.4))
+                continue;
+
+            bool fromTop = x < 10.0 || (x > 10.2 && x < 10.4);
+            PlaneElevationLayer* expected = fromTop ? top.get() : base.get();
+
+            REQUIRE(hf->getHeight(col, row) == Approx(expected->height(x, y)).margin(0.01));
+            REQUIRE(resolutions[row * size + col] != FLT_MAX);
+        }
+    }
+}
+
+TEST_CASE("ElevationLayerVector compositing skips covered layers")
+{
+    osg::ref_ptr<PlaneElevationLayer> base = new PlaneElevationLayer();
+    base->_base = 100.0;
+    base->open();
+
+    osg::ref_ptr<PlaneElevationLayer> top = new PlaneElevationLayer();
+    top->setTileSize(129);
+    top->_base = 500.0;
+    top->_dhdx = 3.0;
+    top->open();
+
+    ElevationLayerVector layers;
+    layers.push_back(base.get());
+    layers.push_back(top.get());
+
+    TileKey key(8, 270, 90, Profile::create(Profile::GLOBAL_GEODETIC));
+    osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(key.getExtent(), 257, 257, 0u, true);
+
+    REQUIRE(layers.populateHeightField(hf.get(), nullptr, key, nullptr, INTERP_BILINEAR, nullptr));
+
+    // the top layer covers the whole tile, so the base is never read
+    REQUIRE(top->_calls > 0);
+    REQUIRE(base->_calls == 0);
+}
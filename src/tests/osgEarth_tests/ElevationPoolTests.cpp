@@ -0,0 +1,204 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/ElevationPool>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/HeightFieldUtils>
+#include <osgEarth/Map>
+#include <osgEarth/Registry>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+
+namespace
+{
+    // Elevation layer that generates a smooth analytic surface,
+    // so the tests need no data files.
+    class SyntheticElevationLayer : public ElevationLayer
+    {
+    public:
+        META_Layer(osgEarth, SyntheticElevationLayer, Options, ElevationLayer, synthetic_elevation);
+
+    protected:
+        Status openImplementation() override
+        {
+            Status parent = ElevationLayer::openImplementation();
+            if (parent.isError())
+                return parent;
+
+            setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+            addDataExtent(DataExtent(getProfile()->getExtent(), 0u, 12u));
+            return Status::NoError;
+        }
+
+        GeoHeightField createHeightFieldImplementation(const TileKey& key, ProgressCallback*) const override
+        {
+            const unsigned size = 257u;
+            const GeoExtent& ex = key.getExtent();
+            osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(ex, size, size, 0u);
+            for (unsigned row = 0; row < size; ++row)
+            {
+                double y = ex.yMin() + ex.height() * (double)row / (double)(size - 1);
+                for (unsigned col = 0; col < size; ++col)
+                {
+                    double x = ex.xMin() + ex.width() * (double)col / (double)(size - 1);
+                    hf->setHeight(col, row, (float)(1000.0 * sin(osg::DegreesToRadians(x * 10.0)) * cos(osg::DegreesToRadians(y * 10.0))));
+                }
+            }
+            return GeoHeightField(hf.get(), ex);
+        }
+    };
+
+    osg::ref_ptr<Map> createSyntheticMap()
+    {
+        osg::ref_ptr<Map> map = new Map();
+        map->setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+        map->addLayer(new SyntheticElevationLayer());
+        return map;
+    }
+
+    std::vector<osg::Vec3d> randomPoints(unsigned count, double xmin, double ymin, double xmax, double ymax)
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> rx(xmin, xmax), ry(ymin, ymax);
+        std::vector<osg::Vec3d> points(count);
+        for (auto& p : points)
+            p.set(rx(gen), ry(gen), 0.0);
+        return points;
+    }
+}
+
+TEST_CASE("ElevationPool batch sampling")
+{
+    osg::ref_ptr<Map> map = createSyntheticMap();
+    ElevationPool* pool = map->getElevationPool();
+    Distance resolution(100.0, Units::METERS);
+
+    auto points = randomPoints(5000, -10.0, -10.0, 10.0, 10.0);
+
+    SECTION("Batch matches one-point-at-a-time sampling")
+    {
+        auto batch = points;
+        ElevationPool::WorkingSet ws;
+        int count = pool->sampleMapCoords(batch.begin(), batch.end(), resolution, &ws, nullptr);
+        REQUIRE(count == (int)points.size());
+
+        for (unsigned i = 0; i < points.size(); i += 37)
+        {
+            std::vector<osg::Vec3d> single(1, points[i]);
+            pool->sampleMapCoords(single.begin(), single.end(), resolution, &ws, nullptr);
+            REQUIRE(single[0].z() == batch[i].z());
+        }
+    }
+
+    SECTION("Samples follow the surface")
+    {
+        auto batch = points;
+        pool->sampleMapCoords(batch.begin(), batch.end(), resolution, nullptr, nullptr);
+        for (auto& p : batch)
+        {
+            double expected = 1000.0 * sin(osg::DegreesToRadians(p.x() * 10.0)) * cos(osg::DegreesToRadians(p.y() * 10.0));
+            REQUIRE(p.z() == Approx(expected).margin(1.0));
+        }
+    }
+
+    SECTION("Envelope follows the surface")
+    {
+        ElevationPool::Envelope env;
+        REQUIRE(pool->prepareEnvelope(env, GeoPoint(map->getSRS(), 0.0, 0.0), resolution));
+        auto batch = points;
+        REQUIRE(env.sampleMapCoords(batch.begin(), batch.end(), nullptr) == (int)points.size());
+        for (auto& p : batch)
+        {
+            double expected = 1000.0 * sin(osg::DegreesToRadians(p.x() * 10.0)) * cos(osg::DegreesToRadians(p.y() * 10.0));
+            REQUIRE(p.z() == Approx(expected).margin(1.0));
+        }
+    }
+}
+
+TEST_CASE("ElevationPool concurrent queries share tile builds")
+{
+    Distance resolution(100.0, Units::METERS);
+    auto points = randomPoints(2000, 1.0, 1.0, 1.5, 1.5);
+
+    auto countBuilds = [](ElevationPool* pool)
+    {
+        std::uint64_t builds = 0u;
+        for (auto& shard : pool->getGlobalLUTStats())
+            builds += shard._misses;
+        return builds;
+    };
+
+    // reference: one thread
+    osg::ref_ptr<Map> map1 = createSyntheticMap();
+    auto batch = points;
+    map1->getElevationPool()->sampleMapCoords(batch.begin(), batch.end(), resolution, nullptr, nullptr);
+    std::uint64_t expected = countBuilds(map1->getElevationPool());
+    REQUIRE(expected > 0u);
+
+    // many threads asking for the same tiles at once
+    osg::ref_ptr<Map> map2 = createSyntheticMap();
+    ElevationPool* pool = map2->getElevationPool();
+    std::vector<std::thread> threads;
+    std::vector<std::vector<osg::Vec3d>> results(8, points);
+    for (unsigned t = 0; t < results.size(); ++t)
+    {
+        threads.emplace_back([&, t]()
+            {
+                ElevationPool::WorkingSet ws;
+                pool->sampleMapCoords(results[t].begin(), results[t].end(), resolution, &ws, nullptr);
+            });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    REQUIRE(countBuilds(pool) == expected);
+    for (auto& result : results)
+        for (unsigned i = 0; i < points.size(); ++i)
+            REQUIRE(result[i].z() == batch[i].z());
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("ElevationPool batch sampling benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    osg::ref_ptr<Map> map = createSyntheticMap();
+    ElevationPool* pool = map->getElevationPool();
+    Distance resolution(100.0, Units::METERS);
+
+    auto points = randomPoints(1000000, 5.0, 40.0, 10.0, 45.0);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        ElevationPool::WorkingSet ws(256u);
+        auto t0 = clock::now();
+        int count = pool->sampleMapCoords(points.begin(), points.end(), resolution, &ws, nullptr);
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        std::cout << "ElevationPool: " << (pass == 0 ? "cold" : "warm") << ": clamped "
+            << count << " points in " << s << " s" << std::endl;
+    }
+}
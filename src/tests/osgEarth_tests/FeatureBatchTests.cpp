@@ -0,0 +1,360 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/FeatureBatch>
+#include <osgEarth/FeatureCursor>
+#include <osgEarth/AttributesFilter>
+#include <osgEarth/TransformFilter>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    const SpatialReference* wgs84()
+    {
+        static osg::ref_ptr<const SpatialReference> srs = SpatialReference::create("wgs84");
+        return srs.get();
+    }
+
+    osg::ref_ptr<Feature> createPolygonFeature(FeatureID fid)
+    {
+        Polygon* poly = new Polygon();
+        poly->push_back(osg::Vec3d(0, 0, 0));
+        poly->push_back(osg::Vec3d(10, 0, 0));
+        poly->push_back(osg::Vec3d(10, 10, 0));
+        poly->push_back(osg::Vec3d(0, 10, 0));
+        Ring* hole = new Ring();
+        hole->push_back(osg::Vec3d(4, 4, 0));
+        hole->push_back(osg::Vec3d(6, 4, 0));
+        hole->push_back(osg::Vec3d(6, 6, 0));
+        poly->getHoles().push_back(hole);
+
+        osg::ref_ptr<Feature> f = new Feature(poly, wgs84(), Style(), fid);
+        f->set("Name", std::string("block"));
+        f->set("height", 12.5);
+        f->set("floors", 3);
+        f->set("occupied", true);
+        f->setNull("owner", ATTRTYPE_STRING);
+        return f;
+    }
+
+    osg::ref_ptr<Feature> createMultiLineFeature(FeatureID fid)
+    {
+        MultiGeometry* multi = new MultiGeometry();
+        LineString* a = new LineString();
+        a->push_back(osg::Vec3d(1, 1, 0));
+        a->push_back(osg::Vec3d(2, 2, 0));
+        LineString* b = new LineString();
+        b->push_back(osg::Vec3d(3, 3, 0));
+        b->push_back(osg::Vec3d(4, 4, 0));
+        b->push_back(osg::Vec3d(5, 4, 0));
+        multi->add(a);
+        multi->add(b);
+
+        osg::ref_ptr<Feature> f = new Feature(multi, wgs84(), Style(), fid);
+        f->set("name", std::string("road"));
+        f->set("height", std::string("n/a"));
+        f->set("lanes", std::vector<double>{ 1.0, 2.0 });
+        return f;
+    }
+
+    void requireSameGeometry(const Geometry* a, const Geometry* b)
+    {
+        REQUIRE(a->getType() == b->getType());
+        REQUIRE(a->asVector() == b->asVector());
+        if (a->getType() == Geometry::TYPE_POLYGON)
+        {
+            auto& ha = static_cast<const Polygon*>(a)->getHoles();
+            auto& hb = static_cast<const Polygon*>(b)->getHoles();
+            REQUIRE(ha.size() == hb.size());
+            for (unsigned i = 0; i < ha.size(); ++i)
+                requireSameGeometry(ha[i].get(), hb[i].get());
+        }
+        else if (a->getType() == Geometry::TYPE_MULTI)
+        {
+            auto& pa = static_cast<const MultiGeometry*>(a)->getComponents();
+            auto& pb = static_cast<const MultiGeometry*>(b)->getComponents();
+            REQUIRE(pa.size() == pb.size());
+            for (unsigned i = 0; i < pa.size(); ++i)
+                requireSameGeometry(pa[i].get(), pb[i].get());
+        }
+    }
+
+    void requireSameFeature(const Feature* a, const Feature* b)
+    {
+        REQUIRE(a->getFID() == b->getFID());
+        REQUIRE((a->getGeometry() != nullptr) == (b->getGeometry() != nullptr));
+        if (a->getGeometry())
+            requireSameGeometry(a->getGeometry(), b->getGeometry());
+
+        REQUIRE(a->getAttrs().size() == b->getAttrs().size());
+        for (auto& attr : a->getAttrs())
+        {
+            REQUIRE(b->hasAttr(attr.first));
+            REQUIRE(b->isSet(attr.first) == attr.second.value.set);
+            REQUIRE(b->getString(attr.first) == attr.second.getString());
+            REQUIRE(b->getDouble(attr.first) == attr.second.getDouble());
+        }
+    }
+
+    // A filter without batch support, to exercise the adapters
+    class DropOddFilter : public FeatureFilter
+    {
+    public:
+        int _calls = 0;
+        FilterContext push(FeatureList& input, FilterContext& context) override
+        {
+            ++_calls;
+            FeatureList output;
+            for (auto& f : input)
+                if (f->getFID() % 2 == 0)
+                    output.push_back(f);
+            input.swap(output);
+            return context;
+        }
+    };
+}
+
+TEST_CASE("FeatureBatch")
+{
+    FeatureList features;
+    features.push_back(createPolygonFeature(1));
+    features.push_back(createMultiLineFeature(2));
+    features.push_back(new Feature(nullptr, wgs84(), Style(), 3));
+    Point* point = new Point();
+    point->set(osg::Vec3d(7, 8, 9));
+    features.push_back(new Feature(point, wgs84(), Style(), 4));
+
+    osg::ref_ptr<FeatureBatch> batch = new FeatureBatch(features);
+    REQUIRE(batch->size() == 4);
+    REQUIRE(batch->getSRS() == wgs84());
+
+    SECTION("Round trip to features")
+    {
+        FeatureList output;
+        batch->createFeatures(output);
+        REQUIRE(output.size() == features.size());
+        for (unsigned i = 0; i < output.size(); ++i)
+            requireSameFeature(features[i].get(), output[i].get());
+    }
+
+    SECTION("Geometry layout")
+    {
+        REQUIRE(batch->getGeometryType(0) == Geometry::TYPE_POLYGON);
+        REQUIRE(batch->partsEnd(0) - batch->partsBegin(0) == 1);
+        unsigned part = batch->partsBegin(0);
+        REQUIRE(batch->ringsEnd(part) - batch->ringsBegin(part) == 2);
+
+        REQUIRE(batch->getGeometryType(1) == Geometry::TYPE_MULTI);
+        REQUIRE(batch->partsEnd(1) - batch->partsBegin(1) == 2);
+        REQUIRE(batch->getPartType(batch->partsBegin(1)) == Geometry::TYPE_LINESTRING);
+        REQUIRE(batch->featureCoordsEnd(1) - batch->featureCoordsBegin(1) == 5);
+
+        REQUIRE(batch->getGeometryType(2) == Geometry::TYPE_UNKNOWN);
+        REQUIRE(batch->partsEnd(2) == batch->partsBegin(2));
+
+        REQUIRE(batch->coords().size() == 4 + 3 + 5 + 1);
+        REQUIRE(batch->coords().back() == osg::Vec3d(7, 8, 9));
+    }
+
+    SECTION("Columns")
+    {
+        REQUIRE(batch->getColumn("NAME") == batch->getColumn("name"));
+        REQUIRE(batch->getColumn(FeatureBatch::intern("Name")) == batch->getColumn("name"));
+        REQUIRE(batch->getColumn("missing") == nullptr);
+
+        auto floors = batch->getColumn("floors");
+        REQUIRE(floors->getType() == ATTRTYPE_INT);
+        REQUIRE(floors->getInt(0) == 3);
+        REQUIRE(floors->ints()[0] == 3);
+        REQUIRE(floors->has(0));
+        REQUIRE_FALSE(floors->has(1));
+        REQUIRE(floors->getInt(3, -1) == -1);
+
+        auto owner = batch->getColumn("owner");
+        REQUIRE(owner->has(0));
+        REQUIRE_FALSE(owner->isSet(0));
+        REQUIRE(owner->getValue(0).type == ATTRTYPE_STRING);
+
+        // "height" holds a double and a string, so it keeps whole values
+        auto height = batch->getColumn("height");
+        REQUIRE(height->getType() == ATTRTYPE_UNSPECIFIED);
+        REQUIRE(height->getDouble(0) == 12.5);
+        REQUIRE(height->getString(1) == "n/a");
+
+        auto lanes = batch->getColumn("lanes");
+        REQUIRE(lanes->getDoubleArray(1)->size() == 2);
+        REQUIRE(lanes->getDoubleArray(0) == nullptr);
+
+        batch->addColumn("Score").set(3, 99.0);
+        REQUIRE(batch->getColumn("score")->getDouble(3) == 99.0);
+        REQUIRE_FALSE(batch->getColumn("score")->has(0));
+    }
+
+    SECTION("Retain compacts rows")
+    {
+        batch->retain({ 1, 3 });
+        REQUIRE(batch->size() == 2);
+        REQUIRE(batch->getFID(0) == 2);
+        REQUIRE(batch->getFID(1) == 4);
+        REQUIRE(batch->coords().size() == 5 + 1);
+        REQUIRE(batch->getColumn("name")->getString(0) == "road");
+        REQUIRE_FALSE(batch->getColumn("floors")->has(0));
+
+        osg::ref_ptr<Feature> f = batch->createFeature(0);
+        requireSameFeature(features[1].get(), f.get());
+        f = batch->createFeature(1);
+        requireSameFeature(features[3].get(), f.get());
+    }
+
+    SECTION("Cursors")
+    {
+        osg::ref_ptr<FeatureCursor> cursor = new FeatureBatchCursor(batch.get());
+        FeatureBatch copy;
+        REQUIRE(cursor->fill(copy) == 4);
+        REQUIRE(copy.size() == 4);
+        REQUIRE(copy.coords() == batch->coords());
+        REQUIRE(copy.getColumn("name")->getString(1) == "road");
+    }
+}
+
+TEST_CASE("FeatureBatch filters")
+{
+    FeatureList features;
+    for (int i = 0; i < 10; ++i)
+    {
+        osg::ref_ptr<Feature> f = (i % 3 == 0) ? createMultiLineFeature(i) : createPolygonFeature(i);
+        features.push_back(f);
+    }
+
+    FilterContext context;
+
+    SECTION("Native batch filter matches the list version")
+    {
+        osg::ref_ptr<AttributesFilter> filter = new AttributesFilter(std::vector<std::string>{ "FLOORS" });
+        REQUIRE(filter->supportsBatch());
+
+        FeatureBatch batch(features);
+        FeatureFilter* base = filter.get();
+        base->push(batch, context);
+        filter->push(features, context);
+
+        REQUIRE(batch.size() == features.size());
+        for (unsigned i = 0; i < features.size(); ++i)
+            requireSameFeature(features[i].get(), osg::ref_ptr<Feature>(batch.createFeature(i)).get());
+    }
+
+    SECTION("Transform matches the list version")
+    {
+        osg::ref_ptr<TransformFilter> filter = new TransformFilter(osg::Matrixd::translate(100, 200, 0));
+        filter->setLocalizeCoordinates(true);
+
+        FeatureBatch batch(features);
+        FeatureFilter* base = filter.get();
+        base->push(batch, context);
+        filter->push(features, context);
+
+        for (unsigned i = 0; i < features.size(); ++i)
+            requireSameFeature(features[i].get(), osg::ref_ptr<Feature>(batch.createFeature(i)).get());
+    }
+
+    SECTION("Filters without batch support run through a FeatureList")
+    {
+        osg::ref_ptr<DropOddFilter> drop = new DropOddFilter();
+        REQUIRE_FALSE(drop->supportsBatch());
+
+        FeatureFilterChain chain;
+        chain.push_back(drop.get());
+        chain.push_back(drop.get());
+        chain.push_back(new AttributesFilter(std::vector<std::string>{ "floors" }));
+
+        FeatureBatch batch(features);
+        chain.push(batch, context);
+        REQUIRE(drop->_calls == 2);
+
+        FeatureList expected = features;
+        chain.push(expected, context);
+        REQUIRE(batch.size() == expected.size());
+        for (unsigned i = 0; i < expected.size(); ++i)
+            requireSameFeature(expected[i].get(), osg::ref_ptr<Feature>(batch.createFeature(i)).get());
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+// Filters and reads an attribute from 500k features, as a FeatureList
+// and as a FeatureBatch.
+TEST_CASE("FeatureBatch benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    const unsigned count = 500000;
+    FeatureList features;
+    features.reserve(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        osg::ref_ptr<Feature> f = createPolygonFeature(i);
+        if (i % 4 == 0)
+            f->removeAttribute("floors");
+        features.push_back(f);
+    }
+
+    auto t0 = clock::now();
+    osg::ref_ptr<FeatureBatch> batch = new FeatureBatch(features);
+    double convert = std::chrono::duration<double>(clock::now() - t0).count();
+
+    osg::ref_ptr<AttributesFilter> attrs = new AttributesFilter(std::vector<std::string>{ "floors" });
+    osg::ref_ptr<TransformFilter> xform = new TransformFilter(osg::Matrixd::translate(1, 2, 3));
+    FilterContext context;
+
+    // FeatureList
+    {
+        auto t = clock::now();
+        attrs->push(features, context);
+        xform->push(features, context);
+        double sum = 0.0;
+        for (auto& f : features)
+            sum += f->getDouble("height");
+        double s = std::chrono::duration<double>(clock::now() - t).count();
+        std::cout << "FeatureList:  " << features.size() << " features, sum "
+            << sum << ", " << s << " s" << std::endl;
+    }
+
+    // FeatureBatch
+    {
+        auto t = clock::now();
+        FeatureFilter* a = attrs.get();
+        FeatureFilter* x = xform.get();
+        a->push(*batch, context);
+        x->push(*batch, context);
+        double sum = 0.0;
+        auto height = batch->getColumn("height");
+        for (unsigned row = 0; row < batch->size(); ++row)
+            sum += height->getDouble(row);
+        double s = std::chrono::duration<double>(clock::now() - t).count();
+        std::cout << "FeatureBatch: " << batch->size() << " features, sum "
+            << sum << ", " << s << " s (plus " << convert << " s to convert)" << std::endl;
+    }
+}
@@ -0,0 +1,158 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/FeatureImageLayer>
+#include <osgEarth/OGRFeatureSource>
+#include <osgEarth/ImageUtils>
+#include <osgEarth/Map>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+
+namespace
+{
+    osg::ref_ptr<Map> createWorldMap(OGRFeatureSource*& features)
+    {
+        osg::ref_ptr<Map> map = new Map();
+        map->setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+
+        features = new OGRFeatureSource();
+        features->setURL("../data/world.shp");
+        map->addLayer(features);
+        return map;
+    }
+
+    FeatureImageLayer* createLayer(Map* map, FeatureSource* features, unsigned metatileSize)
+    {
+        Style style;
+        style.getOrCreate<PolygonSymbol>()->fill().mutable_value().color() = Color::Yellow;
+        style.getOrCreate<LineSymbol>()->stroke().mutable_value().color() = Color::Red;
+        style.getOrCreate<LineSymbol>()->stroke().mutable_value().width() = 2.0f;
+
+        StyleSheet* sheet = new StyleSheet();
+        sheet->addStyle(style);
+
+        FeatureImageLayer* layer = new FeatureImageLayer();
+        layer->setFeatureSource(features);
+        layer->setStyleSheet(sheet);
+        layer->setMetatileSize(metatileSize);
+        map->addLayer(layer);
+        return layer;
+    }
+
+    unsigned countDifferentPixels(const osg::Image* a, const osg::Image* b)
+    {
+        ImageUtils::PixelReader readA(a), readB(b);
+        osg::Vec4 pa, pb;
+        unsigned count = 0;
+        for (int t = 0; t < a->t(); ++t)
+        {
+            for (int s = 0; s < a->s(); ++s)
+            {
+                readA(pa, s, t);
+                readB(pb, s, t);
+                if ((pa - pb).length() > 0.1f)
+                    ++count;
+            }
+        }
+        return count;
+    }
+}
+
+TEST_CASE("FeatureImageLayer metatiles")
+{
+    OGRFeatureSource* features = nullptr;
+    osg::ref_ptr<Map> map = createWorldMap(features);
+    REQUIRE(features->getStatus().isOK());
+
+    FeatureImageLayer* single = createLayer(map.get(), features, 1u);
+    FeatureImageLayer* meta = createLayer(map.get(), features, 4u);
+    REQUIRE(single->getStatus().isOK());
+    REQUIRE(meta->getStatus().isOK());
+
+    SECTION("Metatile size is rounded down to a power of two, at most 8")
+    {
+        meta->setMetatileSize(6u);
+        REQUIRE(meta->getMetatileSize() == 4u);
+        meta->setMetatileSize(0u);
+        REQUIRE(meta->getMetatileSize() == 1u);
+        meta->setMetatileSize(16u);
+        REQUIRE(meta->getMetatileSize() == 8u);
+        meta->setMetatileSize(4u);
+    }
+
+    SECTION("Sliced tiles match tiles rendered alone")
+    {
+        // Europe, so every tile has coastlines and borders crossing its edges
+        TileKey parent(2, 4, 0, meta->getProfile());
+        std::vector<TileKey> keys;
+        for (unsigned y = 0; y < 4; ++y)
+            for (unsigned x = 0; x < 4; ++x)
+                keys.emplace_back(4, parent.getTileX() * 4 + x, parent.getTileY() * 4 + y, meta->getProfile());
+
+        for (auto& key : keys)
+        {
+            GeoImage a = single->createImage(key);
+            GeoImage b = meta->createImage(key);
+            REQUIRE(a.valid());
+            REQUIRE(b.valid());
+            REQUIRE(b.getExtent() == key.getExtent());
+            REQUIRE(b.getImage()->s() == a.getImage()->s());
+            REQUIRE(b.getImage()->t() == a.getImage()->t());
+
+            // Only pixels along tile edges may differ, since a lone tile
+            // clips its lines there.
+            unsigned different = countDifferentPixels(a.getImage(), b.getImage());
+            REQUIRE(different < (unsigned)(a.getImage()->s() * a.getImage()->t() / 50));
+        }
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+// Renders every tile of a region at one LOD from a local shapefile, with
+// and without metatiles, and reports tiles per second.
+TEST_CASE("FeatureImageLayer metatile benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    for (unsigned metatileSize = 1u; metatileSize <= 8u; metatileSize *= 2)
+    {
+        OGRFeatureSource* features = nullptr;
+        osg::ref_ptr<Map> map = createWorldMap(features);
+        FeatureImageLayer* layer = createLayer(map.get(), features, metatileSize);
+        REQUIRE(layer->getStatus().isOK());
+
+        const unsigned lod = 6u;
+        const unsigned x0 = 64u, y0 = 8u, count = 32u;
+
+        auto t0 = clock::now();
+        for (unsigned y = y0; y < y0 + count; ++y)
+            for (unsigned x = x0; x < x0 + count; ++x)
+                layer->createImage(TileKey(lod, x, y, layer->getProfile()));
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+
+        std::cout << "Metatile size " << metatileSize << ": "
+            << (double)(count * count) / s << " tiles/s" << std::endl;
+    }
+}
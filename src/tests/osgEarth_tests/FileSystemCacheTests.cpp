@@ -0,0 +1,387 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/Cache>
+#include <osgEarth/CacheBin>
+#include <osgEarth/StringUtils>
+#include <osgDB/FileNameUtils>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    const std::string s_cachePath = "filesystem_cache_test";
+    const std::string s_binID = "fs_test_bin";
+
+    // Opens a filesystem cache that writes synchronously, so every
+    // write is on disk when write() returns.
+    osg::ref_ptr<Cache> openFileSystemCache(const std::string& layout)
+    {
+        Config conf;
+        conf.set("driver", "filesystem");
+        conf.set("path", s_cachePath);
+        conf.set("layout", layout);
+        conf.set("threads", 0u);
+        return CacheFactory::create(CacheOptions(ConfigOptions(conf)));
+    }
+
+    std::string key(int i)
+    {
+        return Stringify() << "key_" << i;
+    }
+
+    std::string value(int i, int version)
+    {
+        return Stringify() << "value " << i << " version " << version;
+    }
+
+    bool write(CacheBin* bin, int i, int version)
+    {
+        osg::ref_ptr<StringObject> s = new StringObject(value(i, version));
+        return bin->write(key(i), s.get(), Config(), nullptr);
+    }
+
+    // true if the record exists and holds the given version
+    bool holds(CacheBin* bin, int i, int version)
+    {
+        ReadResult r = bin->readString(key(i), nullptr);
+        return r.succeeded() && r.getString() == value(i, version);
+    }
+
+    bool missing(CacheBin* bin, int i)
+    {
+        return bin->readString(key(i), nullptr).failed();
+    }
+
+    const std::string s_budgetPath = "filesystem_cache_budget_test";
+    const unsigned s_budgetMB = 1u;
+
+    // Opens a filesystem cache with a size budget, which starts the
+    // eviction thread.
+    osg::ref_ptr<Cache> openBudgetedCache(const std::string& eviction)
+    {
+        Config conf;
+        conf.set("driver", "filesystem");
+        conf.set("path", s_budgetPath);
+        conf.set("threads", 0u);
+        conf.set("max_size_mb", s_budgetMB);
+        conf.set("eviction", eviction);
+        return CacheFactory::create(CacheOptions(ConfigOptions(conf)));
+    }
+
+    // Writes about 100 kB of noise, which the compressor can't shrink,
+    // so that a dozen records overrun the budget.
+    bool writeLarge(CacheBin* bin, int i)
+    {
+        std::string data(100000, '\0');
+        std::uint32_t seed = 2463534242u + (std::uint32_t)i;
+        for (auto& c : data)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            c = (char)(seed & 0xff);
+        }
+        osg::ref_ptr<StringObject> s = new StringObject(data);
+        return bin->write(key(i), s.get(), Config(), nullptr);
+    }
+
+    bool present(CacheBin* bin, int i)
+    {
+        return bin->readString(key(i), nullptr).succeeded();
+    }
+
+    // Waits for the eviction thread, which checks the budget every few
+    // seconds, to bring the cache down to 90% of it.
+    bool waitForEviction(Cache* cache)
+    {
+        const off_t target = (off_t)(0.9 * 1048576.0 * s_budgetMB);
+        for (int i = 0; i < 300; ++i)
+        {
+            if (cache->getApproximateSize() <= target)
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return false;
+    }
+
+    // Damages every bundle index in the bin: truncates half of them and
+    // overwrites the header of the rest.
+    void damageBundleIndexes()
+    {
+        std::string bundles = osgDB::concatPaths(osgDB::concatPaths(s_cachePath, s_binID), "bundles");
+        for (int i = 0; i < 64; ++i)
+        {
+            std::string path = osgDB::concatPaths(bundles, Stringify() << "bundle_" << i << ".idx");
+            if (i % 2 == 0)
+            {
+                std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+                out.write("OEBI", 4);
+            }
+            else
+            {
+                std::fstream out(path.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+                if (out.is_open())
+                    out.write("XXXXXXXX", 8);
+            }
+        }
+    }
+
+    // Writes, overwrites and removes records, then checks them before
+    // and after reopening the cache.
+    void roundTrip(const std::string& layout, int count)
+    {
+        osg::ref_ptr<Cache> cache = openFileSystemCache(layout);
+        REQUIRE(cache.valid());
+        REQUIRE(cache->getStatus().isOK());
+
+        osg::ref_ptr<CacheBin> bin = cache->addBin(s_binID);
+        REQUIRE(bin.valid());
+        bin->clear();
+
+        for (int i = 0; i < count; ++i)
+            REQUIRE(write(bin.get(), i, 0));
+
+        for (int i = 0; i < count; ++i)
+            REQUIRE(holds(bin.get(), i, 0));
+
+        // overwrite the first quarter, remove the second
+        for (int i = 0; i < count / 4; ++i)
+            REQUIRE(write(bin.get(), i, 1));
+
+        for (int i = count / 4; i < count / 2; ++i)
+            REQUIRE(bin->remove(key(i)));
+
+        for (int i = 0; i < count / 4; ++i)
+            REQUIRE(holds(bin.get(), i, 1));
+
+        for (int i = count / 4; i < count / 2; ++i)
+            REQUIRE(missing(bin.get(), i));
+
+        for (int i = count / 2; i < count; ++i)
+            REQUIRE(holds(bin.get(), i, 0));
+
+        REQUIRE(bin->getRecordStatus(key(0)) == CacheBin::STATUS_OK);
+        REQUIRE(bin->getRecordStatus(key(count / 4)) == CacheBin::STATUS_NOT_FOUND);
+
+        // the same records after reopening the cache
+        bin = nullptr;
+        cache = openFileSystemCache(layout);
+        bin = cache->addBin(s_binID);
+        REQUIRE(bin.valid());
+
+        for (int i = 0; i < count / 4; ++i)
+            REQUIRE(holds(bin.get(), i, 1));
+
+        for (int i = count / 4; i < count / 2; ++i)
+            REQUIRE(missing(bin.get(), i));
+
+        for (int i = count / 2; i < count; ++i)
+            REQUIRE(holds(bin.get(), i, 0));
+
+        bin->clear();
+    }
+}
+
+TEST_CASE("FileSystemCache")
+{
+    const int count = 200;
+
+    SECTION("Round trip, files layout")
+    {
+        roundTrip("files", count);
+    }
+
+    SECTION("Round trip, bundles layout")
+    {
+        roundTrip("bundles", count);
+    }
+
+    SECTION("Bundle compaction")
+    {
+        osg::ref_ptr<Cache> cache = openFileSystemCache("bundles");
+        REQUIRE(cache.valid());
+        osg::ref_ptr<CacheBin> bin = cache->addBin(s_binID);
+        REQUIRE(bin.valid());
+        bin->clear();
+
+        for (int i = 0; i < count; ++i)
+            REQUIRE(write(bin.get(), i, 0));
+
+        // every overwrite and removal leaves garbage in the data files
+        for (int i = 0; i < count; ++i)
+            REQUIRE(write(bin.get(), i, 1));
+
+        for (int i = 0; i < count / 4; ++i)
+            REQUIRE(bin->remove(key(i)));
+
+        off_t before = bin->getStorageSize();
+        REQUIRE(cache->compact());
+        off_t after = bin->getStorageSize();
+
+        REQUIRE(after > 0);
+        REQUIRE(after < before / 2);
+
+        for (int i = 0; i < count / 4; ++i)
+            REQUIRE(missing(bin.get(), i));
+
+        for (int i = count / 4; i < count; ++i)
+            REQUIRE(holds(bin.get(), i, 1));
+
+        // compaction is idempotent
+        REQUIRE(cache->compact());
+        REQUIRE(bin->getStorageSize() == after);
+
+        bin->clear();
+    }
+
+    SECTION("Rebuilding a damaged bundle index")
+    {
+        osg::ref_ptr<Cache> cache = openFileSystemCache("bundles");
+        REQUIRE(cache.valid());
+        osg::ref_ptr<CacheBin> bin = cache->addBin(s_binID);
+        REQUIRE(bin.valid());
+        bin->clear();
+
+        for (int i = 0; i < count; ++i)
+            REQUIRE(write(bin.get(), i, 0));
+
+        for (int i = 0; i < count / 2; ++i)
+            REQUIRE(write(bin.get(), i, 1));
+
+        // close every bundle before touching its files
+        bin = nullptr;
+        cache = nullptr;
+
+        damageBundleIndexes();
+
+        // the indexes are rebuilt from the data files; later records
+        // replace earlier ones with the same key
+        cache = openFileSystemCache("bundles");
+        bin = cache->addBin(s_binID);
+        REQUIRE(bin.valid());
+
+        for (int i = 0; i < count / 2; ++i)
+            REQUIRE(holds(bin.get(), i, 1));
+
+        for (int i = count / 2; i < count; ++i)
+            REQUIRE(holds(bin.get(), i, 0));
+
+        // and the rebuilt index takes new writes
+        REQUIRE(write(bin.get(), 0, 2));
+        REQUIRE(holds(bin.get(), 0, 2));
+
+        bin->clear();
+    }
+}
+
+TEST_CASE("FileSystemCache size budget")
+{
+    // records 0-3 are "A", 4-7 are "B" and 8-10 are "C"; together they
+    // come to about 1.1 MB, so the records written last push the cache
+    // over its 1 MB budget and eviction has to free two or three records.
+
+    SECTION("LRU evicts the least recently used records")
+    {
+        osg::ref_ptr<Cache> cache = openBudgetedCache("lru");
+        REQUIRE(cache.valid());
+        REQUIRE(cache->getStatus().isOK());
+        osg::ref_ptr<CacheBin> bin = cache->addBin(s_binID);
+        REQUIRE(bin.valid());
+        bin->clear();
+
+        for (int i = 0; i < 8; ++i)
+            REQUIRE(writeLarge(bin.get(), i));
+
+        // access times are in seconds; reading A a second later makes
+        // B the least recently used
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(present(bin.get(), i));
+
+        for (int i = 8; i < 11; ++i)
+            REQUIRE(writeLarge(bin.get(), i));
+
+        REQUIRE(waitForEviction(cache.get()));
+
+        int evicted = 0;
+        for (int i = 4; i < 8; ++i)
+            if (!present(bin.get(), i))
+                ++evicted;
+        REQUIRE(evicted > 0);
+
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(present(bin.get(), i));
+
+        for (int i = 8; i < 11; ++i)
+            REQUIRE(present(bin.get(), i));
+
+        REQUIRE(cache->getApproximateSize() <= (off_t)(1048576u * s_budgetMB));
+
+        bin->clear();
+    }
+
+    SECTION("LFU evicts the least frequently used records")
+    {
+        osg::ref_ptr<Cache> cache = openBudgetedCache("lfu");
+        REQUIRE(cache.valid());
+        REQUIRE(cache->getStatus().isOK());
+        osg::ref_ptr<CacheBin> bin = cache->addBin(s_binID);
+        REQUIRE(bin.valid());
+        bin->clear();
+
+        // A is used three times, but longer ago than B and C, so LRU
+        // would evict it first.
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(writeLarge(bin.get(), i));
+
+        for (int n = 0; n < 2; ++n)
+            for (int i = 0; i < 4; ++i)
+                REQUIRE(present(bin.get(), i));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+        for (int i = 4; i < 11; ++i)
+            REQUIRE(writeLarge(bin.get(), i));
+
+        REQUIRE(waitForEviction(cache.get()));
+
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(present(bin.get(), i));
+
+        int evicted = 0;
+        for (int i = 4; i < 11; ++i)
+            if (!present(bin.get(), i))
+                ++evicted;
+        REQUIRE(evicted > 0);
+
+        REQUIRE(cache->getApproximateSize() <= (off_t)(1048576u * s_budgetMB));
+
+        bin->clear();
+    }
+}
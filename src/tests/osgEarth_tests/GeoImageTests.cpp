@@ -0,0 +1,111 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/GeoData>
+#include <osgEarth/SpatialReference>
+#include <random>
+
+using namespace osgEarth;
+
+namespace
+{
+    osg::Image* createRandomImage(int s, int t, GLenum format, GLenum type)
+    {
+        osg::Image* image = new osg::Image();
+        image->allocateImage(s, t, 1, format, type);
+        std::mt19937 prng(s * t);
+        if (type == GL_FLOAT)
+        {
+            std::uniform_real_distribution<float> dist(-100.0f, 9000.0f);
+            float* ptr = reinterpret_cast<float*>(image->data());
+            for (unsigned i = 0; i < image->getTotalSizeInBytes() / sizeof(float); ++i)
+                ptr[i] = dist(prng);
+        }
+        else
+        {
+            std::uniform_int_distribution<int> dist(0, 255);
+            for (unsigned i = 0; i < image->getTotalSizeInBytes(); ++i)
+                image->data()[i] = (unsigned char)dist(prng);
+        }
+        return image;
+    }
+
+    bool sameBits(const osg::Image* a, const osg::Image* b)
+    {
+        return
+            a && b &&
+            a->s() == b->s() && a->t() == b->t() && a->r() == b->r() &&
+            a->getPixelFormat() == b->getPixelFormat() &&
+            a->getDataType() == b->getDataType() &&
+            a->getTotalSizeInBytes() == b->getTotalSizeInBytes() &&
+            ::memcmp(a->data(), b->data(), a->getTotalSizeInBytes()) == 0;
+    }
+
+    bool reprojectMatchesReference(GLenum format, GLenum type, unsigned size, bool bilinear)
+    {
+        const SpatialReference* wgs84 = SpatialReference::get("wgs84");
+        const SpatialReference* merc = SpatialReference::get("spherical-mercator");
+
+        GeoImage input(createRandomImage(size - 7, size + 5, format, type), GeoExtent(wgs84, -20, -15, 20, 15));
+
+        // partial overlap, so some output pixels fall outside the source
+        GeoExtent output = GeoExtent(wgs84, -25, -10, 10, 20).transform(merc);
+
+        GeoImage fast = input.reprojectManual(output, size, size, bilinear, false);
+        GeoImage reference = input.reprojectManual(output, size, size, bilinear, true);
+
+        return fast.valid() && reference.valid() && sameBits(fast.getImage(), reference.getImage());
+    }
+}
+
+TEST_CASE("GeoImage manual reprojection matches the reference implementation")
+{
+    SECTION("RGBA8 bilinear")
+    {
+        REQUIRE(reprojectMatchesReference(GL_RGBA, GL_UNSIGNED_BYTE, 256, true));
+    }
+    SECTION("RGBA8 nearest")
+    {
+        REQUIRE(reprojectMatchesReference(GL_RGBA, GL_UNSIGNED_BYTE, 256, false));
+    }
+    SECTION("RGB8 bilinear")
+    {
+        REQUIRE(reprojectMatchesReference(GL_RGB, GL_UNSIGNED_BYTE, 128, true));
+    }
+    SECTION("R8 bilinear")
+    {
+        REQUIRE(reprojectMatchesReference(GL_RED, GL_UNSIGNED_BYTE, 128, true));
+    }
+    SECTION("R32F bilinear")
+    {
+        REQUIRE(reprojectMatchesReference(GL_RED, GL_FLOAT, 257, true));
+    }
+    SECTION("R32F nearest")
+    {
+        REQUIRE(reprojectMatchesReference(GL_LUMINANCE, GL_FLOAT, 257, false));
+    }
+    SECTION("Large RGBA8, split across threads")
+    {
+        REQUIRE(reprojectMatchesReference(GL_RGBA, GL_UNSIGNED_BYTE, 1024, true));
+    }
+}
@@ -0,0 +1,299 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/HTTPClient>
+
+#ifndef _WIN32
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace osgEarth;
+
+namespace
+{
+#ifdef MSG_NOSIGNAL
+    const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+    const int SEND_FLAGS = 0;
+#endif
+
+    // Minimal keep-alive HTTP/1.1 server on the loopback interface. Each
+    // response is held back by "latency" to stand in for a distant server.
+    // Paths starting with "/missing" return 404; everything else returns
+    // "tile <path>".
+    class LatencyServer
+    {
+    public:
+        LatencyServer(std::chrono::milliseconds latency) :
+            _latency(latency),
+            _done(false),
+            _requests(0u)
+        {
+            _listener = ::socket(AF_INET, SOCK_STREAM, 0);
+            int yes = 1;
+            ::setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            ::bind(_listener, (sockaddr*)&addr, sizeof(addr));
+            ::listen(_listener, 128);
+
+            socklen_t len = sizeof(addr);
+            ::getsockname(_listener, (sockaddr*)&addr, &len);
+            _port = ntohs(addr.sin_port);
+
+            _acceptor = std::thread([this]() { acceptLoop(); });
+        }
+
+        ~LatencyServer()
+        {
+            _done = true;
+
+            // wake up accept() with a throwaway connection
+            int wake = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(_port);
+            ::connect(wake, (sockaddr*)&addr, sizeof(addr));
+            ::close(wake);
+            _acceptor.join();
+            ::close(_listener);
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                for (int fd : _sockets)
+                    ::shutdown(fd, SHUT_RDWR);
+            }
+            for (auto& t : _connections)
+                t.join();
+            for (int fd : _sockets)
+                ::close(fd);
+        }
+
+        std::string url(const std::string& path) const
+        {
+            return "http://127.0.0.1:" + std::to_string(_port) + path;
+        }
+
+        unsigned requests() const { return _requests; }
+
+        unsigned connections() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _sockets.size();
+        }
+
+    private:
+        void acceptLoop()
+        {
+            for (;;)
+            {
+                int fd = ::accept(_listener, nullptr, nullptr);
+                if (fd < 0 || _done)
+                {
+                    if (fd >= 0) ::close(fd);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(_mutex);
+                _sockets.push_back(fd);
+                _connections.emplace_back([this, fd]() { serve(fd); });
+            }
+        }
+
+        void serve(int fd)
+        {
+            std::string buf;
+            char chunk[4096];
+            for (;;)
+            {
+                std::size_t end;
+                while ((end = buf.find("\r\n\r\n")) == std::string::npos)
+                {
+                    ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                    if (n <= 0)
+                        return;
+                    buf.append(chunk, n);
+                }
+
+                // request line: GET /path HTTP/1.1
+                std::string head = buf.substr(0, end);
+                buf.erase(0, end + 4);
+                std::size_t a = head.find(' ');
+                std::size_t b = head.find(' ', a + 1);
+                std::string path = head.substr(a + 1, b - a - 1);
+
+                std::this_thread::sleep_for(_latency);
+
+                bool missing = path.compare(0, 8, "/missing") == 0;
+                std::string body = missing ? "not found" : "tile " + path;
+                std::string response =
+                    std::string(missing ? "HTTP/1.1 404 Not Found" : "HTTP/1.1 200 OK") + "\r\n"
+                    "Content-Type: text/plain\r\n"
+                    "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                    "\r\n" + body;
+
+                ++_requests;
+                if (::send(fd, response.data(), response.size(), SEND_FLAGS) < 0)
+                    return;
+            }
+        }
+
+        std::chrono::milliseconds _latency;
+        std::atomic_bool _done;
+        std::atomic_uint _requests;
+        int _listener;
+        unsigned short _port;
+        std::thread _acceptor;
+        mutable std::mutex _mutex;
+        std::vector<int> _sockets;
+        std::vector<std::thread> _connections;
+    };
+
+    double percentile(std::vector<double> values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+        std::sort(values.begin(), values.end());
+        std::size_t i = std::min(values.size() - 1, (std::size_t)(p * (double)(values.size() - 1) + 0.5));
+        return values[i];
+    }
+}
+
+TEST_CASE("HTTPClient getAsync runs transfers concurrently")
+{
+    using clock = std::chrono::steady_clock;
+
+    LatencyServer server(std::chrono::milliseconds(50));
+    const unsigned count = 32;
+
+    auto t0 = clock::now();
+
+    std::vector<Threading::Future<HTTPResponse>> results;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        results.push_back(HTTPClient::getAsync(HTTPRequest(server.url("/" + std::to_string(i)))));
+    }
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        HTTPResponse response;
+        response = results[i].join();
+        REQUIRE(results[i].available());
+        REQUIRE(response.isOK());
+        REQUIRE(response.getPartAsString(0) == "tile /" + std::to_string(i));
+    }
+
+    double elapsed_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    // one at a time this would take 1.6s
+    REQUIRE(elapsed_s < 1.0);
+    REQUIRE(server.requests() == count);
+    REQUIRE(server.connections() <= HTTPClient::getMaxConnectionsPerHost());
+
+    // errors come back as responses:
+    HTTPResponse missing;
+    missing = HTTPClient::getAsync(HTTPRequest(server.url("/missing"))).join();
+    REQUIRE(missing.getCode() == 404);
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("HTTPClient throughput", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    LatencyServer server(std::chrono::milliseconds(20));
+    const unsigned count = 400;
+    const unsigned loaderThreads = 8;
+
+    // blocking GETs from a pool of loader threads:
+    std::vector<double> blockingLatency(count);
+    std::atomic_uint next(0u);
+    auto t0 = clock::now();
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < loaderThreads; ++t)
+        {
+            threads.emplace_back([&]()
+                {
+                    for (unsigned i = next++; i < count; i = next++)
+                    {
+                        auto start = clock::now();
+                        HTTPClient::get(HTTPRequest(server.url("/blocking/" + std::to_string(i))));
+                        blockingLatency[i] = std::chrono::duration<double>(clock::now() - start).count();
+                    }
+                });
+        }
+        for (auto& t : threads)
+            t.join();
+    }
+    double blocking_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    // the same requests issued from one thread on the async engine:
+    std::vector<double> asyncLatency(count, 0.0);
+    std::vector<clock::time_point> started(count);
+    std::vector<Threading::Future<HTTPResponse>> results(count);
+    t0 = clock::now();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        started[i] = clock::now();
+        results[i] = HTTPClient::getAsync(HTTPRequest(server.url("/async/" + std::to_string(i))));
+    }
+    for (unsigned pending = count; pending > 0; )
+    {
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (asyncLatency[i] == 0.0 && results[i].available())
+            {
+                asyncLatency[i] = std::chrono::duration<double>(clock::now() - started[i]).count();
+                --pending;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double async_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::cout << "HTTP: " << count << " requests, 20 ms server latency, "
+        << HTTPClient::getMaxConnectionsPerHost() << " connections per host" << std::endl
+        << "  blocking (" << loaderThreads << " threads): "
+        << (count / blocking_s) << " req/s, p99 " << (percentile(blockingLatency, 0.99) * 1000.0) << " ms" << std::endl
+        << "  async (1 thread): "
+        << (count / async_s) << " req/s, p99 " << (percentile(asyncLatency, 0.99) * 1000.0) << " ms" << std::endl;
+}
+
+#endif // !_WIN32
@@ -25,6 +25,9 @@
 #include <osgEarth/ImageLayer>
 #include <osgEarth/Registry>
 #include <osgEarth/GDAL>
+#include <osgEarth/ImageUtils>
+#include <osgEarth/Map>
+#include <osgEarth/MemCache>
 
 using namespace osgEarth;
 
@@ -67,4 +70,91 @@ TEST_CASE("Attribution works")
 
     REQUIRE(status.isOK());
     REQUIRE(layer->getAttribution() == attribution);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Shared GDAL datasets match per-thread datasets")
+{
+    osg::ref_ptr<GDALElevationLayer> perThread = new GDALElevationLayer();
+    perThread->setURL("../data/world.tif");
+    perThread->setInterpolation(INTERP_BILINEAR);
+    REQUIRE(perThread->open().isOK());
+
+    osg::ref_ptr<GDALElevationLayer> shared = new GDALElevationLayer();
+    shared->setURL("../data/world.tif");
+    shared->setInterpolation(INTERP_BILINEAR);
+    shared->setSharedDataset(true);
+    REQUIRE(shared->open().isOK());
+
+    TileKey key(2, 1, 1, shared->getProfile());
+    GeoHeightField expected = perThread->createHeightField(key);
+    GeoHeightField actual = shared->createHeightField(key);
+    REQUIRE(expected.valid());
+    REQUIRE(actual.valid());
+
+    const std::vector<float>& a = expected.getHeightField()->getFloatArray()->asVector();
+    const std::vector<float>& b = actual.getHeightField()->getFloatArray()->asVector();
+    REQUIRE(a.size() == b.size());
+    for (unsigned i = 0; i < a.size(); ++i)
+        REQUIRE(a[i] == b[i]);
+
+    // neighboring samples share blocks, so one tile yields hits and misses
+    ConcurrentCacheShardStats stats = shared->getBlockCacheStats();
+    REQUIRE(stats._misses > 0u);
+    REQUIRE(stats._hits > 0u);
+    REQUIRE(stats._bytes > 0u);
+}
+
+TEST_CASE("Batched createImages matches createImage")
+{
+    osg::ref_ptr<Map> map = new Map();
+    map->setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+    map->setCache(new MemCache(256u, true));
+
+    osg::ref_ptr<GDALImageLayer> layer = new GDALImageLayer();
+    layer->setURL("../data/world.tif");
+    map->addLayer(layer.get());
+    REQUIRE(layer->isOpen());
+
+    // reference images from a layer with no cache
+    osg::ref_ptr<GDALImageLayer> reference = new GDALImageLayer();
+    reference->setURL("../data/world.tif");
+    REQUIRE(reference->open().isOK());
+
+    std::vector<TileKey> keys;
+    TileKey parent(1, 0, 0, layer->getProfile());
+    for (unsigned c = 0; c < 4; ++c)
+        keys.push_back(parent.createChildKey(c));
+
+    auto check = [&](const std::vector<GeoImage>& images)
+    {
+        REQUIRE(images.size() == keys.size());
+        for (unsigned i = 0; i < keys.size(); ++i)
+        {
+            GeoImage expected = reference->createImage(keys[i]);
+            REQUIRE(expected.valid());
+            REQUIRE(images[i].valid());
+            REQUIRE(images[i].getExtent() == expected.getExtent());
+            REQUIRE(ImageUtils::areEquivalent(images[i].getImage(), expected.getImage()));
+        }
+    };
+
+    // cache one key ahead of time, so the batch mixes hits and misses
+    REQUIRE(layer->createImage(keys[2]).valid());
+    check(layer->createImages(keys, nullptr));
+
+    // the batch wrote the misses, so now every key is a hit
+    CacheBin* bin = layer->getCacheBin(layer->getProfile());
+    REQUIRE(bin != nullptr);
+    for (auto& key : keys)
+        REQUIRE(bin->readImage(layer->getCacheKey(key), nullptr).succeeded());
+
+    check(layer->createImages(keys, nullptr));
+
+    // and one key across several layers
+    std::vector<ImageLayer*> layers = { layer.get(), reference.get() };
+    std::vector<GeoImage> images = ImageLayer::createImages(layers, keys[0], nullptr);
+    REQUIRE(images.size() == 2u);
+    REQUIRE(images[0].valid());
+    REQUIRE(images[1].valid());
+    REQUIRE(ImageUtils::areEquivalent(images[0].getImage(), images[1].getImage()));
+}
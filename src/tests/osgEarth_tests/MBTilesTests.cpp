@@ -0,0 +1,195 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/MBTiles>
+#include <osgEarth/ImageUtils>
+#include <osgEarth/Registry>
+#include <osgDB/FileUtils>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+
+using namespace osgEarth;
+
+namespace
+{
+    osg::ref_ptr<MBTilesImageLayer> createMBTilesLayer(const std::string& filename, bool write)
+    {
+        osg::ref_ptr<MBTilesImageLayer> layer = new MBTilesImageLayer();
+        layer->setURL(filename);
+        layer->setFormat("png");
+        if (write)
+        {
+            layer->options().profile() = ProfileOptions("global-geodetic");
+            layer->openForWriting();
+        }
+        else
+        {
+            layer->open();
+        }
+        return layer;
+    }
+
+    osg::Image* createTestImage(unsigned x, unsigned y)
+    {
+        return ImageUtils::createOnePixelImage(osg::Vec4((x % 255) / 255.0f, (y % 255) / 255.0f, 0.5f, 1.0f));
+    }
+
+    void removeDatabase(const std::string& filename)
+    {
+        for (auto& suffix : { "", "-wal", "-shm" })
+            ::remove((filename + suffix).c_str());
+    }
+}
+
+TEST_CASE("MBTiles")
+{
+    const std::string filename = "mbtiles_test.mbtiles";
+    removeDatabase(filename);
+
+    osg::ref_ptr<MBTilesImageLayer> layer = createMBTilesLayer(filename, true);
+    REQUIRE(layer->getStatus().isOK());
+
+    const unsigned lod = 4u;
+    unsigned cols, rows;
+    layer->getProfile()->getNumTiles(lod, cols, rows);
+
+    for (unsigned y = 0; y < rows; ++y)
+    {
+        for (unsigned x = 0; x < cols; ++x)
+        {
+            osg::ref_ptr<osg::Image> image = createTestImage(x, y);
+            TileKey key(lod, x, y, layer->getProfile());
+            REQUIRE(layer->writeImage(key, image.get(), nullptr).isOK());
+        }
+    }
+
+    SECTION("Queued tiles commit cleanly")
+    {
+        REQUIRE(layer->flushWrites().isOK());
+    }
+
+    SECTION("Tiles read back while writing")
+    {
+        TileKey key(lod, 3, 2, layer->getProfile());
+        GeoImage image = layer->createImage(key);
+        REQUIRE(image.valid());
+        osg::ref_ptr<osg::Image> expected = createTestImage(3, 2);
+        REQUIRE(ImageUtils::areEquivalent(image.getImage(), expected.get()));
+    }
+
+    SECTION("Tiles read back after closing")
+    {
+        layer->close();
+        layer = createMBTilesLayer(filename, false);
+        REQUIRE(layer->getStatus().isOK());
+
+        for (unsigned y = 0; y < rows; y += 3)
+        {
+            for (unsigned x = 0; x < cols; x += 5)
+            {
+                TileKey key(lod, x, y, layer->getProfile());
+                GeoImage image = layer->createImage(key);
+                REQUIRE(image.valid());
+                osg::ref_ptr<osg::Image> expected = createTestImage(x, y);
+                REQUIRE(ImageUtils::areEquivalent(image.getImage(), expected.get()));
+            }
+        }
+
+        // the WAL is folded back into the database on close
+        REQUIRE(!osgDB::fileExists(filename + "-wal"));
+    }
+
+    layer->close();
+    layer = nullptr;
+    removeDatabase(filename);
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("MBTiles throughput", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    const std::string filename = "mbtiles_benchmark.mbtiles";
+    removeDatabase(filename);
+
+    const unsigned lod = 8u;
+    const unsigned numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    osg::ref_ptr<MBTilesImageLayer> layer = createMBTilesLayer(filename, true);
+    REQUIRE(layer->getStatus().isOK());
+    const Profile* profile = layer->getProfile();
+
+    unsigned cols, rows;
+    profile->getNumTiles(lod, cols, rows);
+    const unsigned numTiles = cols * rows;
+
+    osg::ref_ptr<osg::Image> image = ImageUtils::createEmptyImage(256, 256);
+
+    // write:
+    auto t0 = clock::now();
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    for (unsigned i = t; i < numTiles; i += numThreads)
+                        layer->writeImage(TileKey(lod, i % cols, i / cols, profile), image.get(), nullptr);
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        layer->close();
+    }
+    double write_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    // read:
+    layer = createMBTilesLayer(filename, false);
+    REQUIRE(layer->getStatus().isOK());
+
+    t0 = clock::now();
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    for (unsigned i = t; i < numTiles; i += numThreads)
+                        layer->createImage(TileKey(lod, i % cols, i / cols, profile));
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    }
+    double read_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::cout << "MBTiles: " << numTiles << " tiles, " << numThreads << " threads: "
+        << "write " << (unsigned)(numTiles / write_s) << " tiles/s, "
+        << "read " << (unsigned)(numTiles / read_s) << " tiles/s" << std::endl;
+
+    layer->close();
+    layer = nullptr;
+    removeDatabase(filename);
+}
@@ -0,0 +1,303 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/MVT>
+
+#ifdef OSGEARTH_HAVE_MVT
+
+#include <osgEarth/Registry>
+#include <osgDB/Registry>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace osgEarth;
+
+namespace
+{
+    // Hand-rolled protobuf writer so the tests need no generated code
+    struct Writer
+    {
+        std::string buf;
+
+        void varint(std::uint64_t v) {
+            while (v >= 0x80) { buf.push_back((char)(v | 0x80)); v >>= 7; }
+            buf.push_back((char)v);
+        }
+        void tag(unsigned field, unsigned wire) { varint((field << 3) | wire); }
+        void uint(unsigned field, std::uint64_t v) { tag(field, 0); varint(v); }
+        void bytes(unsigned field, const std::string& s) { tag(field, 2); varint(s.size()); buf += s; }
+        void packed(unsigned field, const std::vector<std::uint32_t>& v) {
+            Writer p;
+            for (auto i : v) p.varint(i);
+            bytes(field, p.buf);
+        }
+        void fixed(unsigned field, const void* data, unsigned len) {
+            tag(field, len == 4 ? 5 : 1);
+            buf.append((const char*)data, len); // test hosts are little-endian
+        }
+    };
+
+    std::uint32_t zz(int v) { return (std::uint32_t)((v << 1) ^ (v >> 31)); }
+    std::uint32_t cmd(unsigned id, unsigned count) { return (id & 0x7) | (count << 3); }
+
+    std::string stringValue(const std::string& s) { Writer w; w.bytes(1, s); return w.buf; }
+    std::string intValue(long long i) { Writer w; w.uint(4, (std::uint64_t)i); return w.buf; }
+    std::string uintValue(unsigned long long i) { Writer w; w.uint(5, i); return w.buf; }
+    std::string sintValue(long long i) { Writer w; w.uint(6, (std::uint64_t)((i << 1) ^ (i >> 63))); return w.buf; }
+    std::string boolValue(bool b) { Writer w; w.uint(7, b ? 1 : 0); return w.buf; }
+    std::string floatValue(float f) { Writer w; w.fixed(2, &f, 4); return w.buf; }
+    std::string doubleValue(double d) { Writer w; w.fixed(3, &d, 8); return w.buf; }
+
+    std::string feature(std::uint64_t id, unsigned type, const std::vector<std::uint32_t>& tags, const std::vector<std::uint32_t>& geometry)
+    {
+        Writer w;
+        w.uint(1, id);
+        w.packed(2, tags);
+        w.uint(3, type);
+        w.packed(4, geometry);
+        return w.buf;
+    }
+
+    // a 10x10 square with a 6x6 hole, starting at (x,y)
+    std::vector<std::uint32_t> squareWithHole(int x, int y)
+    {
+        return {
+            cmd(1, 1), zz(x), zz(y),
+            cmd(2, 3), zz(10), zz(0), zz(0), zz(10), zz(-10), zz(0),
+            cmd(7, 1),
+            cmd(1, 1), zz(2), zz(-8),
+            cmd(2, 3), zz(0), zz(6), zz(6), zz(0), zz(0), zz(-6),
+            cmd(7, 1)
+        };
+    }
+
+    std::string createTile(unsigned numRepeats = 1)
+    {
+        Writer roads;
+        roads.uint(15, 2);
+        // features first, to check that the decoder does not depend on field order
+        for (unsigned i = 0; i < numRepeats; ++i)
+        {
+            std::uint64_t id = i * 4u;
+            roads.bytes(2, feature(id + 1, 2, { 0, 0, 1, 1, 2, 2 },
+                { cmd(1, 1), zz(100), zz(100), cmd(2, 2), zz(50), zz(0), zz(0), zz(50) }));
+            roads.bytes(2, feature(id + 2, 2, { 0, 3, 3, 4, 4, 5 },
+                { cmd(1, 1), zz(10), zz(10), cmd(2, 1), zz(20), zz(20),
+                  cmd(1, 1), zz(100), zz(0), cmd(2, 1), zz(5), zz(5) }));
+            roads.bytes(2, feature(id + 3, 1, { 0, 6, 5, 7 },
+                { cmd(1, 2), zz(2048), zz(2048), zz(10), zz(-10) }));
+            roads.bytes(2, feature(id + 4, 3, { 0, 0, 1, 1 },
+                [] { auto a = squareWithHole(500, 500), b = squareWithHole(100, 0); a.insert(a.end(), b.begin(), b.end()); return a; }()));
+        }
+        roads.bytes(1, "roads");
+        roads.bytes(3, "name");
+        roads.bytes(3, "lanes");
+        roads.bytes(3, "speed");
+        roads.bytes(3, "oneway");
+        roads.bytes(3, "weight");
+        roads.bytes(3, "other_tags");
+        roads.bytes(4, stringValue("Main Street"));
+        roads.bytes(4, intValue(2));
+        roads.bytes(4, doubleValue(12.5));
+        roads.bytes(4, boolValue(true));
+        roads.bytes(4, floatValue(0.25f));
+        roads.bytes(4, sintValue(-7));
+        roads.bytes(4, uintValue(12345678901ull));
+        roads.bytes(4, stringValue("height=>\"42.5\""));
+        roads.uint(5, 4096);
+
+        Writer water;
+        water.uint(15, 2);
+        water.bytes(1, "water");
+        water.bytes(3, "kind");
+        water.bytes(4, stringValue("lake"));
+        water.bytes(2, feature(99, 3, { 0, 0 }, squareWithHole(0, 0)));
+        water.uint(5, 256);
+
+        Writer tile;
+        tile.bytes(3, roads.buf);
+        tile.bytes(3, water.buf);
+        return tile.buf;
+    }
+
+    void requireSameGeometry(const Geometry* a, const Geometry* b)
+    {
+        REQUIRE(a != nullptr);
+        REQUIRE(b != nullptr);
+        REQUIRE(a->getComponentType() == b->getComponentType());
+        REQUIRE(a->getNumComponents() == b->getNumComponents());
+        REQUIRE(a->asVector() == b->asVector());
+
+        if (a->getComponentType() == Geometry::TYPE_POLYGON && a->getType() != Geometry::TYPE_MULTI)
+        {
+            const Polygon* pa = static_cast<const Polygon*>(a);
+            const Polygon* pb = static_cast<const Polygon*>(b);
+            REQUIRE(pa->getHoles().size() == pb->getHoles().size());
+            for (unsigned i = 0; i < pa->getHoles().size(); ++i)
+                REQUIRE(pa->getHoles()[i]->asVector() == pb->getHoles()[i]->asVector());
+        }
+
+        if (a->getType() == Geometry::TYPE_MULTI)
+        {
+            const MultiGeometry* ma = static_cast<const MultiGeometry*>(a);
+            const MultiGeometry* mb = static_cast<const MultiGeometry*>(b);
+            REQUIRE(ma->getComponents().size() == mb->getComponents().size());
+            for (unsigned i = 0; i < ma->getComponents().size(); ++i)
+                requireSameGeometry(ma->getComponents()[i].get(), mb->getComponents()[i].get());
+        }
+    }
+
+    void requireSameFeatures(const FeatureList& expected, const FeatureList& actual)
+    {
+        REQUIRE(expected.size() == actual.size());
+        for (unsigned i = 0; i < expected.size(); ++i)
+        {
+            const Feature* e = expected[i].get();
+            const Feature* a = actual[i].get();
+            REQUIRE(e->getFID() == a->getFID());
+            REQUIRE(e->getAttrs().size() == a->getAttrs().size());
+            for (auto& attr : e->getAttrs())
+            {
+                REQUIRE(a->hasAttr(attr.first));
+                const AttributeValue& value = a->getAttrs().find(attr.first)->second;
+                REQUIRE(value.type == attr.second.type);
+                REQUIRE(value.getString() == attr.second.getString());
+            }
+            requireSameGeometry(e->getGeometry(), a->getGeometry());
+        }
+    }
+}
+
+TEST_CASE("MVT")
+{
+    const Profile* profile = Registry::instance()->getSphericalMercatorProfile();
+    TileKey key(3, 2, 5, profile);
+    std::string tile = createTile();
+
+    std::stringstream in(tile);
+    FeatureList expected;
+    REQUIRE(MVT::readTileWithProtobuf(in, key, expected));
+    REQUIRE(expected.size() == 5u);
+
+    SECTION("Streaming decoder matches the protobuf decoder")
+    {
+        FeatureList actual;
+        REQUIRE(MVT::readTile(tile.data(), tile.size(), key, MVT::Selection(), actual));
+        requireSameFeatures(expected, actual);
+
+        REQUIRE(actual[0]->getString("name") == "Main Street");
+        REQUIRE(actual[0]->getDouble("speed") == 12.5);
+        REQUIRE(actual[1]->getInt("weight") == -7);
+        REQUIRE(actual[2]->getDouble("height") == 42.5);
+        REQUIRE(actual[3]->getGeometry()->getType() == Geometry::TYPE_MULTI);
+        REQUIRE(actual[4]->getString("mvt_layer") == "water");
+    }
+
+    SECTION("Compressed tiles")
+    {
+        osg::ref_ptr<osgDB::BaseCompressor> compressor = osgDB::Registry::instance()->getObjectWrapperManager()->findCompressor("zlib");
+        if (compressor.valid())
+        {
+            std::stringstream out;
+            REQUIRE(compressor->compress(out, tile));
+            std::string compressed = out.str();
+
+            FeatureList actual;
+            REQUIRE(MVT::readTile(compressed.data(), compressed.size(), key, MVT::Selection(), actual));
+            requireSameFeatures(expected, actual);
+        }
+    }
+
+    SECTION("Selection skips layers and attributes")
+    {
+        MVT::Selection selection;
+        selection.layers.insert("roads");
+        selection.attributes.insert("name");
+        selection.attributes.insert("height");
+
+        FeatureList actual;
+        REQUIRE(MVT::readTile(tile.data(), tile.size(), key, selection, actual));
+        REQUIRE(actual.size() == 4u);
+        for (auto& f : actual)
+        {
+            REQUIRE(f->getString("mvt_layer") == "roads");
+            REQUIRE_FALSE(f->hasAttr("lanes"));
+            REQUIRE_FALSE(f->hasAttr("other_tags"));
+        }
+        REQUIRE(actual[0]->getString("name") == "Main Street");
+        REQUIRE(actual[2]->getDouble("height") == 42.5);
+    }
+
+    SECTION("Truncated tiles fail")
+    {
+        FeatureList actual;
+        REQUIRE_FALSE(MVT::readTile(tile.data(), tile.size() - 3, key, MVT::Selection(), actual));
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("MVT decoding", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    const Profile* profile = Registry::instance()->getSphericalMercatorProfile();
+    TileKey key(14, 8000, 5000, profile);
+    std::string tile = createTile(2500);
+    const unsigned iterations = 50;
+
+    auto t0 = clock::now();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        std::stringstream in(tile);
+        FeatureList features;
+        MVT::readTileWithProtobuf(in, key, features);
+    }
+    double protobuf_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    t0 = clock::now();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        FeatureList features;
+        MVT::readTile(tile.data(), tile.size(), key, MVT::Selection(), features);
+    }
+    double streaming_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    MVT::Selection selection;
+    selection.attributes.insert("name");
+    t0 = clock::now();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        FeatureList features;
+        MVT::readTile(tile.data(), tile.size(), key, selection, features);
+    }
+    double selected_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::cout << "MVT: " << (tile.size() / 1024) << " KB tile, " << iterations << " iterations: "
+        << "protobuf " << (protobuf_s * 1000.0 / iterations) << " ms/tile, "
+        << "streaming " << (streaming_s * 1000.0 / iterations) << " ms/tile, "
+        << "streaming (1 attribute) " << (selected_s * 1000.0 / iterations) << " ms/tile" << std::endl;
+}
+
+#endif // OSGEARTH_HAVE_MVT
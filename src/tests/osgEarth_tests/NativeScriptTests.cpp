@@ -0,0 +1,204 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/NativeScriptEngine>
+#include <osgEarth/Geometry>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    osg::ref_ptr<Feature> createFeature()
+    {
+        Polygon* polygon = new Polygon();
+        polygon->push_back(osg::Vec3d(0, 0, 0));
+        polygon->push_back(osg::Vec3d(1, 0, 0));
+        polygon->push_back(osg::Vec3d(1, 1, 0));
+
+        osg::ref_ptr<Feature> feature = new Feature(polygon, SpatialReference::create("wgs84"), Style(), 7LL);
+        feature->set("name", std::string("Main Street"));
+        feature->set("lanes", 4);
+        feature->set("area", 0.1 + 0.2);
+        feature->set("paved", true);
+        feature->set("width", std::string(" 12.5 "));
+        feature->set("empty", std::string());
+        feature->set("cafe", std::string("caf\xC3\xA9"));
+        return feature;
+    }
+
+    std::string eval(const std::string& code, const Feature* feature)
+    {
+        osg::ref_ptr<NativeScript> script = NativeScript::compile(code);
+        REQUIRE(script.valid());
+        ScriptResult result;
+        REQUIRE(script->run(feature, result) == NativeScript::STATUS_OK);
+        REQUIRE(result.success());
+        return result.asString();
+    }
+}
+
+TEST_CASE("NativeScript")
+{
+    osg::ref_ptr<Feature> feature = createFeature();
+
+    SECTION("Reads feature data")
+    {
+        REQUIRE(eval("feature.properties.name", feature.get()) == "Main Street");
+        REQUIRE(eval("feature.properties['lanes']", feature.get()) == "4");
+        REQUIRE(eval("feature.properties.paved", feature.get()) == "true");
+        REQUIRE(eval("feature.properties.missing", feature.get()) == "undefined");
+        REQUIRE(eval("feature.properties.Name", feature.get()) == "undefined");
+        REQUIRE(eval("feature.id", feature.get()) == "7");
+        REQUIRE(eval("feature.geometry.type", feature.get()) == "Polygon");
+    }
+
+    SECTION("Formats numbers like JavaScript")
+    {
+        REQUIRE(eval("feature.properties.area", feature.get()) == "0.30000000000000004");
+        REQUIRE(eval("1/3", feature.get()) == "0.3333333333333333");
+        REQUIRE(eval("100", feature.get()) == "100");
+        REQUIRE(eval("1e21", feature.get()) == "1e+21");
+        REQUIRE(eval("123e18", feature.get()) == "123000000000000000000");
+        REQUIRE(eval("0.000001", feature.get()) == "0.000001");
+        REQUIRE(eval("1e-7", feature.get()) == "1e-7");
+        REQUIRE(eval("-1.5e-9", feature.get()) == "-1.5e-9");
+        REQUIRE(eval("0/0", feature.get()) == "NaN");
+        REQUIRE(eval("-1/0", feature.get()) == "-Infinity");
+    }
+
+    SECTION("Operators")
+    {
+        REQUIRE(eval("feature.properties.lanes * 3.5 + 1", feature.get()) == "15");
+        REQUIRE(eval("feature.properties.name + ' (' + feature.properties.lanes + ')'", feature.get()) == "Main Street (4)");
+        REQUIRE(eval("1 + 2 + '3'", feature.get()) == "33");
+        REQUIRE(eval("'5' - 2", feature.get()) == "3");
+        REQUIRE(eval("feature.properties.width * 2", feature.get()) == "25");
+        REQUIRE(eval("-7 % 3", feature.get()) == "-1");
+        REQUIRE(eval("feature.properties.lanes > 2 && feature.properties.paved", feature.get()) == "true");
+        REQUIRE(eval("feature.properties.empty || 'none'", feature.get()) == "none");
+        REQUIRE(eval("feature.properties.lanes >= 4 ? 'wide' : 'narrow'", feature.get()) == "wide");
+        REQUIRE(eval("feature.properties.lanes == '4'", feature.get()) == "true");
+        REQUIRE(eval("feature.properties.lanes === '4'", feature.get()) == "false");
+        REQUIRE(eval("null == undefined", feature.get()) == "true");
+        REQUIRE(eval("'10' < '9'", feature.get()) == "true");
+        REQUIRE(eval("!feature.properties.empty;", feature.get()) == "true");
+    }
+
+    SECTION("Methods and Math")
+    {
+        REQUIRE(eval("feature.properties.name.toUpperCase()", feature.get()) == "MAIN STREET");
+        REQUIRE(eval("feature.properties.name.substring(5)", feature.get()) == "Street");
+        REQUIRE(eval("feature.properties.name.indexOf('Street')", feature.get()) == "5");
+        REQUIRE(eval("feature.properties.name.length", feature.get()) == "11");
+        REQUIRE(eval("feature.properties.width.trim()", feature.get()) == "12.5");
+        REQUIRE(eval("feature.properties.lanes.toString() + 'x'", feature.get()) == "4x");
+        REQUIRE(eval("Math.round(2.5) + Math.round(-2.5)", feature.get()) == "1");
+        REQUIRE(eval("Math.max(1, feature.properties.lanes, 3)", feature.get()) == "4");
+        REQUIRE(eval("Math.pow(1, 0/0)", feature.get()) == "NaN");
+        REQUIRE(eval("Math.floor(Math.PI * 100)", feature.get()) == "314");
+    }
+
+    SECTION("Leaves unsupported code to a full engine")
+    {
+        REQUIRE(NativeScript::compile("") == nullptr);
+        REQUIRE(NativeScript::compile("var x = 1; x") == nullptr);
+        REQUIRE(NativeScript::compile("myFunction(feature)") == nullptr);
+        REQUIRE(NativeScript::compile("feature.properties.name.split(' ')") == nullptr);
+        REQUIRE(NativeScript::compile("1 +") == nullptr);
+
+        osg::ref_ptr<NativeScript> script = NativeScript::compile("feature.properties.cafe.length");
+        REQUIRE(script.valid());
+        ScriptResult result;
+        REQUIRE(script->run(feature.get(), result) == NativeScript::STATUS_UNSUPPORTED);
+    }
+
+    SECTION("Reports runtime errors")
+    {
+        osg::ref_ptr<NativeScript> script = NativeScript::compile("feature.properties.missing.length");
+        REQUIRE(script.valid());
+        ScriptResult result;
+        REQUIRE(script->run(feature.get(), result) == NativeScript::STATUS_ERROR);
+        REQUIRE_FALSE(result.success());
+    }
+}
+
+TEST_CASE("NativeScriptEngine")
+{
+    osg::ref_ptr<Feature> feature = createFeature();
+    osg::ref_ptr<ScriptEngine> engine = new NativeScriptEngine(nullptr);
+
+    REQUIRE(engine->supported("javascript"));
+    REQUIRE(engine->run("feature.properties.lanes * 2", feature.get()).asDouble() == 8.0);
+    REQUIRE(engine->run("feature.properties.paved", feature.get()).asBool());
+    REQUIRE_FALSE(engine->run("myFunction()", feature.get()).success());
+    REQUIRE_FALSE(engine->run("", feature.get()).success());
+
+    FeatureList features;
+    for (int i = 0; i < 3; ++i)
+    {
+        osg::ref_ptr<Feature> f = createFeature();
+        f->set("lanes", i);
+        features.push_back(f);
+    }
+
+    std::vector<ScriptResult> results;
+    REQUIRE(engine->run("feature.properties.lanes + 1", features, results, nullptr));
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0].asString() == "1");
+    REQUIRE(results[2].asString() == "3");
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("NativeScriptEngine benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    FeatureList features;
+    for (int i = 0; i < 100000; ++i)
+    {
+        osg::ref_ptr<Feature> f = createFeature();
+        f->set("lanes", i % 6);
+        features.push_back(f);
+    }
+
+    const std::string code = "feature.properties.lanes > 2 ? feature.properties.name.toUpperCase() : 'minor'";
+
+    osg::ref_ptr<ScriptEngine> js = ScriptEngineFactory::create("javascript", "", true);
+    osg::ref_ptr<ScriptEngine> native = new NativeScriptEngine(js.get());
+
+    for (auto engine : { js.get(), (ScriptEngine*)native.get() })
+    {
+        if (!engine)
+            continue;
+
+        std::vector<ScriptResult> results;
+        auto t0 = clock::now();
+        engine->run(code, features, results, nullptr);
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        std::cout << engine->className() << ": evaluated "
+            << results.size() << " features in " << s << " s" << std::endl;
+    }
+}
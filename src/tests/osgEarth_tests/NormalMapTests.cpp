@@ -0,0 +1,213 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/Elevation>
+#include <osgEarth/ElevationPool>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/HeightFieldUtils>
+#include <osgEarth/ImageUtils>
+#include <osgEarth/Map>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+
+namespace
+{
+    // Elevation layer with rolling hills and a few sharp ridges,
+    // so the normals vary from texel to texel.
+    class RidgeElevationLayer : public ElevationLayer
+    {
+    public:
+        META_Layer(osgEarth, RidgeElevationLayer, Options, ElevationLayer, ridge_elevation);
+
+        static float height(double x, double y)
+        {
+            double h = 800.0 * sin(osg::DegreesToRadians(x * 40.0)) * cos(osg::DegreesToRadians(y * 25.0));
+            h += 150.0 * fabs(sin(osg::DegreesToRadians((x + y) * 300.0)));
+            return (float)h;
+        }
+
+    protected:
+        Status openImplementation() override
+        {
+            Status parent = ElevationLayer::openImplementation();
+            if (parent.isError())
+                return parent;
+
+            setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+            addDataExtent(DataExtent(getProfile()->getExtent(), 0u, 12u));
+            return Status::NoError;
+        }
+
+        GeoHeightField createHeightFieldImplementation(const TileKey& key, ProgressCallback*) const override
+        {
+            const unsigned size = 257u;
+            const GeoExtent& ex = key.getExtent();
+            osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(ex, size, size, 0u);
+            for (unsigned row = 0; row < size; ++row)
+            {
+                double y = ex.yMin() + ex.height() * (double)row / (double)(size - 1);
+                for (unsigned col = 0; col < size; ++col)
+                {
+                    double x = ex.xMin() + ex.width() * (double)col / (double)(size - 1);
+                    hf->setHeight(col, row, height(x, y));
+                }
+            }
+            return GeoHeightField(hf.get(), ex);
+        }
+    };
+
+    osg::ref_ptr<Map> createRidgeMap()
+    {
+        osg::ref_ptr<Map> map = new Map();
+        map->setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+        map->addLayer(new RidgeElevationLayer());
+        return map;
+    }
+
+    // Largest per-channel difference between the top levels of two normal maps
+    int maxDifference(osg::Texture2D* a, osg::Texture2D* b)
+    {
+        const osg::Image* ia = a->getImage();
+        const osg::Image* ib = b->getImage();
+        int result = 0;
+        for (int t = 0; t < ia->t(); ++t)
+        {
+            const unsigned char* pa = ia->data(0, t);
+            const unsigned char* pb = ib->data(0, t);
+            for (int i = 0; i < 2 * ia->s(); ++i)
+                result = std::max(result, std::abs((int)pa[i] - (int)pb[i]));
+        }
+        return result;
+    }
+}
+
+TEST_CASE("NormalMapGenerator stencil matches the reference normal")
+{
+    const int size = 64, border = 2, pitch = size + 2 * border;
+    std::vector<float> grid(pitch * pitch);
+    for (int j = 0; j < pitch; ++j)
+        for (int i = 0; i < pitch; ++i)
+            grid[j * pitch + i] = RidgeElevationLayer::height(i * 0.01, j * 0.01);
+
+    // a hole in the data
+    grid[(border + 10) * pitch + border + 20] = NO_DATA_VALUE;
+
+    osg::ref_ptr<osg::Image> image = new osg::Image();
+    image->allocateImage(size, 1, 1, GL_RG, GL_UNSIGNED_BYTE);
+    ImageUtils::PixelWriter write(image.get());
+
+    for (int stride = 1; stride <= border; ++stride)
+    {
+        for (int t = 0; t < size; ++t)
+        {
+            const float dx = 900.0f + (float)t, dy = 1100.0f;
+            const float* row = &grid[(t + border) * pitch + border];
+
+            std::vector<GLubyte> out(2 * size);
+            NormalMapGenerator::computeNormals(row, pitch, size, stride, dx, dy, out.data(), nullptr);
+
+            for (int s = 0; s < size; ++s)
+            {
+                float W = row[s - stride], E = row[s + stride];
+                float S = row[s - stride * pitch], N = row[s + stride * pitch];
+
+                osg::Vec3 normal(0, 0, 1);
+                if (W != NO_DATA_VALUE && E != NO_DATA_VALUE && S != NO_DATA_VALUE && N != NO_DATA_VALUE)
+                {
+                    normal = osg::Vec3(2 * dx, 0, E - W) ^ osg::Vec3(0, 2 * dy, N - S);
+                    normal.normalize();
+                }
+
+                osg::Vec4 packed;
+                NormalMapGenerator::pack(normal, packed);
+                write(packed, s, 0);
+
+                REQUIRE(std::abs((int)out[2 * s + 0] - (int)image->data(s, 0)[0]) <= 1);
+                REQUIRE(std::abs((int)out[2 * s + 1] - (int)image->data(s, 0)[1]) <= 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("NormalMapGenerator stencil agrees with per-texel sampling")
+{
+    osg::ref_ptr<Map> map = createRidgeMap();
+    const Profile* profile = map->getProfile();
+    NormalMapGenerator gen;
+
+    SECTION("Native data")
+    {
+        TileKey key(8, 271, 90, profile);
+        osg::ref_ptr<osg::Texture2D> a = gen.createNormalMap(key, map.get(), nullptr, nullptr, nullptr);
+        osg::ref_ptr<osg::Texture2D> b = gen.createNormalMapFromSamples(key, map.get(), nullptr, nullptr, nullptr);
+        REQUIRE(a.valid());
+        REQUIRE(b.valid());
+        REQUIRE(maxDifference(a.get(), b.get()) <= 2);
+    }
+
+    SECTION("Upsampled data")
+    {
+        // beyond the layer's max LOD, so the stencil widens to the data resolution
+        TileKey key(14, 17350, 5770, profile);
+        osg::ref_ptr<osg::Texture2D> a = gen.createNormalMap(key, map.get(), nullptr, nullptr, nullptr);
+        osg::ref_ptr<osg::Texture2D> b = gen.createNormalMapFromSamples(key, map.get(), nullptr, nullptr, nullptr);
+        REQUIRE(a.valid());
+        REQUIRE(b.valid());
+        REQUIRE(maxDifference(a.get(), b.get()) <= 2);
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("NormalMapGenerator benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    osg::ref_ptr<Map> map = createRidgeMap();
+    const Profile* profile = map->getProfile();
+    NormalMapGenerator gen;
+
+    std::vector<TileKey> keys;
+    for (unsigned y = 88; y < 92; ++y)
+        for (unsigned x = 270; x < 274; ++x)
+            keys.push_back(TileKey(8, x, y, profile));
+
+    // warm up the elevation pool so both passes time only the normal maps
+    ElevationPool::WorkingSet ws(256u);
+    for (auto& key : keys)
+        osg::ref_ptr<osg::Texture2D> tex = gen.createNormalMapFromSamples(key, map.get(), &ws, nullptr, nullptr);
+
+    auto t0 = clock::now();
+    for (auto& key : keys)
+        osg::ref_ptr<osg::Texture2D> tex = gen.createNormalMapFromSamples(key, map.get(), &ws, nullptr, nullptr);
+    double sampled = std::chrono::duration<double>(clock::now() - t0).count();
+
+    t0 = clock::now();
+    for (auto& key : keys)
+        osg::ref_ptr<osg::Texture2D> tex = gen.createNormalMap(key, map.get(), &ws, nullptr, nullptr);
+    double stencil = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::cout << "NormalMapGenerator: " << keys.size() << " tiles: sampled "
+        << sampled << " s, stencil " << stencil << " s" << std::endl;
+}
@@ -0,0 +1,188 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/SDF>
+#include <osgEarth/ImageUtils>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    const float NODATA = 32767.0f;
+
+    // NN field with a few random seeds plus a curve, like a rasterized road
+    osg::Image* createSeededField(unsigned size, unsigned numPoints, unsigned seed)
+    {
+        osg::Image* image = new osg::Image();
+        image->allocateImage(size, size, 1, GL_RG, GL_FLOAT);
+        float* data = (float*)image->data();
+        for (unsigned i = 0; i < size * size * 2; ++i)
+            data[i] = NODATA;
+
+        std::mt19937 rng(seed);
+        auto mark = [&](unsigned s, unsigned t) {
+            data[(t * size + s) * 2 + 0] = (float)s;
+            data[(t * size + s) * 2 + 1] = (float)t;
+        };
+        for (unsigned i = 0; i < numPoints; ++i)
+            mark(rng() % size, rng() % size);
+        for (unsigned s = 0; s < size; ++s)
+            mark(s, (unsigned)(size / 2 + size / 4 * sin(s * 0.01)));
+
+        return image;
+    }
+
+    inline float distanceToAssigned(const osg::Image* image, unsigned s, unsigned t)
+    {
+        const float* p = (const float*)image->data(s, t);
+        return sqrtf((p[0] - s) * (p[0] - s) + (p[1] - t) * (p[1] - t));
+    }
+}
+
+TEST_CASE("SDFGenerator")
+{
+    SECTION("Nearest-neighbor field is exact")
+    {
+        for (unsigned size : { 1u, 7u, 64u, 300u })
+        {
+            osg::ref_ptr<osg::Image> image = createSeededField(size, size / 8 + 1, size);
+            osg::ref_ptr<osg::Image> original = new osg::Image(*image.get(), osg::CopyOp::DEEP_COPY_ALL);
+
+            std::vector<osg::Vec2f> seeds;
+            for (unsigned t = 0; t < size; ++t)
+                for (unsigned s = 0; s < size; ++s)
+                    if (*(const float*)original->data(s, t) != NODATA)
+                        seeds.emplace_back((float)s, (float)t);
+
+            SDFGenerator::computeNearestNeighborField(image.get());
+
+            unsigned wrong = 0;
+            for (unsigned t = 0; t < size; ++t)
+            {
+                for (unsigned s = 0; s < size; ++s)
+                {
+                    float best = FLT_MAX;
+                    for (auto& seed : seeds)
+                        best = std::min(best, (seed - osg::Vec2f(s, t)).length2());
+
+                    const float* p = (const float*)image->data(s, t);
+                    const float* q = (const float*)original->data((unsigned)p[0], (unsigned)p[1]);
+                    if (q[0] != p[0] || q[1] != p[1] || (osg::Vec2f(p[0], p[1]) - osg::Vec2f(s, t)).length2() != best)
+                        ++wrong;
+                }
+            }
+            REQUIRE(wrong == 0u);
+        }
+    }
+
+    SECTION("Field with no seeds is left alone")
+    {
+        osg::ref_ptr<osg::Image> image = new osg::Image();
+        image->allocateImage(32, 32, 1, GL_RG, GL_FLOAT);
+        float* data = (float*)image->data();
+        for (unsigned i = 0; i < 32 * 32 * 2; ++i)
+            data[i] = NODATA;
+
+        SDFGenerator::computeNearestNeighborField(image.get());
+        REQUIRE(data[0] == NODATA);
+        REQUIRE(data[32 * 32 * 2 - 1] == NODATA);
+    }
+
+    SECTION("Distance field from alpha")
+    {
+        osg::ref_ptr<osg::Image> image = new osg::Image();
+        image->allocateImage(64, 64, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+        ImageUtils::PixelWriter write(image.get());
+        write.assign(osg::Vec4(0, 0, 0, 0));
+        write(osg::Vec4(1, 1, 1, 1), 0, 0);
+
+        SDFGenerator sdf;
+        osg::ref_ptr<osg::Image> field = sdf.createDistanceField(image.get(), 0.0f, 10.0f);
+        REQUIRE(field.valid());
+        REQUIRE(field->getPixelFormat() == GL_RED);
+
+        ImageUtils::PixelReader read(field.get());
+        osg::Vec4 value;
+        read(value, 0, 0);
+        REQUIRE(value.r() == Approx(0.0f).margin(0.01f));
+        read(value, 6, 8);
+        REQUIRE(value.r() == Approx(1.0f).margin(0.01f));
+        read(value, 3, 4);
+        REQUIRE(value.r() == Approx(0.5f).margin(0.01f));
+        read(value, 63, 63);
+        REQUIRE(value.r() == Approx(1.0f).margin(0.01f));
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+// Compares the exact EDT with jump flooding, and measures how far off
+// jump flooding's answers are.
+TEST_CASE("SDFGenerator nearest-neighbor field benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    for (unsigned size = 256; size <= 4096; size *= 2)
+    {
+        osg::ref_ptr<osg::Image> jfa = createSeededField(size, size * size / 2000, size);
+        osg::ref_ptr<osg::Image> edt = new osg::Image(*jfa.get(), osg::CopyOp::DEEP_COPY_ALL);
+
+        auto t0 = clock::now();
+        SDFGenerator::computeNearestNeighborField(jfa.get(), SDFGenerator::ALGORITHM_JFA);
+        double jfaSeconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+        t0 = clock::now();
+        SDFGenerator::computeNearestNeighborField(edt.get(), SDFGenerator::ALGORITHM_EDT);
+        double edtSeconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+        unsigned wrong = 0;
+        double maxError = 0.0, sumError = 0.0;
+        for (unsigned t = 0; t < size; ++t)
+        {
+            for (unsigned s = 0; s < size; ++s)
+            {
+                double error = distanceToAssigned(jfa.get(), s, t) - distanceToAssigned(edt.get(), s, t);
+                REQUIRE(error > -1e-3);
+                if (error > 1e-3)
+                {
+                    ++wrong;
+                    maxError = std::max(maxError, error);
+                    sumError += error;
+                }
+            }
+        }
+
+        std::cout << size << "x" << size
+            << ": JFA " << jfaSeconds * 1000.0 << " ms"
+            << ", EDT " << edtSeconds * 1000.0 << " ms"
+            << "; JFA wrong pixels " << wrong
+            << ", max error " << maxError << " px"
+            << ", mean error " << (wrong > 0 ? sumError / wrong : 0.0) << " px"
+            << std::endl;
+    }
+}
@@ -23,6 +23,9 @@
 #include <osgEarth/catch.hpp>
 
 #include <osgEarth/SpatialReference>
+#include <chrono>
+#include <iostream>
+#include <random>
 
 using namespace osgEarth;
 
@@ -34,7 +37,24 @@ namespace
             if (!osg::equivalent(a[i], b[i])) return false;
         return true;
     }
-                
+
+    template<typename T>
+    bool vec_eq(const T& a, const T& b, double epsilon) {
+        for(int i=0; i<a.num_components; ++i)
+            if (!osg::equivalent(a[i], b[i], epsilon)) return false;
+        return true;
+    }
+
+    // transform with OGR, then with the built-in kernels, and compare
+    bool native_matches_ogr(const SpatialReference* from, const SpatialReference* to, const osg::Vec3d& input, double epsilon)
+    {
+        osg::Vec3d ogr, native;
+        SpatialReference::setNativeTransformsEnabled(false);
+        bool ok1 = from->transform(input, to, ogr);
+        SpatialReference::setNativeTransformsEnabled(true);
+        bool ok2 = from->transform(input, to, native);
+        return ok1 && ok2 && vec_eq(ogr, native, epsilon);
+    }
 }
 
 TEST_CASE( "SpatialReferences are cached" ) {
@@ -215,3 +235,82 @@ TEST_CASE("MFE SRS") {
     REQUIRE(p_wgs84.x() == -157.0);
     REQUIRE(p_wgs84.y() == 21.0);
 }
+
+TEST_CASE("Native transforms match OGR") {
+    const SpatialReference* wgs84 = SpatialReference::get("wgs84");
+    const SpatialReference* sm = SpatialReference::get("spherical-mercator");
+    const SpatialReference* utm13n = SpatialReference::get("+proj=utm +zone=13 +datum=WGS84");
+    const SpatialReference* utm56s = SpatialReference::get("+proj=utm +zone=56 +south +datum=WGS84");
+    const SpatialReference* ecef = wgs84->getGeocentricSRS();
+
+    REQUIRE(native_matches_ogr(wgs84, sm, osg::Vec3d(-122.5, 37.7, 100), 1e-4));
+    REQUIRE(native_matches_ogr(sm, wgs84, osg::Vec3d(-13636813.0, 4539055.0, 100), 1e-9));
+    REQUIRE(native_matches_ogr(wgs84, utm13n, osg::Vec3d(-105.0, 40.0, 0), 1e-4));
+    REQUIRE(native_matches_ogr(utm13n, wgs84, osg::Vec3d(450000.0, 4400000.0, 0), 1e-9));
+    REQUIRE(native_matches_ogr(wgs84, utm56s, osg::Vec3d(151.2093, -33.8688, 0), 1e-4));
+    REQUIRE(native_matches_ogr(sm, utm13n, osg::Vec3d(-11688546.0, 4865942.0, 0), 1e-4));
+    REQUIRE(native_matches_ogr(wgs84, ecef, osg::Vec3d(45.0, 45.0, 1000.0), 1e-6));
+    REQUIRE(native_matches_ogr(ecef, wgs84, osg::Vec3d(3194419.0, 3194419.0, 4487348.0), 1e-9));
+
+    // published value: 40N 105W is exactly on the zone 13 central meridian
+    osg::Vec3d out;
+    REQUIRE(wgs84->transform(osg::Vec3d(-105.0, 40.0, 0), utm13n, out));
+    REQUIRE(osg::equivalent(out.x(), 500000.0, 1e-3));
+    REQUIRE(osg::equivalent(out.y(), 4427757.219, 1e-3));
+
+    // mercator can't reach the poles, natively or through OGR
+    REQUIRE_FALSE(wgs84->transform(osg::Vec3d(0.0, 90.0, 0), sm, out));
+    REQUIRE_FALSE(wgs84->transform(osg::Vec3d(0.0, -90.0, 0), sm, out));
+    SpatialReference::setNativeTransformsEnabled(false);
+    bool ogr = wgs84->transform(osg::Vec3d(0.0, 90.0, 0), sm, out);
+    SpatialReference::setNativeTransformsEnabled(true);
+    REQUIRE_FALSE(ogr);
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("Native transform throughput", "[.][benchmark]") {
+    using clock = std::chrono::steady_clock;
+
+    const SpatialReference* wgs84 = SpatialReference::get("wgs84");
+    const SpatialReference* sm = SpatialReference::get("spherical-mercator");
+    const SpatialReference* utm = SpatialReference::get("+proj=utm +zone=13 +datum=WGS84");
+    const SpatialReference* ecef = wgs84->getGeocentricSRS();
+
+    std::mt19937 prng(0);
+    std::uniform_real_distribution<double> lon(-108.0, -102.0), lat(-80.0, 80.0);
+
+    for (auto to : { sm, utm, ecef })
+    {
+        for (unsigned count : { 1u, 1000u, 1000000u })
+        {
+            std::vector<osg::Vec3d> input(count);
+            for (auto& p : input)
+                p.set(lon(prng), lat(prng), 0.0);
+
+            double seconds[2];
+            for (int native = 0; native < 2; ++native)
+            {
+                SpatialReference::setNativeTransformsEnabled(native == 1);
+                std::vector<osg::Vec3d> points(input);
+                auto t0 = clock::now();
+                if (count == 1)
+                {
+                    osg::Vec3d out;
+                    for (int i = 0; i < 100000; ++i)
+                        wgs84->transform(points[0], to, out);
+                }
+                else
+                {
+                    wgs84->transform(points, to);
+                }
+                seconds[native] = std::chrono::duration<double>(clock::now() - t0).count();
+            }
+            SpatialReference::setNativeTransformsEnabled(true);
+
+            unsigned total = count == 1 ? 100000u : count;
+            std::cout << "wgs84 -> " << to->getName() << ": " << count << " points: "
+                << "OGR " << (int)(total / seconds[0]) << " pts/s, "
+                << "native " << (int)(total / seconds[1]) << " pts/s" << std::endl;
+        }
+    }
+}
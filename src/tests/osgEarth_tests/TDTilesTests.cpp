@@ -0,0 +1,215 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/TDTiles>
+#include <sstream>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+using namespace osgEarth::Contrib::ThreeDTiles;
+
+namespace
+{
+    // Writes a quadtree tile with "depth" levels below it.
+    void writeTile(std::ostream& out, int depth, double west, double south, double east, double north, int& count)
+    {
+        out << "{\"boundingVolume\":{\"region\":["
+            << west << "," << south << "," << east << "," << north << ",0,100]},"
+            << "\"geometricError\":" << (1 << depth) << ","
+            << "\"content\":{\"uri\":\"tiles/" << count++ << ".b3dm\"}";
+
+        if (depth > 0)
+        {
+            double x = 0.5*(west + east), y = 0.5*(south + north);
+            out << ",\"children\":[";
+            writeTile(out, depth - 1, west, south, x, y, count); out << ",";
+            writeTile(out, depth - 1, x, south, east, y, count); out << ",";
+            writeTile(out, depth - 1, west, y, x, north, count); out << ",";
+            writeTile(out, depth - 1, x, y, east, north, count);
+            out << "]";
+        }
+        out << "}";
+    }
+
+    std::string createTilesetJSON(int depth, int& count)
+    {
+        std::ostringstream out;
+        out << "{\"asset\":{\"version\":\"1.0\",\"gltfUpAxis\":\"Z\"},\"geometricError\":1000,\"root\":";
+        writeTile(out, depth, -1.5, 0.5, -1.4, 0.6, count);
+        out << "}";
+        return out.str();
+    }
+
+    // Counts the tiles currently materialized, without expanding any.
+    int countTiles(const Tile* tile)
+    {
+        int count = 1;
+        for (auto& child : tile->children())
+            count += countTiles(child.get());
+        return count;
+    }
+}
+
+TEST_CASE("TDTiles")
+{
+    int count = 0;
+    std::string json = createTilesetJSON(5, count);
+
+    osg::ref_ptr<Tileset> tileset = Tileset::create(json, URIContext());
+    REQUIRE(tileset.valid());
+    REQUIRE(tileset->asset()->gltfUpAxis() == "Z");
+    REQUIRE(tileset->root().valid());
+
+    Tile* root = tileset->root().get();
+
+    SECTION("Only the top levels are materialized")
+    {
+        REQUIRE(countTiles(root) == 1 + 4 + 16);
+
+        Tile* tile = root->children()[0]->children()[0].get();
+        REQUIRE(tile->hasChildren());
+        REQUIRE_FALSE(tile->isExpanded());
+        REQUIRE(tile->children().empty());
+        REQUIRE(tile->geometricError() == 8.0);
+        REQUIRE(tile->content()->uri()->base() == "tiles/2.b3dm");
+    }
+
+    SECTION("Expanding reads the next level")
+    {
+        Tile* tile = root->children()[1]->children()[2].get();
+        REQUIRE(tile->expand());
+        REQUIRE(tile->isExpanded());
+        REQUIRE(tile->children().size() == 4);
+        REQUIRE(tile->children()[3]->geometricError() == 4.0);
+        REQUIRE_FALSE(tile->children()[3]->isExpanded());
+        REQUIRE(countTiles(root) == 1 + 4 + 16 + 4);
+    }
+
+    SECTION("Expanding everything matches the full tree")
+    {
+        std::vector<Tile*> stack { root };
+        int n = 0;
+        while (!stack.empty())
+        {
+            Tile* tile = stack.back();
+            stack.pop_back();
+            REQUIRE(tile->expand());
+            for (auto& child : tile->children())
+                stack.push_back(child.get());
+            ++n;
+        }
+        REQUIRE(n == count);
+
+        Json::Reader reader;
+        Json::Value value;
+        REQUIRE(reader.parse(json, value, false));
+        LoadContext lc;
+        osg::ref_ptr<Tileset> eager = new Tileset(value, lc);
+        REQUIRE(tileset->root()->getJSON().toStyledString() == eager->root()->getJSON().toStyledString());
+    }
+
+    SECTION("Collapsing returns lazy children to JSON")
+    {
+        Tile* tile = root->children()[0]->children()[3].get();
+        REQUIRE(tile->expand());
+        REQUIRE(tile->collapse());
+        REQUIRE(tile->children().empty());
+        REQUIRE(tile->hasChildren());
+        REQUIRE(tile->expand());
+        REQUIRE(tile->children().size() == 4);
+
+        // eagerly materialized levels stay resident
+        REQUIRE_FALSE(root->collapse());
+        REQUIRE(root->children().size() == 4);
+    }
+
+    SECTION("Unexpanded children still serialize")
+    {
+        Tile* tile = root->children()[2]->children()[2].get();
+        Json::Value value = tile->getJSON();
+        REQUIRE(value["children"].size() == 4);
+        REQUIRE_FALSE(tile->isExpanded());
+    }
+
+    SECTION("Invalid JSON")
+    {
+        REQUIRE(Tileset::create("", URIContext()) == nullptr);
+        REQUIRE(Tileset::create("{\"root\":{\"geometricError\":1x}}", URIContext()) == nullptr);
+        REQUIRE(Tileset::create("{\"root\":{\"children\":[}", URIContext()) == nullptr);
+
+        // errors in deferred subtrees show up on expansion
+        osg::ref_ptr<Tileset> bad = Tileset::create(
+            "{\"root\":{\"children\":[{\"children\":[{\"children\":[{\"children\":[{\"geometricError\":}]}]}]}]}}",
+            URIContext());
+        REQUIRE(bad.valid());
+        Tile* tile = bad->root()->children()[0]->children()[0].get();
+        REQUIRE(tile->expand());
+        tile = tile->children()[0].get();
+        REQUIRE_FALSE(tile->expand());
+        REQUIRE_FALSE(tile->hasChildren());
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+// Opens a synthetic quadtree tileset of about 1.4 million tiles (~200 MB of JSON)
+// eagerly (full JSON tree, then the full Tile tree) and lazily.
+TEST_CASE("TDTiles deep tileset load benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    int count = 0;
+    std::string json = createTilesetJSON(10, count);
+    std::cout << "Tileset: " << count << " tiles, " << json.size() / 1048576 << " MB of JSON" << std::endl;
+
+    {
+        auto t0 = clock::now();
+        Json::Reader reader;
+        Json::Value value;
+        reader.parse(json, value, false);
+        LoadContext lc;
+        osg::ref_ptr<Tileset> tileset = new Tileset(value, lc);
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        std::cout << "Eager: " << s << " s, " << countTiles(tileset->root().get()) << " tiles resident" << std::endl;
+    }
+
+    {
+        auto t0 = clock::now();
+        osg::ref_ptr<Tileset> tileset = Tileset::create(json, URIContext());
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        std::cout << "Lazy: " << s << " s, " << countTiles(tileset->root().get()) << " tiles resident" << std::endl;
+
+        // refine down one branch to a leaf, as traversal would
+        t0 = clock::now();
+        Tile* tile = tileset->root().get();
+        while (tile->hasChildren())
+        {
+            tile->expand();
+            tile = tile->children().back().get();
+        }
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+        std::cout << "Lazy: expanded one branch to a leaf in " << ms << " ms, "
+            << countTiles(tileset->root().get()) << " tiles resident" << std::endl;
+    }
+}
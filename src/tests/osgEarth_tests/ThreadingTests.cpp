@@ -23,6 +23,9 @@
 #include <osgEarth/catch.hpp>
 #include <osgEarth/Threading>
 #include <thread>
+#include <chrono>
+#include <iostream>
+#include <random>
 
 using namespace osgEarth;
 
@@ -133,4 +136,171 @@ TEST_CASE( "ReadWriteMutex can handle multiple read locks from the same thread w
     REQUIRE(!thread2.isRunning());
     REQUIRE(elapsedTime < maxTimeSeconds);
 }
-#endif
\ No newline at end of file
+#endif
+
+namespace
+{
+    // New pools start with two threads, and surplus threads only exit after
+    // finishing a job; so feed the pool no-ops until it's down to one.
+    jobs::jobpool* get_single_threaded_pool(const std::string& name)
+    {
+        auto pool = jobs::get_pool(name);
+        pool->set_concurrency(1);
+        jobs::context c;
+        c.pool = pool;
+        while (pool->metrics()->concurrency > 1)
+        {
+            jobs::dispatch([]() {}, c);
+            std::this_thread::yield();
+        }
+        return pool;
+    }
+}
+
+TEST_CASE("jobpool runs queued jobs in priority order")
+{
+    auto pool = get_single_threaded_pool("oe.test.priority");
+
+    // occupy the only thread so the rest of the jobs queue up
+    Threading::Event gate;
+    jobs::context blocker;
+    blocker.pool = pool;
+    jobs::dispatch([&gate]() { gate.wait(); }, blocker);
+
+    std::vector<int> order;
+    auto group = jobs::jobgroup::create();
+
+    for (int i = 0; i < 100; ++i)
+    {
+        int p = (i * 37) % 100;
+        jobs::context c;
+        c.pool = pool;
+        c.group = group;
+        c.priority = [p]() { return (float)p; };
+        jobs::dispatch([&order, p]() { order.push_back(p); }, c);
+    }
+
+    gate.set();
+    group->join();
+
+    REQUIRE(order.size() == 100);
+    REQUIRE(std::is_sorted(order.rbegin(), order.rend()));
+}
+
+TEST_CASE("jobpool runs equal-priority jobs in dispatch order")
+{
+    auto pool = get_single_threaded_pool("oe.test.fifo");
+
+    Threading::Event gate;
+    jobs::context blocker;
+    blocker.pool = pool;
+    jobs::dispatch([&gate]() { gate.wait(); }, blocker);
+
+    std::vector<int> order;
+    auto group = jobs::jobgroup::create();
+
+    for (int i = 0; i < 100; ++i)
+    {
+        jobs::context c;
+        c.pool = pool;
+        c.group = group;
+        jobs::dispatch([&order, i]() { order.push_back(i); }, c);
+    }
+
+    gate.set();
+    group->join();
+
+    REQUIRE(order.size() == 100);
+    REQUIRE(std::is_sorted(order.begin(), order.end()));
+}
+
+TEST_CASE("parallel_for covers the range exactly once")
+{
+    auto pool = jobs::get_pool("oe.test.parallel_for");
+    pool->set_concurrency(4);
+
+    for (std::size_t count : { 0u, 1u, 7u, 1000u })
+    {
+        std::vector<std::atomic_int> hits(count);
+        for (auto& h : hits)
+            h = 0;
+        std::atomic_bool oversized = { false };
+
+        jobs::parallel_for(pool, count, 16u, [&](std::size_t begin, std::size_t end)
+            {
+                if (end - begin > 16u)
+                    oversized = true;
+                for (std::size_t i = begin; i < end; ++i)
+                    ++hits[i];
+            });
+
+        REQUIRE_FALSE(oversized);
+        for (auto& h : hits)
+            REQUIRE(h == 1);
+    }
+
+    // no pool runs on the calling thread
+    auto caller = std::this_thread::get_id();
+    bool sameThread = true;
+    jobs::parallel_for(nullptr, 100u, 1u, [&](std::size_t, std::size_t)
+        {
+            sameThread = sameThread && (std::this_thread::get_id() == caller);
+        });
+    REQUIRE(sameThread);
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("jobpool dispatch and dequeue throughput", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    auto pool = jobs::get_pool("oe.test.throughput");
+    pool->set_concurrency(std::max(2u, std::thread::hardware_concurrency()));
+
+    std::mt19937 prng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1000.0f);
+
+    for (int count : { 10000, 100000, 1000000 })
+    {
+        // hold all the workers so the whole batch is queued before any dequeues
+        Threading::Event gate;
+        auto blockers = jobs::jobgroup::create();
+        for (unsigned t = 0; t < pool->concurrency(); ++t)
+        {
+            jobs::context c;
+            c.pool = pool;
+            c.group = blockers;
+            jobs::dispatch([&gate]() { gate.wait(); }, c);
+        }
+
+        std::atomic_int counter = { 0 };
+        auto group = jobs::jobgroup::create();
+
+        auto t0 = clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            float p = dist(prng);
+            jobs::context c;
+            c.pool = pool;
+            c.group = group;
+            c.priority = [p]() { return p; };
+            jobs::dispatch([&counter]() { ++counter; }, c);
+        }
+        auto t1 = clock::now();
+
+        gate.set();
+        group->join();
+        blockers->join();
+        auto t2 = clock::now();
+
+        REQUIRE(counter == count);
+
+        double dispatch_s = std::chrono::duration<double>(t1 - t0).count();
+        double dequeue_s = std::chrono::duration<double>(t2 - t1).count();
+
+        std::cout << "jobpool: " << count << " jobs: "
+            << "dispatch " << (int)(count / dispatch_s) << " jobs/s, "
+            << "dequeue " << (int)(count / dequeue_s) << " jobs/s"
+            << std::endl;
+    }
+}
@@ -0,0 +1,226 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/TileVisitor>
+#include <cstdio>
+#include <fstream>
+#include <set>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    // Records every key it handles; has data down to level 4.
+    struct RecordingHandler : public TileHandler
+    {
+        bool handleTile(const TileKey& key, const TileVisitor& tv) override
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _keys.insert(key);
+            ++_count;
+            return true;
+        }
+
+        bool hasData(const TileKey& key) const override
+        {
+            return key.getLevelOfDetail() <= 4;
+        }
+
+        std::mutex _mutex;
+        std::set<TileKey> _keys;
+        unsigned _count = 0;
+    };
+
+    // Whether to descend below a key; prunes part of the tree
+    bool descend(const TileKey& key)
+    {
+        return key.getLevelOfDetail() != 2 || key.getTileX() % 3 != 0;
+    }
+
+    // Handles one key at a time
+    struct SingleKeyHandler : public TileHandler
+    {
+        bool handleTile(const TileKey& key, const TileVisitor& tv) override
+        {
+            _keys.push_back(key);
+            return descend(key);
+        }
+
+        std::vector<TileKey> _keys;
+    };
+
+    // Handles each set of siblings as one batch
+    struct BatchHandler : public TileHandler
+    {
+        std::vector<bool> handleTiles(const std::vector<TileKey>& keys, const TileVisitor& tv) override
+        {
+            _batches.push_back(keys);
+            std::vector<bool> result;
+            for (auto& key : keys)
+                result.push_back(descend(key));
+            return result;
+        }
+
+        std::vector<std::vector<TileKey>> _batches;
+    };
+
+    // Overrides the visitor's own hook instead of the handler's
+    struct BatchVisitor : public TileVisitor
+    {
+        std::vector<bool> handleTiles(const std::vector<TileKey>& keys) override
+        {
+            _keys.insert(_keys.end(), keys.begin(), keys.end());
+            std::vector<bool> result;
+            for (auto& key : keys)
+                result.push_back(descend(key));
+            return result;
+        }
+
+        std::vector<TileKey> _keys;
+    };
+}
+
+TEST_CASE("TileVisitor hands sibling keys over in batches")
+{
+    osg::ref_ptr<const Profile> profile = Profile::create(Profile::GLOBAL_GEODETIC);
+
+    // the western hemisphere, from level 1 to 4
+    GeoExtent extent(profile->getSRS(), -180.0, -90.0, -1.0, 90.0);
+
+    osg::ref_ptr<SingleKeyHandler> single = new SingleKeyHandler();
+    osg::ref_ptr<TileVisitor> tv = new TileVisitor(single.get());
+    tv->setMinLevel(1);
+    tv->setMaxLevel(4);
+    tv->addExtentToVisit(extent);
+    tv->run(profile.get());
+
+    std::set<TileKey> expected(single->_keys.begin(), single->_keys.end());
+    REQUIRE(expected.size() == single->_keys.size());
+    REQUIRE(!expected.empty());
+    for (auto& key : expected)
+    {
+        REQUIRE(key.getLevelOfDetail() >= 1u);
+        REQUIRE(key.getLevelOfDetail() <= 4u);
+        REQUIRE(key.getExtent().intersects(extent));
+    }
+
+    SECTION("Batched handler")
+    {
+        osg::ref_ptr<BatchHandler> batched = new BatchHandler();
+        osg::ref_ptr<TileVisitor> btv = new TileVisitor(batched.get());
+        btv->setMinLevel(1);
+        btv->setMaxLevel(4);
+        btv->addExtentToVisit(extent);
+        btv->run(profile.get());
+
+        std::set<TileKey> keys;
+        for (auto& batch : batched->_batches)
+        {
+            REQUIRE(!batch.empty());
+            REQUIRE(batch.size() <= 4u);
+            for (auto& key : batch)
+            {
+                // every key in a batch is a sibling of the first
+                REQUIRE(key.createParentKey() == batch.front().createParentKey());
+                REQUIRE(keys.insert(key).second);
+            }
+        }
+        REQUIRE(keys == expected);
+    }
+
+    SECTION("Visitor subclass")
+    {
+        osg::ref_ptr<BatchVisitor> btv = new BatchVisitor();
+        btv->setMinLevel(1);
+        btv->setMaxLevel(4);
+        btv->addExtentToVisit(extent);
+        btv->run(profile.get());
+
+        std::set<TileKey> keys(btv->_keys.begin(), btv->_keys.end());
+        REQUIRE(keys.size() == btv->_keys.size());
+        REQUIRE(keys == expected);
+    }
+}
+
+TEST_CASE("MultithreadedTileVisitor")
+{
+    osg::ref_ptr<const Profile> profile = Profile::create(Profile::GLOBAL_GEODETIC);
+    const std::string checkpointFile = "tilevisitor_test.checkpoint";
+    std::remove(checkpointFile.c_str());
+
+    // 2 root tiles, 4 levels of children
+    const unsigned numTiles = 2 * (1 + 4 + 16 + 64 + 256);
+
+    SECTION("Visits the same tiles as the single-threaded visitor")
+    {
+        osg::ref_ptr<RecordingHandler> serial = new RecordingHandler();
+        osg::ref_ptr<TileVisitor> tv = new TileVisitor(serial.get());
+        tv->addExtentToVisit(profile->getExtent());
+        tv->run(profile.get());
+
+        osg::ref_ptr<RecordingHandler> pipelined = new RecordingHandler();
+        osg::ref_ptr<MultithreadedTileVisitor> mtv = new MultithreadedTileVisitor(pipelined.get());
+        mtv->setNumThreads(4);
+        mtv->addExtentToVisit(profile->getExtent());
+        mtv->run(profile.get());
+
+        REQUIRE(serial->_keys.size() == numTiles);
+        REQUIRE(pipelined->_count == numTiles);
+        REQUIRE(pipelined->_keys == serial->_keys);
+    }
+
+    SECTION("Resuming skips the completed tiles")
+    {
+        osg::ref_ptr<RecordingHandler> first = new RecordingHandler();
+        osg::ref_ptr<MultithreadedTileVisitor> mtv = new MultithreadedTileVisitor(first.get());
+        mtv->setCheckpointFile(checkpointFile);
+        mtv->addExtentToVisit(profile->getExtent());
+        mtv->run(profile.get());
+        REQUIRE(first->_count == numTiles);
+
+        osg::ref_ptr<RecordingHandler> second = new RecordingHandler();
+        mtv->setTileHandler(second.get());
+        mtv->setResume(true);
+        mtv->run(profile.get());
+        REQUIRE(second->_count == 0u);
+    }
+
+    SECTION("A checkpoint from a different run starts over")
+    {
+        {
+            std::ofstream out(checkpointFile.c_str());
+            out << "3" << std::endl << "9, 9, 9" << std::endl;
+        }
+
+        osg::ref_ptr<RecordingHandler> handler = new RecordingHandler();
+        osg::ref_ptr<MultithreadedTileVisitor> mtv = new MultithreadedTileVisitor(handler.get());
+        mtv->setCheckpointFile(checkpointFile);
+        mtv->setResume(true);
+        mtv->addExtentToVisit(profile->getExtent());
+        mtv->run(profile.get());
+        REQUIRE(handler->_count == numTiles);
+    }
+
+    std::remove(checkpointFile.c_str());
+}
@@ -0,0 +1,193 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/Utils>
+#include <thread>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    struct Tile : public osg::Referenced
+    {
+        UsageStamp _usage;
+        void* _token = nullptr;
+    };
+
+    std::vector<osg::ref_ptr<Tile>> createTiles(unsigned count)
+    {
+        std::vector<osg::ref_ptr<Tile>> tiles(count);
+        for (auto& tile : tiles)
+            tile = new Tile();
+        return tiles;
+    }
+}
+
+TEST_CASE("UsageTracker")
+{
+    auto tiles = createTiles(100);
+    UsageTracker<osg::ref_ptr<Tile>> tracker;
+
+    for (auto& tile : tiles)
+        tracker.use(tile, tile->_usage);
+    REQUIRE(tracker.size() == 100);
+
+    SECTION("Objects join once")
+    {
+        for (auto& tile : tiles)
+            tracker.use(tile, tile->_usage);
+        REQUIRE(tracker.size() == 100);
+    }
+
+    SECTION("Flush only offers objects not used since the last flush")
+    {
+        unsigned offered = 0;
+        tracker.flush(~0u, [&](osg::ref_ptr<Tile>&) { ++offered; return true; });
+        REQUIRE(offered == 0);
+
+        for (unsigned i = 0; i < 40; ++i)
+            tracker.use(tiles[i], tiles[i]->_usage);
+
+        tracker.flush(~0u, [&](osg::ref_ptr<Tile>&) { ++offered; return true; });
+        REQUIRE(offered == 60);
+        REQUIRE(tracker.size() == 40);
+    }
+
+    SECTION("Flush honors the disposal limit")
+    {
+        tracker.flush(~0u, [](osg::ref_ptr<Tile>&) { return false; });
+        tracker.flush(10u, [](osg::ref_ptr<Tile>&) { return true; });
+        REQUIRE(tracker.size() == 90);
+    }
+
+    SECTION("Disposed objects are released two flushes later and can rejoin")
+    {
+        osg::observer_ptr<Tile> weak = tiles[0].get();
+        tiles[0] = nullptr;
+
+        tracker.flush(~0u, [](osg::ref_ptr<Tile>&) { return false; });
+        tracker.flush(~0u, [](osg::ref_ptr<Tile>& t) { return t->referenceCount() == 1; });
+        REQUIRE(tracker.size() == 99);
+        REQUIRE(weak.valid());
+
+        tracker.flush(~0u, [](osg::ref_ptr<Tile>&) { return false; });
+        REQUIRE(weak.valid());
+        tracker.flush(~0u, [](osg::ref_ptr<Tile>&) { return false; });
+        REQUIRE_FALSE(weak.valid());
+
+        tracker.flush(~0u, [](osg::ref_ptr<Tile>&) { return true; });
+        REQUIRE(tracker.size() == 0);
+        tracker.use(tiles[1], tiles[1]->_usage);
+        REQUIRE(tracker.size() == 1);
+    }
+
+    SECTION("Concurrent use from many threads")
+    {
+        tracker.reset();
+        auto more = createTiles(1000);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&]() {
+                for (int pass = 0; pass < 10; ++pass)
+                    for (auto& tile : more)
+                        tracker.use(tile, tile->_usage);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(tracker.size() == 1000);
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+// Several "cameras" touch the same tiles in parallel, like one cull
+// thread per view, and we count touches per second.
+TEST_CASE("UsageTracker multi-camera touch benchmark", "[.][benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+
+    const unsigned numTiles = 20000;
+    const unsigned numFrames = 200;
+    auto tiles = createTiles(numTiles);
+
+    for (unsigned cameras = 1; cameras <= 8; cameras *= 2)
+    {
+        // Previous approach: sentry list behind a mutex
+        {
+            SentryTracker<osg::ref_ptr<Tile>> tracker;
+            std::mutex mutex;
+            for (auto& tile : tiles)
+                tile->_token = tracker.use(tile, nullptr);
+
+            auto t0 = clock::now();
+            for (unsigned frame = 0; frame < numFrames; ++frame)
+            {
+                std::vector<std::thread> culls;
+                for (unsigned c = 0; c < cameras; ++c)
+                {
+                    culls.emplace_back([&]() {
+                        for (auto& tile : tiles) {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            tile->_token = tracker.use(tile, tile->_token);
+                        }
+                    });
+                }
+                for (auto& cull : culls)
+                    cull.join();
+                tracker.flush(~0u, [](osg::ref_ptr<Tile>&) { return false; });
+            }
+            double s = std::chrono::duration<double>(clock::now() - t0).count();
+            std::cout << "SentryTracker: " << cameras << " cameras: "
+                << (double)numTiles * numFrames * cameras / s << " touches/s" << std::endl;
+        }
+
+        // Lock-free touch
+        {
+            UsageTracker<osg::ref_ptr<Tile>> tracker;
+
+            auto t0 = clock::now();
+            for (unsigned frame = 0; frame < numFrames; ++frame)
+            {
+                std::vector<std::thread> culls;
+                for (unsigned c = 0; c < cameras; ++c)
+                {
+                    culls.emplace_back([&]() {
+                        for (auto& tile : tiles)
+                            tracker.use(tile, tile->_usage);
+                    });
+                }
+                for (auto& cull : culls)
+                    cull.join();
+                tracker.flush(~0u, [](osg::ref_ptr<Tile>&) { return false; });
+            }
+            double s = std::chrono::duration<double>(clock::now() - t0).count();
+            std::cout << "UsageTracker:  " << cameras << " cameras: "
+                << (double)numTiles * numFrames * cameras / s << " touches/s" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,226 @@
+/* -*-c++-*- */
+/* osgEarth - Geospatial SDK for OpenSceneGraph
+* Copyright 2018 Pelican Mapping
+* http://osgearth.org
+*
+* osgEarth is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <osgEarth/catch.hpp>
+#include <osgEarth/Viewshed>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/HeightFieldUtils>
+#include <osgEarth/Map>
+#include <chrono>
+#include <iostream>
+
+using namespace osgEarth;
+using namespace osgEarth::Util;
+
+namespace
+{
+    // Degrees of longitude per meter at the equator
+    const double DEG_PER_METER = 1.0 / 111319.49;
+
+    // Flat elevation layer at sea level with an optional north-south ridge,
+    // so the tests need no data files.
+    class RidgeElevationLayer : public ElevationLayer
+    {
+    public:
+        META_Layer(osgEarth, RidgeElevationLayer, Options, ElevationLayer, ridge_elevation);
+
+        double ridgeWest = 0.0, ridgeEast = 0.0, ridgeHeight = 0.0;
+
+    protected:
+        Status openImplementation() override
+        {
+            Status parent = ElevationLayer::openImplementation();
+            if (parent.isError())
+                return parent;
+
+            setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+            addDataExtent(DataExtent(getProfile()->getExtent(), 0u, 14u));
+            return Status::NoError;
+        }
+
+        GeoHeightField createHeightFieldImplementation(const TileKey& key, ProgressCallback*) const override
+        {
+            const unsigned size = 257u;
+            const GeoExtent& ex = key.getExtent();
+            osg::ref_ptr<osg::HeightField> hf = HeightFieldUtils::createReferenceHeightField(ex, size, size, 0u);
+            for (unsigned col = 0; col < size; ++col)
+            {
+                double x = ex.xMin() + ex.width() * (double)col / (double)(size - 1);
+                float h = (x >= ridgeWest && x <= ridgeEast) ? (float)ridgeHeight : 0.0f;
+                for (unsigned row = 0; row < size; ++row)
+                    hf->setHeight(col, row, h);
+            }
+            return GeoHeightField(hf.get(), ex);
+        }
+    };
+
+    osg::ref_ptr<Map> createMap(double ridgeWestMeters, double ridgeEastMeters, double ridgeHeight)
+    {
+        osg::ref_ptr<RidgeElevationLayer> layer = new RidgeElevationLayer();
+        layer->ridgeWest = ridgeWestMeters * DEG_PER_METER;
+        layer->ridgeEast = ridgeEastMeters * DEG_PER_METER;
+        layer->ridgeHeight = ridgeHeight;
+
+        osg::ref_ptr<Map> map = new Map();
+        map->setProfile(Profile::create(Profile::GLOBAL_GEODETIC));
+        map->addLayer(layer.get());
+        return map;
+    }
+
+    // Visibility of the cell (dx, dy) cells away from the observer
+    unsigned char visibilityAt(const GeoImage& result, int dx, int dy)
+    {
+        const osg::Image* image = result.getImage();
+        int r = image->s() / 2;
+        return *image->data(dx + r, dy + r);
+    }
+}
+
+TEST_CASE("Viewshed")
+{
+    SECTION("Earth curvature limits visibility to the horizon")
+    {
+        osg::ref_ptr<Map> map = createMap(0.0, 0.0, 0.0);
+
+        Viewshed viewshed(map.get());
+        viewshed.setCellSize(Distance(100.0, Units::METERS));
+        viewshed.setRefraction(0.0);
+
+        GeoPoint observer(map->getSRS(), 0.0, 0.0, 10.0, ALTMODE_RELATIVE);
+        GeoImage result = viewshed.compute(observer, Distance(20.0, Units::KILOMETERS));
+        REQUIRE(result.valid());
+        REQUIRE(result.getImage()->s() == 401);
+        REQUIRE(result.getImage()->t() == 401);
+
+        // horizon for a 10m eye is sqrt(2 * R * 10) ~= 11.3km
+        const int r = 200;
+        unsigned wrong = 0;
+        for (int y = -r; y <= r; ++y)
+        {
+            for (int x = -r; x <= r; ++x)
+            {
+                double d = sqrt((double)(x * x + y * y)) * 100.0;
+                unsigned char v = visibilityAt(result, x, y);
+                if (d > 20000.0)
+                    wrong += (v != Viewshed::OUT_OF_RANGE);
+                else if (d < 10500.0)
+                    wrong += (v != Viewshed::VISIBLE);
+                else if (d > 12000.0)
+                    wrong += (v != Viewshed::HIDDEN);
+            }
+        }
+        REQUIRE(wrong == 0u);
+    }
+
+    SECTION("Without curvature, flat terrain is all visible")
+    {
+        osg::ref_ptr<Map> map = createMap(0.0, 0.0, 0.0);
+
+        Viewshed viewshed(map.get());
+        viewshed.setCellSize(Distance(100.0, Units::METERS));
+        viewshed.setRefraction(1.0);
+
+        GeoPoint observer(map->getSRS(), 0.0, 0.0, 10.0, ALTMODE_RELATIVE);
+        GeoImage result = viewshed.compute(observer, Distance(20.0, Units::KILOMETERS));
+        REQUIRE(result.valid());
+
+        REQUIRE(visibilityAt(result, 199, 0) == Viewshed::VISIBLE);
+        REQUIRE(visibilityAt(result, -140, 140) == Viewshed::VISIBLE);
+        REQUIRE(visibilityAt(result, 0, -199) == Viewshed::VISIBLE);
+    }
+
+    SECTION("A ridge hides the terrain behind it")
+    {
+        // 500m ridge from 2.0 to 2.3km east of the observer
+        osg::ref_ptr<Map> map = createMap(2000.0, 2300.0, 500.0);
+
+        Viewshed viewshed(map.get());
+        viewshed.setCellSize(Distance(100.0, Units::METERS));
+        viewshed.setRefraction(1.0);
+
+        GeoPoint observer(map->getSRS(), 0.0, 0.0, 10.0, ALTMODE_RELATIVE);
+        GeoImage result = viewshed.compute(observer, Distance(5.0, Units::KILOMETERS));
+        REQUIRE(result.valid());
+
+        // ridge top is visible, the far side is not
+        REQUIRE(visibilityAt(result, 21, 0) == Viewshed::VISIBLE);
+        for (int x = 25; x <= 50; ++x)
+            REQUIRE(visibilityAt(result, x, 0) == Viewshed::HIDDEN);
+
+        // everything to the west is open
+        for (int x = -50; x < 0; ++x)
+            REQUIRE(visibilityAt(result, x, 0) == Viewshed::VISIBLE);
+
+        // a tall enough target shows over the ridge
+        viewshed.setTargetHeight(2000.0);
+        result = viewshed.compute(observer, Distance(5.0, Units::KILOMETERS));
+        REQUIRE(visibilityAt(result, 40, 0) == Viewshed::VISIBLE);
+    }
+
+    SECTION("Rays stop at the terrain")
+    {
+        osg::ref_ptr<Map> map = createMap(2000.0, 2300.0, 500.0);
+
+        Viewshed viewshed(map.get());
+        viewshed.setCellSize(Distance(10.0, Units::METERS));
+
+        osg::Vec3d start, east, west;
+        REQUIRE(viewshed.toWorld(GeoPoint(map->getSRS(), 0.0, 0.0, 10.0, ALTMODE_RELATIVE), start));
+        REQUIRE(viewshed.toWorld(GeoPoint(map->getSRS(), 4000.0 * DEG_PER_METER, 0.0, 10.0, ALTMODE_RELATIVE), east));
+        REQUIRE(viewshed.toWorld(GeoPoint(map->getSRS(), -4000.0 * DEG_PER_METER, 0.0, 10.0, ALTMODE_RELATIVE), west));
+
+        std::vector<Viewshed::Ray> rays(2);
+        rays[0].start = start, rays[0].end = east;
+        rays[1].start = start, rays[1].end = west;
+        REQUIRE(viewshed.intersect(rays));
+
+        REQUIRE(rays[0].hasLOS == false);
+        REQUIRE(rays[1].hasLOS == true);
+
+        GeoPoint hit;
+        hit.fromWorld(map->getSRS(), rays[0].hit);
+        REQUIRE(fabs(hit.x() / DEG_PER_METER - 2000.0) < 20.0);
+    }
+}
+
+// Benchmark: run with "osgearth_tests [benchmark]"
+TEST_CASE("Viewshed benchmark", "[.][benchmark]")
+{
+    osg::ref_ptr<Map> map = createMap(2000.0, 2300.0, 500.0);
+    Viewshed viewshed(map.get());
+    GeoPoint observer(map->getSRS(), 0.0, 0.0, 10.0, ALTMODE_RELATIVE);
+
+    struct Run { double radius, cellSize; };
+    for (auto run : { Run{ 1000.0, 10.0 }, Run{ 10000.0, 30.0 }, Run{ 100000.0, 100.0 } })
+    {
+        viewshed.setCellSize(Distance(run.cellSize, Units::METERS));
+
+        auto t0 = std::chrono::steady_clock::now();
+        GeoImage result = viewshed.compute(observer, Distance(run.radius, Units::METERS));
+        auto t1 = std::chrono::steady_clock::now();
+        REQUIRE(result.valid());
+
+        std::cout << "Viewshed radius " << run.radius << "m, cell " << run.cellSize << "m ("
+            << result.getImage()->s() << "x" << result.getImage()->t() << "): "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << "ms" << std::endl;
+    }
+}